@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <endian_convert.h>
+#include <numeric>
+#include <vector>
+
+//*****************************
+// Element-wise host_to_network over an array, the way payloads are converted today.
+template <typename T>
+static void BM_HostToNetworkArray(benchmark::State &state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    std::vector<T> in(count);
+    std::vector<T> out(count);
+    std::iota(in.begin(), in.end(), T{1});
+
+    for (auto _ : state) {
+        std::ranges::transform(in, out.begin(), [](T v) { return net::host_to_network(v); });
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) *
+                            static_cast<int64_t>(sizeof(T)));
+}
+BENCHMARK_TEMPLATE(BM_HostToNetworkArray, uint16_t)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_HostToNetworkArray, uint32_t)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_HostToNetworkArray, uint64_t)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_HostToNetworkArray, float)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+//*****************************
+// Span conversion through the vector kernel picked at startup (see the "isa" label).
+template <typename T>
+static void BM_HostToNetworkBulk(benchmark::State &state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    std::vector<T> in(count);
+    std::vector<T> out(count);
+    std::iota(in.begin(), in.end(), T{1});
+
+    for (auto _ : state) {
+        net::host_to_network<T>(in, out);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(net::detail::SwapIsaName(net::detail::ActiveSwapIsa()));
+    state.SetBytesProcessed(state.iterations() * state.range(0) *
+                            static_cast<int64_t>(sizeof(T)));
+}
+BENCHMARK_TEMPLATE(BM_HostToNetworkBulk, uint16_t)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_HostToNetworkBulk, uint32_t)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_HostToNetworkBulk, uint64_t)->RangeMultiplier(16)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_HostToNetworkBulk, float)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+template <typename T>
+static void BM_HostToNetworkInPlace(benchmark::State &state)
+{
+    std::vector<T> data(static_cast<std::size_t>(state.range(0)));
+    std::iota(data.begin(), data.end(), T{1});
+
+    for (auto _ : state) {
+        net::host_to_network(std::span(data));
+        benchmark::DoNotOptimize(data.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(net::detail::SwapIsaName(net::detail::ActiveSwapIsa()));
+    state.SetBytesProcessed(state.iterations() * state.range(0) *
+                            static_cast<int64_t>(sizeof(T)));
+}
+BENCHMARK_TEMPLATE(BM_HostToNetworkInPlace, uint32_t)->RangeMultiplier(16)->Range(16, 1 << 20);
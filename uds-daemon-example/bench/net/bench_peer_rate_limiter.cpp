@@ -0,0 +1,32 @@
+#include <benchmark/benchmark.h>
+#include <peer_rate_limiter.h>
+
+using namespace net;
+
+//*****************************
+// Admission cost per request: both buckets are far above the request rate, so this measures the
+// two compare-and-swaps and counters, not waiting. With several threads all sessions share one
+// uid account, its worst case.
+static void BM_AdmitSharedUid(benchmark::State &state)
+{
+    static PeerRateLimiter limiter({.sessionRate = 1e12, .uidRate = 1e12});
+    const auto account = limiter.AccountOf(1000);
+    utils::TokenBucket session(1e12, 16);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(limiter.Admit(*account, session));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AdmitSharedUid)->ThreadRange(1, 4);
+
+static void BM_AdmitUnlimited(benchmark::State &state)
+{
+    PeerRateLimiter limiter;
+    const auto account = limiter.AccountOf(1000);
+    utils::TokenBucket session;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(limiter.Admit(*account, session));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AdmitUnlimited);
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+#include <format>
+#include <pubsub.h>
+#include <string>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+struct Event {
+    uint64_t sequence;
+    std::string source;
+    double value;
+};
+
+std::string format(const Event &event)
+{
+    return std::format("seq={} source={} value={:.3f} unit=degC state=nominal", event.sequence,
+                       event.source, event.value);
+}
+
+} // namespace
+
+//*****************************
+// Delivering one event to state.range(0) subscribers, including the subscriber side taking it
+// off its queue. The baseline formats and copies the payload into every subscriber's own
+// buffer, the way a loop over SocketSession::send would.
+static void BM_FanOutCopyPerSubscriber(benchmark::State &state)
+{
+    const auto subscribers = static_cast<std::size_t>(state.range(0));
+    std::vector<std::vector<std::vector<std::byte>>> queues(subscribers);
+    Event event{.sequence = 0, .source = "sensor-7", .value = 21.5};
+
+    for (auto _ : state) {
+        ++event.sequence;
+        for (auto &queue : queues) {
+            const std::string text = format(event);
+            const auto bytes = std::as_bytes(std::span(text));
+            queue.emplace_back(bytes.begin(), bytes.end());
+        }
+        for (auto &queue : queues) {
+            benchmark::DoNotOptimize(queue.back().data());
+            queue.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FanOutCopyPerSubscriber)->RangeMultiplier(4)->Range(1, 1024);
+
+static void BM_FanOutSharedBuffer(benchmark::State &state)
+{
+    const auto subscribers = static_cast<std::size_t>(state.range(0));
+    Broker broker;
+    std::vector<std::shared_ptr<Subscriber>> queues;
+    for (std::size_t i = 0; i < subscribers; ++i) {
+        queues.push_back(std::make_shared<Subscriber>(SubscriberOptions{}, nullptr));
+        broker.Subscribe(queues.back(), "sensors");
+    }
+    Event event{.sequence = 0, .source = "sensor-7", .value = 21.5};
+    std::vector<SharedBuffer> drained;
+
+    for (auto _ : state) {
+        ++event.sequence;
+        broker.Publish("sensors", format(event));
+        for (auto &queue : queues) {
+            queue->Drain(drained);
+            benchmark::DoNotOptimize(drained.back()->data());
+            drained.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FanOutSharedBuffer)->RangeMultiplier(4)->Range(1, 1024);
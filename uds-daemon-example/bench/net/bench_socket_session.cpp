@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+#include <socket_session.h>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+std::pair<SocketSession, SocketSession> makeSessionPair()
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+        throw std::system_error(errno, std::system_category(), "socketpair() failed");
+    return {SocketSession(fds[0]), SocketSession(fds[1])};
+}
+
+// Keeps reading until the whole message arrived; large messages are split by the kernel.
+CallbackReceive untilSize(std::size_t size)
+{
+    return [size](std::span<const std::byte> data) { return data.size() >= size; };
+}
+
+} // namespace
+
+//*****************************
+// Request/response round trip between two sessions over a socketpair, driven from one thread.
+static void BM_SocketSessionRoundTrip(benchmark::State &state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    auto [client, server] = makeSessionPair();
+
+    std::vector<std::byte> request(size, std::byte{0x5a});
+    std::vector<std::byte> rxBuffer(size);
+    const auto scanForEnd = untilSize(size);
+
+    for (auto _ : state) {
+        auto sent = client.send(std::span(request));
+        auto received = server.receive(std::span(rxBuffer), scanForEnd);
+        auto replied = server.send(std::span(rxBuffer.data(), *received));
+        auto answer = client.receive(std::span(rxBuffer), scanForEnd);
+        if (!sent || !received || !replied || !answer) {
+            state.SkipWithError("round trip failed");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 2);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SocketSessionRoundTrip)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+//*****************************
+// Round trip time against an echo thread, so every receive really has to wait for the peer.
+// Arguments: spin budget of both sides in microseconds (0 = park in poll() right away) and
+// whether the spin is adaptive. The spin yields between probes, so it does not starve a peer
+// that shares its cpu; the gain over parking is largest with a core per side.
+static void BM_SocketSessionPingPong(benchmark::State &state)
+{
+    constexpr std::size_t size = 64;
+    const SpinPolicy policy{.spin = std::chrono::microseconds(state.range(0)),
+                            .adaptive = state.range(1) != 0};
+    auto [client, server] = makeSessionPair();
+    client.setSpinPolicy(policy);
+    server.setSpinPolicy(policy);
+
+    std::thread echo([&server = server]() {
+        std::vector<std::byte> buffer(size);
+        const auto scanForEnd = untilSize(size);
+        while (auto received = server.receive(std::span(buffer), scanForEnd)) {
+            if (!server.send(std::span(buffer.data(), *received)))
+                break;
+        }
+    });
+
+    std::vector<std::byte> request(size, std::byte{0x5a});
+    std::vector<std::byte> reply(size);
+    const auto scanForEnd = untilSize(size);
+    for (auto _ : state) {
+        auto sent = client.send(std::span(request));
+        auto answer = client.receive(std::span(reply), scanForEnd);
+        if (!sent || !answer) {
+            state.SkipWithError("round trip failed");
+            break;
+        }
+    }
+    client.shutdown();
+    echo.join();
+
+    const auto stats = client.spinStats();
+    const auto receives = static_cast<double>(stats.spinHits + stats.parks);
+    state.counters["spin_hit_ratio"] =
+        receives > 0 ? static_cast<double>(stats.spinHits) / receives : 0.0;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SocketSessionPingPong)
+    ->ArgNames({"spin_us", "adaptive"})
+    ->Args({0, 0})
+    ->Args({20, 0})
+    ->Args({100, 0})
+    ->Args({100, 1})
+    ->UseRealTime();
+
+//*****************************
+// One-way send throughput, drained by a receive of the same size.
+static void BM_SocketSessionSendReceive(benchmark::State &state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    auto [client, server] = makeSessionPair();
+
+    std::vector<std::byte> payload(size, std::byte{0x5a});
+    std::vector<std::byte> rxBuffer(size);
+    const auto scanForEnd = untilSize(size);
+
+    for (auto _ : state) {
+        auto sent = client.send(std::span(payload));
+        auto received = server.receive(std::span(rxBuffer), scanForEnd);
+        if (!sent || !received) {
+            state.SkipWithError("send/receive failed");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SocketSessionSendReceive)->RangeMultiplier(8)->Range(16, 64 << 10);
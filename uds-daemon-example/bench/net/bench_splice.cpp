@@ -0,0 +1,142 @@
+#include <benchmark/benchmark.h>
+#include <pipe.h>
+#include <socket_session.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+std::pair<SocketSession, SocketSession> makeSessionPair()
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+        throw std::system_error(errno, std::system_category(), "socketpair() failed");
+
+    // Room for a whole chunk in flight, so one thread can drive both ends.
+    const int size = 1 << 20;
+    for (int fd : fds) {
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    return {SocketSession(fds[0]), SocketSession(fds[1])};
+}
+
+CallbackReceive untilSize(std::size_t size)
+{
+    return [size](std::span<const std::byte> data) { return data.size() >= size; };
+}
+
+// The copy loop a relay uses today: recv into a user-space buffer, send it on.
+bool copyRelay(const SocketSession &from, const SocketSession &to, std::vector<std::byte> &buffer,
+               std::size_t size)
+{
+    auto received = from.receive(std::span(buffer.data(), size), untilSize(size));
+    return received && to.send(std::span(buffer.data(), *received));
+}
+
+} // namespace
+
+//*****************************
+// client -> relay -> backend; the relay step is a user-space copy or a splice through a pipe.
+// The client send and backend receive are identical for both variants.
+static void BM_RelayCopy(benchmark::State &state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    auto [client, relayIn] = makeSessionPair();
+    auto [relayOut, backend] = makeSessionPair();
+    std::vector<std::byte> payload(size, std::byte{0x5a});
+    std::vector<std::byte> relayBuffer(size);
+    std::vector<std::byte> sink(size);
+
+    for (auto _ : state) {
+        auto sent = client.send(std::span(payload));
+        const bool relayed = copyRelay(relayIn, relayOut, relayBuffer, size);
+        auto received = backend.receive(std::span(sink), untilSize(size));
+        if (!sent || !relayed || !received) {
+            state.SkipWithError("relay failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RelayCopy)->RangeMultiplier(4)->Range(4 << 10, 256 << 10);
+
+static void BM_RelaySplice(benchmark::State &state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    auto [client, relayIn] = makeSessionPair();
+    auto [relayOut, backend] = makeSessionPair();
+    std::vector<std::byte> payload(size, std::byte{0x5a});
+    std::vector<std::byte> sink(size);
+    utils::Pipe pipe;
+    pipe.setCapacity(size);
+
+    for (auto _ : state) {
+        auto sent = client.send(std::span(payload));
+        auto relayed = relayIn.relayTo(relayOut, size, pipe);
+        auto received = backend.receive(std::span(sink), untilSize(size));
+        if (!sent || !relayed || !received) {
+            state.SkipWithError("relay failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RelaySplice)->RangeMultiplier(4)->Range(4 << 10, 256 << 10);
+
+//*****************************
+// Serving a file region: pread + send against splice file -> pipe -> socket.
+static void BM_FileToSocketCopy(benchmark::State &state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const int file = ::memfd_create("bench", MFD_CLOEXEC);
+    std::vector<std::byte> content(size, std::byte{0x33});
+    if (::write(file, content.data(), size) != static_cast<ssize_t>(size))
+        state.SkipWithError("write failed");
+
+    auto [server, client] = makeSessionPair();
+    std::vector<std::byte> buffer(size);
+    std::vector<std::byte> sink(size);
+
+    for (auto _ : state) {
+        const bool read = ::pread(file, buffer.data(), size, 0) == static_cast<ssize_t>(size);
+        auto sent = server.send(std::span(buffer));
+        auto received = client.receive(std::span(sink), untilSize(size));
+        if (!read || !sent || !received) {
+            state.SkipWithError("transfer failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    ::close(file);
+}
+BENCHMARK(BM_FileToSocketCopy)->RangeMultiplier(4)->Range(4 << 10, 256 << 10);
+
+static void BM_FileToSocketSplice(benchmark::State &state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const int file = ::memfd_create("bench", MFD_CLOEXEC);
+    std::vector<std::byte> content(size, std::byte{0x33});
+    if (::write(file, content.data(), size) != static_cast<ssize_t>(size))
+        state.SkipWithError("write failed");
+
+    auto [server, client] = makeSessionPair();
+    std::vector<std::byte> sink(size);
+    utils::Pipe pipe;
+    pipe.setCapacity(size);
+
+    for (auto _ : state) {
+        auto sent = server.sendFile(file, 0, size, pipe);
+        auto received = client.receive(std::span(sink), untilSize(size));
+        if (!sent || !received) {
+            state.SkipWithError("transfer failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    ::close(file);
+}
+BENCHMARK(BM_FileToSocketSplice)->RangeMultiplier(4)->Range(4 << 10, 256 << 10);
@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <filesystem>
+#include <fs_utils.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <uds_server.h>
+
+namespace fs = std::filesystem;
+using namespace net;
+
+//*****************************
+// connect() + WaitForConnection() + close on both ends, i.e. the accept rate of one server.
+static void BM_UdsServerAccept(benchmark::State &state)
+{
+    UdsServer server(fs::temp_directory_path() /
+                     ("sockact-uds-bench-" + fs_utils::random_suffix() + ".sock"));
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, server.SocketPath().c_str(), sizeof(addr.sun_path) - 1);
+
+    for (auto _ : state) {
+        Socket client(ESocketMode::UNIX_STREAM);
+        if (::connect(client.getFd(), reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) <
+            0) {
+            state.SkipWithError("connect failed");
+            break;
+        }
+
+        auto session = server.WaitForConnection();
+        if (!session) {
+            state.SkipWithError("accept failed");
+            break;
+        }
+        benchmark::DoNotOptimize(session->getFd());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UdsServerAccept);
@@ -0,0 +1,145 @@
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <endian_convert.h>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <wire_schema.h>
+
+namespace {
+
+// The hand-written encoding of the unit tests' TestData message as it was before the schema
+// existed: name[10], uint32, uint16, uint8, one push per field into a fresh vector.
+struct HandWritten {
+    std::array<char, 10> name{};
+    uint32_t data0{0};
+    uint16_t data1{0};
+    uint8_t data2{0};
+
+    std::vector<std::byte> serialize() const
+    {
+        std::vector<std::byte> buffer;
+        buffer.reserve(name.size() + sizeof(data0) + sizeof(data1) + sizeof(data2));
+
+        auto push = [&buffer]<typename T>(T v) {
+            T net = net::host_to_network(v);
+            auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(net);
+            buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+        };
+
+        const auto *raw = reinterpret_cast<const std::byte *>(name.data());
+        buffer.insert(buffer.end(), raw, raw + name.size());
+        push(data0);
+        push(data1);
+        push(data2);
+        return buffer;
+    }
+
+    static HandWritten deserialize(std::span<const std::byte> buf)
+    {
+        HandWritten result;
+        if (buf.size() < 17)
+            throw std::runtime_error("Buffer too small while reading field");
+
+        std::size_t offset = 0;
+        std::memcpy(result.name.data(), buf.data(), result.name.size());
+        offset += result.name.size();
+
+        auto pull = [&buf, &offset]<typename T>(T &field) {
+            T net{};
+            std::memcpy(&net, buf.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            field = net::network_to_host(net);
+        };
+        pull(result.data0);
+        pull(result.data1);
+        pull(result.data2);
+        return result;
+    }
+};
+
+struct Name;
+struct Data0;
+struct Data1;
+struct Data2;
+using TestDataSchema =
+    net::wire::Schema<net::wire::FixedString<Name, 10>, net::wire::Scalar<Data0, uint32_t>,
+                      net::wire::Scalar<Data1, uint16_t>, net::wire::Scalar<Data2, uint8_t>>;
+
+struct Blob;
+using FramedSchema =
+    net::wire::Schema<net::wire::Scalar<Data0, uint32_t>, net::wire::Text<Name>,
+                      net::wire::Bytes<Blob, uint32_t>, net::wire::Scalar<Data2, uint8_t>>;
+
+} // namespace
+
+//*****************************
+// Encoding one message into a send buffer.
+static void BM_EncodeHandWritten(benchmark::State &state)
+{
+    HandWritten msg{.name = {'b', 'e', 'n', 'c', 'h'}, .data0 = 1, .data1 = 2, .data2 = 3};
+    for (auto _ : state) {
+        auto buffer = msg.serialize();
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncodeHandWritten);
+
+static void BM_EncodeSchema(benchmark::State &state)
+{
+    std::array<std::byte, TestDataSchema::kMinSize> buffer{};
+    uint32_t id = 1;
+    for (auto _ : state) {
+        auto written = TestDataSchema::Encode(buffer, "bench", id++, 2, 3);
+        benchmark::DoNotOptimize(written);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncodeSchema);
+
+//*****************************
+// Reading one field of a received message: full struct decode against a lazy view.
+static void BM_DecodeHandWritten(benchmark::State &state)
+{
+    HandWritten msg{.name = {'b', 'e', 'n', 'c', 'h'}, .data0 = 1, .data1 = 2, .data2 = 3};
+    const auto wire = msg.serialize();
+    for (auto _ : state) {
+        auto decoded = HandWritten::deserialize(wire);
+        benchmark::DoNotOptimize(decoded.data1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeHandWritten);
+
+static void BM_DecodeSchemaView(benchmark::State &state)
+{
+    std::array<std::byte, TestDataSchema::kMinSize> wire{};
+    (void)TestDataSchema::Encode(wire, "bench", 1, 2, 3);
+    for (auto _ : state) {
+        auto view = TestDataSchema::Parse(wire);
+        benchmark::DoNotOptimize(view->Get<Data1>());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeSchemaView);
+
+//*****************************
+// Variable-length message with a payload of state.range(0) bytes: the view hands out the payload
+// in place, so its cost does not grow with the payload.
+static void BM_DecodeSchemaPayload(benchmark::State &state)
+{
+    const std::vector<std::byte> payload(static_cast<std::size_t>(state.range(0)), std::byte{7});
+    std::vector<std::byte> wire;
+    (void)FramedSchema::Append(wire, 1, "name", payload, 9);
+
+    for (auto _ : state) {
+        auto view = FramedSchema::Parse(wire);
+        benchmark::DoNotOptimize(view->Get<Blob>().size());
+        benchmark::DoNotOptimize(view->Get<Data2>());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeSchemaPayload)->Range(16, 64 << 10);
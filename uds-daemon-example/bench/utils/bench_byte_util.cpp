@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+#include <byte_util.h>
+#include <string>
+
+using namespace utils;
+
+static void BM_ToBytesStringView(benchmark::State &state)
+{
+    const std::string str(static_cast<std::size_t>(state.range(0)), 'x');
+
+    for (auto _ : state) {
+        auto bytes = to_bytes(std::string_view(str));
+        benchmark::DoNotOptimize(bytes.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ToBytesStringView)->RangeMultiplier(8)->Range(8, 64 << 10);
+
+static void BM_ToBytesLiteral(benchmark::State &state)
+{
+    for (auto _ : state) {
+        auto bytes = to_bytes("uds-daemon request literal");
+        benchmark::DoNotOptimize(bytes.data());
+    }
+}
+BENCHMARK(BM_ToBytesLiteral);
+
+static void BM_FromBytes(benchmark::State &state)
+{
+    const auto bytes = to_bytes(std::string(static_cast<std::size_t>(state.range(0)), 'x'));
+
+    for (auto _ : state) {
+        auto view = from_bytes(bytes);
+        benchmark::DoNotOptimize(view);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FromBytes)->RangeMultiplier(8)->Range(8, 64 << 10);
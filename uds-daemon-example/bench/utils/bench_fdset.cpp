@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include <fdset.h>
+#include <pipe.h>
+#include <vector>
+
+using namespace utils;
+
+//*****************************
+// Select() with N registered fds where only the last one is readable.
+static void BM_FdSetSelect(benchmark::State &state)
+{
+    const auto fdCount = static_cast<std::size_t>(state.range(0));
+
+    FdSet set;
+    std::vector<Pipe> pipes(fdCount);
+    for (const auto &p : pipes)
+        set.AddFd(p.readFd());
+
+    pipes.back().writeString("x");
+
+    for (auto _ : state) {
+        FdSetRet ret = set.Select(std::chrono::milliseconds(0));
+        benchmark::DoNotOptimize(ret);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["fds"] = static_cast<double>(fdCount);
+}
+BENCHMARK(BM_FdSetSelect)->RangeMultiplier(4)->Range(1, 256);
+
+//*****************************
+// Select() with a per-fd callback on every readable entry.
+static void BM_FdSetSelectCallback(benchmark::State &state)
+{
+    const auto fdCount = static_cast<std::size_t>(state.range(0));
+
+    FdSet set;
+    std::vector<Pipe> pipes(fdCount);
+    std::size_t hits = 0;
+    for (auto &p : pipes) {
+        set.AddFd(p.readFd(), [&hits](int) { ++hits; });
+        p.writeString("x");
+    }
+
+    for (auto _ : state) {
+        FdSetRet ret = set.Select(std::chrono::milliseconds(0));
+        benchmark::DoNotOptimize(ret);
+    }
+
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FdSetSelectCallback)->RangeMultiplier(4)->Range(1, 256);
+
+//*****************************
+// UnBlock() followed by the Select() it wakes up.
+static void BM_FdSetUnblock(benchmark::State &state)
+{
+    FdSet set;
+    for (auto _ : state) {
+        set.UnBlock();
+        FdSetRet ret = set.Select();
+        benchmark::DoNotOptimize(ret);
+    }
+}
+BENCHMARK(BM_FdSetUnblock);
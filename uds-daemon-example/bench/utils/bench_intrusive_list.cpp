@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <intrusive_list.h>
+#include <list.h>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+struct Entry : IntrusiveListHook<> {
+    uint64_t value{0};
+};
+
+// Moving the middle element to the back leaves its follower in the middle, so cycling through
+// the upper half keeps every target at position count / 2.
+std::size_t nextTarget(std::size_t current, std::size_t count)
+{
+    const std::size_t middle = count / 2;
+    return middle + (current - middle + 1) % (count - middle);
+}
+
+// Moves the element behind a held pointer to the back of a list of state.range(0) entries: the
+// "drop the session I hold" lookup of a session table or the touch of an LRU chain.
+void BM_CListRemoveByPointer(benchmark::State &state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    CList<Entry> list;
+    std::vector<Entry *> entries;
+    for (std::size_t i = 0; i < count; ++i)
+        entries.push_back(&list.emplace_back());
+
+    std::size_t next = count / 2;
+    for (auto _ : state) {
+        auto it = list.data_to_iterator(entries[next]);
+        list.splice(list.end(), list, it); // relinks the node, the element keeps its address
+        benchmark::DoNotOptimize(it);
+        next = nextTarget(next, count);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_IntrusiveRemoveByPointer(benchmark::State &state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    std::vector<Entry> entries(count);
+    IntrusiveList<Entry> list;
+    for (auto &entry : entries)
+        list.push_back(entry);
+
+    std::size_t next = count / 2;
+    for (auto _ : state) {
+        Entry &entry = entries[next];
+        list.remove(entry);
+        list.push_back(entry);
+        benchmark::DoNotOptimize(&entry);
+        next = nextTarget(next, count);
+    }
+    state.SetItemsProcessed(state.iterations());
+    list.clear();
+}
+
+} // namespace
+
+BENCHMARK(BM_CListRemoveByPointer)->Range(16, 4096);
+BENCHMARK(BM_IntrusiveRemoveByPointer)->Range(16, 4096);
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <list.h>
+#include <queue.h>
+
+using namespace utils;
+
+namespace {
+
+// Fixed number of live elements; every iteration erases the oldest batch and appends a new one,
+// the steady-state churn of a bookkeeping list.
+constexpr std::size_t kLive = 1024;
+constexpr std::size_t kBatch = 64;
+
+template <typename List>
+void BM_ListInsertErase(benchmark::State &state)
+{
+    List list;
+    for (std::size_t i = 0; i < kLive; ++i)
+        list.push_back(i);
+
+    uint64_t next = kLive;
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < kBatch; ++i)
+            list.pop_front();
+        for (std::size_t i = 0; i < kBatch; ++i)
+            list.push_back(next++);
+        benchmark::DoNotOptimize(list.back());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kBatch));
+}
+
+// Erases from the middle through an iterator, what a session table does on disconnect.
+template <typename List>
+void BM_ListEraseMiddle(benchmark::State &state)
+{
+    List list;
+    for (std::size_t i = 0; i < kLive; ++i)
+        list.push_back(i);
+
+    auto middle = std::next(list.begin(), kLive / 2);
+    for (auto _ : state) {
+        // Replace the node in place so the position stays in the middle.
+        middle = list.insert(list.erase(middle), 42);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Queue>
+void BM_QueuePushPop(benchmark::State &state)
+{
+    Queue queue;
+    uint64_t next = 0;
+    for (auto _ : state) {
+        // Grows and drains a few chunks per iteration so chunk allocation is part of the cost.
+        for (std::size_t i = 0; i < 4 * kLive; ++i)
+            queue.push_back(next++);
+        while (!queue.empty())
+            queue.pop_front();
+    }
+    state.SetItemsProcessed(state.iterations() * 4 * static_cast<int64_t>(kLive));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ListInsertErase, CList<uint64_t>);
+BENCHMARK_TEMPLATE(BM_ListInsertErase, CPoolList<uint64_t>);
+BENCHMARK_TEMPLATE(BM_ListInsertErase, CPoolList<uint64_t, PoolBacking::HugePages>);
+BENCHMARK_TEMPLATE(BM_ListEraseMiddle, CList<uint64_t>);
+BENCHMARK_TEMPLATE(BM_ListEraseMiddle, CPoolList<uint64_t>);
+BENCHMARK_TEMPLATE(BM_QueuePushPop, CQueue<uint64_t>);
+BENCHMARK_TEMPLATE(BM_QueuePushPop, CPoolQueue<uint64_t>);
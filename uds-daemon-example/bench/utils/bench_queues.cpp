@@ -0,0 +1,148 @@
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <deque>
+#include <mpsc_queue.h>
+#include <mutex>
+#include <optional>
+#include <spsc_ring.h>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+//! Baseline: what the handoff costs with a mutex around a std::deque.
+template <typename T>
+class MutexDeque {
+  public:
+    explicit MutexDeque(std::size_t capacity)
+     : capacity_(capacity)
+    {
+    }
+
+    bool TryPush(T value)
+    {
+        std::lock_guard lock(mutex_);
+        if (items_.size() == capacity_)
+            return false;
+        items_.push_back(std::move(value));
+        return true;
+    }
+
+    std::optional<T> TryPop()
+    {
+        std::lock_guard lock(mutex_);
+        if (items_.empty())
+            return std::nullopt;
+        T value = std::move(items_.front());
+        items_.pop_front();
+        return value;
+    }
+
+    template <typename OutputIt>
+    std::size_t PopBatch(OutputIt out, std::size_t max)
+    {
+        std::lock_guard lock(mutex_);
+        const std::size_t n = std::min(max, items_.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            *out++ = std::move(items_.front());
+            items_.pop_front();
+        }
+        return n;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::deque<T> items_;
+    std::size_t capacity_;
+};
+
+constexpr std::size_t kCapacity = 1024;
+
+//! Runs \p producers threads pushing as fast as the queue accepts while the benchmark thread
+//! consumes \p batch items per iteration.
+template <typename Queue>
+void consumeWithProducers(benchmark::State &state, Queue &queue, int producers, std::size_t batch)
+{
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, &stop]() {
+            uint64_t value = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (queue.TryPush(value))
+                    ++value;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<uint64_t> out(batch);
+    for (auto _ : state) {
+        std::size_t got = 0;
+        while (got < batch) {
+            const auto n = queue.PopBatch(out.begin(), batch - got);
+            if (n == 0)
+                std::this_thread::yield();
+            got += n;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    stop = true;
+    for (auto &t : threads)
+        t.join();
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+
+} // namespace
+
+//*****************************
+// Many I/O threads hand items to one worker.
+template <typename Queue>
+static void BM_MultiProducerHandoff(benchmark::State &state)
+{
+    Queue queue(kCapacity);
+    consumeWithProducers(state, queue, static_cast<int>(state.range(0)),
+                         static_cast<std::size_t>(state.range(1)));
+}
+BENCHMARK(BM_MultiProducerHandoff<MpscQueue<uint64_t>>)
+    ->ArgsProduct({{1, 2, 4}, {1, 64}})
+    ->UseRealTime();
+BENCHMARK(BM_MultiProducerHandoff<MutexDeque<uint64_t>>)
+    ->ArgsProduct({{1, 2, 4}, {1, 64}})
+    ->UseRealTime();
+
+//*****************************
+// One producer, one consumer.
+template <typename Queue>
+static void BM_SingleProducerHandoff(benchmark::State &state)
+{
+    Queue queue(kCapacity);
+    consumeWithProducers(state, queue, 1, static_cast<std::size_t>(state.range(0)));
+}
+BENCHMARK(BM_SingleProducerHandoff<SpscRing<uint64_t>>)->Arg(1)->Arg(64)->UseRealTime();
+BENCHMARK(BM_SingleProducerHandoff<MpscQueue<uint64_t>>)->Arg(1)->Arg(64)->UseRealTime();
+BENCHMARK(BM_SingleProducerHandoff<MutexDeque<uint64_t>>)->Arg(1)->Arg(64)->UseRealTime();
+
+//*****************************
+// Uncontended push + pop on one thread: the bare cost of the synchronization.
+template <typename Queue>
+static void BM_PushPopSameThread(benchmark::State &state)
+{
+    Queue queue(kCapacity);
+    uint64_t value = 0;
+    for (auto _ : state) {
+        queue.TryPush(value++);
+        auto item = queue.TryPop();
+        benchmark::DoNotOptimize(item);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PushPopSameThread<SpscRing<uint64_t>>);
+BENCHMARK(BM_PushPopSameThread<MpscQueue<uint64_t>>);
+BENCHMARK(BM_PushPopSameThread<MutexDeque<uint64_t>>);
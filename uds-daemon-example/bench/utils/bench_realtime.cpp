@@ -0,0 +1,84 @@
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <latency_histogram.h>
+#include <realtime.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+constexpr auto kPeriod = std::chrono::microseconds(100);
+
+timespec toTimespec(std::chrono::steady_clock::time_point t)
+{
+    const auto since = t.time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since);
+    timespec ts{};
+    ts.tv_sec = seconds.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since - seconds).count();
+    return ts;
+}
+
+} // namespace
+
+//*****************************
+// Wakeup jitter of a periodic thread, the way a session thread waits for its next request,
+// while one busy thread per cpu competes for the cpus. An iteration is one period of 100 us;
+// the counters are how late the wakeup came, in microseconds. Argument: 1 runs the measured
+// thread under SCHED_FIFO, which preempts the competing load instead of waiting for its slice.
+static void BM_WakeupJitter(benchmark::State &state)
+{
+    // Started first: threads inherit the scheduling policy of the thread that creates them.
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> load;
+    for (unsigned i = 0; i < std::max(std::thread::hardware_concurrency(), 1U); ++i) {
+        load.emplace_back([&stop]() {
+            while (!stop.load(std::memory_order_relaxed))
+                benchmark::ClobberMemory();
+        });
+    }
+    auto stopLoad = [&stop, &load]() {
+        stop = true;
+        for (auto &thread : load)
+            thread.join();
+    };
+
+    const bool realtime = state.range(0) != 0;
+    if (realtime) {
+        try {
+            SetCurrentThreadPriority(kMaxRealtimePriority / 2);
+        } catch (const RealtimeError &e) {
+            stopLoad();
+            state.SkipWithError(e.what());
+            return;
+        }
+        PrefaultStack();
+    }
+
+    LatencyHistogram late;
+    auto next = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        next += kPeriod;
+        const auto wakeAt = toTimespec(next);
+        ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeAt, nullptr);
+        const auto now = std::chrono::steady_clock::now();
+        late.Record(now - next);
+        // A wakeup later than a whole period starts the schedule over instead of catching up.
+        if (now - next > kPeriod)
+            next = now;
+    }
+
+    if (realtime)
+        SetCurrentThreadPriority(0);
+    stopLoad();
+
+    auto micros = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    state.counters["p50_us"] = micros(late.ValueAtPercentile(50));
+    state.counters["p99_us"] = micros(late.ValueAtPercentile(99));
+    state.counters["p99.9_us"] = micros(late.ValueAtPercentile(99.9));
+    state.counters["max_us"] = micros(late.Max());
+}
+BENCHMARK(BM_WakeupJitter)->ArgName("realtime")->Arg(0)->Arg(1)->Iterations(5000)->UseRealTime();
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+#include <request_trace.h>
+
+using namespace utils;
+
+namespace {
+
+using Clock = RequestTrace::Clock;
+
+// What a session adds to one request: the sampling decision and, when sampled, a clock read per
+// span boundary and the six spans of the request.
+void traceOneRequest(uint64_t session)
+{
+    if (!RequestTrace::Sample())
+        return;
+    const auto waiting = Clock::now();
+    const auto ready = Clock::now();
+    const auto received = Clock::now();
+    const auto handling = Clock::now();
+    const auto sending = Clock::now();
+    const auto sent = Clock::now();
+    RequestTrace::Record("wait", session, waiting, ready);
+    RequestTrace::Record("request", session, ready, sent);
+    RequestTrace::Record("recv", session, ready, received);
+    RequestTrace::Record("dispatch", session, received, handling);
+    RequestTrace::Record("handler", session, handling, sending);
+    RequestTrace::Record("send", session, sending, sent);
+}
+
+} // namespace
+
+//*****************************
+// Tracing overhead per request: off, every request traced, and 1 in state.range(0) traced.
+static void BM_RequestTraceOff(benchmark::State &state)
+{
+    RequestTrace::Disable();
+    for (auto _ : state)
+        traceOneRequest(1);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestTraceOff);
+
+static void BM_RequestTraceSampled(benchmark::State &state)
+{
+    RequestTrace::Enable(static_cast<uint64_t>(state.range(0)));
+    for (auto _ : state)
+        traceOneRequest(1);
+    RequestTrace::Disable();
+    RequestTrace::Clear();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestTraceSampled)->Arg(1)->Arg(100);
@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include <format>
+#include <response_cache.h>
+#include <string>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+constexpr int kKeys = 1024;
+
+std::vector<std::string> makeRequests()
+{
+    std::vector<std::string> requests;
+    for (int i = 0; i < kKeys; ++i)
+        requests.push_back(std::format("get state of component {:04}", i));
+    return requests;
+}
+
+// Stands in for a handler that builds a few hundred bytes of state text per request.
+void computeReply(const std::string &request, std::string &reply)
+{
+    reply.clear();
+    for (int line = 0; line < 8; ++line)
+        std::format_to(std::back_inserter(reply), "{}: line {} value {}\n", request, line,
+                       line * 31);
+}
+
+ResponseCache &sharedCache(std::size_t shards)
+{
+    static ResponseCache single(ResponseCacheOptions{.byteBudget = 4 << 20, .shards = 1});
+    static ResponseCache sharded(ResponseCacheOptions{.byteBudget = 4 << 20, .shards = 16});
+    return shards == 1 ? single : sharded;
+}
+
+} // namespace
+
+//*****************************
+// Answering a repeated request: computing the reply against fetching it from the cache.
+static void BM_ReplyRecompute(benchmark::State &state)
+{
+    const auto requests = makeRequests();
+    std::string reply;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        computeReply(requests[i++ % kKeys], reply);
+        benchmark::DoNotOptimize(reply.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReplyRecompute);
+
+static void BM_ReplyCacheHit(benchmark::State &state)
+{
+    const auto requests = makeRequests();
+    ResponseCache cache(ResponseCacheOptions{.byteBudget = 4 << 20});
+    std::string reply;
+    for (const auto &request : requests) {
+        computeReply(request, reply);
+        cache.Insert(request, reply);
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const bool hit = cache.Lookup(requests[i++ % kKeys], reply);
+        benchmark::DoNotOptimize(hit);
+        benchmark::DoNotOptimize(reply.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReplyCacheHit);
+
+//*****************************
+// Lookups from several session threads at once, one lock for all against 16 shards.
+static void BM_ReplyCacheContended(benchmark::State &state)
+{
+    const auto requests = makeRequests();
+    ResponseCache &cache = sharedCache(static_cast<std::size_t>(state.range(0)));
+    std::string reply;
+    if (state.thread_index() == 0) {
+        for (const auto &request : requests) {
+            computeReply(request, reply);
+            cache.Insert(request, reply);
+        }
+    }
+
+    std::size_t i = static_cast<std::size_t>(state.thread_index()) * 97;
+    for (auto _ : state) {
+        if (!cache.Lookup(requests[i++ % kKeys], reply)) {
+            computeReply(requests[(i - 1) % kKeys], reply);
+            cache.Insert(requests[(i - 1) % kKeys], reply);
+        }
+        benchmark::DoNotOptimize(reply.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReplyCacheContended)->Arg(1)->Arg(16)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ResponseCacheHash(benchmark::State &state)
+{
+    const std::string request(static_cast<std::size_t>(state.range(0)), 'r');
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ResponseCache::Hash(request));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ResponseCacheHash)->RangeMultiplier(8)->Range(8, 4096);
@@ -0,0 +1,128 @@
+#ifndef NET_CHUNK_STREAM_H_
+#define NET_CHUNK_STREAM_H_
+
+#include <socket_session.h>
+#include <wire_schema.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+//*****************************************************************************
+// Streamed responses with credit based flow control.
+//
+// A client asks for a streamed response with the request
+// "stream <credits> <request>". From then on both directions are framed:
+//
+//   server -> client   ChunkHeader (marker, length, flags) + payload,
+//                      repeated; the chunk flagged kChunkLast ends the stream
+//   client -> server   CreditGrant frames only
+//
+// Events of a subscribed session (pubsub.h) may arrive ahead of the chunks;
+// the leading kChunkMarker tells a chunk apart from an event's kEventMarker.
+//
+// The server sends a chunk only while it holds a credit; the request grants
+// the first ones and the client grants more as it consumes chunks. A chunk
+// carries at most kMaxChunkSize bytes, so neither side buffers more than
+// credits * kMaxChunkSize whatever the size of the whole response. After the
+// last chunk the client sends a zero grant, which tells the server that no
+// more grants are on their way: the next bytes are a new request.
+//*****************************************************************************
+
+namespace net {
+
+namespace stream {
+struct Marker;
+struct Length;
+struct Flags;
+struct Credits;
+} // namespace stream
+
+using ChunkHeader = wire::Schema<wire::Scalar<stream::Marker, uint8_t>,
+                                 wire::Scalar<stream::Length, uint32_t>,
+                                 wire::Scalar<stream::Flags, uint32_t>>;
+using CreditGrant = wire::Schema<wire::Scalar<stream::Credits, uint32_t>>;
+
+//! First byte of every chunk; must differ from kEventMarker.
+inline constexpr uint8_t kChunkMarker = 1;
+//! Ends the stream.
+inline constexpr uint32_t kChunkLast = 1;
+//! The payload is an error message; set together with kChunkLast.
+inline constexpr uint32_t kChunkError = 2;
+
+inline constexpr std::string_view kStreamPrefix = "stream ";
+inline constexpr std::size_t kMaxChunkSize = 64 * 1024;
+
+struct StreamRequest {
+    //! Zero if the request did not name a valid credit count.
+    uint32_t credits{0};
+    std::string_view request;
+};
+
+//! The parts of "stream <credits> <request>"; nullopt for a request that is not a stream.
+std::optional<StreamRequest> ParseStreamRequest(std::string_view request) noexcept;
+
+//*****************************************************************************
+//! \brief ChunkWriter
+//! Server end of a stream. Write() collects the response into chunks and
+//! sends each full one as soon as a credit is available, waiting for the
+//! client's grants on the session socket otherwise; data of a chunk's size
+//! or more goes out straight from the caller's buffer. Finish() or Fail()
+//! ends the stream and waits for the client's closing grant.
+//!
+//! A stream breaks when the connection fails or \p running turns false
+//! (the session is stopped); from then on every call returns false and the
+//! connection is unusable, since a chunk may have been cut short.
+class ChunkWriter {
+  public:
+    ChunkWriter(const SocketSession &session, uint32_t credits, const std::atomic<bool> &running,
+                std::size_t chunkSize = kMaxChunkSize);
+
+    ChunkWriter(const ChunkWriter &) = delete;
+    ChunkWriter &operator=(const ChunkWriter &) = delete;
+
+    //! False once the stream is broken or ended; a handler should stop producing then.
+    bool Write(std::span<const std::byte> data);
+    bool Write(std::string_view text) { return Write(std::as_bytes(std::span(text))); }
+
+    //! Sends what is left as the last chunk.
+    bool Finish();
+    //! Ends the stream with \p message instead; the chunks already sent stay sent.
+    bool Fail(std::string_view message);
+
+    [[nodiscard]] bool Ended() const noexcept { return state_ != EState::OPEN; }
+    [[nodiscard]] bool Broken() const noexcept { return state_ == EState::BROKEN; }
+
+    //! Payload bytes and chunks sent so far, error message excluded.
+    [[nodiscard]] uint64_t Bytes() const noexcept { return bytes_; }
+    [[nodiscard]] uint64_t Chunks() const noexcept { return chunks_; }
+
+  private:
+    enum class EState { OPEN, ENDED, BROKEN };
+
+    bool SendChunk(std::span<const std::byte> payload, uint32_t flags);
+    bool ReceiveGrant();
+    bool End(std::span<const std::byte> payload, uint32_t flags);
+
+    const SocketSession &session_;
+    const std::atomic<bool> &running_;
+    const std::size_t chunkSize_;
+    std::vector<std::byte> pending_;
+    uint64_t credits_;
+    // Grants are read one frame at a time, so nothing past the closing grant is consumed.
+    std::array<std::byte, CreditGrant::kMinSize> grant_{};
+    std::size_t grantBytes_{0};
+    bool closed_{false};
+    EState state_{EState::OPEN};
+    uint64_t bytes_{0};
+    uint64_t chunks_{0};
+};
+
+} // namespace net
+
+#endif // NET_CHUNK_STREAM_H_
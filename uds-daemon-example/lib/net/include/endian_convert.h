@@ -6,10 +6,14 @@
 #ifndef ENDIAN_CONVERT_H
 #define ENDIAN_CONVERT_H
 
+#include <bit>
 #include <byteswap.h>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <endian.h> // __BYTE_ORDER, __LITTLE_ENDIAN
+#include <span>
 #include <type_traits>
 
 namespace net {
@@ -27,7 +31,11 @@ concept EndianConvertible = std::is_arithmetic_v<T> &&
 template <EndianConvertible T>
 constexpr T host_to_network(T value) noexcept
 {
-    if constexpr (sizeof(T) == 1) {
+    if constexpr (std::is_floating_point_v<T>) {
+        // Swap the object representation; a value cast to an integer would lose it.
+        using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+        return std::bit_cast<T>(host_to_network(std::bit_cast<Bits>(value)));
+    } else if constexpr (sizeof(T) == 1) {
         return value;
     } else if constexpr (sizeof(T) == 2) {
 #if __BYTE_ORDER == __LITTLE_ENDIAN
@@ -59,6 +67,71 @@ constexpr T network_to_host(T value) noexcept
     return host_to_network(value);
 }
 
+namespace detail {
+
+//! Byte swap implementations, picked once at startup from what the CPU supports.
+enum class SwapIsa { Scalar, Ssse3, Avx2, Neon };
+
+bool SwapIsaSupported(SwapIsa isa) noexcept;
+SwapIsa ActiveSwapIsa() noexcept;
+const char *SwapIsaName(SwapIsa isa) noexcept;
+
+//! Reverses the bytes of \p count elements of \p width (2, 4 or 8) bytes each. \p in and
+//! \p out are either the same buffer or do not overlap.
+void SwapBytes(const std::byte *in, std::byte *out, std::size_t count,
+               std::size_t width) noexcept;
+//! Same with an explicit implementation, which must be supported by this CPU.
+void SwapBytes(SwapIsa isa, const std::byte *in, std::byte *out, std::size_t count,
+               std::size_t width) noexcept;
+
+} // namespace detail
+
+//*****************************************************************************
+//! \brief host_to_network for arrays
+//! Converts in.size() elements into the front of \p out, which must be at least
+//! as large. Uses SSSE3/AVX2 or NEON shuffles where available; in constant
+//! evaluation it is the plain element-wise loop.
+//*****************************************************************************
+template <EndianConvertible T>
+constexpr void host_to_network(std::type_identity_t<std::span<const T>> in,
+                               std::span<T> out) noexcept
+{
+    if consteval {
+        for (std::size_t i = 0; i < in.size(); ++i)
+            out[i] = host_to_network(in[i]);
+    } else {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        if constexpr (sizeof(T) > 1) {
+            detail::SwapBytes(reinterpret_cast<const std::byte *>(in.data()),
+                              reinterpret_cast<std::byte *>(out.data()), in.size(), sizeof(T));
+            return;
+        }
+#endif
+        if (!in.empty() && in.data() != out.data())
+            std::memmove(out.data(), in.data(), in.size_bytes());
+    }
+}
+
+//! In-place variant.
+template <EndianConvertible T>
+constexpr void host_to_network(std::span<T> data) noexcept
+{
+    host_to_network<T>(data, data);
+}
+
+template <EndianConvertible T>
+constexpr void network_to_host(std::type_identity_t<std::span<const T>> in,
+                               std::span<T> out) noexcept
+{
+    host_to_network<T>(in, out);
+}
+
+template <EndianConvertible T>
+constexpr void network_to_host(std::span<T> data) noexcept
+{
+    host_to_network<T>(data, data);
+}
+
 } // namespace net
 
 #endif /* ENDIAN_CONVERT_H */
@@ -0,0 +1,103 @@
+#ifndef NET_PEER_RATE_LIMITER_H_
+#define NET_PEER_RATE_LIMITER_H_
+
+#include <token_bucket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+namespace net {
+
+//! Account of peers whose credentials could not be read.
+inline constexpr uid_t kUnknownUid = static_cast<uid_t>(-1);
+
+struct PeerLimits {
+    //! Requests per second and burst of a single session; a rate of zero is unlimited.
+    double sessionRate{0};
+    double sessionBurst{16};
+    //! Requests per second and burst shared by all sessions of one uid, before weighting.
+    double uidRate{0};
+    double uidBurst{64};
+    //! Multiplier of the uid rate and burst; uids not listed have weight 1.
+    std::map<uid_t, double> uidWeights{};
+
+    [[nodiscard]] double WeightOf(uid_t uid) const noexcept
+    {
+        const auto it = uidWeights.find(uid);
+        return it == uidWeights.end() ? 1.0 : it->second;
+    }
+};
+
+struct ThrottleStats {
+    uid_t uid{0};
+    uint64_t requests{0};
+    //! Requests that had to wait for their turn, and how long they waited in total.
+    uint64_t throttled{0};
+    std::chrono::nanoseconds delayed{0};
+};
+
+//*****************************************************************************
+//! \brief PeerRateLimiter
+//! Admission control by peer identity (SO_PEERCRED). Each request pays into
+//! the bucket of its session and the bucket of its uid and then waits until
+//! both conform. A bucket's arrival time works as the virtual finish time of
+//! its flow, so a uid or session that sends faster than its (weighted) share
+//! queues behind its own backlog while the others keep being served on time.
+//!
+//! Thread-safe; a request takes no lock, only a compare-and-swap per bucket.
+class PeerRateLimiter {
+  public:
+    using Clock = utils::TokenBucket::Clock;
+
+    //! Bucket and counters shared by the sessions of one uid.
+    class Account {
+      public:
+        explicit Account(uid_t uid)
+         : uid_(uid)
+        {
+        }
+
+        [[nodiscard]] uid_t Uid() const noexcept { return uid_; }
+
+      private:
+        friend class PeerRateLimiter;
+
+        const uid_t uid_;
+        utils::TokenBucket bucket_;
+        std::atomic<uint64_t> requests_{0};
+        std::atomic<uint64_t> throttled_{0};
+        std::atomic<int64_t> delayedNs_{0};
+    };
+
+    explicit PeerRateLimiter(const PeerLimits &limits = {});
+
+    //! New uid limits apply to all accounts right away; session buckets are reconfigured by
+    //! their owners.
+    void Reconfigure(const PeerLimits &limits);
+
+    std::shared_ptr<Account> AccountOf(uid_t uid);
+
+    //! Reserves one request of a session of \p account; returns how long to hold it back.
+    Clock::duration Admit(Account &account, utils::TokenBucket &session,
+                          Clock::time_point now = Clock::now()) noexcept;
+
+    //! Counters per uid seen so far, ordered by uid.
+    [[nodiscard]] std::vector<ThrottleStats> Stats() const;
+
+  private:
+    void Apply(Account &account) const noexcept;
+
+    mutable std::mutex mutex_;
+    PeerLimits limits_;
+    std::map<uid_t, std::shared_ptr<Account>> accounts_;
+};
+
+} // namespace net
+
+#endif // NET_PEER_RATE_LIMITER_H_
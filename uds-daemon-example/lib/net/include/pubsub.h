@@ -0,0 +1,156 @@
+#ifndef NET_PUBSUB_H_
+#define NET_PUBSUB_H_
+
+#include <wire_schema.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace net {
+
+//! A serialized message, shared read-only by every subscriber queue it was put on.
+using SharedBuffer = std::shared_ptr<const std::vector<std::byte>>;
+
+namespace event {
+struct Marker;
+struct Topic;
+struct Payload;
+} // namespace event
+
+//! First byte of every event. Events share a session's byte stream with the replies, which are
+//! text and never start with a NUL, and with the chunks of a streamed response, which start with
+//! kChunkMarker: a client reads an event wherever the next message starts with the marker, and
+//! the reply to its pending request otherwise.
+inline constexpr uint8_t kEventMarker = 0;
+
+//! Wire format of a published event: kEventMarker, length-prefixed topic, then length-prefixed
+//! payload.
+using EventFrame = wire::Schema<wire::Scalar<event::Marker, uint8_t>, wire::Text<event::Topic>,
+                                wire::Bytes<event::Payload, uint32_t>>;
+
+//! What happens when a message is published to a subscriber whose queue is full.
+enum class SlowSubscriberPolicy {
+    //! The subscriber is closed and removed from every topic.
+    Disconnect,
+    //! The oldest queued message makes room.
+    DropOldest,
+    //! A queued message of the same topic is replaced; without one the oldest is dropped.
+    Conflate,
+};
+
+struct SubscriberOptions {
+    std::size_t maxQueued{256};
+    SlowSubscriberPolicy policy{SlowSubscriberPolicy::DropOldest};
+};
+
+struct SubscriberStats {
+    uint64_t queued{0};
+    uint64_t dropped{0};
+    uint64_t conflated{0};
+};
+
+//*****************************************************************************
+//! \brief Subscriber
+//! Output queue of one consumer, e.g. a session. Publishers append shared
+//! buffers; the consumer takes them with Drain() and writes them out, for a
+//! socket with one gather send (SocketSession::sendv). The notify callback
+//! runs on the publishing thread whenever the queue turns non-empty or the
+//! subscriber is closed, so it has to be cheap and must not call back into
+//! the broker.
+class Subscriber {
+  public:
+    using Notify = std::function<void()>;
+
+    Subscriber(const SubscriberOptions &options, Notify notify);
+
+    Subscriber(const Subscriber &) = delete;
+    Subscriber &operator=(const Subscriber &) = delete;
+
+    //! Moves up to \p max queued messages to the end of \p out, oldest first.
+    std::size_t Drain(std::vector<SharedBuffer> &out,
+                      std::size_t max = std::numeric_limits<std::size_t>::max());
+
+    //! True once the subscriber was dropped by SlowSubscriberPolicy::Disconnect.
+    [[nodiscard]] bool Closed() const noexcept;
+    [[nodiscard]] std::size_t Queued() const;
+    [[nodiscard]] SubscriberStats Stats() const;
+
+  private:
+    friend class Broker;
+
+    struct Entry {
+        uint64_t topic;
+        SharedBuffer message;
+    };
+
+    //! False if the subscriber is (now) closed.
+    bool Enqueue(uint64_t topic, const SharedBuffer &message);
+
+    const SubscriberOptions options_;
+    const Notify notify_;
+    mutable std::mutex mutex_;
+    std::deque<Entry> queue_;
+    SubscriberStats stats_;
+    std::atomic<bool> closed_{false};
+};
+
+//*****************************************************************************
+//! \brief Broker
+//! Topic registry. Publish() serializes a message once into a SharedBuffer and
+//! queues that same buffer to every subscriber of the topic, so fan-out costs
+//! one reference count increment per subscriber instead of a format and copy.
+//!
+//! Thread-safe; publishing only takes the registry lock shared.
+class Broker {
+  public:
+    //! Adds \p subscriber to \p topic; subscribing twice has no effect.
+    void Subscribe(const std::shared_ptr<Subscriber> &subscriber, std::string_view topic);
+    bool Unsubscribe(const Subscriber &subscriber, std::string_view topic);
+    //! Removes \p subscriber from all topics.
+    void Remove(const Subscriber &subscriber);
+
+    //! Returns the number of subscribers the message was queued to.
+    std::size_t Publish(std::string_view topic, std::span<const std::byte> payload);
+    std::size_t Publish(std::string_view topic, std::string_view payload);
+
+    [[nodiscard]] std::size_t Subscribers(std::string_view topic) const;
+
+    //! One EventFrame, marker included.
+    static SharedBuffer Serialize(std::string_view topic, std::span<const std::byte> payload);
+
+  private:
+    struct Topic {
+        uint64_t id;
+        std::vector<std::shared_ptr<Subscriber>> subscribers;
+    };
+
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept
+        {
+            return std::hash<std::string_view>{}(s);
+        }
+    };
+
+    void RemoveLocked(const Subscriber &subscriber);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Topic, Hash, std::equal_to<>> topics_;
+    uint64_t nextTopicId_{0};
+};
+
+} // namespace net
+
+#endif // NET_PUBSUB_H_
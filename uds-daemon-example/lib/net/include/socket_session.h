@@ -1,18 +1,46 @@
 #ifndef SOCKETSESSION_HPP
 #define SOCKETSESSION_HPP
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <expected>
 #include <fdset.h>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <pipe.h>
 #include <socket.h>
 #include <span>
 #include <system_error>
+#include <sys/types.h>
 
 namespace net {
 
+//! Identity of the process on the other end, as the kernel recorded it at connect().
+struct PeerCredentials {
+    pid_t pid{0};
+    uid_t uid{0};
+    gid_t gid{0};
+};
+
+//! Busy polling of receive(): before the thread parks in poll() the socket is probed with
+//! non-blocking recv() for up to \p spin, trading a busy core for the wakeup latency of a
+//! sleeping thread. The thread yields between probes. Zero parks right away.
+struct SpinPolicy {
+    std::chrono::microseconds spin{0};
+    //! Spins only about as long as messages recently took to arrive (twice their moving
+    //! average, capped at \p spin) and not at all while they arrive further apart than that.
+    bool adaptive{false};
+};
+
+struct SpinStats {
+    //! Receives whose data arrived while spinning.
+    uint64_t spinHits{0};
+    //! Receives that had to park in poll().
+    uint64_t parks{0};
+};
+
 using CallbackReceive = std::function<bool(std::span<const std::byte>)>;
 
 constexpr auto defaultOneRead = [](std::span<const std::byte>) noexcept { return true; };
@@ -50,6 +78,10 @@ class SocketSession {
 
     int getFd() const noexcept;
 
+    //! SO_PEERCRED of the socket, read once when the session is created; empty for sockets
+    //! without credentials.
+    const std::optional<PeerCredentials> &peerCredentials() const noexcept;
+
     //-------------------------------------------------------------------------
     // Send
     //-------------------------------------------------------------------------
@@ -65,6 +97,10 @@ class SocketSession {
         }
     }
 
+    //! Gather send: writes \p buffers back to back without joining them first.
+    std::expected<std::size_t, std::errc>
+    sendv(std::span<const std::span<const std::byte>> buffers) const noexcept;
+
     //-------------------------------------------------------------------------
     // Receive
     //-------------------------------------------------------------------------
@@ -82,22 +118,91 @@ class SocketSession {
         }
     }
 
-    //! Unblocks a blocking receive.
+    //! Unblocks a blocking receive. A receive that is spinning notices it once it parks, at most
+    //! SpinPolicy::spin later.
     bool unblockReceive() const noexcept;
 
+    //! Applies to the following receives; receive() has to be called from one thread at a time.
+    void setSpinPolicy(const SpinPolicy &policy) noexcept;
+    [[nodiscard]] SpinStats spinStats() const noexcept;
+
+    //! With \p enabled, receive() notes when the socket turned readable, which splits the time
+    //! of a receive into waiting for the data and reading it (request tracing). Off by default:
+    //! it costs a clock read per receive.
+    void setReadyTimestamps(bool enabled) noexcept;
+    //! When the last receive found the socket readable; only kept while enabled.
+    [[nodiscard]] std::chrono::steady_clock::time_point readyTime() const noexcept;
+
+    //! Shuts the connection down in both directions (the fd stays open): a send blocked on a
+    //! peer that does not read fails, a receive sees the end of the stream.
+    bool shutdown() const noexcept;
+
+    //-------------------------------------------------------------------------
+    // Zero-copy transfer: data is spliced through \p pipe and never copied into
+    // user space. \p pipe has to be empty and can be reused across calls.
+    //-------------------------------------------------------------------------
+
+    //! Moves up to \p len bytes that already arrived on the session into \p pipe.
+    std::expected<std::size_t, std::errc> receiveInto(utils::Pipe &pipe,
+                                                      std::size_t len) const noexcept;
+
+    //! Sends \p len bytes queued in \p pipe, e.g. filled by receiveInto() of another session.
+    std::expected<std::size_t, std::errc> sendFrom(utils::Pipe &pipe,
+                                                   std::size_t len) const noexcept;
+
+    //! Sends \p len bytes of \p fileFd starting at \p offset; stops early at end of file.
+    std::expected<std::size_t, std::errc> sendFile(int fileFd, loff_t offset, std::size_t len,
+                                                   utils::Pipe &pipe) const noexcept;
+
+    //! Writes the next \p len bytes received on the session to \p fileFd at \p offset.
+    std::expected<std::size_t, std::errc> receiveFile(int fileFd, loff_t offset, std::size_t len,
+                                                      utils::Pipe &pipe) const noexcept;
+
+    //! Forwards the next \p len bytes received on this session to \p peer.
+    std::expected<std::size_t, std::errc> relayTo(const SocketSession &peer, std::size_t len,
+                                                  utils::Pipe &pipe) const noexcept;
+
   private:
     std::expected<std::size_t, std::errc>
     sendImpl(std::span<const std::byte> buffer) const noexcept;
+    std::expected<std::size_t, std::errc>
+    sendAll(std::span<const std::byte> buffer) const noexcept;
+    std::expected<std::size_t, std::errc>
+    sendvAll(std::span<const std::span<const std::byte>> buffers) const noexcept;
 
     std::expected<std::size_t, std::errc>
     receiveImpl(std::span<std::byte> buffer,
                 const CallbackReceive &scanForEnd = defaultOneRead) const noexcept;
+    //! receiveImpl() without its probes.
+    std::expected<std::size_t, std::errc>
+    waitAndReceive(std::span<std::byte> buffer, const CallbackReceive &scanForEnd) const noexcept;
 
     std::expected<std::size_t, std::errc>
     receiveRaw(std::span<std::byte> &buffer, const CallbackReceive &scanForEnd) const noexcept;
 
+    //! True as soon as the socket has data or an error to report, false once the spin budget is
+    //! spent.
+    bool spinUntilReadable(std::chrono::steady_clock::time_point start) const noexcept;
+    std::chrono::nanoseconds spinBudget() const noexcept;
+    void recordArrival(std::chrono::nanoseconds waited) const noexcept;
+
+    // Receive side only, hence mutable: receive() is const but single threaded.
+    struct SpinState {
+        SpinPolicy policy{};
+        //! Moving average of the time a receive waited for its data.
+        std::chrono::nanoseconds averageWait{0};
+        SpinStats stats{};
+    };
+
     utils::FdSet fdSet_;
     Socket socket_;
+    std::optional<PeerCredentials> peer_;
+    mutable SpinState spin_{};
+    struct ReadyStamp {
+        bool enabled{false};
+        std::chrono::steady_clock::time_point at{};
+    };
+    mutable ReadyStamp ready_{};
 };
 
 } // namespace net
@@ -1,18 +1,41 @@
 #ifndef NET_UDS_CLIENT_H
 #define NET_UDS_CLIENT_H
 
+#include <chunk_stream.h>
+#include <cstdint>
 #include <expected>
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <socket_session.h>
+#include <string>
+#include <string_view>
 #include <system_error>
 
 namespace fs = std::filesystem;
 
 namespace net {
 
+//! A streamed response that ran to its end.
+struct StreamResult {
+    uint64_t bytes{0};
+    uint64_t chunks{0};
+    //! The server's message if it ended the stream with an error.
+    std::string error;
+};
+
+//! Receives each chunk of a streamed response; the span is valid during the call only.
+using ChunkCallback = std::function<void(std::span<const std::byte> chunk)>;
+//! Receives an event that arrived while a response was awaited; both views are valid during the
+//! call only.
+using EventCallback =
+    std::function<void(std::string_view topic, std::span<const std::byte> payload)>;
+
 class UdsClient {
   public:
+    //! Chunks in flight per stream unless asked otherwise.
+    static constexpr uint32_t kDefaultStreamWindow = 8;
+
     explicit UdsClient();
 
     UdsClient(const UdsClient &) = delete;
@@ -42,7 +65,25 @@ class UdsClient {
         return session_.receive(buffer, scanForEnd);
     }
 
+    //! Sends "stream <window> <request>" and hands the response to \p onChunk chunk by chunk as
+    //! it arrives, granting the server a new credit for every chunk consumed. At most \p window
+    //! chunks are in flight and one is held, so memory stays constant whatever the size of the
+    //! response (see chunk_stream.h). Events of the connection's subscriptions that arrive ahead
+    //! of the chunks go to \p onEvent, or are skipped without one. Fails on a connection error
+    //! or a malformed frame (bad_message); the connection is unusable then.
+    std::expected<StreamResult, std::errc> stream(std::string_view request,
+                                                  const ChunkCallback &onChunk,
+                                                  uint32_t window = kDefaultStreamWindow,
+                                                  const EventCallback &onEvent = {});
+
+    //! Takes effect for the current connection; connect() on a closed client starts over.
+    void setSpinPolicy(const SpinPolicy &policy) noexcept { session_.setSpinPolicy(policy); }
+
   private:
+    std::expected<void, std::errc> receiveExactly(std::span<std::byte> buffer) const noexcept;
+    std::expected<void, std::errc> grant(uint32_t credits) const noexcept;
+    std::expected<void, std::errc> receiveEvent(const EventCallback &onEvent) const;
+
     SocketSession session_;
     std::optional<fs::path> socket_path_;
 };
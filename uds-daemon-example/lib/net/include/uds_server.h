@@ -22,8 +22,10 @@ class UdsServerError : public std::system_error {
 
 class UdsServer {
   public:
+    static constexpr int defaultBacklog = 5;
+
     UdsServer() = default;
-    explicit UdsServer(const fs::path &socket_path);
+    explicit UdsServer(const fs::path &socket_path, int backlog = defaultBacklog);
     explicit UdsServer(const systemd_socket::SocketInfo &sd_socket_info);
     ~UdsServer();
 
@@ -39,9 +41,22 @@ class UdsServer {
     fs::path SocketPath() const noexcept;
     const Socket &ServerSocket() const noexcept;
 
+    //! Changes the accept queue length of the listening socket; safe while accepting.
+    bool SetBacklog(int backlog) const noexcept;
+
+    //! Makes accept() non-blocking, for a listener shared by several processes: all of them wake
+    //! up for a new connection and the ones that lose the race go back to waiting instead of
+    //! blocking in accept(), where Unblock() could not reach them.
+    bool SetNonBlocking() const noexcept;
+
+    //! Leaves the socket path in place on destruction, e.g. after the listener was handed to a
+    //! successor process. Sockets passed by systemd are never unlinked.
+    void KeepSocketPath() noexcept;
+
   private:
     Socket socket_;
     fs::path socket_path_;
+    bool unlinkOnClose_{false};
     utils::FdSet fdSet_;
 };
 
@@ -0,0 +1,288 @@
+#ifndef WIRE_SCHEMA_H
+#define WIRE_SCHEMA_H
+
+#include <endian_convert.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+//*****************************************************************************
+// Compile-time message layouts.
+//
+// A schema lists its fields in wire order; each field is named by an empty tag
+// type:
+//
+//   struct Name; struct Id; struct Payload;
+//   using Hello = net::wire::Schema<net::wire::FixedString<Name, 10>,
+//                                   net::wire::Scalar<Id, uint32_t>,
+//                                   net::wire::Bytes<Payload>>;
+//
+//   Hello::Encode(sendBuffer, "client", 7, payload);   // straight into the buffer
+//   auto view = Hello::Parse(received);                // bounds checked once
+//   uint32_t id = view->Get<Id>();                     // decoded on access
+//
+// Scalars are big endian (host_to_network). Offsets of fields in front of the
+// first variable-length field are compile-time constants.
+//*****************************************************************************
+
+namespace net::wire {
+
+//! Arithmetic value in network byte order.
+template <typename Tag, EndianConvertible T>
+struct Scalar {
+    using tag = Tag;
+    using value_type = T;
+    static constexpr bool kFixed = true;
+    static constexpr std::size_t kFixedSize = sizeof(T);
+
+    static constexpr bool Fits(value_type) noexcept { return true; }
+    static constexpr std::size_t SizeOf(value_type) noexcept { return sizeof(T); }
+    static std::size_t ExtentAt(const std::byte *) noexcept { return sizeof(T); }
+
+    static void Write(std::byte *out, value_type value) noexcept
+    {
+        const T wire = host_to_network(value);
+        std::memcpy(out, &wire, sizeof(T));
+    }
+
+    static value_type Read(const std::byte *in) noexcept
+    {
+        T wire;
+        std::memcpy(&wire, in, sizeof(T));
+        return network_to_host(wire);
+    }
+};
+
+//! Text in N bytes, NUL padded; reads back up to the first NUL.
+template <typename Tag, std::size_t N>
+struct FixedString {
+    using tag = Tag;
+    using value_type = std::string_view;
+    static constexpr bool kFixed = true;
+    static constexpr std::size_t kFixedSize = N;
+
+    static constexpr bool Fits(value_type value) noexcept { return value.size() <= N; }
+    static constexpr std::size_t SizeOf(value_type) noexcept { return N; }
+    static std::size_t ExtentAt(const std::byte *) noexcept { return N; }
+
+    static void Write(std::byte *out, value_type value) noexcept
+    {
+        if (!value.empty())
+            std::memcpy(out, value.data(), value.size());
+        std::memset(out + value.size(), 0, N - value.size());
+    }
+
+    static value_type Read(const std::byte *in) noexcept
+    {
+        const auto *chars = reinterpret_cast<const char *>(in);
+        return {chars, ::strnlen(chars, N)};
+    }
+};
+
+//! Length-prefixed run of bytes, exposed as \p Value (a span or a string_view).
+template <typename Tag, typename LengthT, typename Value>
+struct LengthPrefixed {
+    static_assert(std::is_unsigned_v<LengthT> && EndianConvertible<LengthT>);
+
+    using tag = Tag;
+    using value_type = Value;
+    static constexpr bool kFixed = false;
+    static constexpr std::size_t kFixedSize = sizeof(LengthT); // the prefix alone
+
+    static constexpr bool Fits(value_type value) noexcept
+    {
+        return value.size() <= std::numeric_limits<LengthT>::max();
+    }
+
+    static constexpr std::size_t SizeOf(value_type value) noexcept
+    {
+        return sizeof(LengthT) + value.size();
+    }
+
+    static std::size_t ExtentAt(const std::byte *in) noexcept
+    {
+        return sizeof(LengthT) + LengthAt(in);
+    }
+
+    static void Write(std::byte *out, value_type value) noexcept
+    {
+        Scalar<Tag, LengthT>::Write(out, static_cast<LengthT>(value.size()));
+        if (!value.empty())
+            std::memcpy(out + sizeof(LengthT), value.data(), value.size());
+    }
+
+    static value_type Read(const std::byte *in) noexcept
+    {
+        const std::size_t length = LengthAt(in);
+        if constexpr (std::is_same_v<Value, std::string_view>)
+            return {reinterpret_cast<const char *>(in + sizeof(LengthT)), length};
+        else
+            return {in + sizeof(LengthT), length};
+    }
+
+  private:
+    static std::size_t LengthAt(const std::byte *in) noexcept
+    {
+        return Scalar<Tag, LengthT>::Read(in);
+    }
+};
+
+template <typename Tag, typename LengthT = uint16_t>
+using Bytes = LengthPrefixed<Tag, LengthT, std::span<const std::byte>>;
+
+template <typename Tag, typename LengthT = uint16_t>
+using Text = LengthPrefixed<Tag, LengthT, std::string_view>;
+
+//*****************************************************************************
+//! \brief Schema
+//! Encoder and lazy view for one message layout. Encode() writes the fields
+//! directly into the caller's buffer without an intermediate struct; Parse()
+//! checks once that every field lies within the received bytes and returns a
+//! View that decodes a field each time it is asked for it.
+template <typename... Fields>
+class Schema {
+    static_assert(sizeof...(Fields) > 0, "a schema needs at least one field");
+
+    template <std::size_t I>
+    using FieldAt = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    template <typename Tag>
+    static consteval std::size_t FindTag()
+    {
+        constexpr std::array<bool, sizeof...(Fields)> matches{
+            std::is_same_v<Tag, typename Fields::tag>...};
+        std::size_t index = sizeof...(Fields);
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            if (matches[i]) {
+                index = i;
+                ++count;
+            }
+        }
+        return count == 1 ? index : sizeof...(Fields);
+    }
+
+  public:
+    static constexpr std::size_t kFieldCount = sizeof...(Fields);
+    //! True if every message of this schema has the same size, kMinSize.
+    static constexpr bool kFixedSize = (Fields::kFixed && ...);
+    static constexpr std::size_t kMinSize = (Fields::kFixedSize + ...);
+
+    template <typename Tag>
+    static constexpr std::size_t IndexOf = FindTag<Tag>();
+
+    static constexpr std::size_t EncodedSize(const typename Fields::value_type &...values) noexcept
+    {
+        return (Fields::SizeOf(values) + ...);
+    }
+
+    //! Writes one message to the front of \p out; returns the number of bytes written.
+    //! Fails with value_too_large if a field value does not fit its field and with
+    //! no_buffer_space if \p out is too small.
+    static std::expected<std::size_t, std::errc>
+    Encode(std::span<std::byte> out, const typename Fields::value_type &...values) noexcept
+    {
+        if (!(Fields::Fits(values) && ...))
+            return std::unexpected(std::errc::value_too_large);
+
+        const std::size_t size = EncodedSize(values...);
+        if (size > out.size())
+            return std::unexpected(std::errc::no_buffer_space);
+
+        std::byte *pos = out.data();
+        ((Fields::Write(pos, values), pos += Fields::SizeOf(values)), ...);
+        return size;
+    }
+
+    //! Appends one message to \p out.
+    static std::expected<std::size_t, std::errc>
+    Append(std::vector<std::byte> &out, const typename Fields::value_type &...values)
+    {
+        const std::size_t start = out.size();
+        out.resize(start + EncodedSize(values...));
+        auto written = Encode(std::span(out).subspan(start), values...);
+        if (!written)
+            out.resize(start);
+        return written;
+    }
+
+    class View {
+      public:
+        //! Decodes the field named \p Tag.
+        template <typename Tag>
+        [[nodiscard]] auto Get() const noexcept
+        {
+            constexpr std::size_t index = IndexOf<Tag>;
+            static_assert(index < kFieldCount, "tag names no (or more than one) field");
+            return FieldAt<index>::Read(data_.data() + OffsetOf<index>());
+        }
+
+        //! Bytes of this message; trailing input after it is not included.
+        [[nodiscard]] std::span<const std::byte> Raw() const noexcept { return data_; }
+        [[nodiscard]] std::size_t Size() const noexcept { return data_.size(); }
+
+      private:
+        friend class Schema;
+
+        explicit View(std::span<const std::byte> data) noexcept
+         : data_(data)
+        {
+        }
+
+        // Fixed-size predecessors fold into a constant; after a variable-length field the
+        // offset is found by following the (already validated) length prefixes.
+        template <std::size_t I>
+        std::size_t OffsetOf() const noexcept
+        {
+            if constexpr (I == 0) {
+                return 0;
+            } else if constexpr (FieldAt<I - 1>::kFixed) {
+                return OffsetOf<I - 1>() + FieldAt<I - 1>::kFixedSize;
+            } else {
+                const std::size_t previous = OffsetOf<I - 1>();
+                return previous + FieldAt<I - 1>::ExtentAt(data_.data() + previous);
+            }
+        }
+
+        std::span<const std::byte> data_;
+    };
+
+    //! Validates the layout of the message at the front of \p in; fails with bad_message if
+    //! it is truncated. Bytes after the message are ignored, see View::Size().
+    static std::expected<View, std::errc> Parse(std::span<const std::byte> in) noexcept
+    {
+        if (in.size() < kMinSize)
+            return std::unexpected(std::errc::bad_message);
+
+        if constexpr (kFixedSize) {
+            return View(in.first(kMinSize));
+        } else {
+            std::size_t offset = 0;
+            // Each prefix is read only after checking it lies within the input.
+            const auto advance = [&offset, in]<typename Field>() noexcept {
+                if (offset + Field::kFixedSize > in.size())
+                    return false;
+                offset += Field::ExtentAt(in.data() + offset);
+                return offset <= in.size();
+            };
+            const bool complete = (advance.template operator()<Fields>() && ...);
+            if (!complete)
+                return std::unexpected(std::errc::bad_message);
+            return View(in.first(offset));
+        }
+    }
+};
+
+} // namespace net::wire
+
+#endif // WIRE_SCHEMA_H
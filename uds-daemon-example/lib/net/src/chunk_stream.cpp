@@ -0,0 +1,141 @@
+#include "chunk_stream.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace net {
+
+std::optional<StreamRequest> ParseStreamRequest(std::string_view request) noexcept
+{
+    if (!request.starts_with(kStreamPrefix))
+        return std::nullopt;
+    request.remove_prefix(kStreamPrefix.size());
+
+    const auto space = request.find(' ');
+    const std::string_view credits = request.substr(0, space);
+    StreamRequest stream;
+    if (space != std::string_view::npos)
+        stream.request = request.substr(space + 1);
+    const auto [end, ec] =
+        std::from_chars(credits.data(), credits.data() + credits.size(), stream.credits);
+    if (ec != std::errc{} || end != credits.data() + credits.size())
+        stream.credits = 0;
+    return stream;
+}
+
+ChunkWriter::ChunkWriter(const SocketSession &session, uint32_t credits,
+                         const std::atomic<bool> &running, std::size_t chunkSize)
+ : session_(session)
+ , running_(running)
+ , chunkSize_(std::clamp<std::size_t>(chunkSize, 1, kMaxChunkSize))
+ , credits_(credits)
+{
+    pending_.reserve(chunkSize_);
+}
+
+bool ChunkWriter::Write(std::span<const std::byte> data)
+{
+    while (state_ == EState::OPEN && !data.empty()) {
+        if (pending_.empty() && data.size() >= chunkSize_) {
+            // Whole chunks need no copy.
+            if (!SendChunk(data.first(chunkSize_), 0))
+                return false;
+            data = data.subspan(chunkSize_);
+            continue;
+        }
+        const auto take = std::min(chunkSize_ - pending_.size(), data.size());
+        const auto taken = data.first(take);
+        pending_.insert(pending_.end(), taken.begin(), taken.end());
+        data = data.subspan(take);
+        if (pending_.size() == chunkSize_) {
+            if (!SendChunk(pending_, 0))
+                return false;
+            pending_.clear();
+        }
+    }
+    return state_ == EState::OPEN;
+}
+
+bool ChunkWriter::Finish()
+{
+    if (state_ != EState::OPEN)
+        return false;
+    return End(pending_, kChunkLast);
+}
+
+bool ChunkWriter::Fail(std::string_view message)
+{
+    if (state_ != EState::OPEN)
+        return false;
+    return End(std::as_bytes(std::span(message)), kChunkLast | kChunkError);
+}
+
+bool ChunkWriter::End(std::span<const std::byte> payload, uint32_t flags)
+{
+    if (!SendChunk(payload, flags))
+        return false;
+    pending_.clear();
+    // Grants the client sent before it saw the last chunk are still on their way.
+    while (!closed_) {
+        if (!ReceiveGrant()) {
+            state_ = EState::BROKEN;
+            return false;
+        }
+    }
+    state_ = EState::ENDED;
+    return true;
+}
+
+bool ChunkWriter::SendChunk(std::span<const std::byte> payload, uint32_t flags)
+{
+    // An error ends a stream the client may not have granted anything for.
+    const bool needsCredit = (flags & kChunkError) == 0;
+    while (needsCredit && credits_ == 0 && running_.load(std::memory_order_relaxed)) {
+        if (!ReceiveGrant() || closed_) {
+            state_ = EState::BROKEN;
+            return false;
+        }
+    }
+    if (!running_.load(std::memory_order_relaxed)) {
+        state_ = EState::BROKEN;
+        return false;
+    }
+
+    std::array<std::byte, ChunkHeader::kMinSize> header;
+    ChunkHeader::Encode(header, kChunkMarker, static_cast<uint32_t>(payload.size()), flags);
+    const std::array<std::span<const std::byte>, 2> pieces{std::span<const std::byte>(header),
+                                                           payload};
+    if (!session_.sendv(pieces)) {
+        state_ = EState::BROKEN;
+        return false;
+    }
+    if (needsCredit)
+        --credits_;
+    if ((flags & kChunkError) == 0) {
+        bytes_ += payload.size();
+        ++chunks_;
+    }
+    return true;
+}
+
+bool ChunkWriter::ReceiveGrant()
+{
+    auto got = session_.receive(std::span(grant_).subspan(grantBytes_));
+    if (!got) {
+        // Publishers wake the receive as well; their events go out after the stream.
+        return got.error() == std::errc::operation_canceled &&
+               running_.load(std::memory_order_relaxed);
+    }
+    grantBytes_ += *got;
+    if (grantBytes_ < grant_.size())
+        return true;
+
+    grantBytes_ = 0;
+    const uint32_t credits = CreditGrant::Parse(grant_)->Get<stream::Credits>();
+    if (credits == 0)
+        closed_ = true;
+    credits_ += credits;
+    return true;
+}
+
+} // namespace net
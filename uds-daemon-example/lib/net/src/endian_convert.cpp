@@ -0,0 +1,212 @@
+#include "endian_convert.h"
+
+#include <array>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace net::detail {
+
+namespace {
+
+using Kernel = void (*)(const std::byte *in, std::byte *out, std::size_t count) noexcept;
+
+struct Kernels {
+    Kernel swap16;
+    Kernel swap32;
+    Kernel swap64;
+};
+
+//*****************************
+// Element-wise fallback, also used for the tails the vector loops leave behind.
+template <typename Bits>
+void swapScalar(const std::byte *in, std::byte *out, std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        Bits value;
+        std::memcpy(&value, in + i * sizeof(Bits), sizeof(Bits));
+        value = host_to_network(value);
+        std::memcpy(out + i * sizeof(Bits), &value, sizeof(Bits));
+    }
+}
+
+constexpr Kernels kScalar{swapScalar<uint16_t>, swapScalar<uint32_t>, swapScalar<uint64_t>};
+
+template <std::size_t Width>
+using BitsFor = std::conditional_t<Width == 2, uint16_t,
+                                   std::conditional_t<Width == 4, uint32_t, uint64_t>>;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// pshufb control reversing each Width-byte group of a 16-byte lane.
+template <std::size_t Width>
+constexpr std::array<char, 16> kShuffle = [] {
+    std::array<char, 16> mask{};
+    for (std::size_t i = 0; i < mask.size(); ++i)
+        mask[i] = static_cast<char>((i / Width) * Width + (Width - 1 - i % Width));
+    return mask;
+}();
+
+template <std::size_t Width>
+__attribute__((target("ssse3"))) void swapSsse3(const std::byte *in, std::byte *out,
+                                                std::size_t count) noexcept
+{
+    const auto *control = reinterpret_cast<const __m128i *>(kShuffle<Width>.data());
+    const __m128i mask = _mm_loadu_si128(control);
+    constexpr std::size_t kPerVector = 16 / Width;
+
+    std::size_t i = 0;
+    for (; i + kPerVector <= count; i += kPerVector) {
+        const auto *src = reinterpret_cast<const __m128i *>(in + i * Width);
+        auto *dst = reinterpret_cast<__m128i *>(out + i * Width);
+        _mm_storeu_si128(dst, _mm_shuffle_epi8(_mm_loadu_si128(src), mask));
+    }
+    swapScalar<BitsFor<Width>>(in + i * Width, out + i * Width, count - i);
+}
+
+template <std::size_t Width>
+__attribute__((target("avx2"))) void swapAvx2(const std::byte *in, std::byte *out,
+                                              std::size_t count) noexcept
+{
+    // vpshufb works per 128-bit lane, so the same 16-byte control is used for both halves.
+    const auto *control = reinterpret_cast<const __m128i *>(kShuffle<Width>.data());
+    const __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128(control));
+    constexpr std::size_t kPerVector = 32 / Width;
+
+    std::size_t i = 0;
+    for (; i + 2 * kPerVector <= count; i += 2 * kPerVector) {
+        const auto *src = reinterpret_cast<const __m256i *>(in + i * Width);
+        auto *dst = reinterpret_cast<__m256i *>(out + i * Width);
+        const __m256i a = _mm256_loadu_si256(src);
+        const __m256i b = _mm256_loadu_si256(src + 1);
+        _mm256_storeu_si256(dst, _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256(dst + 1, _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + kPerVector <= count; i += kPerVector) {
+        const auto *src = reinterpret_cast<const __m256i *>(in + i * Width);
+        auto *dst = reinterpret_cast<__m256i *>(out + i * Width);
+        _mm256_storeu_si256(dst, _mm256_shuffle_epi8(_mm256_loadu_si256(src), mask));
+    }
+    swapSsse3<Width>(in + i * Width, out + i * Width, count - i);
+}
+
+constexpr Kernels kSsse3{swapSsse3<2>, swapSsse3<4>, swapSsse3<8>};
+constexpr Kernels kAvx2{swapAvx2<2>, swapAvx2<4>, swapAvx2<8>};
+
+#elif defined(__aarch64__)
+
+template <std::size_t Width>
+void swapNeon(const std::byte *in, std::byte *out, std::size_t count) noexcept
+{
+    constexpr std::size_t kPerVector = 16 / Width;
+
+    std::size_t i = 0;
+    for (; i + kPerVector <= count; i += kPerVector) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(in + i * Width));
+        uint8x16_t r;
+        if constexpr (Width == 2)
+            r = vrev16q_u8(v);
+        else if constexpr (Width == 4)
+            r = vrev32q_u8(v);
+        else
+            r = vrev64q_u8(v);
+        vst1q_u8(reinterpret_cast<uint8_t *>(out + i * Width), r);
+    }
+    swapScalar<BitsFor<Width>>(in + i * Width, out + i * Width, count - i);
+}
+
+constexpr Kernels kNeon{swapNeon<2>, swapNeon<4>, swapNeon<8>};
+
+#endif
+
+const Kernels &kernelsFor(SwapIsa isa) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (isa == SwapIsa::Avx2)
+        return kAvx2;
+    if (isa == SwapIsa::Ssse3)
+        return kSsse3;
+#elif defined(__aarch64__)
+    if (isa == SwapIsa::Neon)
+        return kNeon;
+#endif
+    return kScalar;
+}
+
+SwapIsa selectIsa() noexcept
+{
+    for (SwapIsa isa : {SwapIsa::Avx2, SwapIsa::Ssse3, SwapIsa::Neon}) {
+        if (SwapIsaSupported(isa))
+            return isa;
+    }
+    return SwapIsa::Scalar;
+}
+
+} // namespace
+
+bool SwapIsaSupported(SwapIsa isa) noexcept
+{
+    if (isa == SwapIsa::Scalar)
+        return true;
+#if defined(__x86_64__) || defined(__i386__)
+    if (isa == SwapIsa::Avx2)
+        return __builtin_cpu_supports("avx2");
+    if (isa == SwapIsa::Ssse3)
+        return __builtin_cpu_supports("ssse3");
+#elif defined(__aarch64__)
+    if (isa == SwapIsa::Neon)
+        return true; // mandatory in AArch64
+#endif
+    return false;
+}
+
+SwapIsa ActiveSwapIsa() noexcept
+{
+    static const SwapIsa active = selectIsa();
+    return active;
+}
+
+const char *SwapIsaName(SwapIsa isa) noexcept
+{
+    switch (isa) {
+    case SwapIsa::Ssse3:
+        return "ssse3";
+    case SwapIsa::Avx2:
+        return "avx2";
+    case SwapIsa::Neon:
+        return "neon";
+    case SwapIsa::Scalar:
+    default:
+        break;
+    }
+    return "scalar";
+}
+
+void SwapBytes(SwapIsa isa, const std::byte *in, std::byte *out, std::size_t count,
+               std::size_t width) noexcept
+{
+    const Kernels &kernels = kernelsFor(isa);
+    switch (width) {
+    case 2:
+        kernels.swap16(in, out, count);
+        break;
+    case 4:
+        kernels.swap32(in, out, count);
+        break;
+    case 8:
+        kernels.swap64(in, out, count);
+        break;
+    default:
+        break;
+    }
+}
+
+void SwapBytes(const std::byte *in, std::byte *out, std::size_t count, std::size_t width) noexcept
+{
+    SwapBytes(ActiveSwapIsa(), in, out, count, width);
+}
+
+} // namespace net::detail
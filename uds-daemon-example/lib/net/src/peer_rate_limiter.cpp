@@ -0,0 +1,70 @@
+#include "peer_rate_limiter.h"
+
+#include <algorithm>
+
+namespace net {
+
+PeerRateLimiter::PeerRateLimiter(const PeerLimits &limits)
+ : limits_(limits)
+{
+}
+
+void PeerRateLimiter::Reconfigure(const PeerLimits &limits)
+{
+    std::lock_guard lock(mutex_);
+    limits_ = limits;
+    for (auto &[uid, account] : accounts_)
+        Apply(*account);
+}
+
+std::shared_ptr<PeerRateLimiter::Account> PeerRateLimiter::AccountOf(uid_t uid)
+{
+    std::lock_guard lock(mutex_);
+    auto &account = accounts_[uid];
+    if (!account) {
+        account = std::make_shared<Account>(uid);
+        Apply(*account);
+    }
+    return account;
+}
+
+PeerRateLimiter::Clock::duration PeerRateLimiter::Admit(Account &account,
+                                                        utils::TokenBucket &session,
+                                                        Clock::time_point now) noexcept
+{
+    // Both reservations are kept even if only one bucket is behind: the request is served once,
+    // after the longer wait, and counts against both shares.
+    const auto wait = std::max(session.Reserve(now), account.bucket_.Reserve(now));
+
+    account.requests_.fetch_add(1, std::memory_order_relaxed);
+    if (wait > Clock::duration::zero()) {
+        account.throttled_.fetch_add(1, std::memory_order_relaxed);
+        account.delayedNs_.fetch_add(std::chrono::nanoseconds(wait).count(),
+                                     std::memory_order_relaxed);
+    }
+    return wait;
+}
+
+std::vector<ThrottleStats> PeerRateLimiter::Stats() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<ThrottleStats> stats;
+    stats.reserve(accounts_.size());
+    for (const auto &[uid, account] : accounts_) {
+        stats.push_back(ThrottleStats{
+            .uid = uid,
+            .requests = account->requests_.load(std::memory_order_relaxed),
+            .throttled = account->throttled_.load(std::memory_order_relaxed),
+            .delayed = std::chrono::nanoseconds(
+                account->delayedNs_.load(std::memory_order_relaxed))});
+    }
+    return stats;
+}
+
+void PeerRateLimiter::Apply(Account &account) const noexcept
+{
+    const double weight = limits_.WeightOf(account.uid_);
+    account.bucket_.Reconfigure(limits_.uidRate * weight, limits_.uidBurst * weight);
+}
+
+} // namespace net
@@ -0,0 +1,190 @@
+#include "pubsub.h"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace net {
+
+//*****************************************************************************
+// Subscriber
+//*****************************************************************************
+
+Subscriber::Subscriber(const SubscriberOptions &options, Notify notify)
+ : options_(options)
+ , notify_(std::move(notify))
+{
+}
+
+std::size_t Subscriber::Drain(std::vector<SharedBuffer> &out, std::size_t max)
+{
+    std::lock_guard lock(mutex_);
+    const std::size_t n = std::min(max, queue_.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        out.push_back(std::move(queue_.front().message));
+        queue_.pop_front();
+    }
+    return n;
+}
+
+bool Subscriber::Closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+std::size_t Subscriber::Queued() const
+{
+    std::lock_guard lock(mutex_);
+    return queue_.size();
+}
+
+SubscriberStats Subscriber::Stats() const
+{
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+bool Subscriber::Enqueue(uint64_t topic, const SharedBuffer &message)
+{
+    bool wasEmpty;
+    {
+        std::lock_guard lock(mutex_);
+        if (Closed())
+            return false;
+
+        if (queue_.size() >= options_.maxQueued) {
+            switch (options_.policy) {
+            case SlowSubscriberPolicy::Disconnect:
+                closed_.store(true, std::memory_order_release);
+                queue_.clear();
+                break;
+            case SlowSubscriberPolicy::Conflate: {
+                // Newest value wins, in the place of the one it supersedes.
+                auto same = std::ranges::find(queue_, topic, &Entry::topic);
+                if (same != queue_.end()) {
+                    same->message = message;
+                    ++stats_.conflated;
+                    return true;
+                }
+                queue_.pop_front();
+                ++stats_.dropped;
+                break;
+            }
+            case SlowSubscriberPolicy::DropOldest:
+            default:
+                queue_.pop_front();
+                ++stats_.dropped;
+                break;
+            }
+        }
+
+        if (!Closed()) {
+            wasEmpty = queue_.empty();
+            queue_.push_back(Entry{.topic = topic, .message = message});
+            ++stats_.queued;
+        } else {
+            wasEmpty = true;
+        }
+    }
+
+    // Outside the lock: the consumer may drain right away.
+    if (wasEmpty && notify_)
+        notify_();
+    return !Closed();
+}
+
+//*****************************************************************************
+// Broker
+//*****************************************************************************
+
+void Broker::Subscribe(const std::shared_ptr<Subscriber> &subscriber, std::string_view topic)
+{
+    std::unique_lock lock(mutex_);
+    auto it = topics_.find(topic);
+    if (it == topics_.end())
+        it = topics_.emplace(std::string(topic), Topic{.id = nextTopicId_++, .subscribers = {}})
+                 .first;
+
+    auto &subscribers = it->second.subscribers;
+    if (std::ranges::find(subscribers, subscriber) == subscribers.end())
+        subscribers.push_back(subscriber);
+}
+
+bool Broker::Unsubscribe(const Subscriber &subscriber, std::string_view topic)
+{
+    std::unique_lock lock(mutex_);
+    auto it = topics_.find(topic);
+    if (it == topics_.end())
+        return false;
+
+    auto &subscribers = it->second.subscribers;
+    const auto erased = std::erase_if(
+        subscribers, [&subscriber](const auto &s) { return s.get() == &subscriber; });
+    if (subscribers.empty())
+        topics_.erase(it);
+    return erased > 0;
+}
+
+void Broker::Remove(const Subscriber &subscriber)
+{
+    std::unique_lock lock(mutex_);
+    RemoveLocked(subscriber);
+}
+
+void Broker::RemoveLocked(const Subscriber &subscriber)
+{
+    for (auto it = topics_.begin(); it != topics_.end();) {
+        auto &subscribers = it->second.subscribers;
+        std::erase_if(subscribers, [&subscriber](const auto &s) { return s.get() == &subscriber; });
+        it = subscribers.empty() ? topics_.erase(it) : std::next(it);
+    }
+}
+
+std::size_t Broker::Publish(std::string_view topic, std::span<const std::byte> payload)
+{
+    SharedBuffer message;
+    std::vector<const Subscriber *> closed;
+    std::size_t queued = 0;
+    {
+        std::shared_lock lock(mutex_);
+        const auto it = topics_.find(topic);
+        if (it == topics_.end())
+            return 0;
+
+        // Serialized once, after we know someone listens.
+        message = Serialize(topic, payload);
+        for (const auto &subscriber : it->second.subscribers) {
+            if (subscriber->Enqueue(it->second.id, message))
+                ++queued;
+            else
+                closed.push_back(subscriber.get());
+        }
+    }
+
+    if (!closed.empty()) {
+        std::unique_lock lock(mutex_);
+        for (const auto *subscriber : closed) {
+            spdlog::warn("Dropping slow subscriber of '{}'", topic);
+            RemoveLocked(*subscriber);
+        }
+    }
+    return queued;
+}
+
+std::size_t Broker::Publish(std::string_view topic, std::string_view payload)
+{
+    return Publish(topic, std::as_bytes(std::span(payload)));
+}
+
+std::size_t Broker::Subscribers(std::string_view topic) const
+{
+    std::shared_lock lock(mutex_);
+    const auto it = topics_.find(topic);
+    return it == topics_.end() ? 0 : it->second.subscribers.size();
+}
+
+SharedBuffer Broker::Serialize(std::string_view topic, std::span<const std::byte> payload)
+{
+    auto buffer = std::make_shared<std::vector<std::byte>>();
+    if (!EventFrame::Append(*buffer, kEventMarker, topic, payload))
+        throw std::length_error("event topic or payload too large");
+    return buffer;
+}
+
+} // namespace net
@@ -1,5 +1,7 @@
 #include "socket_session.h"
 
+#include <array>
+#include <sched.h>
 #include <iostream>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
@@ -8,9 +10,33 @@
 #include <unistd.h>
 
 #include <errormsg.h>
+#include <hot_log.h>
+#include <usdt.h>
 
 namespace net {
 
+namespace {
+
+// Probe argument for a transfer: the bytes moved, or the negated error code.
+int64_t probeResult(const std::expected<std::size_t, std::errc> &result) noexcept
+{
+    return result ? static_cast<int64_t>(*result) : -static_cast<int64_t>(result.error());
+}
+
+// Per-message info lines: enough to follow a few sessions, bounded under load.
+constexpr double kMessageLogRate = 100;
+
+std::optional<PeerCredentials> readPeerCredentials(int fd) noexcept
+{
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (fd < 0 || ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0)
+        return std::nullopt;
+    return PeerCredentials{.pid = cred.pid, .uid = cred.uid, .gid = cred.gid};
+}
+
+} // namespace
+
 SocketSession::SocketSession() noexcept
  : socket_(-1)
 {
@@ -18,6 +44,7 @@ SocketSession::SocketSession() noexcept
 
 SocketSession::SocketSession(int socketFd) noexcept
  : socket_(socketFd)
+ , peer_(readPeerCredentials(socketFd))
 {
     if (socketFd >= 0)
         fdSet_.AddFd(socketFd);
@@ -25,6 +52,7 @@ SocketSession::SocketSession(int socketFd) noexcept
 
 SocketSession::SocketSession(Socket &&socket) noexcept
  : socket_(std::move(socket))
+ , peer_(readPeerCredentials(socket_.getFd()))
 {
     if (socket_.isValid())
         fdSet_.AddFd(socket_.getFd());
@@ -33,6 +61,9 @@ SocketSession::SocketSession(Socket &&socket) noexcept
 SocketSession::SocketSession(SocketSession &&rhs) noexcept
  : fdSet_(std::move(rhs.fdSet_))
  , socket_(std::move(rhs.socket_))
+ , peer_(std::move(rhs.peer_))
+ , spin_(rhs.spin_)
+ , ready_(rhs.ready_)
 {
 }
 
@@ -41,6 +72,9 @@ SocketSession &SocketSession::operator=(SocketSession &&rhs) noexcept
     if (this != &rhs) {
         fdSet_ = std::move(rhs.fdSet_);
         socket_ = std::move(rhs.socket_);
+        peer_ = std::move(rhs.peer_);
+        spin_ = rhs.spin_;
+        ready_ = rhs.ready_;
     }
     return *this;
 }
@@ -56,18 +90,33 @@ bool SocketSession::isValid() const noexcept { return socket_.isValid(); }
 
 int SocketSession::getFd() const noexcept { return socket_.getFd(); }
 
+const std::optional<PeerCredentials> &SocketSession::peerCredentials() const noexcept
+{
+    return peer_;
+}
+
 //*****************************************************************************
 // Send
 //*****************************************************************************
 
 std::expected<std::size_t, std::errc>
 SocketSession::sendImpl(std::span<const std::byte> buffer) const noexcept
+{
+    auto result = sendAll(buffer);
+    UDS_PROBE(send, socket_.getFd(), probeResult(result), 1);
+    return result;
+}
+
+std::expected<std::size_t, std::errc>
+SocketSession::sendAll(std::span<const std::byte> buffer) const noexcept
 {
     std::size_t dataWritten = 0;
     const int fd = socket_.getFd();
 
     while (dataWritten < buffer.size_bytes()) {
-        ssize_t put = ::send(fd, buffer.data() + dataWritten, buffer.size_bytes() - dataWritten, 0);
+        // A peer that went away is reported as EPIPE, not by a process-killing SIGPIPE.
+        ssize_t put = ::send(fd, buffer.data() + dataWritten, buffer.size_bytes() - dataWritten,
+                             MSG_NOSIGNAL);
 
         if (put < 0) {
             std::error_code ec(errno, std::generic_category());
@@ -92,16 +141,151 @@ SocketSession::sendImpl(std::span<const std::byte> buffer) const noexcept
     return dataWritten;
 }
 
+std::expected<std::size_t, std::errc>
+SocketSession::sendv(std::span<const std::span<const std::byte>> buffers) const noexcept
+{
+    auto result = sendvAll(buffers);
+    UDS_PROBE(send, socket_.getFd(), probeResult(result), buffers.size());
+    return result;
+}
+
+std::expected<std::size_t, std::errc>
+SocketSession::sendvAll(std::span<const std::span<const std::byte>> buffers) const noexcept
+{
+    // Up to 64 pieces per sendmsg(); a partial write resumes inside a piece.
+    std::array<iovec, 64> iov;
+    std::size_t dataWritten = 0;
+    std::size_t next = 0;
+    std::size_t skip = 0;
+    const int fd = socket_.getFd();
+
+    while (next < buffers.size()) {
+        std::size_t count = 0;
+        for (std::size_t i = next; i < buffers.size() && count < iov.size(); ++i, ++count) {
+            const std::size_t offset = i == next ? skip : 0;
+            iov[count].iov_base = const_cast<std::byte *>(buffers[i].data() + offset);
+            iov[count].iov_len = buffers[i].size() - offset;
+        }
+
+        msghdr msg{};
+        msg.msg_iov = iov.data();
+        msg.msg_iovlen = count;
+        ssize_t put = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+
+        if (put < 0) {
+            std::error_code ec(errno, std::generic_category());
+
+            if (ec == std::errc::interrupted)
+                continue;
+            if (ec == std::errc::operation_would_block) {
+                spdlog::debug("SocketSession::sendv: would block");
+                return std::unexpected(std::errc::operation_would_block);
+            }
+
+            spdlog::warn("SocketSession::sendv: sendmsg() failed: {}", ec.message());
+            return std::unexpected(std::errc::io_error);
+        }
+
+        auto remaining = static_cast<std::size_t>(put);
+        dataWritten += remaining;
+        while (next < buffers.size() && remaining >= buffers[next].size() - skip) {
+            remaining -= buffers[next].size() - skip;
+            skip = 0;
+            ++next;
+        }
+        skip += remaining;
+    }
+
+    return dataWritten;
+}
+
 bool SocketSession::unblockReceive() const noexcept { return fdSet_.UnBlock(); }
 
+void SocketSession::setSpinPolicy(const SpinPolicy &policy) noexcept { spin_.policy = policy; }
+
+SpinStats SocketSession::spinStats() const noexcept { return spin_.stats; }
+
+void SocketSession::setReadyTimestamps(bool enabled) noexcept { ready_.enabled = enabled; }
+
+std::chrono::steady_clock::time_point SocketSession::readyTime() const noexcept
+{
+    return ready_.at;
+}
+
+bool SocketSession::spinUntilReadable(std::chrono::steady_clock::time_point start) const noexcept
+{
+    const auto budget = spinBudget();
+    if (budget <= std::chrono::nanoseconds::zero())
+        return false;
+
+    const int fd = socket_.getFd();
+    const auto deadline = start + budget;
+    char probe;
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        // Data, end of stream or an error: receiveRaw() takes it from here.
+        if (::recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT) >= 0 ||
+            (errno != EAGAIN && errno != EINTR)) {
+            ++spin_.stats.spinHits;
+            recordArrival(now - start);
+            if (ready_.enabled)
+                ready_.at = now;
+            return true;
+        }
+        if (now >= deadline)
+            return false;
+        // Lets the peer run if it shares this cpu; a no-op when nothing else is runnable.
+        ::sched_yield();
+    }
+}
+
+std::chrono::nanoseconds SocketSession::spinBudget() const noexcept
+{
+    const std::chrono::nanoseconds limit = spin_.policy.spin;
+    if (!spin_.policy.adaptive || spin_.averageWait == std::chrono::nanoseconds::zero())
+        return limit;
+
+    // Messages that come further apart than the limit would be missed anyway: park at once and
+    // leave the core to others. The parked waits keep the average current, so spinning resumes
+    // when traffic picks up.
+    const auto expected = 2 * spin_.averageWait;
+    return expected > limit ? std::chrono::nanoseconds::zero() : expected;
+}
+
+void SocketSession::recordArrival(std::chrono::nanoseconds waited) const noexcept
+{
+    // Exponential moving average over roughly the last eight messages.
+    spin_.averageWait += (waited - spin_.averageWait) / 8;
+    if (spin_.averageWait <= std::chrono::nanoseconds::zero())
+        spin_.averageWait = std::chrono::nanoseconds(1);
+}
+
+bool SocketSession::shutdown() const noexcept { return ::shutdown(getFd(), SHUT_RDWR) == 0; }
+
 std::expected<std::size_t, std::errc>
 SocketSession::receiveImpl(std::span<std::byte> buffer,
                            const CallbackReceive &scanForEnd) const noexcept
+{
+    UDS_PROBE(receive_start, socket_.getFd(), buffer.size());
+    auto result = waitAndReceive(buffer, scanForEnd);
+    UDS_PROBE(receive_end, socket_.getFd(), probeResult(result));
+    return result;
+}
+
+std::expected<std::size_t, std::errc>
+SocketSession::waitAndReceive(std::span<std::byte> buffer,
+                              const CallbackReceive &scanForEnd) const noexcept
 {
     const int fd = socket_.getFd();
+    const bool spinning = spin_.policy.spin > std::chrono::microseconds::zero();
+    const auto start = spinning ? std::chrono::steady_clock::now()
+                                : std::chrono::steady_clock::time_point{};
+    if (spinning && spinUntilReadable(start))
+        return receiveRaw(buffer, scanForEnd);
+
     utils::FdSetRet ret = fdSet_.Select([&fd](int readyFd) {
         if (readyFd == fd) {
-            spdlog::debug("fd {} is readable", readyFd);
+            HOT_LOG(spdlog::level::debug, "fd {} is readable", readyFd);
         } else {
             spdlog::warn("SocketSession::receive: unexpected fd {} signaled, expected {}", readyFd,
                          fd);
@@ -114,6 +298,15 @@ SocketSession::receiveImpl(std::span<std::byte> buffer,
     case utils::FdSetRet::TIMEOUT:
         return std::unexpected(std::errc::timed_out);
     case utils::FdSetRet::OK: {
+        if (spinning || ready_.enabled) {
+            const auto now = std::chrono::steady_clock::now();
+            if (spinning) {
+                ++spin_.stats.parks;
+                recordArrival(now - start);
+            }
+            if (ready_.enabled)
+                ready_.at = now;
+        }
         auto result = receiveRaw(buffer, scanForEnd);
         if (!result.has_value()) {
             spdlog::warn("SocketSession::receiveRaw failed: {}",
@@ -139,7 +332,7 @@ SocketSession::receiveRaw(std::span<std::byte> &buffer,
     auto *readBuffer = buffer.data();
     int fd = socket_.getFd();
 
-    spdlog::debug("SocketSession::receiveRaw: starting receive on fd {}", fd);
+    HOT_LOG(spdlog::level::debug, "SocketSession::receiveRaw: starting receive on fd {}", fd);
 
     {
         char probe;
@@ -191,17 +384,70 @@ SocketSession::receiveRaw(std::span<std::byte> &buffer,
         }
 
         dataRead += static_cast<std::size_t>(got);
-        spdlog::debug("SocketSession::receiveRaw: read {} bytes (total {})", got, dataRead);
+        HOT_LOG(spdlog::level::debug, "SocketSession::receiveRaw: read {} bytes (total {})", got,
+                dataRead);
 
         if (scanForEnd(std::span(readBuffer, dataRead))) {
-            spdlog::debug("SocketSession::receiveRaw: scanForEnd triggered stop condition");
+            HOT_LOG(spdlog::level::debug,
+                    "SocketSession::receiveRaw: scanForEnd triggered stop condition");
             break;
         }
     }
 
     buffer = std::span(readBuffer, dataRead);
-    spdlog::info("SocketSession::receiveRaw: finished reading {} bytes", dataRead);
+    HOT_LOG_RATE_LIMITED(spdlog::level::info, kMessageLogRate, kMessageLogRate,
+                         "SocketSession::receiveRaw: finished reading {} bytes", dataRead);
     return dataRead;
 }
 
+//*****************************************************************************
+// Zero-copy transfer
+//*****************************************************************************
+
+namespace {
+
+std::expected<std::size_t, std::errc> toErrc(std::string_view what,
+                                             std::expected<std::size_t, std::error_code> result)
+{
+    if (result)
+        return *result;
+    spdlog::warn("SocketSession::{}: splice failed: {}", what, result.error().message());
+    return std::unexpected(static_cast<std::errc>(result.error().value()));
+}
+
+} // namespace
+
+std::expected<std::size_t, std::errc> SocketSession::receiveInto(utils::Pipe &pipe,
+                                                                 std::size_t len) const noexcept
+{
+    return toErrc("receiveInto", pipe.spliceFrom(socket_.getFd(), len));
+}
+
+std::expected<std::size_t, std::errc> SocketSession::sendFrom(utils::Pipe &pipe,
+                                                              std::size_t len) const noexcept
+{
+    return toErrc("sendFrom", pipe.spliceTo(socket_.getFd(), len));
+}
+
+std::expected<std::size_t, std::errc> SocketSession::sendFile(int fileFd, loff_t offset,
+                                                              std::size_t len,
+                                                              utils::Pipe &pipe) const noexcept
+{
+    return toErrc("sendFile", pipe.relay(fileFd, socket_.getFd(), len, &offset, nullptr));
+}
+
+std::expected<std::size_t, std::errc> SocketSession::receiveFile(int fileFd, loff_t offset,
+                                                                 std::size_t len,
+                                                                 utils::Pipe &pipe) const noexcept
+{
+    return toErrc("receiveFile", pipe.relay(socket_.getFd(), fileFd, len, nullptr, &offset));
+}
+
+std::expected<std::size_t, std::errc> SocketSession::relayTo(const SocketSession &peer,
+                                                             std::size_t len,
+                                                             utils::Pipe &pipe) const noexcept
+{
+    return toErrc("relayTo", pipe.relay(socket_.getFd(), peer.getFd(), len));
+}
+
 } // namespace net
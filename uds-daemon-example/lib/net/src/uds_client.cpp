@@ -1,10 +1,15 @@
 #include "uds_client.h"
 
+#include <pubsub.h>
+
+#include <algorithm>
 #include <cstring>
+#include <format>
 #include <spdlog/spdlog.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <vector>
 
 namespace net {
 
@@ -13,6 +18,24 @@ inline const sockaddr *to_sockaddr(const sockaddr_un *addr) noexcept
     return reinterpret_cast<const sockaddr *>(addr);
 }
 
+static_assert(kChunkMarker != kEventMarker);
+
+namespace {
+
+struct Prefix;
+
+//! A longer event is taken for a corrupt stream rather than allocated.
+constexpr uint32_t kMaxEventPayload = 16 * 1024 * 1024;
+
+//! The big endian length prefix at \p offset of a partly received frame.
+template <typename T> T lengthAt(std::span<const std::byte> frame, std::size_t offset) noexcept
+{
+    using Length = wire::Schema<wire::Scalar<Prefix, T>>;
+    return Length::Parse(frame.subspan(offset))->template Get<Prefix>();
+}
+
+} // namespace
+
 UdsClient::UdsClient()
  : session_(Socket(ESocketMode::UNIX_STREAM))
 {
@@ -73,4 +96,115 @@ bool UdsClient::isConnected() const noexcept
 
 std::optional<fs::path> UdsClient::socketPath() const noexcept { return socket_path_; }
 
+std::expected<void, std::errc>
+UdsClient::receiveExactly(std::span<std::byte> buffer) const noexcept
+{
+    if (buffer.empty())
+        return {};
+    const auto received = session_.receive(buffer, [](std::span<const std::byte>) {
+        return false; // until the buffer is full
+    });
+    if (!received)
+        return std::unexpected(received.error());
+    if (*received != buffer.size())
+        return std::unexpected(std::errc::connection_reset);
+    return {};
+}
+
+std::expected<void, std::errc> UdsClient::grant(uint32_t credits) const noexcept
+{
+    std::array<std::byte, CreditGrant::kMinSize> frame;
+    CreditGrant::Encode(frame, credits);
+    if (auto sent = session_.send(std::span(frame)); !sent)
+        return std::unexpected(sent.error());
+    return {};
+}
+
+std::expected<void, std::errc> UdsClient::receiveEvent(const EventCallback &onEvent) const
+{
+    // The marker is in; the rest is read up to each length prefix, then as far as it announces.
+    std::vector<std::byte> frame(1 + sizeof(uint16_t));
+    frame[0] = std::byte{kEventMarker};
+    if (auto ok = receiveExactly(std::span(frame).subspan(1)); !ok)
+        return ok;
+    const std::size_t topicEnd = frame.size() + lengthAt<uint16_t>(frame, 1);
+    frame.resize(topicEnd + sizeof(uint32_t));
+    if (auto ok = receiveExactly(std::span(frame).subspan(1 + sizeof(uint16_t))); !ok)
+        return ok;
+    const uint32_t payloadSize = lengthAt<uint32_t>(frame, topicEnd);
+    if (payloadSize > kMaxEventPayload)
+        return std::unexpected(std::errc::bad_message);
+    frame.resize(frame.size() + payloadSize);
+    if (auto ok = receiveExactly(std::span(frame).subspan(topicEnd + sizeof(uint32_t))); !ok)
+        return ok;
+
+    const auto view = EventFrame::Parse(frame);
+    if (!view)
+        return std::unexpected(std::errc::bad_message);
+    if (onEvent)
+        onEvent(view->Get<event::Topic>(), view->Get<event::Payload>());
+    return {};
+}
+
+std::expected<StreamResult, std::errc> UdsClient::stream(std::string_view request,
+                                                         const ChunkCallback &onChunk,
+                                                         uint32_t window,
+                                                         const EventCallback &onEvent)
+{
+    window = std::max<uint32_t>(window, 1);
+    const std::string text = std::format("{}{} {}", kStreamPrefix, window, request);
+    if (auto sent = session_.send(std::span(text)); !sent)
+        return std::unexpected(sent.error());
+
+    // Credits go back in batches of half the window, so the server never runs dry while the
+    // grant is on its way and a grant costs a fraction of a send per chunk.
+    const uint32_t batch = std::max<uint32_t>(window / 2, 1);
+    uint32_t owed = 0;
+    std::vector<std::byte> chunk(kMaxChunkSize);
+    StreamResult result;
+    for (;;) {
+        std::array<std::byte, ChunkHeader::kMinSize> header;
+        if (auto ok = receiveExactly(std::span(header).first(1)); !ok)
+            return std::unexpected(ok.error());
+        // Events published before the stream began are still ahead of its chunks.
+        if (header[0] == std::byte{kEventMarker}) {
+            if (auto ok = receiveEvent(onEvent); !ok)
+                return std::unexpected(ok.error());
+            continue;
+        }
+        if (header[0] != std::byte{kChunkMarker})
+            return std::unexpected(std::errc::bad_message);
+        if (auto ok = receiveExactly(std::span(header).subspan(1)); !ok)
+            return std::unexpected(ok.error());
+        const auto view = ChunkHeader::Parse(header);
+        const uint32_t length = view->Get<stream::Length>();
+        const uint32_t flags = view->Get<stream::Flags>();
+        if (length > chunk.size())
+            return std::unexpected(std::errc::bad_message);
+
+        const auto payload = std::span(chunk).first(length);
+        if (auto ok = receiveExactly(payload); !ok)
+            return std::unexpected(ok.error());
+
+        if ((flags & kChunkError) != 0) {
+            result.error.assign(reinterpret_cast<const char *>(payload.data()), payload.size());
+        } else {
+            result.bytes += payload.size();
+            ++result.chunks;
+            onChunk(payload);
+        }
+
+        if ((flags & kChunkLast) != 0) {
+            if (auto ok = grant(0); !ok)
+                return std::unexpected(ok.error());
+            return result;
+        }
+        if (++owed >= batch) {
+            if (auto ok = grant(owed); !ok)
+                return std::unexpected(ok.error());
+            owed = 0;
+        }
+    }
+}
+
 } // namespace net
@@ -1,10 +1,10 @@
 #include <cstring>
+#include <fcntl.h>
 #include <final_action.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <uds_server.h>
-
-constexpr int maxConnectionBacklog = 5;
+#include <utility>
 
 using namespace net;
 
@@ -13,9 +13,10 @@ inline const sockaddr *to_sockaddr(const sockaddr_un *addr) noexcept
     return reinterpret_cast<const sockaddr *>(addr);
 }
 
-UdsServer::UdsServer(const fs::path &socketPath)
+UdsServer::UdsServer(const fs::path &socketPath, int backlog)
  : socket_(ESocketMode::UNIX_STREAM)
  , socket_path_(socketPath)
+ , unlinkOnClose_(true)
 {
     fs::remove(socketPath);
 
@@ -27,7 +28,7 @@ UdsServer::UdsServer(const fs::path &socketPath)
         throw UdsServerError("bind failed");
     }
 
-    if (::listen(socket_.getFd(), maxConnectionBacklog) == -1) {
+    if (::listen(socket_.getFd(), backlog) == -1) {
         throw UdsServerError("listen failed");
     }
 }
@@ -47,7 +48,7 @@ UdsServer::UdsServer(const systemd_socket::SocketInfo &sd_socket_info)
 
 UdsServer::~UdsServer()
 {
-    if (!socket_path_.empty()) {
+    if (unlinkOnClose_ && !socket_path_.empty()) {
         ::unlink(socket_path_.c_str());
     }
 }
@@ -55,6 +56,7 @@ UdsServer::~UdsServer()
 UdsServer::UdsServer(UdsServer &&other) noexcept
  : socket_(std::move(other.socket_))
  , socket_path_(std::move(other.socket_path_))
+ , unlinkOnClose_(std::exchange(other.unlinkOnClose_, false))
 {
     other.socket_path_.clear();
 }
@@ -64,12 +66,13 @@ UdsServer &UdsServer::operator=(UdsServer &&other) noexcept
     if (this == &other)
         return *this;
 
-    if (!socket_path_.empty()) {
+    if (unlinkOnClose_ && !socket_path_.empty()) {
         ::unlink(socket_path_.c_str());
     }
 
     socket_ = std::move(other.socket_);
     socket_path_ = std::move(other.socket_path_);
+    unlinkOnClose_ = std::exchange(other.unlinkOnClose_, false);
 
     other.socket_path_.clear();
     return *this;
@@ -80,13 +83,16 @@ std::expected<SocketSession, std::errc> UdsServer::WaitForConnection() noexcept
     fdSet_.AddFd(socket_.getFd());
     auto finally = utils::Finally([this]() noexcept { fdSet_.RemoveFd(socket_.getFd()); });
 
-    if (utils::FdSetRet ret = fdSet_.Select(); ret == utils::FdSetRet::UNBLOCK)
-        return std::unexpected(std::errc::operation_canceled);
-
     int clientFd;
     do {
-        clientFd = ::accept(socket_.getFd(), nullptr, nullptr);
-    } while (clientFd < 0 && errno == EINTR);
+        if (utils::FdSetRet ret = fdSet_.Select(); ret == utils::FdSetRet::UNBLOCK)
+            return std::unexpected(std::errc::operation_canceled);
+
+        do {
+            clientFd = ::accept(socket_.getFd(), nullptr, nullptr);
+        } while (clientFd < 0 && errno == EINTR);
+        // A shared, non-blocking listener: another process took the connection.
+    } while (clientFd < 0 && errno == EAGAIN); // EWOULDBLOCK is the same on Linux
 
     if (clientFd < 0)
         return std::unexpected(static_cast<std::errc>(errno));
@@ -99,3 +105,17 @@ void UdsServer::Unblock() const noexcept { fdSet_.UnBlock(); }
 const Socket &UdsServer::ServerSocket() const noexcept { return socket_; }
 
 fs::path UdsServer::SocketPath() const noexcept { return socket_path_; }
+
+bool UdsServer::SetBacklog(int backlog) const noexcept
+{
+    // listen(2) on a listening socket only updates its backlog
+    return ::listen(socket_.getFd(), backlog) == 0;
+}
+
+bool UdsServer::SetNonBlocking() const noexcept
+{
+    const int flags = ::fcntl(socket_.getFd(), F_GETFL);
+    return flags >= 0 && ::fcntl(socket_.getFd(), F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void UdsServer::KeepSocketPath() noexcept { unlinkOnClose_ = false; }
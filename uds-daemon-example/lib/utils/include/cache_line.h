@@ -0,0 +1,16 @@
+#ifndef CACHE_LINE_H
+#define CACHE_LINE_H
+
+#include <cstddef>
+
+namespace utils {
+
+//! Alignment used to keep independently written data on separate cache lines.
+//! std::hardware_destructive_interference_size is not ABI-stable (GCC warns
+//! when it is used in headers), so the common line size of our amd64 and
+//! arm64 targets is spelled out.
+inline constexpr std::size_t kCacheLineSize = 64;
+
+} // namespace utils
+
+#endif // CACHE_LINE_H
@@ -0,0 +1,146 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+class CaptureFileError : public std::system_error {
+  public:
+    explicit CaptureFileError(const std::string &what, int errnum = errno)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//! Start of a capture file. Everything is in host byte order; the magic tells a file written on
+//! a host of the other byte order apart.
+struct CaptureFileHeader {
+    static constexpr std::array<char, 8> kMagic{'U', 'D', 'S', 'C', 'A', 'P', '0', '1'};
+
+    std::array<char, 8> magic{kMagic};
+    uint32_t headerSize{sizeof(CaptureFileHeader)};
+    uint32_t recordHeaderSize{0};
+    //! Wall clock time of the capture start, in nanoseconds since the epoch.
+    int64_t startedAt{0};
+    uint64_t reserved{0};
+};
+static_assert(sizeof(CaptureFileHeader) == 32);
+
+//! Precedes each request; the payload follows, padded to a multiple of 8 bytes so every record
+//! header of a mapped file is aligned.
+struct CaptureRecordHeader {
+    //! Receive time relative to the capture start.
+    uint64_t offsetNs;
+    uint64_t session;
+    uint32_t length;
+    uint32_t reserved;
+};
+static_assert(sizeof(CaptureRecordHeader) == 24);
+
+struct CaptureStats {
+    uint64_t records{0};
+    //! File size so far, header included.
+    uint64_t bytes{0};
+    //! Not recorded: the buffer was full or the size limit reached.
+    uint64_t dropped{0};
+};
+
+//*****************************************************************************
+//! \brief CaptureWriter
+//! Appends requests to a capture file. Record() copies the request into an
+//! in-memory buffer under a short lock and never waits for the disk; a
+//! writer thread flushes the buffer in the background. When the buffer is
+//! full, or the file reached \p maxBytes, requests are dropped and counted
+//! instead. Only whole records reach the file, so a capture cut short by a
+//! crash ends with at most one partial record, which readers ignore.
+class CaptureWriter {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Requests waiting for the writer thread, in bytes; a request larger than this is dropped.
+    static constexpr std::size_t kBufferSize = 4 * 1024 * 1024;
+
+    //! Creates (or truncates) \p path; throws CaptureFileError.
+    CaptureWriter(const std::filesystem::path &path, uint64_t maxBytes);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    //! False if the request was dropped (or the writer is closed). A \p receivedAt before the
+    //! start of the capture counts as its start.
+    bool Record(uint64_t session, Clock::time_point receivedAt,
+                std::span<const std::byte> request) noexcept;
+
+    //! Writes what is buffered and closes the file; Record() drops from then on.
+    void Close() noexcept;
+
+    [[nodiscard]] CaptureStats Stats() const noexcept;
+    [[nodiscard]] const std::filesystem::path &Path() const noexcept { return path_; }
+
+  private:
+    void Run();
+    void Write(std::span<const std::byte> data) noexcept;
+
+    std::filesystem::path path_;
+    int fd_{-1};
+    const uint64_t maxBytes_;
+    const Clock::time_point started_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::byte> pending_;
+    bool closing_{false};
+    std::atomic<bool> closed_{false};
+    // Under mutex_: what the file will hold once pending_ is written.
+    CaptureStats stats_{};
+    std::thread thread_;
+};
+
+//*****************************************************************************
+//! \brief CaptureReader
+//! Maps a capture file read-only; the records are views into the mapping
+//! and stay valid as long as the reader.
+class CaptureReader {
+  public:
+    struct Record {
+        std::chrono::nanoseconds offset;
+        uint64_t session;
+        std::span<const std::byte> request;
+    };
+
+    //! Throws CaptureFileError if the file cannot be mapped or is not a capture.
+    explicit CaptureReader(const std::filesystem::path &path);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    [[nodiscard]] const CaptureFileHeader &Header() const noexcept { return header_; }
+
+    //! Every complete record in file order, i.e. by receive time within a session.
+    [[nodiscard]] std::vector<Record> Records() const;
+
+  private:
+    const std::byte *data_{nullptr};
+    std::size_t size_{0};
+    CaptureFileHeader header_{};
+};
+
+} // namespace utils
+
+#endif // CAPTURE_FILE_H
@@ -0,0 +1,50 @@
+#ifndef CONFIG_FILE_H
+#define CONFIG_FILE_H
+
+#include <cerrno>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace utils {
+
+class ConfigFileError : public std::system_error {
+  public:
+    explicit ConfigFileError(const std::string &what, int errnum = errno)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//*****************************************************************************
+//! \brief ConfigFile
+//! Flat "key = value" configuration. Blank lines and lines starting with '#'
+//! or ';' are ignored, as is everything after " #" on a value line. Keys are
+//! unique; a repeated key is an error so typos do not silently win.
+class ConfigFile {
+  public:
+    ConfigFile() = default;
+
+    //! Throws ConfigFileError if the file cannot be read or is malformed.
+    static ConfigFile Load(const std::filesystem::path &path);
+
+    //! \p source names the origin in error messages.
+    static ConfigFile Parse(std::string_view text, std::string_view source = "<string>");
+
+    [[nodiscard]] std::optional<std::string_view> Get(std::string_view key) const;
+    [[nodiscard]] bool Contains(std::string_view key) const { return Get(key).has_value(); }
+    [[nodiscard]] const std::map<std::string, std::string, std::less<>> &Entries() const noexcept
+    {
+        return entries_;
+    }
+
+  private:
+    std::map<std::string, std::string, std::less<>> entries_;
+};
+
+} // namespace utils
+
+#endif // CONFIG_FILE_H
@@ -0,0 +1,67 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <cerrno>
+#include <cstddef>
+#include <sched.h>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace utils {
+
+class CpuAffinityError : public std::system_error {
+  public:
+    explicit CpuAffinityError(const std::string &what, int errnum = errno)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//*****************************************************************************
+//! \brief CpuSet
+//! Value type around cpu_set_t with the kernel's cpu list notation
+//! ("0-3,8,10-11", see cpuset(7)) for parsing and printing.
+//! An empty set means "no affinity requested".
+class CpuSet {
+  public:
+    CpuSet() noexcept;
+
+    //! Parses a cpu list; throws CpuAffinityError(EINVAL) on malformed input.
+    static CpuSet Parse(std::string_view list);
+
+    //! Affinity of the calling thread.
+    static CpuSet OfCurrentThread();
+
+    void Add(unsigned cpu);
+    [[nodiscard]] bool Contains(unsigned cpu) const noexcept;
+    [[nodiscard]] std::size_t Count() const noexcept;
+    [[nodiscard]] bool Empty() const noexcept { return Count() == 0; }
+
+    //! True if every cpu of this set is also in \p other.
+    [[nodiscard]] bool IsSubsetOf(const CpuSet &other) const noexcept;
+
+    [[nodiscard]] std::vector<unsigned> Cpus() const;
+    [[nodiscard]] std::string ToString() const;
+
+    [[nodiscard]] const cpu_set_t &Native() const noexcept { return set_; }
+
+    bool operator==(const CpuSet &other) const noexcept;
+
+  private:
+    cpu_set_t set_;
+};
+
+//! Restricts the calling thread to \p cpus; an empty set leaves the affinity untouched.
+void PinCurrentThread(const CpuSet &cpus);
+
+//! NUMA nodes the cpus of \p cpus belong to, from sysfs; empty on non-NUMA kernels.
+std::vector<unsigned> NumaNodesOf(const CpuSet &cpus);
+
+//! Human readable "cpus 0-3 (numa node 0)" for startup reports.
+std::string DescribeAffinity(const CpuSet &cpus);
+
+} // namespace utils
+
+#endif // CPU_AFFINITY_H
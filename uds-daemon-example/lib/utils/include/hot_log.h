@@ -0,0 +1,299 @@
+#ifndef HOT_LOG_H
+#define HOT_LOG_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <token_bucket.h>
+#include <tuple>
+#include <type_traits>
+
+//! Lowest level whose HOT_LOG statements are compiled in (SPDLOG_LEVEL_* numbering); set by the
+//! build, trace for debug builds and info otherwise.
+#ifndef HOT_LOG_ACTIVE_LEVEL
+#define HOT_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
+namespace utils {
+
+//! One log statement: its format string, level and source location. The address identifies the
+//! statement in a captured record; the text is only looked at when the record is formatted.
+struct HotLogSite {
+    spdlog::level::level_enum level;
+    std::string_view format;
+    spdlog::source_loc location;
+};
+
+//! Log statement that passes at most \p rate messages per second (bursts of \p burst); the rest
+//! are counted and the count is appended to the next message that passes.
+struct RateLimitedHotLogSite : HotLogSite {
+    RateLimitedHotLogSite(const HotLogSite &site, double rate, double burst) noexcept
+     : HotLogSite(site)
+     , bucket(rate, burst)
+    {
+    }
+
+    TokenBucket bucket;
+    std::atomic<uint64_t> suppressed{0};
+};
+
+//! Log statement that passes every \p nth message.
+struct SampledHotLogSite : HotLogSite {
+    SampledHotLogSite(const HotLogSite &site, uint64_t nth) noexcept
+     : HotLogSite(site)
+     , every(nth > 0 ? nth : 1)
+    {
+    }
+
+    const uint64_t every;
+    std::atomic<uint64_t> seen{0};
+};
+
+struct HotLogRecord;
+using HotLogDecoder = std::string (*)(const HotLogRecord &record);
+
+//! What a log statement hands to the backend: no formatting, only the raw arguments. Strings are
+//! copied and cut to what fits into the record.
+struct HotLogRecord {
+    static constexpr std::size_t kSize = 256;
+
+    const HotLogSite *site;
+    HotLogDecoder decode;
+    spdlog::log_clock::time_point time;
+    std::size_t thread;
+    //! Messages of a rate limited site dropped before this one.
+    uint64_t suppressed;
+    std::array<std::byte, kSize - 5 * sizeof(uint64_t)> args;
+};
+static_assert(sizeof(HotLogRecord) == HotLogRecord::kSize);
+
+struct HotLogStats {
+    uint64_t written{0};
+    //! Lost because a thread's ring was full.
+    uint64_t dropped{0};
+};
+
+//*****************************************************************************
+//! \brief HotLog
+//! Logging for per-message paths. A HOT_LOG statement copies its arguments
+//! into a record and pushes it to a ring of the calling thread (SpscRing, no
+//! lock, no syscall); a backend thread formats the records and writes them to
+//! the sinks of the default spdlog logger with the original time and thread
+//! id. A full ring drops the record and counts it rather than block.
+//!
+//! Until Start() and after Stop() statements are formatted and written right
+//! away, so code using HOT_LOG works in tools and tests without a backend.
+//! The backend does not survive fork(): start it in the process that logs.
+//!
+//! Arguments are restricted to arithmetic types, enums and strings.
+class HotLog {
+  public:
+    //! Records each thread's ring holds; allocated on the thread's first statement.
+    static constexpr std::size_t kRingCapacity = 128;
+
+    static void Start();
+    //! Writes everything captured so far, then stops the backend.
+    static void Stop();
+    [[nodiscard]] static bool Running() noexcept;
+    [[nodiscard]] static HotLogStats Stats() noexcept;
+
+    template <typename... Args>
+    static void Log(const HotLogSite &site, uint64_t suppressed, const Args &...args) noexcept;
+
+  private:
+    static void Submit(const HotLogRecord &record) noexcept;
+};
+
+namespace hot_log_detail {
+
+template <typename T>
+concept StringLike = std::convertible_to<const T &, std::string_view>;
+
+template <typename T>
+concept Scalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+template <typename T>
+struct StoredAs {
+    using type = T;
+};
+template <StringLike T>
+struct StoredAs<T> {
+    using type = std::string_view;
+};
+template <typename T>
+    requires std::is_enum_v<T>
+struct StoredAs<T> {
+    using type = std::underlying_type_t<T>;
+};
+
+// How an argument is kept in the record and handed to the formatter.
+template <typename T>
+using Stored = typename StoredAs<T>::type;
+
+template <typename T>
+constexpr std::size_t fixedSize() noexcept
+{
+    static_assert(StringLike<T> || Scalar<T>, "HOT_LOG takes arithmetic types, enums and strings");
+    return StringLike<T> ? sizeof(uint16_t) : sizeof(T);
+}
+
+class Writer {
+  public:
+    Writer(std::span<std::byte> out, std::size_t fixed) noexcept
+     : out_(out)
+     , textBudget_(out.size() - fixed)
+    {
+    }
+
+    template <typename T>
+    void Put(const T &value) noexcept
+    {
+        if constexpr (StringLike<T>) {
+            const std::string_view text(value);
+            const auto length = static_cast<uint16_t>(std::min(text.size(), textBudget_));
+            textBudget_ -= length;
+            Raw(&length, sizeof(length));
+            Raw(text.data(), length);
+        } else {
+            Raw(&value, sizeof(value));
+        }
+    }
+
+  private:
+    void Raw(const void *data, std::size_t size) noexcept
+    {
+        std::memcpy(out_.data() + offset_, data, size);
+        offset_ += size;
+    }
+
+    std::span<std::byte> out_;
+    std::size_t textBudget_;
+    std::size_t offset_{0};
+};
+
+class Reader {
+  public:
+    explicit Reader(std::span<const std::byte> in) noexcept
+     : in_(in)
+    {
+    }
+
+    template <typename T>
+    T Get() noexcept
+    {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            const auto length = Get<uint16_t>();
+            std::string_view text(reinterpret_cast<const char *>(in_.data() + offset_), length);
+            offset_ += length;
+            return text;
+        } else {
+            T value;
+            std::memcpy(&value, in_.data() + offset_, sizeof(T));
+            offset_ += sizeof(T);
+            return value;
+        }
+    }
+
+  private:
+    std::span<const std::byte> in_;
+    std::size_t offset_{0};
+};
+
+template <typename... Stored>
+std::string decode(const HotLogRecord &record)
+{
+    Reader reader(record.args);
+    // Braced initialization evaluates the reads in order.
+    std::tuple<Stored...> values{reader.Get<Stored>()...};
+    return std::apply(
+        [&record](const auto &...value) {
+            return std::vformat(record.site->format, std::make_format_args(value...));
+        },
+        values);
+}
+
+constexpr bool compiledIn(spdlog::level::level_enum level) noexcept
+{
+    return static_cast<int>(level) >= HOT_LOG_ACTIVE_LEVEL;
+}
+
+std::size_t threadId() noexcept;
+
+} // namespace hot_log_detail
+
+template <typename... Args>
+void HotLog::Log(const HotLogSite &site, uint64_t suppressed, const Args &...args) noexcept
+{
+    using namespace hot_log_detail;
+    constexpr std::size_t fixed = (std::size_t{0} + ... + fixedSize<Args>());
+    static_assert(fixed <= std::tuple_size_v<decltype(HotLogRecord::args)>,
+                  "too many HOT_LOG arguments for one record");
+
+    HotLogRecord record{.site = &site,
+                        .decode = &decode<Stored<Args>...>,
+                        .time = spdlog::log_clock::now(),
+                        .thread = threadId(),
+                        .suppressed = suppressed,
+                        .args = {}};
+    Writer writer(record.args, fixed);
+    (writer.Put(args), ...);
+    Submit(record);
+}
+
+} // namespace utils
+
+#define HOT_LOG_SITE_(lvl, fmt)                                                                   \
+    utils::HotLogSite { lvl, fmt, spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION} }
+
+//! Logs through the HotLog backend. Compiled out below HOT_LOG_ACTIVE_LEVEL; below the logger's
+//! level at run time it costs one load and compare.
+#define HOT_LOG(lvl, fmt, ...)                                                                    \
+    do {                                                                                          \
+        if constexpr (utils::hot_log_detail::compiledIn(lvl)) {                                   \
+            if (spdlog::default_logger_raw()->should_log(lvl)) {                                  \
+                static const utils::HotLogSite hotLogSite_ = HOT_LOG_SITE_(lvl, fmt);             \
+                utils::HotLog::Log(hotLogSite_, 0 __VA_OPT__(, ) __VA_ARGS__);                    \
+            }                                                                                     \
+        }                                                                                         \
+    } while (false)
+
+//! HOT_LOG limited to \p rate messages per second at this statement, with bursts of
+//! \p burst.
+#define HOT_LOG_RATE_LIMITED(lvl, rate, burst, fmt, ...)                                         \
+    do {                                                                                          \
+        if constexpr (utils::hot_log_detail::compiledIn(lvl)) {                                   \
+            if (spdlog::default_logger_raw()->should_log(lvl)) {                                  \
+                static utils::RateLimitedHotLogSite hotLogSite_(HOT_LOG_SITE_(lvl, fmt), rate,    \
+                                                                burst);                           \
+                if (hotLogSite_.bucket.TryAcquire())                                              \
+                    utils::HotLog::Log(hotLogSite_, hotLogSite_.suppressed.exchange(0)            \
+                                                        __VA_OPT__(, ) __VA_ARGS__);              \
+                else                                                                              \
+                    hotLogSite_.suppressed.fetch_add(1, std::memory_order_relaxed);               \
+            }                                                                                     \
+        }                                                                                         \
+    } while (false)
+
+//! HOT_LOG that writes only every \p nth message of this statement.
+#define HOT_LOG_SAMPLED(lvl, nth, fmt, ...)                                                       \
+    do {                                                                                          \
+        if constexpr (utils::hot_log_detail::compiledIn(lvl)) {                                   \
+            if (spdlog::default_logger_raw()->should_log(lvl)) {                                  \
+                static utils::SampledHotLogSite hotLogSite_(HOT_LOG_SITE_(lvl, fmt), nth);        \
+                const auto seen = hotLogSite_.seen.fetch_add(1, std::memory_order_relaxed);      \
+                if (seen % hotLogSite_.every == 0)                                                \
+                    utils::HotLog::Log(hotLogSite_, 0 __VA_OPT__(, ) __VA_ARGS__);                \
+            }                                                                                     \
+        }                                                                                         \
+    } while (false)
+
+#endif // HOT_LOG_H
@@ -0,0 +1,257 @@
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace utils {
+
+template <typename T, typename Tag>
+class IntrusiveList;
+
+//*****************************************************************************
+//! \brief IntrusiveListHook
+//! Links embedded in an element of an IntrusiveList. Elements derive from the
+//! hook; an element that has to be on several lists at once derives from one
+//! hook per list, told apart by \p Tag.
+//!
+//! Copying an element does not copy its links. An element has to be unlinked
+//! before it is destroyed, the hook does not know the list it is on.
+template <typename Tag = void>
+class IntrusiveListHook {
+  public:
+    IntrusiveListHook() noexcept = default;
+    IntrusiveListHook(const IntrusiveListHook &) noexcept {}
+    IntrusiveListHook &operator=(const IntrusiveListHook &) noexcept { return *this; }
+    ~IntrusiveListHook() = default;
+
+    [[nodiscard]] bool IsLinked() const noexcept { return next_ != nullptr; }
+
+  private:
+    template <typename, typename>
+    friend class IntrusiveList;
+
+    IntrusiveListHook *prev_{nullptr};
+    IntrusiveListHook *next_{nullptr};
+};
+
+//*****************************************************************************
+//! \brief IntrusiveList
+//! Doubly linked list over elements that embed their links. The list never
+//! allocates and does not own its elements; insert, erase and the lookup of
+//! an iterator from an element reference are O(1), in contrast to the
+//! find_if walk of CList::data_to_iterator. erase_and_dispose() and
+//! clear_and_dispose() hand removed elements to a disposer, e.g.
+//! std::default_delete<T> for heap allocated ones.
+//!
+//! Not thread-safe, like CList.
+template <typename T, typename Tag = void>
+class IntrusiveList {
+    using Hook = IntrusiveListHook<Tag>;
+    static_assert(std::is_base_of_v<Hook, T>,
+                  "IntrusiveList elements have to derive from IntrusiveListHook<Tag>");
+
+    template <bool Const>
+    class Iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T *, T *>;
+        using reference = std::conditional_t<Const, const T &, T &>;
+
+        Iterator() noexcept = default;
+
+        // iterator -> const_iterator; a template, so the implicit copy constructor stays
+        template <bool OtherConst>
+            requires(Const && !OtherConst)
+        Iterator(const Iterator<OtherConst> &other) noexcept
+         : node_(other.node_)
+        {
+        }
+
+        reference operator*() const noexcept { return static_cast<reference>(*node_); }
+        pointer operator->() const noexcept { return &**this; }
+
+        Iterator &operator++() noexcept
+        {
+            node_ = node_->next_;
+            return *this;
+        }
+        Iterator operator++(int) noexcept
+        {
+            Iterator old = *this;
+            node_ = node_->next_;
+            return old;
+        }
+        Iterator &operator--() noexcept
+        {
+            node_ = node_->prev_;
+            return *this;
+        }
+        Iterator operator--(int) noexcept
+        {
+            Iterator old = *this;
+            node_ = node_->prev_;
+            return old;
+        }
+
+        bool operator==(const Iterator &other) const noexcept { return node_ == other.node_; }
+
+      private:
+        friend class IntrusiveList;
+        friend class Iterator<!Const>;
+
+        using HookPtr = std::conditional_t<Const, const Hook *, Hook *>;
+        explicit Iterator(HookPtr node) noexcept
+         : node_(node)
+        {
+        }
+
+        // Hook and T are related by inheritance, so the element is a static_cast away.
+        HookPtr node_{nullptr};
+    };
+
+  public:
+    using value_type = T;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = std::size_t;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    IntrusiveList() noexcept { head_.prev_ = head_.next_ = &head_; }
+    ~IntrusiveList() { clear(); }
+
+    IntrusiveList(const IntrusiveList &) = delete;
+    IntrusiveList &operator=(const IntrusiveList &) = delete;
+
+    IntrusiveList(IntrusiveList &&other) noexcept
+     : IntrusiveList()
+    {
+        splice(end(), other);
+    }
+
+    IntrusiveList &operator=(IntrusiveList &&other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            splice(end(), other);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] iterator begin() noexcept { return iterator(head_.next_); }
+    [[nodiscard]] iterator end() noexcept { return iterator(&head_); }
+    [[nodiscard]] const_iterator begin() const noexcept { return const_iterator(head_.next_); }
+    [[nodiscard]] const_iterator end() const noexcept { return const_iterator(&head_); }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] size_type size() const noexcept { return size_; }
+
+    [[nodiscard]] reference front() noexcept { return *begin(); }
+    [[nodiscard]] const_reference front() const noexcept { return *begin(); }
+    [[nodiscard]] reference back() noexcept { return *iterator(head_.prev_); }
+    [[nodiscard]] const_reference back() const noexcept { return *const_iterator(head_.prev_); }
+
+    //! Links \p element in front of \p pos; the element must not be on a list.
+    iterator insert(const_iterator pos, reference element) noexcept
+    {
+        Hook *next = const_cast<Hook *>(pos.node_);
+        Hook *node = &element;
+        node->next_ = next;
+        node->prev_ = next->prev_;
+        next->prev_->next_ = node;
+        next->prev_ = node;
+        ++size_;
+        return iterator(node);
+    }
+
+    void push_front(reference element) noexcept { insert(begin(), element); }
+    void push_back(reference element) noexcept { insert(end(), element); }
+
+    //! Unlinks the element at \p pos and returns the iterator following it.
+    iterator erase(const_iterator pos) noexcept
+    {
+        Hook *node = const_cast<Hook *>(pos.node_);
+        Hook *next = node->next_;
+        node->prev_->next_ = next;
+        next->prev_ = node->prev_;
+        node->prev_ = node->next_ = nullptr;
+        --size_;
+        return iterator(next);
+    }
+
+    //! Unlinks \p element, which has to be on this list.
+    void remove(reference element) noexcept { erase(data_to_iterator(&element)); }
+
+    void pop_front() noexcept { erase(begin()); }
+    void pop_back() noexcept { erase(iterator(head_.prev_)); }
+
+    template <typename Disposer>
+    iterator erase_and_dispose(const_iterator pos, Disposer &&dispose)
+    {
+        pointer element = const_cast<pointer>(&*pos);
+        iterator next = erase(pos);
+        dispose(element);
+        return next;
+    }
+
+    //! Unlinks all elements without touching them otherwise.
+    void clear() noexcept
+    {
+        while (!empty())
+            pop_front();
+    }
+
+    template <typename Disposer>
+    void clear_and_dispose(Disposer &&dispose)
+    {
+        while (!empty())
+            erase_and_dispose(begin(), dispose);
+    }
+
+    //! Moves all elements of \p other in front of \p pos.
+    void splice(const_iterator pos, IntrusiveList &other) noexcept
+    {
+        if (other.empty())
+            return;
+
+        Hook *next = const_cast<Hook *>(pos.node_);
+        Hook *first = other.head_.next_;
+        Hook *last = other.head_.prev_;
+
+        first->prev_ = next->prev_;
+        next->prev_->next_ = first;
+        last->next_ = next;
+        next->prev_ = last;
+        size_ += other.size_;
+
+        other.head_.prev_ = other.head_.next_ = &other.head_;
+        other.size_ = 0;
+    }
+
+    //! Element to iterator in O(1); \p elm has to be on this list (or be nullptr -> end()).
+    [[nodiscard]] iterator data_to_iterator(pointer elm) noexcept
+    {
+        return elm ? iterator(static_cast<Hook *>(elm)) : end();
+    }
+
+    [[nodiscard]] const_iterator cdata_to_iterator(const_pointer elm) const noexcept
+    {
+        return elm ? const_iterator(static_cast<const Hook *>(elm)) : cend();
+    }
+
+  private:
+    Hook head_;
+    size_type size_{0};
+};
+
+} // namespace utils
+
+#endif // INTRUSIVE_LIST_H
@@ -0,0 +1,64 @@
+#ifndef INTRUSIVE_QUEUE_H
+#define INTRUSIVE_QUEUE_H
+
+#include <intrusive_list.h>
+
+namespace utils {
+
+//*****************************************************************************
+//! \brief IntrusiveQueue
+//! FIFO over elements deriving from IntrusiveListHook<Tag>. Next to push_back
+//! and pop_front it can drop any queued element in O(1) (remove()), which is
+//! what an LRU chain needs: touching an entry is remove() + push_back(), the
+//! eviction candidate is front().
+template <typename T, typename Tag = void>
+class IntrusiveQueue : private IntrusiveList<T, Tag> {
+    using List = IntrusiveList<T, Tag>;
+
+  public:
+    using typename List::const_iterator;
+    using typename List::const_pointer;
+    using typename List::const_reference;
+    using typename List::iterator;
+    using typename List::pointer;
+    using typename List::reference;
+    using typename List::size_type;
+    using typename List::value_type;
+
+    using List::begin;
+    using List::cbegin;
+    using List::cdata_to_iterator;
+    using List::cend;
+    using List::clear;
+    using List::clear_and_dispose;
+    using List::data_to_iterator;
+    using List::empty;
+    using List::end;
+    using List::size;
+
+    using List::back;
+    using List::front;
+    using List::push_back;
+    using List::remove;
+
+    //! Unlinks and returns the oldest element, nullptr if the queue is empty.
+    pointer pop_front() noexcept
+    {
+        if (empty())
+            return nullptr;
+        pointer element = &front();
+        List::pop_front();
+        return element;
+    }
+
+    //! Moves a queued element to the back, e.g. on access in an LRU chain.
+    void move_to_back(reference element) noexcept
+    {
+        List::remove(element);
+        List::push_back(element);
+    }
+};
+
+} // namespace utils
+
+#endif // INTRUSIVE_QUEUE_H
@@ -0,0 +1,126 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace utils {
+
+//*****************************************************************************
+//! \brief LatencyHistogram
+//! Log-linear histogram of nanosecond values (HdrHistogram layout).
+//! Every power-of-two range is split into 128 linear sub-buckets, so a
+//! reported percentile is at most 1/128 (< 0.8 %) above the recorded value.
+//! Recording is a shift and an increment; histograms of several threads are
+//! combined with Merge().
+class LatencyHistogram {
+  public:
+    static constexpr unsigned kSubBucketBits = 8;
+
+    LatencyHistogram()
+     : counts_(kBucketCount, 0)
+    {
+    }
+
+    void Record(std::chrono::nanoseconds value) noexcept
+    {
+        RecordValue(static_cast<uint64_t>(std::max<int64_t>(value.count(), 0)), 1);
+    }
+
+    void RecordValue(uint64_t value, uint64_t count) noexcept
+    {
+        counts_[IndexOf(value)] += count;
+        total_ += count;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += static_cast<double>(value) * static_cast<double>(count);
+    }
+
+    void Merge(const LatencyHistogram &other) noexcept
+    {
+        for (std::size_t i = 0; i < counts_.size(); ++i)
+            counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    void Reset() noexcept
+    {
+        std::ranges::fill(counts_, 0);
+        total_ = 0;
+        min_ = std::numeric_limits<uint64_t>::max();
+        max_ = 0;
+        sum_ = 0.0;
+    }
+
+    [[nodiscard]] uint64_t Count() const noexcept { return total_; }
+    [[nodiscard]] uint64_t Min() const noexcept { return total_ ? min_ : 0; }
+    [[nodiscard]] uint64_t Max() const noexcept { return max_; }
+
+    [[nodiscard]] double Mean() const noexcept
+    {
+        return total_ ? sum_ / static_cast<double>(total_) : 0.0;
+    }
+
+    //! Smallest value v such that at least \p percentile % of all samples are <= v.
+    [[nodiscard]] uint64_t ValueAtPercentile(double percentile) const noexcept
+    {
+        if (total_ == 0)
+            return 0;
+
+        percentile = std::clamp(percentile, 0.0, 100.0);
+        auto wanted = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total_) + 0.5);
+        wanted = std::clamp<uint64_t>(wanted, 1, total_);
+
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= wanted)
+                return std::min(HighestValueOf(i), max_);
+        }
+        return max_;
+    }
+
+  private:
+    static constexpr uint64_t kSubBucketCount = uint64_t{1} << kSubBucketBits;
+    static constexpr uint64_t kSubBucketHalf = kSubBucketCount / 2;
+    static constexpr std::size_t kBucketCount =
+        kSubBucketCount + (64 - kSubBucketBits) * kSubBucketHalf;
+
+    static constexpr uint64_t IndexOf(uint64_t value) noexcept
+    {
+        if (value < kSubBucketCount)
+            return value;
+
+        const auto shift = static_cast<unsigned>(std::bit_width(value)) - kSubBucketBits;
+        return kSubBucketCount + (shift - 1) * kSubBucketHalf + ((value >> shift) - kSubBucketHalf);
+    }
+
+    static constexpr uint64_t HighestValueOf(uint64_t index) noexcept
+    {
+        if (index < kSubBucketCount)
+            return index;
+
+        const uint64_t rel = index - kSubBucketCount;
+        const uint64_t shift = rel / kSubBucketHalf + 1;
+        const uint64_t sub = rel % kSubBucketHalf + kSubBucketHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_{0};
+    uint64_t min_{std::numeric_limits<uint64_t>::max()};
+    uint64_t max_{0};
+    double sum_{0.0};
+};
+
+} // namespace utils
+
+#endif // LATENCY_HISTOGRAM_H
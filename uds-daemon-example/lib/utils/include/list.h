@@ -2,6 +2,7 @@
 #define LIST_H_
 
 #include <typetraits.h>
+#include <pool_allocator.h>
 #include <algorithm>
 #include <list>
 #include <memory>
@@ -76,6 +77,10 @@ public:
 template <typename alloc, typename ElementType = typename alloc::value_type>
 CList(const alloc&) -> CList<ElementType, alloc>;
 
+// CList whose storage comes from the calling thread's PoolArena instead of malloc
+template <typename ElementType, PoolBacking backing = PoolBacking::Heap>
+using CPoolList = CList<ElementType, PoolAllocator<ElementType, backing>>;
+
 } // namespace utils
 
 #endif /* LIST_H_ */
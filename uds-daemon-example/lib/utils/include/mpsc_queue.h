@@ -0,0 +1,147 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <cache_line.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace utils {
+
+//*****************************************************************************
+//! \brief MpscQueue
+//! Bounded lock-free queue for many producers and a single consumer, the
+//! handoff from I/O threads to one worker. Cells carry a sequence number
+//! (Vyukov's bounded queue): producers claim a position with a CAS and
+//! publish the cell by bumping its sequence, the consumer needs no atomic
+//! read-modify-write at all. TryPush() fails instead of blocking when the
+//! queue is full, so callers choose their own backpressure.
+template <typename T>
+class MpscQueue {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "MpscQueue elements have to be nothrow move constructible");
+
+  public:
+    explicit MpscQueue(std::size_t capacity)
+     : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+     , mask_(capacity_ - 1)
+     , cells_(std::make_unique<Cell[]>(capacity_))
+    {
+        for (std::size_t i = 0; i < capacity_; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue()
+    {
+        while (TryPop()) {
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    //*************************************************************************
+    // Producers, any thread
+
+    template <typename... Args>
+    bool TryEmplace(Args &&...args)
+    {
+        if constexpr (!std::is_nothrow_constructible_v<T, Args &&...>) {
+            // A claimed cell must be published, so anything that may throw happens up front.
+            return TryEmplace(T(std::forward<Args>(args)...));
+        }
+
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & mask_];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+            if (diff == 0) {
+                // Cell is free for this lap; claim the position.
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    std::construct_at(cell.ptr(), std::forward<Args>(args)...);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // consumer has not freed this cell yet: full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed); // lost the race, retry
+            }
+        }
+    }
+
+    bool TryPush(const T &value) { return TryEmplace(value); }
+    bool TryPush(T &&value) { return TryEmplace(std::move(value)); }
+
+    //*************************************************************************
+    // Consumer, one thread only
+
+    std::optional<T> TryPop()
+    {
+        Cell &cell = cells_[head_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != head_ + 1)
+            return std::nullopt; // empty, or the producer has not finished writing
+
+        std::optional<T> value(std::move(*cell.ptr()));
+        std::destroy_at(cell.ptr());
+        cell.sequence.store(head_ + capacity_, std::memory_order_release);
+        ++head_;
+        return value;
+    }
+
+    //! Moves up to \p max elements to \p out; stops early at the first unpublished cell.
+    template <typename OutputIt>
+    std::size_t PopBatch(OutputIt out, std::size_t max)
+    {
+        std::size_t n = 0;
+        while (n < max) {
+            auto value = TryPop();
+            if (!value)
+                break;
+            *out++ = std::move(*value);
+            ++n;
+        }
+        return n;
+    }
+
+    //*************************************************************************
+    // Either side
+
+    [[nodiscard]] std::size_t Capacity() const noexcept { return capacity_; }
+
+    //! Consumer side only; a snapshot while producers are active.
+    [[nodiscard]] std::size_t SizeApprox() const noexcept
+    {
+        return tail_.load(std::memory_order_acquire) - head_;
+    }
+
+  private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        alignas(T) std::byte storage[sizeof(T)];
+        T *ptr() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const std::unique_ptr<Cell[]> cells_;
+
+    // Contended by all producers.
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    // Owned by the consumer.
+    alignas(kCacheLineSize) std::size_t head_{0};
+};
+
+} // namespace utils
+
+#endif // MPSC_QUEUE_H
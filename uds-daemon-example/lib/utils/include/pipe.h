@@ -3,6 +3,7 @@
 #include <expected>
 #include <span>
 #include <string>
+#include <sys/types.h>
 #include <system_error>
 #include <unistd.h>
 
@@ -31,10 +32,49 @@ class Pipe {
 
     ssize_t writeString(std::string_view sv) noexcept;
     std::expected<std::string, std::error_code> readString() const noexcept;
+    //! Like readString() but reuses the storage of \p out; returns the number of bytes read.
+    std::expected<std::size_t, std::error_code> readString(std::string& out) const noexcept;
 
     int readFd() const noexcept;
     int writeFd() const noexcept;
 
+    //! Size of the pipe buffer, i.e. the most a single splice can move.
+    std::size_t capacity() const noexcept;
+    //! Grows (or shrinks) the pipe buffer; rounded up to pages by the kernel.
+    bool setCapacity(std::size_t bytes) noexcept;
+    //! Bytes currently queued in the pipe.
+    std::size_t buffered() const noexcept;
+
+    //-------------------------------------------------------------------------
+    // Zero-copy transfer: page references are moved between the pipe and
+    // another fd inside the kernel, the data never enters user space.
+    //-------------------------------------------------------------------------
+
+    //! Moves up to \p len bytes from \p fd into the pipe; 0 means end of input.
+    //! \p offset is read and advanced for files, nullptr uses the file position.
+    std::expected<std::size_t, std::error_code> spliceFrom(int fd, std::size_t len,
+                                                           loff_t* offset = nullptr) noexcept;
+
+    //! Moves up to \p len queued bytes from the pipe to \p fd.
+    std::expected<std::size_t, std::error_code> spliceTo(int fd, std::size_t len,
+                                                         loff_t* offset = nullptr) noexcept;
+
+    //! Duplicates up to \p len queued bytes into \p other without consuming them.
+    std::expected<std::size_t, std::error_code> teeTo(Pipe& other, std::size_t len) noexcept;
+
+    //! Maps the pages of \p data into the pipe instead of copying them; \p data must stay
+    //! untouched until the bytes have been consumed from the pipe.
+    std::expected<std::size_t, std::error_code>
+    vmspliceFrom(std::span<const std::byte> data) noexcept;
+
+    //! Moves \p len bytes from \p inFd to \p outFd through the pipe, stopping early at end of
+    //! input; a full output is waited for. The pipe has to be empty on entry and is empty again
+    //! on return: when the output fails, the bytes already taken from the input are dropped.
+    //! Returns the number of bytes moved.
+    std::expected<std::size_t, std::error_code> relay(int inFd, int outFd, std::size_t len,
+                                                      loff_t* inOffset = nullptr,
+                                                      loff_t* outOffset = nullptr) noexcept;
+
     template <typename T>
         requires std::is_trivially_copyable_v<T>
     ssize_t writeData(std::span<const T> data) noexcept
@@ -83,6 +123,9 @@ class Pipe {
     }
 
   private:
+    //! Drops whatever is queued.
+    void discard() noexcept;
+
     int readFd_{-1};
     int writeFd_{-1};
 };
@@ -0,0 +1,214 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+//! Where PoolArena takes its memory from.
+enum class PoolBacking {
+    Heap,     //!< 256 KiB regions from operator new
+    HugePages //!< 2 MiB regions, MAP_HUGETLB or transparent huge pages as fallback
+};
+
+struct PoolStats {
+    std::size_t blockSize{0};
+    uint64_t allocations{0};
+    uint64_t deallocations{0};
+    std::size_t inUse{0};
+    std::size_t peakInUse{0};
+    //! Blocks carved from slabs so far, i.e. in use plus on the free list.
+    std::size_t capacity{0};
+};
+
+struct ArenaStats {
+    PoolBacking backing{PoolBacking::Heap};
+    std::size_t regions{0};
+    std::size_t reservedBytes{0};
+    //! Regions that got explicit (MAP_HUGETLB) huge pages.
+    std::size_t hugePageRegions{0};
+    //! Requests above PoolArena::kMaxBlockSize, served by operator new.
+    uint64_t oversizeAllocations{0};
+    //! One entry per size class that has been used.
+    std::vector<PoolStats> pools;
+};
+
+//*****************************************************************************
+//! \brief PoolArena
+//! Per-thread set of fixed-size block pools, one per 16 byte size class up to
+//! 1 KiB. A pool pops from its free list, otherwise bumps through its current
+//! 16 KiB slab; slabs are cut from large regions which are only returned when
+//! the arena is destroyed. Allocation and release are a handful of
+//! instructions without locks or atomics.
+//!
+//! Arenas are thread-local (ThisThread()): memory has to be released on the
+//! thread that allocated it, which holds for the single-threaded CList and
+//! CQueue containers. If blocks are still in use when the thread exits, the
+//! regions are deliberately leaked rather than freed underneath their owners.
+class PoolArena final {
+  public:
+    static constexpr std::size_t kGranularity = 16;
+    static constexpr std::size_t kMaxBlockSize = 1024;
+    static constexpr std::size_t kSizeClasses = kMaxBlockSize / kGranularity;
+    static constexpr std::size_t kSlabSize = 16 * 1024;
+
+    explicit PoolArena(PoolBacking backing) noexcept;
+    ~PoolArena();
+
+    PoolArena(const PoolArena &) = delete;
+    PoolArena &operator=(const PoolArena &) = delete;
+    PoolArena(PoolArena &&) = delete;
+    PoolArena &operator=(PoolArena &&) = delete;
+
+    template <PoolBacking Backing>
+    static PoolArena &ThisThread() noexcept
+    {
+        thread_local PoolArena arena(Backing);
+        return arena;
+    }
+
+    //! Block of at least \p bytes, aligned to kGranularity; throws std::bad_alloc.
+    [[nodiscard]] void *Allocate(std::size_t bytes)
+    {
+        if (bytes > kMaxBlockSize)
+            return AllocateOversize(bytes);
+
+        Pool &pool = pools_[ClassOf(bytes)];
+        void *block;
+        if (pool.free != nullptr) {
+            block = pool.free;
+            pool.free = pool.free->next;
+        } else if (pool.cursor != pool.end) {
+            block = pool.cursor;
+            pool.cursor += pool.stats.blockSize;
+            ++pool.stats.capacity;
+        } else {
+            block = Refill(pool);
+        }
+
+        ++pool.stats.allocations;
+        pool.stats.peakInUse = std::max(pool.stats.peakInUse, ++pool.stats.inUse);
+        return block;
+    }
+
+    //! Releases a block; \p bytes has to match the size passed to Allocate().
+    void Deallocate(void *block, std::size_t bytes) noexcept
+    {
+        if (bytes > kMaxBlockSize) {
+            ::operator delete(block, bytes);
+            return;
+        }
+
+        Pool &pool = pools_[ClassOf(bytes)];
+        auto *node = static_cast<FreeBlock *>(block);
+        node->next = pool.free;
+        pool.free = node;
+        ++pool.stats.deallocations;
+        --pool.stats.inUse;
+    }
+
+    [[nodiscard]] ArenaStats Stats() const;
+
+  private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct Pool {
+        FreeBlock *free{nullptr};
+        std::byte *cursor{nullptr};
+        std::byte *end{nullptr};
+        PoolStats stats;
+    };
+
+    struct Region {
+        void *base;
+        std::size_t size;
+        bool mapped;
+        bool hugeTlb;
+    };
+
+    static constexpr std::size_t ClassOf(std::size_t bytes) noexcept
+    {
+        return (std::max<std::size_t>(bytes, 1) - 1) / kGranularity;
+    }
+
+    void *AllocateOversize(std::size_t bytes);
+    void *Refill(Pool &pool);
+    std::byte *CarveSlab();
+    void AddRegion();
+
+    PoolBacking backing_;
+    std::array<Pool, kSizeClasses> pools_{};
+    std::vector<Region> regions_;
+    std::byte *regionCursor_{nullptr};
+    std::byte *regionEnd_{nullptr};
+    uint64_t oversize_{0};
+};
+
+//*****************************************************************************
+//! \brief PoolAllocator
+//! Stateless allocator drawing from the calling thread's PoolArena, meant for
+//! the node-based containers: PoolAllocator<T> plugs into CList and CQueue
+//! (see CPoolList / CPoolQueue) so list nodes and deque chunks stop costing a
+//! malloc/free each. Over-aligned types bypass the pool.
+template <typename T, PoolBacking Backing = PoolBacking::Heap>
+class PoolAllocator {
+  public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    // The non-type template parameter keeps allocator_traits from rebinding on its own.
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, Backing>;
+    };
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, Backing> &) noexcept
+    {
+    }
+
+    [[nodiscard]] T *allocate(std::size_t n)
+    {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+
+        if constexpr (alignof(T) > PoolArena::kGranularity) {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        } else {
+            return static_cast<T *>(PoolArena::ThisThread<Backing>().Allocate(n * sizeof(T)));
+        }
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        if constexpr (alignof(T) > PoolArena::kGranularity) {
+            ::operator delete(p, n * sizeof(T), std::align_val_t{alignof(T)});
+        } else {
+            PoolArena::ThisThread<Backing>().Deallocate(p, n * sizeof(T));
+        }
+    }
+
+    //! Usage of the calling thread's arena behind this allocator.
+    [[nodiscard]] static ArenaStats Stats() { return PoolArena::ThisThread<Backing>().Stats(); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, Backing> &) const noexcept
+    {
+        return true;
+    }
+};
+
+} // namespace utils
+
+#endif // POOL_ALLOCATOR_H
@@ -2,6 +2,7 @@
 #define QUEUE_H_
 
 #include <typetraits.h>
+#include <pool_allocator.h>
 #include <algorithm>
 #include <deque>
 #include <memory>
@@ -76,6 +77,10 @@ public:
 template <typename alloc, typename ElementType = typename alloc::value_type>
 CQueue(const alloc&) -> CQueue<ElementType, alloc>;
 
+// CQueue whose storage comes from the calling thread's PoolArena instead of malloc
+template <typename ElementType, PoolBacking backing = PoolBacking::Heap>
+using CPoolQueue = CQueue<ElementType, PoolAllocator<ElementType, backing>>;
+
 } // namespace utils
 
 
@@ -0,0 +1,50 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace utils {
+
+class RealtimeError : public std::system_error {
+  public:
+    explicit RealtimeError(const std::string &what, int errnum = errno)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//! Highest SCHED_FIFO priority accepted by SetCurrentThreadPriority().
+inline constexpr int kMaxRealtimePriority = 99;
+
+//! Runs the calling thread under SCHED_FIFO at \p priority (1..kMaxRealtimePriority); 0 puts it
+//! back under the normal scheduler. Throws RealtimeError, EPERM without CAP_SYS_NICE or a
+//! sufficient RLIMIT_RTPRIO.
+void SetCurrentThreadPriority(int priority);
+
+//! Locks every current and future page of the process into memory (mlockall) and keeps malloc
+//! from returning freed memory to the kernel, so neither has to be faulted in again. Not
+//! inherited by fork()ed children. Throws RealtimeError.
+void LockProcessMemory();
+
+//! Stack size of threads started from now on (std::thread included). Locked memory covers the
+//! whole stack of every thread, so real-time mode uses far less than the 8 MiB default.
+void SetDefaultThreadStackSize(std::size_t bytes);
+
+//! Stack a real-time thread touches before it starts serving.
+inline constexpr std::size_t kStackPrefault = 64 * 1024;
+
+//! Writes \p bytes of the calling thread's stack below the current frame, so the first deep call
+//! on a latency critical path does not take page faults.
+void PrefaultStack(std::size_t bytes = kStackPrefault) noexcept;
+
+//! Why real-time mode will not fully work for this process, one message per missing privilege
+//! (SCHED_FIFO up to \p priority, unlimited locked memory); empty when nothing is missing.
+std::vector<std::string> RealtimePrivilegeProblems(int priority);
+
+} // namespace utils
+
+#endif // REALTIME_H
@@ -0,0 +1,84 @@
+#ifndef REQUEST_TRACE_H
+#define REQUEST_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+//! One finished span. \p name has to be a string literal (or live as long as the process).
+struct TraceSpan {
+    const char *name;
+    //! Timeline the span belongs to, e.g. the session id.
+    uint64_t track;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+};
+
+//*****************************************************************************
+//! \brief RequestTrace
+//! Span recorder for finding out where the time of a slow request went. Off
+//! by default; while off, asking whether to trace costs one relaxed load.
+//! Once enabled, every nth request is sampled and its spans are stored in a
+//! ring of the recording thread (no lock; a full ring overwrites its oldest
+//! spans), so a dump shows the most recent requests.
+//!
+//! Rings of threads that exited are kept, up to kMaxRetiredThreads, so the
+//! spans of sessions that already ended still show up in a dump.
+//! WriteChromeTrace() writes the Chrome trace-event JSON that Perfetto and
+//! chrome://tracing open, with one timeline per track.
+class RequestTrace {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Spans one thread keeps; the ring is allocated on the thread's first span.
+    static constexpr std::size_t kThreadSpans = 512;
+    static constexpr std::size_t kMaxRetiredThreads = 256;
+
+    //! Starts sampling every \p sampleEvery th request (1 = all of them).
+    static void Enable(uint64_t sampleEvery = 1) noexcept;
+    static void Disable() noexcept;
+    [[nodiscard]] static bool Enabled() noexcept
+    {
+        return sampleEvery_.load(std::memory_order_relaxed) != 0;
+    }
+    //! 0 while disabled.
+    [[nodiscard]] static uint64_t SampleEvery() noexcept
+    {
+        return sampleEvery_.load(std::memory_order_relaxed);
+    }
+
+    //! Decides whether the request about to start is traced; the answer covers all its spans.
+    [[nodiscard]] static bool Sample() noexcept
+    {
+        const uint64_t every = sampleEvery_.load(std::memory_order_relaxed);
+        return every != 0 && sampled_.fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    //! Stores a span in the calling thread's ring, also while disabled: the caller sampled.
+    static void Record(const char *name, uint64_t track, Clock::time_point start,
+                       Clock::time_point end) noexcept;
+
+    //! Spans of all threads, including ones that exited, in no particular order.
+    [[nodiscard]] static std::vector<TraceSpan> Collect();
+    //! Forgets every span recorded so far.
+    static void Clear() noexcept;
+
+    //! Writes \p spans as Chrome trace-event JSON; every track becomes a thread named
+    //! "<trackName> <track>" of process \p pid. Returns the number of spans written.
+    static std::size_t WriteChromeTrace(std::ostream &out, const std::vector<TraceSpan> &spans,
+                                        int pid, std::string_view trackName);
+
+  private:
+    static std::atomic<uint64_t> sampleEvery_;
+    static std::atomic<uint64_t> sampled_;
+};
+
+} // namespace utils
+
+#endif // REQUEST_TRACE_H
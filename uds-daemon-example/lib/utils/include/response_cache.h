@@ -0,0 +1,91 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <cache_line.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+struct ResponseCacheOptions {
+    //! Upper bound of key, value and bookkeeping bytes held; zero disables the cache.
+    std::size_t byteBudget{0};
+    //! Entries older than this are not served any more; zero keeps them until evicted.
+    std::chrono::milliseconds ttl{0};
+    //! Independent shards, rounded up to a power of two.
+    std::size_t shards{16};
+};
+
+struct ResponseCacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t insertions{0};
+    //! Entries dropped to stay within the byte budget.
+    uint64_t evictions{0};
+    //! Entries found past their TTL.
+    uint64_t expirations{0};
+    uint64_t invalidations{0};
+    std::size_t entries{0};
+    std::size_t bytes{0};
+};
+
+//*****************************************************************************
+//! \brief ResponseCache
+//! Maps request bytes to the reply computed for them, for handlers whose reply
+//! depends on nothing but the request. Keys are hashed once; the hash picks a
+//! shard with its own lock, so lookups from different session threads rarely
+//! meet. Each shard is an open-addressing table (linear probing, backward shift
+//! deletion) over an entry slab, evicted in CLOCK order: a hit only sets a
+//! reference bit, nothing is relinked.
+//!
+//! Thread-safe.
+class ResponseCache {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ResponseCache(const ResponseCacheOptions &options = {});
+    ~ResponseCache();
+
+    ResponseCache(const ResponseCache &) = delete;
+    ResponseCache &operator=(const ResponseCache &) = delete;
+
+    //! Copies the cached reply to \p request into \p response; false on a miss.
+    bool Lookup(std::string_view request, std::string &response,
+                Clock::time_point now = Clock::now());
+
+    //! Stores or replaces the reply to \p request. False if the cache is disabled or the entry
+    //! is larger than a shard's share of the budget.
+    bool Insert(std::string_view request, std::string_view response,
+                Clock::time_point now = Clock::now());
+
+    //! Drops the entry of \p request; false if there was none.
+    bool Invalidate(std::string_view request);
+    void InvalidateAll();
+
+    //! Applies a new budget and TTL; entries beyond the new budget are evicted right away. The
+    //! shard count is fixed at construction.
+    void Reconfigure(const ResponseCacheOptions &options);
+
+    [[nodiscard]] ResponseCacheStats Stats() const;
+
+    [[nodiscard]] static uint64_t Hash(std::string_view bytes) noexcept;
+
+  private:
+    class Shard;
+
+    Shard &ShardOf(uint64_t hash) noexcept;
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shardMask_;
+};
+
+} // namespace utils
+
+#endif // RESPONSE_CACHE_H
@@ -1,6 +1,9 @@
 #ifndef SD_NOTIFY_H
 #define SD_NOTIFY_H
 
+#include <chrono>
+#include <cstddef>
+#include <span>
 #include <string_view>
 
 namespace systemd_notify {
@@ -10,6 +13,19 @@ void stopping();
 void reloading(std::string_view msg = "Reloading");
 void status(std::string_view msg);
 
+//! Asks systemd to wait at least \p time from now for the current start, reload or stop
+//! (EXTEND_TIMEOUT_USEC), e.g. so a bounded connection drain is not cut by TimeoutStopSec.
+void extendTimeout(std::chrono::microseconds time);
+
+//! Number of fds the service may keep in the systemd fd store ($FDSTORE), 0 if unavailable.
+std::size_t fdStoreLimit() noexcept;
+
+//! Parks \p fds in the systemd fd store under \p name (FDSTORE=1).
+bool storeFds(std::string_view name, std::span<const int> fds);
+
+//! Drops every fd stored under \p name (FDSTOREREMOVE=1).
+void removeStoredFds(std::string_view name);
+
 } // namespace systemd_notify
 
 #endif /* SD_NOTIFY_H */
@@ -2,6 +2,8 @@
 #define SD_SOCKET_H
 
 #include <filesystem>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace systemd_socket {
@@ -9,10 +11,22 @@ namespace systemd_socket {
 struct SocketInfo {
     int fd;
     std::filesystem::path path;
+    //! FileDescriptorName= of the socket unit or FDNAME= of an fd store entry.
+    std::string name;
 };
 
+//! Passed fd that is not a listening socket, e.g. a connection parked in the fd store.
+struct StoredFd {
+    int fd;
+    std::string name;
+};
+
+//! Listening AF_UNIX stream sockets passed by systemd (socket units and fd store).
 std::vector<SocketInfo> getSystemdUnixSockets() noexcept;
 
+//! Passed non-listening stream sockets whose name starts with \p prefix.
+std::vector<StoredFd> getSystemdStoredFds(std::string_view prefix) noexcept;
+
 } // namespace systemd_socket
 
 #endif /* SD_SOCKET_H */
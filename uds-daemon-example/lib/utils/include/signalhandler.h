@@ -2,9 +2,12 @@
 #define SIGNALHANDLER_H
 
 #include <cerrno>
+#include <chrono>
 #include <csignal>
 #include <initializer_list>
+#include <optional>
 #include <pthread.h>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -24,9 +27,12 @@ class SignalError : public std::system_error {
 class SignalHandler {
   public:
     explicit SignalHandler(std::initializer_list<int> signals);
+    explicit SignalHandler(std::span<const int> signals);
     ~SignalHandler();
 
     int wait() const;
+    //! Like wait() but gives up after \p timeout; std::nullopt if no signal arrived.
+    std::optional<int> waitFor(std::chrono::milliseconds timeout) const;
     static void enableSegfaultHandler();
 
   private:
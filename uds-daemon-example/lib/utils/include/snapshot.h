@@ -0,0 +1,98 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace utils {
+
+//*****************************************************************************
+//! \brief Snapshot
+//! Holds an immutable value that is replaced as a whole by Publish().
+//! Hot paths read through a Reader: it keeps a reference to the snapshot it
+//! saw last and only compares a generation counter per access, so readers
+//! take no lock until a new value was published. Published values stay
+//! alive as long as any reader still refers to them.
+template <typename T>
+class Snapshot {
+  public:
+    explicit Snapshot(T initial = T{})
+     : current_(std::make_shared<const T>(std::move(initial)))
+    {
+    }
+
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+
+    void Publish(T value)
+    {
+        auto next = std::make_shared<const T>(std::move(value));
+        {
+            std::lock_guard lock(mutex_);
+            current_.swap(next);
+        }
+        generation_.fetch_add(1, std::memory_order_release);
+        // The previous value is released here, outside the lock.
+    }
+
+    [[nodiscard]] std::shared_ptr<const T> Load() const
+    {
+        std::lock_guard lock(mutex_);
+        return current_;
+    }
+
+    [[nodiscard]] uint64_t Generation() const noexcept
+    {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    //*************************************************************************
+    //! \brief Reader
+    //! Per-thread cached view of a Snapshot; not thread-safe itself.
+    class Reader {
+      public:
+        explicit Reader(const Snapshot &snapshot)
+         : snapshot_(&snapshot)
+        {
+            Refresh();
+        }
+
+        //! Picks up a newer value if one was published; returns true if it did.
+        bool Refresh()
+        {
+            const uint64_t generation = snapshot_->Generation();
+            if (value_ && generation == generation_)
+                return false;
+
+            // Read the generation first: a publish in between only causes one more refresh.
+            generation_ = generation;
+            value_ = snapshot_->Load();
+            return true;
+        }
+
+        const T &operator*()
+        {
+            Refresh();
+            return *value_;
+        }
+
+        const T *operator->() { return &**this; }
+
+      private:
+        const Snapshot *snapshot_;
+        std::shared_ptr<const T> value_;
+        uint64_t generation_{0};
+    };
+
+  private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const T> current_;
+    std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace utils
+
+#endif // SNAPSHOT_H
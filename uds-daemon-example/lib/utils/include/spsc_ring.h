@@ -0,0 +1,161 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <cache_line.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace utils {
+
+//*****************************************************************************
+//! \brief SpscRing
+//! Bounded wait-free ring for exactly one producer and one consumer thread.
+//! The capacity is rounded up to a power of two so positions wrap with a
+//! mask. Producer and consumer indices live on separate cache lines and each
+//! side keeps a cached copy of the other's index, so the shared lines are
+//! only touched when the ring looks full (producer) or empty (consumer).
+//! The batch calls publish many elements with a single release store.
+template <typename T>
+class SpscRing {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "SpscRing elements have to be nothrow move constructible");
+
+  public:
+    explicit SpscRing(std::size_t capacity)
+     : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+     , mask_(capacity_ - 1)
+     , slots_(std::make_unique<Slot[]>(capacity_))
+    {
+    }
+
+    ~SpscRing()
+    {
+        while (TryPop()) {
+        }
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    //*************************************************************************
+    // Producer side
+
+    template <typename... Args>
+    bool TryEmplace(Args &&...args)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == capacity_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == capacity_)
+                return false;
+        }
+
+        std::construct_at(slots_[tail & mask_].ptr(), std::forward<Args>(args)...);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(const T &value) { return TryEmplace(value); }
+    bool TryPush(T &&value) { return TryEmplace(std::move(value)); }
+
+    //! Moves as many of \p items as fit into the ring; returns how many were taken.
+    std::size_t PushBatch(std::span<T> items)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t free = capacity_ - (tail - headCache_);
+        if (free < items.size()) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            free = capacity_ - (tail - headCache_);
+        }
+
+        const std::size_t n = std::min(free, items.size());
+        for (std::size_t i = 0; i < n; ++i)
+            std::construct_at(slots_[(tail + i) & mask_].ptr(), std::move(items[i]));
+        if (n > 0)
+            tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    //*************************************************************************
+    // Consumer side
+
+    std::optional<T> TryPop()
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_)
+                return std::nullopt;
+        }
+
+        T *slot = slots_[head & mask_].ptr();
+        std::optional<T> value(std::move(*slot));
+        std::destroy_at(slot);
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    //! Moves up to \p max elements to \p out; returns how many were popped.
+    template <typename OutputIt>
+    std::size_t PopBatch(OutputIt out, std::size_t max)
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t available = tailCache_ - head;
+        if (available < max) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            available = tailCache_ - head;
+        }
+
+        const std::size_t n = std::min(available, max);
+        for (std::size_t i = 0; i < n; ++i) {
+            T *slot = slots_[(head + i) & mask_].ptr();
+            *out++ = std::move(*slot);
+            std::destroy_at(slot);
+        }
+        if (n > 0)
+            head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    //*************************************************************************
+    // Either side
+
+    [[nodiscard]] std::size_t Capacity() const noexcept { return capacity_; }
+
+    //! Exact only while neither side is active.
+    [[nodiscard]] std::size_t SizeApprox() const noexcept
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct Slot {
+        alignas(T) std::byte storage[sizeof(T)];
+        T *ptr() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const std::unique_ptr<Slot[]> slots_;
+
+    // Consumer line: its index and its view of the producer's.
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+    std::size_t tailCache_{0};
+
+    // Producer line.
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    std::size_t headCache_{0};
+};
+
+} // namespace utils
+
+#endif // SPSC_RING_H
@@ -0,0 +1,150 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <string>
+#include <system_error>
+
+namespace utils {
+
+class TimerWheelError : public std::system_error {
+  public:
+    explicit TimerWheelError(const std::string &what, int errnum = errno)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//*****************************************************************************
+//! \brief TimerId
+//! Handle of a scheduled timer. Stale handles (fired or cancelled timers) are
+//! detected by the generation counter and ignored.
+struct TimerId {
+    static constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index{kInvalid};
+    uint32_t generation{0};
+
+    [[nodiscard]] bool isValid() const noexcept { return index != kInvalid; }
+};
+
+//*****************************************************************************
+//! \brief TimerWheel
+//! Hierarchical timing wheel (4 levels x 64 slots) with O(1) schedule, cancel
+//! and reset. Timers are kept in a node slab with index links, so none of the
+//! operations allocate once the slab has grown to the working set.
+//!
+//! The wheel is driven by a single timerfd: register Fd() with the event loop
+//! and call OnReadable() when it fires. The timerfd is armed one-shot for the
+//! next tick with something to expire or cascade, and the wheel skips the
+//! empty ticks in between, so an idle wheel costs no wakeups. Resolution is
+//! one tick; delays beyond 64^4 ticks are re-cascaded.
+//!
+//! Not thread-safe: all calls, including the ones from callbacks, have to come
+//! from the thread driving the wheel or be serialized by the owner.
+class TimerWheel final {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using TimerCallback = std::function<void()>;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+    TimerWheel(TimerWheel &&) = delete;
+    TimerWheel &operator=(TimerWheel &&) = delete;
+
+    //! One-shot timer firing after \p delay.
+    TimerId Schedule(Clock::duration delay, TimerCallback cb);
+
+    //! Periodic timer firing every \p period until cancelled.
+    TimerId SchedulePeriodic(Clock::duration period, TimerCallback cb);
+
+    bool Cancel(TimerId id) noexcept;
+
+    //! Moves a pending timer to now + \p delay (keeps the period of periodic timers).
+    bool Reset(TimerId id, Clock::duration delay) noexcept;
+
+    [[nodiscard]] bool IsActive(TimerId id) const noexcept;
+    [[nodiscard]] std::size_t Size() const noexcept { return active_; }
+
+    //! Current time of the wheel, i.e. the last tick processed.
+    [[nodiscard]] Clock::time_point Now() const noexcept;
+
+    //! timerfd to be polled by the event loop.
+    [[nodiscard]] int Fd() const noexcept { return timerFd_; }
+
+    //! Drains the timerfd and runs everything due; returns the number of callbacks run.
+    std::size_t OnReadable();
+
+    //! Processes all ticks up to \p now; returns the number of callbacks run.
+    std::size_t AdvanceTo(Clock::time_point now);
+
+  private:
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1U << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlots - 1;
+    static constexpr unsigned kLevels = 4;
+    static constexpr uint32_t kExpiredList = kLevels * kSlots;
+    static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        uint32_t prev{kNil};
+        uint32_t next{kNil};
+        uint32_t list{kNil};
+        uint32_t generation{0};
+        uint64_t expires{0};
+        uint64_t period{0};
+        bool active{false};
+        bool cancelled{false};
+        TimerCallback cb;
+    };
+
+    uint64_t TicksOf(Clock::duration d) const noexcept;
+    uint64_t TickOf(Clock::time_point t) const noexcept;
+
+    TimerId Add(Clock::duration delay, uint64_t period, TimerCallback &&cb);
+    uint32_t Allocate();
+    void Release(uint32_t index) noexcept;
+    Node *Lookup(TimerId id) noexcept;
+    const Node *Lookup(TimerId id) const noexcept;
+
+    void Insert(uint32_t index) noexcept;
+    void Link(uint32_t index, uint32_t list) noexcept;
+    void Unlink(uint32_t index) noexcept;
+    void Cascade(unsigned level, uint32_t slot) noexcept;
+    //! First tick after the current one with a timer to expire or a slot to cascade.
+    uint64_t NextTick() const noexcept;
+    //! Moves the wheel up to the clock as far as it can without stepping; returns the tick of now.
+    uint64_t CatchUp() noexcept;
+    std::size_t Step();
+    std::size_t RunExpired();
+
+    void Rearm() noexcept;
+    void Disarm() noexcept;
+
+    static constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+    int timerFd_{-1};
+    uint64_t armedTick_{kNever};
+    Clock::duration tick_;
+    Clock::time_point origin_;
+    uint64_t currentTick_{0};
+    std::size_t active_{0};
+    uint32_t running_{kNil};
+    uint32_t freeList_{kNil};
+    std::array<uint32_t, kLevels * kSlots + 1> heads_{};
+    std::deque<Node> nodes_;
+};
+
+} // namespace utils
+
+#endif // TIMER_WHEEL_H
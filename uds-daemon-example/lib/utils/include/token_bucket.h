@@ -0,0 +1,92 @@
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace utils {
+
+//*****************************************************************************
+//! \brief TokenBucket
+//! Rate limiter allowing \p rate requests per second with bursts of up to
+//! \p burst. Kept as a single "theoretical arrival time" (GCRA), so a request
+//! costs one compare-and-swap and the bucket can be shared between threads
+//! without a lock. A rate of zero means unlimited.
+class TokenBucket {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TokenBucket(double rate = 0, double burst = 1) noexcept { Reconfigure(rate, burst); }
+
+    TokenBucket(const TokenBucket &) = delete;
+    TokenBucket &operator=(const TokenBucket &) = delete;
+
+    void Reconfigure(double rate, double burst) noexcept
+    {
+        const int64_t interval =
+            rate > 0 ? std::max<int64_t>(static_cast<int64_t>(1e9 / rate), 1) : 0;
+        const double extra = std::max(burst, 1.0) - 1.0;
+        interval_.store(interval, std::memory_order_relaxed);
+        tolerance_.store(static_cast<int64_t>(extra * static_cast<double>(interval)),
+                         std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool Unlimited() const noexcept
+    {
+        return interval_.load(std::memory_order_relaxed) == 0;
+    }
+
+    //! Takes one token, borrowing from the future if the bucket is empty; returns how long the
+    //! caller has to wait before the request conforms (zero if it already does).
+    Clock::duration Reserve(Clock::time_point now = Clock::now()) noexcept
+    {
+        const int64_t interval = interval_.load(std::memory_order_relaxed);
+        if (interval == 0)
+            return Clock::duration::zero();
+
+        const int64_t tolerance = tolerance_.load(std::memory_order_relaxed);
+        const int64_t t = Nanos(now);
+        int64_t tat = tat_.load(std::memory_order_relaxed);
+        int64_t start;
+        do {
+            start = std::max(tat, t);
+        } while (!tat_.compare_exchange_weak(tat, start + interval, std::memory_order_relaxed));
+
+        return std::chrono::nanoseconds(std::max<int64_t>(start - t - tolerance, 0));
+    }
+
+    //! Takes one token only if the request conforms right now.
+    bool TryAcquire(Clock::time_point now = Clock::now()) noexcept
+    {
+        const int64_t interval = interval_.load(std::memory_order_relaxed);
+        if (interval == 0)
+            return true;
+
+        const int64_t tolerance = tolerance_.load(std::memory_order_relaxed);
+        const int64_t t = Nanos(now);
+        int64_t tat = tat_.load(std::memory_order_relaxed);
+        int64_t start;
+        do {
+            start = std::max(tat, t);
+            if (start - t > tolerance)
+                return false;
+        } while (!tat_.compare_exchange_weak(tat, start + interval, std::memory_order_relaxed));
+        return true;
+    }
+
+  private:
+    static int64_t Nanos(Clock::time_point t) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    std::atomic<int64_t> tat_{0};
+    std::atomic<int64_t> interval_{0};
+    std::atomic<int64_t> tolerance_{0};
+};
+
+} // namespace utils
+
+#endif // TOKEN_BUCKET_H
@@ -0,0 +1,26 @@
+#ifndef TYPETRAITS_H_
+#define TYPETRAITS_H_
+
+#include <type_traits>
+
+namespace utils::detail
+{
+
+// True if T is a complete type at the point of instantiation; sizeof is ill-formed for
+// forward declared types, so the specialization drops out by SFINAE.
+template <typename T, typename = void>
+struct is_complete : std::false_type
+{
+};
+
+template <typename T>
+struct is_complete<T, std::void_t<decltype(sizeof(T))>> : std::true_type
+{
+};
+
+template <typename T>
+inline constexpr bool is_complete_v = is_complete<T>::value;
+
+} // namespace utils::detail
+
+#endif /* TYPETRAITS_H_ */
@@ -0,0 +1,55 @@
+#ifndef USDT_H
+#define USDT_H
+
+//! Static tracepoints (USDT) of provider "uds", for perf and bpftrace to attach to a running
+//! daemon without a rebuild. A probe is a single nop until a tracer attaches; its arguments are
+//! values the surrounding code has at hand anyway. The probes:
+//!
+//!   session_accept  (session id, fd)
+//!   session_close   (session id, replies sent, closed by the peer)
+//!   receive_start   (fd, buffer size)
+//!   receive_end     (fd, bytes read or negated error code)
+//!   send            (fd, bytes sent or negated error code, buffers)
+//!   select_wake     (FdSetRet, fds ready, fd)
+//!   handler_start   (session id, request size)
+//!   handler_end     (session id, reply size)
+//!
+//! tools/bpftrace has scripts for latency and size distributions; with perf:
+//!   perf buildid-cache --add /usr/bin/uds-daemon && perf record -e sdt_uds:receive_end -p PID
+//!
+//! Compiled in with ENABLE_USDT (the default) when sys/sdt.h is available; otherwise UDS_PROBE
+//! compiles to nothing and its arguments are type checked but not evaluated.
+
+#ifdef UDS_USDT_ENABLED
+
+#include <sys/sdt.h>
+
+// sys/sdt.h builds its operands with C casts; they are not ours to fix.
+#define UDS_PROBE(name, ...)                                                                      \
+    do {                                                                                          \
+        _Pragma("GCC diagnostic push");                                                           \
+        _Pragma("GCC diagnostic ignored \"-Wold-style-cast\"");                                   \
+        _Pragma("GCC diagnostic ignored \"-Wuseless-cast\"");                                     \
+        STAP_PROBEV(uds, name __VA_OPT__(, ) __VA_ARGS__);                                        \
+        _Pragma("GCC diagnostic pop");                                                            \
+    } while (false)
+
+#else
+
+namespace utils::usdt_detail {
+template <typename... Args>
+constexpr void unused(const Args &...) noexcept
+{
+}
+} // namespace utils::usdt_detail
+
+// The arguments are still type checked, so a probe cannot rot in builds without sys/sdt.h.
+#define UDS_PROBE(name, ...)                                                                      \
+    do {                                                                                          \
+        if constexpr (false)                                                                      \
+            utils::usdt_detail::unused(__VA_ARGS__);                                              \
+    } while (false)
+
+#endif
+
+#endif // USDT_H
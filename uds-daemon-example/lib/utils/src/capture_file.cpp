@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <capture_file.h>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace utils {
+
+namespace {
+
+// The writer thread flushes at least this often, and earlier once the buffer is half full.
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+constexpr std::size_t padded(std::size_t length) noexcept { return (length + 7) & ~std::size_t{7}; }
+
+template <typename T>
+std::span<const std::byte> bytesOf(const T &value) noexcept
+{
+    return std::as_bytes(std::span(&value, 1));
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter(const std::filesystem::path &path, uint64_t maxBytes)
+ : path_(path)
+ , maxBytes_(maxBytes)
+ , started_(Clock::now())
+{
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd_ < 0)
+        throw CaptureFileError(std::format("cannot create capture file {}", path.string()));
+
+    CaptureFileHeader header;
+    header.recordHeaderSize = sizeof(CaptureRecordHeader);
+    header.startedAt = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+    if (::write(fd_, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+        const int err = errno;
+        ::close(fd_);
+        throw CaptureFileError(std::format("cannot write capture file {}", path.string()), err);
+    }
+    stats_.bytes = sizeof(header);
+
+    pending_.reserve(kBufferSize);
+    thread_ = std::thread(&CaptureWriter::Run, this);
+}
+
+CaptureWriter::~CaptureWriter() { Close(); }
+
+bool CaptureWriter::Record(uint64_t session, Clock::time_point receivedAt,
+                           std::span<const std::byte> request) noexcept
+{
+    if (closed_.load(std::memory_order_acquire))
+        return false;
+
+    // A request received just before the capture started is recorded at its very beginning.
+    const auto offset = std::max(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(receivedAt - started_).count(),
+        std::chrono::nanoseconds::rep{0});
+    const CaptureRecordHeader header{
+        .offsetNs = static_cast<uint64_t>(offset),
+        .session = session,
+        .length = static_cast<uint32_t>(request.size()),
+        .reserved = 0};
+    const std::size_t size = sizeof(header) + padded(request.size());
+    constexpr std::array<std::byte, 8> kPadding{};
+
+    bool flush = false;
+    {
+        std::lock_guard lock(mutex_);
+        if (closing_)
+            return false;
+        if (stats_.bytes + size > maxBytes_ || pending_.size() + size > kBufferSize) {
+            ++stats_.dropped;
+            return false;
+        }
+        // Within the reserved capacity: no allocation under the lock.
+        const auto raw = bytesOf(header);
+        pending_.insert(pending_.end(), raw.begin(), raw.end());
+        pending_.insert(pending_.end(), request.begin(), request.end());
+        pending_.insert(pending_.end(), kPadding.begin(),
+                        kPadding.begin() + static_cast<std::ptrdiff_t>(padded(request.size()) -
+                                                                       request.size()));
+        ++stats_.records;
+        stats_.bytes += size;
+        flush = pending_.size() >= kBufferSize / 2;
+    }
+    if (flush)
+        wake_.notify_one();
+    return true;
+}
+
+void CaptureWriter::Close() noexcept
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (closing_)
+            return;
+        closing_ = true;
+    }
+    closed_.store(true, std::memory_order_release);
+    wake_.notify_one();
+    if (thread_.joinable())
+        thread_.join();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+CaptureStats CaptureWriter::Stats() const noexcept
+{
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void CaptureWriter::Run()
+{
+    std::vector<std::byte> batch;
+    batch.reserve(kBufferSize);
+    for (bool last = false; !last;) {
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait_for(lock, kFlushInterval,
+                           [this]() { return closing_ || pending_.size() >= kBufferSize / 2; });
+            last = closing_;
+            batch.swap(pending_);
+        }
+        Write(batch);
+        batch.clear();
+    }
+}
+
+void CaptureWriter::Write(std::span<const std::byte> data) noexcept
+{
+    while (!data.empty()) {
+        const ssize_t written = ::write(fd_, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            spdlog::error("Capture {}: write failed, capture stopped: {}", path_.string(),
+                          std::strerror(errno));
+            closed_.store(true, std::memory_order_release);
+            return;
+        }
+        data = data.subspan(static_cast<std::size_t>(written));
+    }
+}
+
+CaptureReader::CaptureReader(const std::filesystem::path &path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw CaptureFileError(std::format("cannot open capture file {}", path.string()));
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || static_cast<std::size_t>(st.st_size) < sizeof(header_)) {
+        ::close(fd);
+        throw CaptureFileError(std::format("{} is not a capture file", path.string()), EINVAL);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    void *mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        throw CaptureFileError(std::format("cannot map capture file {}", path.string()));
+    data_ = static_cast<const std::byte *>(mapped);
+
+    std::memcpy(&header_, data_, sizeof(header_));
+    if (header_.magic != CaptureFileHeader::kMagic || header_.headerSize != sizeof(header_) ||
+        header_.recordHeaderSize != sizeof(CaptureRecordHeader)) {
+        ::munmap(const_cast<std::byte *>(data_), size_);
+        throw CaptureFileError(
+            std::format("{} is not a capture file of this version or byte order", path.string()),
+            EINVAL);
+    }
+}
+
+CaptureReader::~CaptureReader() { ::munmap(const_cast<std::byte *>(data_), size_); }
+
+std::vector<CaptureReader::Record> CaptureReader::Records() const
+{
+    std::vector<Record> records;
+    std::size_t pos = header_.headerSize;
+    while (pos + sizeof(CaptureRecordHeader) <= size_) {
+        CaptureRecordHeader header;
+        std::memcpy(&header, data_ + pos, sizeof(header));
+        const std::size_t payload = pos + sizeof(header);
+        // A record cut short by a crash of the writer ends the capture.
+        if (payload + header.length > size_)
+            break;
+        records.push_back(Record{.offset = std::chrono::nanoseconds(header.offsetNs),
+                                 .session = header.session,
+                                 .request = std::span(data_ + payload, header.length)});
+        pos = payload + padded(header.length);
+    }
+    return records;
+}
+
+} // namespace utils
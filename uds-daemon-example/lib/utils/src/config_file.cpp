@@ -0,0 +1,75 @@
+#include <config_file.h>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+using namespace utils;
+
+namespace {
+
+std::string_view trim(std::string_view s) noexcept
+{
+    constexpr std::string_view whitespace = " \t\r";
+    const auto first = s.find_first_not_of(whitespace);
+    if (first == std::string_view::npos)
+        return {};
+    const auto last = s.find_last_not_of(whitespace);
+    return s.substr(first, last - first + 1);
+}
+
+} // namespace
+
+ConfigFile ConfigFile::Load(const std::filesystem::path &path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw ConfigFileError(std::format("cannot open config file {}", path.string()));
+
+    std::ostringstream text;
+    text << in.rdbuf();
+    return Parse(text.str(), path.string());
+}
+
+ConfigFile ConfigFile::Parse(std::string_view text, std::string_view source)
+{
+    ConfigFile config;
+    std::size_t lineNo = 0;
+
+    while (!text.empty()) {
+        const auto eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text = (eol == std::string_view::npos) ? std::string_view{} : text.substr(eol + 1);
+        ++lineNo;
+
+        line = trim(line);
+        if (line.empty() || line.front() == '#' || line.front() == ';')
+            continue;
+
+        const auto eq = line.find('=');
+        if (eq == std::string_view::npos)
+            throw ConfigFileError(std::format("{}:{}: expected 'key = value'", source, lineNo),
+                                  EINVAL);
+
+        const std::string_view key = trim(line.substr(0, eq));
+        std::string_view value = line.substr(eq + 1);
+        if (const auto comment = value.find(" #"); comment != std::string_view::npos)
+            value = value.substr(0, comment);
+        value = trim(value);
+
+        if (key.empty())
+            throw ConfigFileError(std::format("{}:{}: missing key", source, lineNo), EINVAL);
+
+        if (!config.entries_.emplace(std::string(key), std::string(value)).second)
+            throw ConfigFileError(std::format("{}:{}: duplicate key '{}'", source, lineNo, key),
+                                  EINVAL);
+    }
+
+    return config;
+}
+
+std::optional<std::string_view> ConfigFile::Get(std::string_view key) const
+{
+    if (auto it = entries_.find(key); it != entries_.end())
+        return it->second;
+    return std::nullopt;
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <charconv>
+#include <cpu_affinity.h>
+#include <filesystem>
+#include <format>
+#include <pthread.h>
+
+using namespace utils;
+
+namespace {
+
+std::string_view trim(std::string_view s) noexcept
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+unsigned parseCpu(std::string_view token, std::string_view list)
+{
+    token = trim(token);
+    unsigned cpu = 0;
+    auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), cpu);
+    if (token.empty() || ec != std::errc{} || end != token.data() + token.size())
+        throw CpuAffinityError(std::format("invalid cpu list '{}'", list), EINVAL);
+    return cpu;
+}
+
+// Collapses sorted cpus into the "a-b,c" notation.
+std::string formatRanges(const std::vector<unsigned> &values)
+{
+    std::string out;
+    for (std::size_t i = 0; i < values.size();) {
+        std::size_t j = i;
+        while (j + 1 < values.size() && values[j + 1] == values[j] + 1)
+            ++j;
+
+        if (!out.empty())
+            out += ',';
+        out += (i == j) ? std::format("{}", values[i]) : std::format("{}-{}", values[i], values[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+} // namespace
+
+CpuSet::CpuSet() noexcept { CPU_ZERO(&set_); }
+
+CpuSet CpuSet::Parse(std::string_view list)
+{
+    CpuSet result;
+    const std::string_view full = list;
+
+    list = trim(list);
+    if (list.empty())
+        return result;
+
+    for (bool more = true; more;) {
+        const auto comma = list.find(',');
+        const std::string_view item = list.substr(0, comma);
+        more = comma != std::string_view::npos;
+        if (more)
+            list.remove_prefix(comma + 1);
+
+        const auto dash = item.find('-');
+        const unsigned first = parseCpu(item.substr(0, dash), full);
+        const unsigned last =
+            (dash == std::string_view::npos) ? first : parseCpu(item.substr(dash + 1), full);
+        if (last < first)
+            throw CpuAffinityError(std::format("invalid cpu range in '{}'", full), EINVAL);
+
+        for (unsigned cpu = first; cpu <= last; ++cpu)
+            result.Add(cpu);
+    }
+    return result;
+}
+
+CpuSet CpuSet::OfCurrentThread()
+{
+    CpuSet result;
+    if (int ret = pthread_getaffinity_np(pthread_self(), sizeof(result.set_), &result.set_);
+        ret != 0)
+        throw CpuAffinityError("pthread_getaffinity_np failed", ret);
+    return result;
+}
+
+void CpuSet::Add(unsigned cpu)
+{
+    if (cpu >= CPU_SETSIZE)
+        throw CpuAffinityError(std::format("cpu {} out of range", cpu), EINVAL);
+    CPU_SET(cpu, &set_);
+}
+
+bool CpuSet::Contains(unsigned cpu) const noexcept
+{
+    return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set_);
+}
+
+std::size_t CpuSet::Count() const noexcept
+{
+    return static_cast<std::size_t>(CPU_COUNT(&set_));
+}
+
+bool CpuSet::IsSubsetOf(const CpuSet &other) const noexcept
+{
+    cpu_set_t both;
+    CPU_AND(&both, &set_, &other.set_);
+    return CPU_EQUAL(&both, &set_);
+}
+
+std::vector<unsigned> CpuSet::Cpus() const
+{
+    std::vector<unsigned> cpus;
+    for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set_))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::string CpuSet::ToString() const { return formatRanges(Cpus()); }
+
+bool CpuSet::operator==(const CpuSet &other) const noexcept
+{
+    return CPU_EQUAL(&set_, &other.set_);
+}
+
+void utils::PinCurrentThread(const CpuSet &cpus)
+{
+    if (cpus.Empty())
+        return;
+
+    if (int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus.Native());
+        ret != 0)
+        throw CpuAffinityError(std::format("cannot pin thread to cpus {}", cpus.ToString()), ret);
+}
+
+std::vector<unsigned> utils::NumaNodesOf(const CpuSet &cpus)
+{
+    namespace fs = std::filesystem;
+    std::vector<unsigned> nodes;
+
+    for (unsigned cpu : cpus.Cpus()) {
+        // Each cpu directory links to its node as "node<N>".
+        std::error_code ec;
+        for (const auto &entry :
+             fs::directory_iterator(std::format("/sys/devices/system/cpu/cpu{}", cpu), ec)) {
+            const std::string name = entry.path().filename().string();
+            unsigned node = 0;
+            if (!name.starts_with("node") ||
+                std::from_chars(name.data() + 4, name.data() + name.size(), node).ec !=
+                    std::errc{})
+                continue;
+            if (std::ranges::find(nodes, node) == nodes.end())
+                nodes.push_back(node);
+        }
+    }
+
+    std::ranges::sort(nodes);
+    return nodes;
+}
+
+std::string utils::DescribeAffinity(const CpuSet &cpus)
+{
+    if (cpus.Empty())
+        return "unpinned";
+
+    const auto nodes = NumaNodesOf(cpus);
+    if (nodes.empty())
+        return std::format("cpus {}", cpus.ToString());
+    return std::format("cpus {} (numa node {})", cpus.ToString(), formatRanges(nodes));
+}
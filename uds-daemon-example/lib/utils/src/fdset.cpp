@@ -6,6 +6,7 @@
 #include <string.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
+#include <usdt.h>
 
 using namespace utils;
 
@@ -76,8 +77,11 @@ FdSetRet FdSet::Select(const Callback &cb, std::chrono::milliseconds timeout) co
     if (ret == -1)
         throw FdSetError("poll failed");
 
-    if (ret == 0)
+    // Probe: wake reason (FdSetRet), fds ready and the fd; a wake for data fires per ready fd.
+    if (ret == 0) {
+        UDS_PROBE(select_wake, static_cast<int>(FdSetRet::TIMEOUT), 0, -1);
         return FdSetRet::TIMEOUT;
+    }
 
     for (size_t i = 0; i < fds.size(); ++i) {
         if (!(fds[i].revents & POLLIN))
@@ -87,9 +91,11 @@ FdSetRet FdSet::Select(const Callback &cb, std::chrono::milliseconds timeout) co
             uint64_t val;
             ssize_t n = ::read(unBlockFd_, &val, sizeof(val)); // read empty
             (void)n;
+            UDS_PROBE(select_wake, static_cast<int>(FdSetRet::UNBLOCK), ret, unBlockFd_);
             return FdSetRet::UNBLOCK;
         }
 
+        UDS_PROBE(select_wake, static_cast<int>(FdSetRet::OK), ret, fds[i].fd);
         if (cb)
             cb(fds[i].fd);
 
@@ -0,0 +1,215 @@
+#include <hot_log.h>
+#include <memory>
+#include <mutex>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+#include <spsc_ring.h>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+namespace {
+
+// The backend backs off to this when there is nothing to write; records wait at most as long.
+constexpr auto kMaxIdleSleep = std::chrono::milliseconds(20);
+constexpr auto kMinIdleSleep = std::chrono::microseconds(500);
+constexpr std::size_t kDrainBatch = 32;
+
+struct ThreadRing {
+    SpscRing<HotLogRecord> ring{HotLog::kRingCapacity};
+    std::atomic<uint64_t> dropped{0};
+    //! Set when the thread exits; the backend drops the ring once it is empty.
+    std::atomic<bool> closed{false};
+};
+
+class Backend {
+  public:
+    static Backend &Instance()
+    {
+        // Leaked on purpose: threads may still log while static destructors run.
+        static auto *backend = new Backend;
+        return *backend;
+    }
+
+    void Start()
+    {
+        std::lock_guard lock(controlMutex_);
+        if (running_.load(std::memory_order_relaxed))
+            return;
+        stopping_.store(false, std::memory_order_relaxed);
+        thread_ = std::thread(&Backend::Run, this);
+        running_.store(true, std::memory_order_release);
+    }
+
+    void Stop()
+    {
+        std::lock_guard lock(controlMutex_);
+        if (!running_.load(std::memory_order_relaxed))
+            return;
+        // Statements from here on are written directly; the backend drains what is queued.
+        running_.store(false, std::memory_order_release);
+        stopping_.store(true, std::memory_order_release);
+        thread_.join();
+    }
+
+    [[nodiscard]] bool Running() const noexcept { return running_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] HotLogStats Stats() const noexcept
+    {
+        return HotLogStats{.written = written_.load(std::memory_order_relaxed),
+                           .dropped = dropped_.load(std::memory_order_relaxed)};
+    }
+
+    void Submit(const HotLogRecord &record) noexcept
+    {
+        if (!Running()) {
+            Write(record);
+            return;
+        }
+        ThreadRing *ring = ThisThreadRing();
+        if (ring == nullptr)
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        else if (!ring->ring.TryPush(record))
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Write(const HotLogRecord &record) noexcept
+    {
+        auto *logger = spdlog::default_logger_raw();
+        const auto &site = *record.site;
+        std::string text;
+        try {
+            text = record.decode(record);
+        } catch (const std::exception &e) {
+            text = std::format("bad log format '{}': {}", site.format, e.what());
+        }
+        if (record.suppressed > 0)
+            text += std::format(" ({} similar suppressed)", record.suppressed);
+
+        spdlog::details::log_msg msg(record.time, site.location, logger->name(), site.level,
+                                     spdlog::string_view_t(text.data(), text.size()));
+        msg.thread_id = record.thread;
+        for (const auto &sink : logger->sinks()) {
+            if (!sink->should_log(site.level))
+                continue;
+            try {
+                sink->log(msg);
+            } catch (...) {
+                // Same as spdlog: a failing sink must not take the process down.
+            }
+        }
+        written_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+  private:
+    Backend() = default;
+
+    ThreadRing *ThisThreadRing() noexcept
+    {
+        // Registered on the thread's first statement; the owner marks it closed on thread exit.
+        struct Owner {
+            std::shared_ptr<ThreadRing> ring;
+            ~Owner()
+            {
+                if (ring)
+                    ring->closed.store(true, std::memory_order_release);
+            }
+        };
+        thread_local Owner owner;
+        if (!owner.ring) {
+            try {
+                owner.ring = std::make_shared<ThreadRing>();
+                std::lock_guard lock(ringsMutex_);
+                rings_.push_back(owner.ring);
+            } catch (...) {
+                owner.ring.reset();
+                return nullptr;
+            }
+        }
+        return owner.ring.get();
+    }
+
+    // Writes what the rings hold; returns how many records that were.
+    std::size_t DrainAll(std::vector<HotLogRecord> &batch)
+    {
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        {
+            std::lock_guard lock(ringsMutex_);
+            rings = rings_;
+        }
+
+        std::size_t total = 0;
+        for (const auto &ring : rings) {
+            // Read before draining: a ring marked closed afterwards may still get records.
+            const bool closed = ring->closed.load(std::memory_order_acquire);
+            for (;;) {
+                batch.clear();
+                const auto n = ring->ring.PopBatch(std::back_inserter(batch), kDrainBatch);
+                for (const auto &record : batch)
+                    Write(record);
+                total += n;
+                if (n < kDrainBatch)
+                    break;
+            }
+            if (const auto lost = ring->dropped.exchange(0, std::memory_order_relaxed); lost > 0) {
+                dropped_.fetch_add(lost, std::memory_order_relaxed);
+                spdlog::warn("Log ring of thread full, {} message(s) dropped", lost);
+            }
+            if (closed) {
+                std::lock_guard lock(ringsMutex_);
+                std::erase(rings_, ring);
+            }
+        }
+        return total;
+    }
+
+    void Run()
+    {
+        std::vector<HotLogRecord> batch;
+        batch.reserve(kDrainBatch);
+        std::chrono::microseconds idle = kMinIdleSleep;
+        while (!stopping_.load(std::memory_order_acquire)) {
+            if (DrainAll(batch) > 0) {
+                idle = kMinIdleSleep;
+                continue;
+            }
+            std::this_thread::sleep_for(idle);
+            idle = std::min<std::chrono::microseconds>(idle * 2, kMaxIdleSleep);
+        }
+        DrainAll(batch);
+        for (const auto &sink : spdlog::default_logger_raw()->sinks())
+            sink->flush();
+    }
+
+    std::mutex controlMutex_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace
+
+std::size_t hot_log_detail::threadId() noexcept
+{
+    thread_local const std::size_t id = spdlog::details::os::thread_id();
+    return id;
+}
+
+void HotLog::Start() { Backend::Instance().Start(); }
+
+void HotLog::Stop() { Backend::Instance().Stop(); }
+
+bool HotLog::Running() noexcept { return Backend::Instance().Running(); }
+
+HotLogStats HotLog::Stats() noexcept { return Backend::Instance().Stats(); }
+
+void HotLog::Submit(const HotLogRecord &record) noexcept { Backend::Instance().Submit(record); }
+
+} // namespace utils
@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <fcntl.h>
 #include <pipe.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <utility>
 
 using namespace utils;
@@ -66,11 +70,147 @@ ssize_t Pipe::writeString(std::string_view sv) noexcept
 
 std::expected<std::string, std::error_code> Pipe::readString() const noexcept
 {
-    std::string str(1024, '\0');
-    auto n = readData(std::span<char>{str.data(), str.size()});
-    if (n < 0)
+    std::string str;
+    auto n = readString(str);
+    if (!n)
+        return std::unexpected(n.error());
+    return str;
+}
+
+std::expected<std::size_t, std::error_code> Pipe::readString(std::string& out) const noexcept
+{
+    // Read what is queued (at least the former fixed 1024 bytes) into the existing capacity.
+    out.resize(std::max<std::size_t>({buffered(), out.capacity(), 1024}));
+    auto n = readData(std::span<char>{out.data(), out.size()});
+    if (n < 0) {
+        out.clear();
         return std::unexpected(std::error_code(errno, std::generic_category()));
+    }
 
-    str.resize(static_cast<size_t>(n));
-    return str;
+    out.resize(static_cast<size_t>(n));
+    return out.size();
+}
+
+std::size_t Pipe::capacity() const noexcept
+{
+    const int size = ::fcntl(writeFd_, F_GETPIPE_SZ);
+    return size > 0 ? static_cast<std::size_t>(size) : 0;
+}
+
+bool Pipe::setCapacity(std::size_t bytes) noexcept
+{
+    return ::fcntl(writeFd_, F_SETPIPE_SZ, static_cast<int>(bytes)) != -1;
+}
+
+std::size_t Pipe::buffered() const noexcept
+{
+    int queued = 0;
+    if (::ioctl(readFd_, FIONREAD, &queued) == -1)
+        return 0;
+    return static_cast<std::size_t>(queued);
+}
+
+void Pipe::discard() noexcept
+{
+    std::array<std::byte, 4096> sink;
+    while (true) {
+        const ssize_t n = ::read(readFd_, sink.data(), sink.size());
+        if (n > 0 || (n < 0 && errno == EINTR))
+            continue;
+        break; // empty (the read end is non-blocking) or broken
+    }
+}
+
+//*****************************************************************************
+// Zero-copy transfer
+//*****************************************************************************
+
+namespace {
+
+std::error_code lastError() noexcept { return {errno, std::generic_category()}; }
+
+template <typename Fn>
+std::expected<std::size_t, std::error_code> retryOnEintr(Fn&& fn) noexcept
+{
+    while (true) {
+        const ssize_t ret = fn();
+        if (ret >= 0)
+            return static_cast<std::size_t>(ret);
+        if (errno != EINTR)
+            return std::unexpected(lastError());
+    }
+}
+
+bool waitWritable(int fd) noexcept
+{
+    pollfd pfd{.fd = fd, .events = POLLOUT, .revents = 0};
+    while (::poll(&pfd, 1, -1) == -1) {
+        if (errno != EINTR)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::expected<std::size_t, std::error_code> Pipe::spliceFrom(int fd, std::size_t len,
+                                                             loff_t* offset) noexcept
+{
+    return retryOnEintr([&]() {
+        return ::splice(fd, offset, writeFd_, nullptr, len, SPLICE_F_MOVE | SPLICE_F_MORE);
+    });
+}
+
+std::expected<std::size_t, std::error_code> Pipe::spliceTo(int fd, std::size_t len,
+                                                           loff_t* offset) noexcept
+{
+    return retryOnEintr([&]() {
+        return ::splice(readFd_, nullptr, fd, offset, len, SPLICE_F_MOVE | SPLICE_F_MORE);
+    });
+}
+
+std::expected<std::size_t, std::error_code> Pipe::teeTo(Pipe& other, std::size_t len) noexcept
+{
+    return retryOnEintr([&]() { return ::tee(readFd_, other.writeFd_, len, 0); });
+}
+
+std::expected<std::size_t, std::error_code>
+Pipe::vmspliceFrom(std::span<const std::byte> data) noexcept
+{
+    // vmsplice only reads the iovec, the cast is the usual iovec constness wart.
+    iovec iov{.iov_base = const_cast<std::byte*>(data.data()), .iov_len = data.size()};
+    return retryOnEintr([&]() { return ::vmsplice(writeFd_, &iov, 1, 0); });
+}
+
+std::expected<std::size_t, std::error_code> Pipe::relay(int inFd, int outFd, std::size_t len,
+                                                        loff_t* inOffset,
+                                                        loff_t* outOffset) noexcept
+{
+    const std::size_t chunk = std::max<std::size_t>(capacity(), 4096);
+    std::size_t moved = 0;
+
+    while (moved < len) {
+        auto in = spliceFrom(inFd, std::min(chunk, len - moved), inOffset);
+        if (!in) {
+            // Whatever arrived so far is delivered; the caller sees the error on the next call.
+            if (moved > 0 && in.error() == std::errc::operation_would_block)
+                break;
+            return std::unexpected(in.error());
+        }
+        if (*in == 0)
+            break; // end of input
+
+        for (std::size_t pending = *in; pending > 0;) {
+            auto out = spliceTo(outFd, pending, outOffset);
+            if (!out) {
+                if (out.error() == std::errc::operation_would_block && waitWritable(outFd))
+                    continue;
+                discard();
+                return std::unexpected(out.error());
+            }
+            pending -= *out;
+        }
+        moved += *in;
+    }
+    return moved;
 }
@@ -0,0 +1,136 @@
+#include <cache_line.h>
+#include <pool_allocator.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+
+using namespace utils;
+
+namespace {
+
+constexpr std::size_t kHeapRegionSize = 256 * 1024;
+constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+static_assert(kHeapRegionSize % PoolArena::kSlabSize == 0);
+static_assert(kHugePageSize % PoolArena::kSlabSize == 0);
+
+// Maps one huge page worth of memory aligned to the huge page size, so transparent huge pages
+// can back it without a split. Returns nullptr on failure.
+void *mapAlignedForThp()
+{
+    const std::size_t span = 2 * kHugePageSize;
+    void *raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return nullptr;
+
+    auto *begin = static_cast<std::byte *>(raw);
+    const auto address = reinterpret_cast<uintptr_t>(begin);
+    const std::size_t head = (kHugePageSize - (address % kHugePageSize)) % kHugePageSize;
+    std::byte *aligned = begin + head;
+
+    if (head != 0)
+        ::munmap(begin, head);
+    if (const std::size_t tail = span - head - kHugePageSize; tail != 0)
+        ::munmap(aligned + kHugePageSize, tail);
+
+    // Best effort: without THP support the region simply stays on 4 KiB pages.
+    ::madvise(aligned, kHugePageSize, MADV_HUGEPAGE);
+    return aligned;
+}
+
+} // namespace
+
+PoolArena::PoolArena(PoolBacking backing) noexcept
+ : backing_(backing)
+{
+    for (std::size_t i = 0; i < kSizeClasses; ++i)
+        pools_[i].stats.blockSize = (i + 1) * kGranularity;
+}
+
+PoolArena::~PoolArena()
+{
+    std::size_t inUse = 0;
+    for (const auto &pool : pools_)
+        inUse += pool.stats.inUse;
+
+    if (inUse != 0) {
+        spdlog::warn("PoolArena: {} blocks still in use at thread exit, leaking {} bytes", inUse,
+                     Stats().reservedBytes);
+        return;
+    }
+
+    for (const auto &region : regions_) {
+        if (region.mapped)
+            ::munmap(region.base, region.size);
+        else
+            ::operator delete(region.base, region.size, std::align_val_t{kCacheLineSize});
+    }
+}
+
+ArenaStats PoolArena::Stats() const
+{
+    ArenaStats stats;
+    stats.backing = backing_;
+    stats.regions = regions_.size();
+    stats.oversizeAllocations = oversize_;
+    for (const auto &region : regions_) {
+        stats.reservedBytes += region.size;
+        if (region.hugeTlb)
+            ++stats.hugePageRegions;
+    }
+    for (const auto &pool : pools_) {
+        if (pool.stats.allocations != 0)
+            stats.pools.push_back(pool.stats);
+    }
+    return stats;
+}
+
+void *PoolArena::AllocateOversize(std::size_t bytes)
+{
+    ++oversize_;
+    return ::operator new(bytes);
+}
+
+void *PoolArena::Refill(Pool &pool)
+{
+    std::byte *slab = CarveSlab();
+    const std::size_t size = pool.stats.blockSize;
+
+    pool.cursor = slab + size;
+    pool.end = slab + (kSlabSize / size) * size;
+    ++pool.stats.capacity;
+    return slab;
+}
+
+std::byte *PoolArena::CarveSlab()
+{
+    if (regionCursor_ == regionEnd_)
+        AddRegion();
+
+    std::byte *slab = regionCursor_;
+    regionCursor_ += kSlabSize;
+    return slab;
+}
+
+void PoolArena::AddRegion()
+{
+    regions_.reserve(regions_.size() + 1);
+
+    Region region{.base = nullptr, .size = kHeapRegionSize, .mapped = false, .hugeTlb = false};
+    if (backing_ == PoolBacking::HugePages) {
+        region.size = kHugePageSize;
+        region.mapped = true;
+        region.base = ::mmap(nullptr, kHugePageSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        region.hugeTlb = region.base != MAP_FAILED;
+        if (!region.hugeTlb)
+            region.base = mapAlignedForThp();
+        if (region.base == nullptr)
+            throw std::bad_alloc();
+    } else {
+        region.base = ::operator new(kHeapRegionSize, std::align_val_t{kCacheLineSize});
+    }
+
+    regions_.push_back(region);
+    regionCursor_ = static_cast<std::byte *>(region.base);
+    regionEnd_ = regionCursor_ + region.size;
+}
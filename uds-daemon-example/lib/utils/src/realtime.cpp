@@ -0,0 +1,103 @@
+#include <alloca.h>
+#include <format>
+#include <fstream>
+#include <linux/capability.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <realtime.h>
+#include <sched.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+
+// Effective capability set from /proc; avoids a dependency on libcap.
+bool hasCapability(unsigned capability)
+{
+    std::ifstream status("/proc/self/status");
+    constexpr std::string_view key = "CapEff:";
+    for (std::string line; std::getline(status, line);) {
+        if (!line.starts_with(key))
+            continue;
+        const auto mask = std::stoull(line.substr(key.size()), nullptr, 16);
+        return ((mask >> capability) & 1U) != 0;
+    }
+    return false;
+}
+
+std::size_t pageSize() noexcept { return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)); }
+
+} // namespace
+
+void utils::SetCurrentThreadPriority(int priority)
+{
+    if (priority < 0 || priority > kMaxRealtimePriority)
+        throw RealtimeError(std::format("priority {} is not within 0..{}", priority,
+                                        kMaxRealtimePriority),
+                            EINVAL);
+
+    const int policy = priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+    sched_param param{};
+    param.sched_priority = priority;
+    if (int ret = pthread_setschedparam(pthread_self(), policy, &param); ret != 0)
+        throw RealtimeError(priority > 0
+                                ? std::format("cannot run thread at SCHED_FIFO priority {}",
+                                              priority)
+                                : std::string("cannot return thread to SCHED_OTHER"),
+                            ret);
+}
+
+void utils::LockProcessMemory()
+{
+    // Freed heap stays in the process instead of being trimmed or unmapped, and large blocks
+    // come from the (locked) heap rather than from fresh mappings.
+    ::mallopt(M_TRIM_THRESHOLD, -1);
+    ::mallopt(M_MMAP_MAX, 0);
+
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        throw RealtimeError("mlockall failed");
+}
+
+void utils::SetDefaultThreadStackSize(std::size_t bytes)
+{
+    pthread_attr_t attr;
+    if (int ret = pthread_getattr_default_np(&attr); ret != 0)
+        throw RealtimeError("pthread_getattr_default_np failed", ret);
+    int ret = pthread_attr_setstacksize(&attr, bytes);
+    if (ret == 0)
+        ret = pthread_setattr_default_np(&attr);
+    pthread_attr_destroy(&attr);
+    if (ret != 0)
+        throw RealtimeError(std::format("cannot set the thread stack size to {} bytes", bytes),
+                            ret);
+}
+
+void utils::PrefaultStack(std::size_t bytes) noexcept
+{
+    // Allocated in this frame and released on return; the pages stay mapped.
+    auto *stack = static_cast<volatile char *>(alloca(bytes));
+    const std::size_t page = pageSize();
+    for (std::size_t offset = 0; offset < bytes; offset += page)
+        stack[offset] = 0;
+}
+
+std::vector<std::string> utils::RealtimePrivilegeProblems(int priority)
+{
+    std::vector<std::string> problems;
+    rlimit limit{};
+
+    if (!hasCapability(CAP_SYS_NICE) && ::getrlimit(RLIMIT_RTPRIO, &limit) == 0 &&
+        limit.rlim_cur < static_cast<rlim_t>(priority))
+        problems.push_back(std::format("SCHED_FIFO priority {} needs CAP_SYS_NICE or an "
+                                       "RLIMIT_RTPRIO of at least {} (LimitRTPRIO=), have {}",
+                                       priority, priority, limit.rlim_cur));
+
+    if (!hasCapability(CAP_IPC_LOCK) && ::getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY)
+        problems.push_back(std::format("locking memory needs CAP_IPC_LOCK or an unlimited "
+                                       "RLIMIT_MEMLOCK (LimitMEMLOCK=infinity), have {} KiB",
+                                       limit.rlim_cur / 1024));
+    return problems;
+}
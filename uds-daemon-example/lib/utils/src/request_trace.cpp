@@ -0,0 +1,254 @@
+#include <request_trace.h>
+#include <algorithm>
+#include <array>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace utils {
+
+std::atomic<uint64_t> RequestTrace::sampleEvery_{0};
+std::atomic<uint64_t> RequestTrace::sampled_{0};
+
+namespace {
+
+using Clock = RequestTrace::Clock;
+
+// A span slot is a seqlock: odd while its owner writes it, so a reader can tell a torn copy.
+struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> track{0};
+    std::atomic<Clock::rep> start{0};
+    std::atomic<Clock::rep> end{0};
+};
+
+struct ThreadSpans {
+    std::array<Slot, RequestTrace::kThreadSpans> slots;
+    std::atomic<uint64_t> written{0};
+    //! Set when the thread exits; the ring is kept for dumps until enough others retired.
+    std::atomic<bool> closed{false};
+};
+
+class Registry {
+  public:
+    static Registry &Instance()
+    {
+        // Leaked on purpose: threads may still record while static destructors run.
+        static auto *registry = new Registry;
+        return *registry;
+    }
+
+    ThreadSpans *ThisThreadSpans() noexcept
+    {
+        struct Owner {
+            std::shared_ptr<ThreadSpans> spans;
+            ~Owner()
+            {
+                if (spans)
+                    spans->closed.store(true, std::memory_order_release);
+            }
+        };
+        thread_local Owner owner;
+        if (!owner.spans) {
+            try {
+                owner.spans = std::make_shared<ThreadSpans>();
+                std::lock_guard lock(mutex_);
+                PruneRetired();
+                rings_.push_back(owner.spans);
+            } catch (...) {
+                owner.spans.reset();
+                return nullptr;
+            }
+        }
+        return owner.spans.get();
+    }
+
+    std::vector<std::shared_ptr<ThreadSpans>> Rings()
+    {
+        std::lock_guard lock(mutex_);
+        return rings_;
+    }
+
+    void DropRetired() noexcept
+    {
+        std::lock_guard lock(mutex_);
+        std::erase_if(rings_, [](const auto &ring) {
+            return ring->closed.load(std::memory_order_acquire);
+        });
+    }
+
+    [[nodiscard]] Clock::time_point ClearedAt() const noexcept
+    {
+        return Clock::time_point(Clock::duration(clearedAt_.load(std::memory_order_acquire)));
+    }
+
+    void MarkCleared(Clock::time_point at) noexcept
+    {
+        clearedAt_.store(at.time_since_epoch().count(), std::memory_order_release);
+    }
+
+  private:
+    Registry() = default;
+
+    // Oldest retired rings go first; rings_ is in registration order.
+    void PruneRetired()
+    {
+        std::size_t retired = static_cast<std::size_t>(std::ranges::count_if(
+            rings_, [](const auto &ring) { return ring->closed.load(std::memory_order_acquire); }));
+        for (auto it = rings_.begin(); it != rings_.end() && retired >= kMaxRetired;) {
+            if ((*it)->closed.load(std::memory_order_acquire)) {
+                it = rings_.erase(it);
+                --retired;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static constexpr std::size_t kMaxRetired = RequestTrace::kMaxRetiredThreads;
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadSpans>> rings_;
+    // Spans that started before this are hidden from Collect(); rings are never reset by others.
+    std::atomic<Clock::rep> clearedAt_{Clock::time_point::min().time_since_epoch().count()};
+};
+
+// Span and track names come from the program, but a quote would still break the file.
+std::string jsonEscape(std::string_view text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (const char c : text) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+        else
+            out += c;
+    }
+    return out;
+}
+
+// Trace-event timestamps are microseconds; three decimals keep the nanoseconds.
+std::string micros(Clock::rep nanos)
+{
+    return std::format("{}.{:03}", nanos / 1000, nanos % 1000);
+}
+
+Clock::rep nanos(Clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+} // namespace
+
+void RequestTrace::Enable(uint64_t sampleEvery) noexcept
+{
+    sampleEvery_.store(std::max<uint64_t>(sampleEvery, 1), std::memory_order_relaxed);
+}
+
+void RequestTrace::Disable() noexcept { sampleEvery_.store(0, std::memory_order_relaxed); }
+
+void RequestTrace::Record(const char *name, uint64_t track, Clock::time_point start,
+                          Clock::time_point end) noexcept
+{
+    ThreadSpans *spans = Registry::Instance().ThisThreadSpans();
+    if (spans == nullptr)
+        return;
+
+    // Only this thread writes the ring; readers check the sequence around their copy.
+    const uint64_t n = spans->written.load(std::memory_order_relaxed);
+    Slot &slot = spans->slots[n % kThreadSpans];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.track.store(track, std::memory_order_relaxed);
+    slot.start.store(start.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.end.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    spans->written.store(n + 1, std::memory_order_release);
+}
+
+std::vector<TraceSpan> RequestTrace::Collect()
+{
+    auto &registry = Registry::Instance();
+    const auto clearedAt = registry.ClearedAt();
+    std::vector<TraceSpan> spans;
+    for (const auto &ring : registry.Rings()) {
+        const uint64_t written = ring->written.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(written, kThreadSpans);
+        for (uint64_t i = written - count; i < written; ++i) {
+            const Slot &slot = ring->slots[i % kThreadSpans];
+            const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before % 2 != 0)
+                continue;
+            TraceSpan span{.name = slot.name.load(std::memory_order_relaxed),
+                           .track = slot.track.load(std::memory_order_relaxed),
+                           .start = Clock::time_point(
+                               Clock::duration(slot.start.load(std::memory_order_relaxed))),
+                           .end = Clock::time_point(
+                               Clock::duration(slot.end.load(std::memory_order_relaxed)))};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Overwritten while it was copied: the span is gone anyway.
+            if (slot.sequence.load(std::memory_order_relaxed) != before || span.name == nullptr)
+                continue;
+            if (span.start >= clearedAt)
+                spans.push_back(span);
+        }
+    }
+    return spans;
+}
+
+void RequestTrace::Clear() noexcept
+{
+    auto &registry = Registry::Instance();
+    registry.MarkCleared(Clock::now());
+    registry.DropRetired();
+}
+
+std::size_t RequestTrace::WriteChromeTrace(std::ostream &out, const std::vector<TraceSpan> &spans,
+                                           int pid, std::string_view trackName)
+{
+    // Per track by start; an enclosing span sorts before the spans it contains.
+    std::vector<const TraceSpan *> sorted;
+    sorted.reserve(spans.size());
+    std::ranges::transform(spans, std::back_inserter(sorted),
+                           [](const TraceSpan &span) { return &span; });
+    std::ranges::sort(sorted, [](const TraceSpan *a, const TraceSpan *b) {
+        if (a->track != b->track)
+            return a->track < b->track;
+        if (a->start != b->start)
+            return a->start < b->start;
+        return a->end > b->end;
+    });
+
+    const std::string name = jsonEscape(trackName);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char *separator = "";
+    std::set<uint64_t> tracks;
+    for (const TraceSpan *span : sorted) {
+        if (tracks.insert(span->track).second) {
+            out << separator
+                << std::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},\"tid\":{},"
+                               "\"args\":{{\"name\":\"{} {}\"}}}}",
+                               pid, span->track, name, span->track);
+            separator = ",\n";
+        }
+        out << separator
+            << std::format("{{\"name\":\"{}\",\"cat\":\"request\",\"ph\":\"X\",\"pid\":{},"
+                           "\"tid\":{},\"ts\":{},\"dur\":{}}}",
+                           jsonEscape(span->name), pid, span->track,
+                           micros(nanos(span->start.time_since_epoch())),
+                           micros(std::max<Clock::rep>(nanos(span->end - span->start), 0)));
+        separator = ",\n";
+    }
+    out << "]}\n";
+    return sorted.size();
+}
+
+} // namespace utils
@@ -0,0 +1,383 @@
+#include <response_cache.h>
+
+#include <bit>
+#include <cstring>
+#include <limits>
+
+using namespace utils;
+
+namespace {
+
+__extension__ typedef unsigned __int128 Uint128;
+
+constexpr uint64_t kSeed0 = 0x2d358dccaa6c78a5ULL;
+constexpr uint64_t kSeed1 = 0x8bb84b93962eacc9ULL;
+constexpr uint64_t kSeed2 = 0x4b33a62ed433d4a3ULL;
+
+// 64x64 -> 128 bit multiply folded back to 64 bits; one multiply mixes both inputs completely.
+uint64_t mix(uint64_t a, uint64_t b) noexcept
+{
+    const Uint128 product = static_cast<Uint128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+uint64_t read64(const unsigned char *p) noexcept
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t read32(const unsigned char *p) noexcept
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+//*****************************************************************************
+// One shard: slot table of entry indices plus the entries themselves. All
+// members are guarded by mutex_.
+class ResponseCache::Shard {
+  public:
+    bool Lookup(uint64_t hash, std::string_view request, std::string &response,
+                Clock::time_point now)
+    {
+        std::lock_guard lock(mutex_);
+        const std::size_t slot = Find(hash, request);
+        if (slot == kNotFound) {
+            ++stats_.misses;
+            return false;
+        }
+
+        Entry &entry = entries_[slots_[slot].entry];
+        if (Expired(entry, now)) {
+            RemoveSlot(slot);
+            ++stats_.expirations;
+            ++stats_.misses;
+            return false;
+        }
+
+        entry.referenced = true;
+        response.assign(entry.value);
+        ++stats_.hits;
+        return true;
+    }
+
+    bool Insert(uint64_t hash, std::string_view request, std::string_view response,
+                Clock::time_point now)
+    {
+        const std::size_t cost = Cost(request.size(), response.size());
+
+        std::lock_guard lock(mutex_);
+        if (cost > budget_)
+            return false;
+
+        if (const std::size_t slot = Find(hash, request); slot != kNotFound)
+            RemoveSlot(slot); // replaced below, so the budget check sees the new size only
+
+        while (bytes_ + cost > budget_)
+            EvictOne(now);
+
+        if ((count_ + 1) * 2 > slots_.size())
+            Grow();
+
+        uint32_t index;
+        if (!free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(entries_.size());
+            entries_.emplace_back();
+        }
+
+        Entry &entry = entries_[index];
+        entry.hash = hash;
+        entry.inserted = now;
+        entry.key.assign(request);
+        entry.value.assign(response);
+        entry.used = true;
+        // Only a hit earns a second chance; a stream of one-off requests then evicts itself
+        // instead of clearing the bits of the entries that are in use.
+        entry.referenced = false;
+
+        std::size_t slot = hash & Mask();
+        while (slots_[slot].entry != kEmpty)
+            slot = (slot + 1) & Mask();
+        slots_[slot] = Slot{.entry = index, .tag = static_cast<uint32_t>(hash)};
+
+        ++count_;
+        bytes_ += cost;
+        ++stats_.insertions;
+        return true;
+    }
+
+    bool Invalidate(uint64_t hash, std::string_view request)
+    {
+        std::lock_guard lock(mutex_);
+        const std::size_t slot = Find(hash, request);
+        if (slot == kNotFound)
+            return false;
+        RemoveSlot(slot);
+        ++stats_.invalidations;
+        return true;
+    }
+
+    void Clear()
+    {
+        std::lock_guard lock(mutex_);
+        stats_.invalidations += count_;
+        ClearLocked();
+    }
+
+    void Configure(std::size_t budget, Clock::duration ttl)
+    {
+        std::lock_guard lock(mutex_);
+        budget_ = budget;
+        ttl_ = ttl;
+        if (budget_ == 0) {
+            stats_.evictions += count_;
+            ClearLocked();
+            return;
+        }
+        const auto now = Clock::now();
+        while (bytes_ > budget_)
+            EvictOne(now);
+    }
+
+    void AddStats(ResponseCacheStats &total) const
+    {
+        std::lock_guard lock(mutex_);
+        total.hits += stats_.hits;
+        total.misses += stats_.misses;
+        total.insertions += stats_.insertions;
+        total.evictions += stats_.evictions;
+        total.expirations += stats_.expirations;
+        total.invalidations += stats_.invalidations;
+        total.entries += count_;
+        total.bytes += bytes_;
+    }
+
+  private:
+    static constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+    static constexpr std::size_t kNotFound = std::numeric_limits<std::size_t>::max();
+
+    // The low hash bits kept in the slot reject most probe mismatches without touching the entry.
+    struct Slot {
+        uint32_t entry{kEmpty};
+        uint32_t tag{0};
+    };
+
+    struct Entry {
+        uint64_t hash{0};
+        Clock::time_point inserted{};
+        std::string key;
+        std::string value;
+        bool used{false};
+        bool referenced{false};
+    };
+
+    static std::size_t Cost(std::size_t keySize, std::size_t valueSize) noexcept
+    {
+        return keySize + valueSize + sizeof(Entry) + 2 * sizeof(Slot);
+    }
+
+    std::size_t Mask() const noexcept { return slots_.size() - 1; }
+
+    bool Expired(const Entry &entry, Clock::time_point now) const noexcept
+    {
+        return ttl_ > Clock::duration::zero() && now - entry.inserted >= ttl_;
+    }
+
+    std::size_t Find(uint64_t hash, std::string_view key) const noexcept
+    {
+        if (count_ == 0)
+            return kNotFound;
+
+        const auto tag = static_cast<uint32_t>(hash);
+        for (std::size_t slot = hash & Mask();; slot = (slot + 1) & Mask()) {
+            const Slot &s = slots_[slot];
+            if (s.entry == kEmpty)
+                return kNotFound;
+            if (s.tag == tag) {
+                const Entry &entry = entries_[s.entry];
+                if (entry.hash == hash && entry.key == key)
+                    return slot;
+            }
+        }
+    }
+
+    std::size_t SlotOf(uint32_t index) const noexcept
+    {
+        std::size_t slot = entries_[index].hash & Mask();
+        while (slots_[slot].entry != index)
+            slot = (slot + 1) & Mask();
+        return slot;
+    }
+
+    // Frees the entry in \p slot and shifts later members of the probe run back, so lookups never
+    // need tombstones.
+    void RemoveSlot(std::size_t slot)
+    {
+        Entry &entry = entries_[slots_[slot].entry];
+        bytes_ -= Cost(entry.key.size(), entry.value.size());
+        --count_;
+        entry.key = {};
+        entry.value = {};
+        entry.used = false;
+        free_.push_back(slots_[slot].entry);
+
+        std::size_t hole = slot;
+        for (std::size_t next = (hole + 1) & Mask(); slots_[next].entry != kEmpty;
+             next = (next + 1) & Mask()) {
+            const std::size_t home = slots_[next].tag & Mask();
+            if (((next - home) & Mask()) >= ((next - hole) & Mask())) {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+        }
+        slots_[hole] = Slot{};
+    }
+
+    // CLOCK: the hand clears reference bits until it finds an entry that was not hit since its
+    // last pass. Expired entries go first regardless of their bit.
+    void EvictOne(Clock::time_point now)
+    {
+        for (;;) {
+            if (hand_ >= entries_.size())
+                hand_ = 0;
+            const auto index = static_cast<uint32_t>(hand_++);
+            Entry &entry = entries_[index];
+            if (!entry.used)
+                continue;
+
+            if (Expired(entry, now)) {
+                ++stats_.expirations;
+            } else if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            } else {
+                ++stats_.evictions;
+            }
+            RemoveSlot(SlotOf(index));
+            return;
+        }
+    }
+
+    void Grow()
+    {
+        std::vector<Slot> slots(std::max<std::size_t>(16, slots_.size() * 2));
+        const std::size_t mask = slots.size() - 1;
+        for (const Slot &s : slots_) {
+            if (s.entry == kEmpty)
+                continue;
+            std::size_t slot = s.tag & mask;
+            while (slots[slot].entry != kEmpty)
+                slot = (slot + 1) & mask;
+            slots[slot] = s;
+        }
+        slots_.swap(slots);
+    }
+
+    void ClearLocked()
+    {
+        slots_.clear();
+        entries_.clear();
+        free_.clear();
+        hand_ = 0;
+        count_ = 0;
+        bytes_ = 0;
+    }
+
+    alignas(kCacheLineSize) mutable std::mutex mutex_;
+    std::vector<Slot> slots_;
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> free_;
+    std::size_t hand_{0};
+    std::size_t count_{0};
+    std::size_t bytes_{0};
+    std::size_t budget_{0};
+    Clock::duration ttl_{};
+    ResponseCacheStats stats_;
+};
+
+ResponseCache::ResponseCache(const ResponseCacheOptions &options)
+ : shards_(std::make_unique<Shard[]>(std::bit_ceil(std::max<std::size_t>(options.shards, 1))))
+ , shardMask_(std::bit_ceil(std::max<std::size_t>(options.shards, 1)) - 1)
+{
+    Reconfigure(options);
+}
+
+ResponseCache::~ResponseCache() = default;
+
+bool ResponseCache::Lookup(std::string_view request, std::string &response, Clock::time_point now)
+{
+    const uint64_t hash = Hash(request);
+    return ShardOf(hash).Lookup(hash, request, response, now);
+}
+
+bool ResponseCache::Insert(std::string_view request, std::string_view response,
+                           Clock::time_point now)
+{
+    const uint64_t hash = Hash(request);
+    return ShardOf(hash).Insert(hash, request, response, now);
+}
+
+bool ResponseCache::Invalidate(std::string_view request)
+{
+    const uint64_t hash = Hash(request);
+    return ShardOf(hash).Invalidate(hash, request);
+}
+
+void ResponseCache::InvalidateAll()
+{
+    for (std::size_t i = 0; i <= shardMask_; ++i)
+        shards_[i].Clear();
+}
+
+void ResponseCache::Reconfigure(const ResponseCacheOptions &options)
+{
+    const std::size_t perShard = options.byteBudget / (shardMask_ + 1);
+    for (std::size_t i = 0; i <= shardMask_; ++i)
+        shards_[i].Configure(perShard, options.ttl);
+}
+
+ResponseCacheStats ResponseCache::Stats() const
+{
+    ResponseCacheStats total;
+    for (std::size_t i = 0; i <= shardMask_; ++i)
+        shards_[i].AddStats(total);
+    return total;
+}
+
+uint64_t ResponseCache::Hash(std::string_view bytes) noexcept
+{
+    const auto *p = reinterpret_cast<const unsigned char *>(bytes.data());
+    std::size_t n = bytes.size();
+    uint64_t h = kSeed0 ^ mix(n ^ kSeed1, kSeed2);
+
+    for (; n > 16; n -= 16, p += 16)
+        h = mix(read64(p) ^ kSeed1, read64(p + 8) ^ h);
+
+    // The last 1..16 bytes, read as (possibly overlapping) words.
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (n >= 8) {
+        a = read64(p);
+        b = read64(p + n - 8);
+    } else if (n >= 4) {
+        a = read32(p);
+        b = read32(p + n - 4);
+    } else if (n > 0) {
+        a = (uint64_t{p[0]} << 16) | (uint64_t{p[n / 2]} << 8) | p[n - 1];
+    }
+    return mix(a ^ kSeed1 ^ bytes.size(), mix(b ^ kSeed2, h));
+}
+
+ResponseCache::Shard &ResponseCache::ShardOf(uint64_t hash) noexcept
+{
+    // The table indexes by the low bits; the shard is picked by the high ones.
+    return shards_[(hash >> 48) & shardMask_];
+}
@@ -1,3 +1,5 @@
+#include <charconv>
+#include <cstdlib>
 #include <sd_notify.h>
 #include <spdlog/spdlog.h>
 #include <string>
@@ -34,6 +36,17 @@ void stopping()
     }
 }
 
+void extendTimeout(std::chrono::microseconds time)
+{
+    if (sd_booted() > 0) {
+        int ret = sd_notifyf(0, "EXTEND_TIMEOUT_USEC=%lld", static_cast<long long>(time.count()));
+        if (ret < 0)
+            spdlog::error("Failed to send EXTEND_TIMEOUT_USEC to systemd: {}", strerror(ret));
+    } else {
+        spdlog::debug("System not booted with systemd, skipping EXTEND_TIMEOUT_USEC notify");
+    }
+}
+
 void reloading(std::string_view msg)
 {
     if (sd_booted() > 0) {
@@ -62,4 +75,55 @@ void status(std::string_view msg)
     }
 }
 
+std::size_t fdStoreLimit() noexcept
+{
+    // systemd >= 254 exports FileDescriptorStoreMax= as $FDSTORE.
+    const char *env = std::getenv("FDSTORE");
+    if (env == nullptr || std::getenv("NOTIFY_SOCKET") == nullptr)
+        return 0;
+
+    std::size_t limit = 0;
+    const std::string_view value(env);
+    if (std::from_chars(value.data(), value.data() + value.size(), limit).ec != std::errc{})
+        return 0;
+    return limit;
+}
+
+bool storeFds(std::string_view name, std::span<const int> fds)
+{
+    if (sd_booted() <= 0) {
+        spdlog::debug("System not booted with systemd, skipping FDSTORE");
+        return false;
+    }
+
+    const std::string state = "FDSTORE=1\nFDNAME=" + std::string(name);
+    int ret = sd_pid_notify_with_fds(0, 0, state.c_str(), fds.data(),
+                                     static_cast<unsigned>(fds.size()));
+    if (ret < 0) {
+        spdlog::error("Failed to store fds '{}' in systemd fd store: {}", name, strerror(-ret));
+        return false;
+    }
+    if (ret == 0) {
+        spdlog::warn("NOTIFY_SOCKET not set, cannot store fds '{}'", name);
+        return false;
+    }
+
+    spdlog::debug("Stored {} fd(s) as '{}' in systemd fd store", fds.size(), name);
+    return true;
+}
+
+void removeStoredFds(std::string_view name)
+{
+    if (sd_booted() > 0) {
+        int ret = sd_notifyf(0, "FDSTOREREMOVE=1\nFDNAME=%s", std::string(name).c_str());
+        if (ret < 0) {
+            spdlog::error("Failed to remove '{}' from systemd fd store: {}", name, strerror(-ret));
+        } else {
+            spdlog::debug("Removed '{}' from systemd fd store", name);
+        }
+    } else {
+        spdlog::debug("System not booted with systemd, skipping FDSTOREREMOVE");
+    }
+}
+
 } // namespace systemd_notify
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <sd_socket.h>
 #include <spdlog/spdlog.h>
 #include <sys/socket.h>
@@ -7,11 +8,15 @@
 
 namespace systemd_socket {
 
-std::vector<SocketInfo> getSystemdUnixSockets() noexcept
+namespace {
+
+//! All fds passed via LISTEN_FDS together with their LISTEN_FDNAMES entry.
+std::vector<StoredFd> listenFds() noexcept
 {
-    std::vector<SocketInfo> result;
+    std::vector<StoredFd> result;
 
-    int fd_count = sd_listen_fds(0);
+    char **names = nullptr;
+    int fd_count = sd_listen_fds_with_names(0, &names);
     if (fd_count < 0) {
         std::error_code ec(-fd_count, std::system_category());
         spdlog::error("sd_listen_fds failed: {}", ec.message());
@@ -19,22 +24,62 @@ std::vector<SocketInfo> getSystemdUnixSockets() noexcept
     }
     result.reserve(static_cast<std::size_t>(fd_count));
 
-    if (fd_count == 0) {
+    for (int i = 0; i < fd_count; ++i) {
+        const char *name = (names != nullptr && names[i] != nullptr) ? names[i] : "unknown";
+        result.emplace_back(StoredFd{.fd = SD_LISTEN_FDS_START + i, .name = name});
+    }
+
+    if (names != nullptr) {
+        for (int i = 0; i < fd_count; ++i)
+            std::free(names[i]);
+        std::free(names);
+    }
+    return result;
+}
+
+bool isStreamSocket(int fd) noexcept
+{
+    int socktype = 0;
+    if (socklen_t optlen = sizeof(socktype);
+        getsockopt(fd, SOL_SOCKET, SO_TYPE, &socktype, &optlen) < 0) {
+        std::error_code ec(errno, std::system_category());
+        spdlog::error("getsockopt failed for fd {}: {}", fd, ec.message());
+        return false;
+    }
+
+    if (socktype != SOCK_STREAM) {
+        spdlog::debug("fd {} is not a SOCK_STREAM socket (type={})", fd, socktype);
+        return false;
+    }
+    return true;
+}
+
+bool isListening(int fd) noexcept
+{
+    int accepting = 0;
+    socklen_t optlen = sizeof(accepting);
+    return getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &optlen) == 0 && accepting != 0;
+}
+
+} // namespace
+
+std::vector<SocketInfo> getSystemdUnixSockets() noexcept
+{
+    std::vector<SocketInfo> result;
+
+    const auto fds = listenFds();
+    if (fds.empty()) {
         spdlog::warn("No systemd socket passed (LISTEN_FDS=0)");
         return result;
     }
 
-    for (int i = 0; i < fd_count; ++i) {
-        int fd = SD_LISTEN_FDS_START + i;
-
-        int socktype = 0;
+    for (const auto &[fd, name] : fds) {
+        if (!isStreamSocket(fd))
+            continue;
 
-        if (socklen_t optlen = sizeof(socktype);
-            getsockopt(fd, SOL_SOCKET, SO_TYPE, &socktype, &optlen) < 0) {
-            std::error_code ec(errno, std::system_category());
-            spdlog::error("getsockopt failed for fd {}: {}", fd, ec.message());
+        // Connections handed over through the fd store are picked up by getSystemdStoredFds()
+        if (!isListening(fd))
             continue;
-        }
 
         sockaddr_un addr{};
         if (socklen_t len = sizeof(addr);
@@ -44,11 +89,6 @@ std::vector<SocketInfo> getSystemdUnixSockets() noexcept
             continue;
         }
 
-        if (socktype != SOCK_STREAM) {
-            spdlog::debug("fd {} is not a SOCK_STREAM socket (type={})", fd, socktype);
-            continue;
-        }
-
         // Only AF_UNIX sockets
         if (addr.sun_family != AF_UNIX) {
             spdlog::debug("fd {} is not an AF_UNIX socket", fd);
@@ -60,7 +100,27 @@ std::vector<SocketInfo> getSystemdUnixSockets() noexcept
             continue;
         }
 
-        result.emplace_back(SocketInfo{.fd = fd, .path = std::filesystem::path(addr.sun_path)});
+        result.emplace_back(
+            SocketInfo{.fd = fd, .path = std::filesystem::path(addr.sun_path), .name = name});
+    }
+
+    return result;
+}
+
+std::vector<StoredFd> getSystemdStoredFds(std::string_view prefix) noexcept
+{
+    std::vector<StoredFd> result;
+
+    for (auto &entry : listenFds()) {
+        if (!entry.name.starts_with(prefix))
+            continue;
+
+        if (!isStreamSocket(entry.fd) || isListening(entry.fd)) {
+            spdlog::warn("Stored fd {} ('{}') is not a connected stream socket, ignoring",
+                         entry.fd, entry.name);
+            continue;
+        }
+        result.push_back(std::move(entry));
     }
 
     return result;
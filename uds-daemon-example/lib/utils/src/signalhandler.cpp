@@ -5,6 +5,11 @@
 namespace utils {
 
 SignalHandler::SignalHandler(std::initializer_list<int> signals)
+ : SignalHandler(std::span<const int>(signals.begin(), signals.size()))
+{
+}
+
+SignalHandler::SignalHandler(std::span<const int> signals)
 {
     if (sigemptyset(&sigSet) != 0)
         throw SignalError("sigemptyset failed");
@@ -29,6 +34,22 @@ int SignalHandler::wait() const
     return sig;
 }
 
+std::optional<int> SignalHandler::waitFor(std::chrono::milliseconds timeout) const
+{
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec ts{.tv_sec = secs.count(),
+                      .tv_nsec = std::chrono::nanoseconds(timeout - secs).count()};
+    for (;;) {
+        const int sig = sigtimedwait(&sigSet, nullptr, &ts);
+        if (sig >= 0)
+            return sig;
+        if (errno == EAGAIN)
+            return std::nullopt;
+        if (errno != EINTR)
+            throw SignalError("sigtimedwait failed");
+    }
+}
+
 void SignalHandler::enableSegfaultHandler()
 {
     struct sigaction sa{};
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <timer_wheel.h>
+#include <unistd.h>
+
+using namespace utils;
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick)
+ : tick_(std::max(tick, std::chrono::milliseconds(1)))
+ , origin_(Clock::now())
+{
+    timerFd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd_ == -1)
+        throw TimerWheelError("timerfd creation failed");
+
+    heads_.fill(kNil);
+}
+
+TimerWheel::~TimerWheel()
+{
+    if (timerFd_ >= 0)
+        ::close(timerFd_);
+}
+
+//*****************************************************************************
+// Public interface
+//*****************************************************************************
+
+TimerId TimerWheel::Schedule(Clock::duration delay, TimerCallback cb)
+{
+    return Add(delay, 0, std::move(cb));
+}
+
+TimerId TimerWheel::SchedulePeriodic(Clock::duration period, TimerCallback cb)
+{
+    return Add(period, std::max<uint64_t>(TicksOf(period), 1), std::move(cb));
+}
+
+bool TimerWheel::Cancel(TimerId id) noexcept
+{
+    Node *node = Lookup(id);
+    if (node == nullptr)
+        return false;
+
+    Unlink(id.index);
+    Release(id.index);
+    return true;
+}
+
+bool TimerWheel::Reset(TimerId id, Clock::duration delay) noexcept
+{
+    Node *node = Lookup(id);
+    if (node == nullptr)
+        return false;
+
+    Unlink(id.index);
+    node->expires = CatchUp() + std::max<uint64_t>(TicksOf(delay), 1);
+    Insert(id.index);
+    if (node->expires < armedTick_)
+        Rearm();
+    return true;
+}
+
+bool TimerWheel::IsActive(TimerId id) const noexcept { return Lookup(id) != nullptr; }
+
+TimerWheel::Clock::time_point TimerWheel::Now() const noexcept
+{
+    return origin_ + tick_ * static_cast<Clock::rep>(currentTick_);
+}
+
+std::size_t TimerWheel::OnReadable()
+{
+    uint64_t expirations;
+    ssize_t n = ::read(timerFd_, &expirations, sizeof(expirations)); // drain
+    (void)n;
+    armedTick_ = kNever;
+    return AdvanceTo(Clock::now());
+}
+
+std::size_t TimerWheel::AdvanceTo(Clock::time_point now)
+{
+    const uint64_t target = TickOf(now);
+    std::size_t fired = 0;
+
+    // Nothing expires or cascades between the ticks NextTick() finds; skip those in one go.
+    for (uint64_t next = NextTick(); next <= target; next = NextTick()) {
+        currentTick_ = next - 1;
+        fired += Step();
+    }
+    currentTick_ = std::max(currentTick_, target);
+
+    Rearm();
+    return fired;
+}
+
+//*****************************************************************************
+// Node slab
+//*****************************************************************************
+
+uint64_t TimerWheel::TicksOf(Clock::duration d) const noexcept
+{
+    if (d <= Clock::duration::zero())
+        return 0;
+    // Round up, a timer must never fire early by a partial tick.
+    return static_cast<uint64_t>((d + tick_ - Clock::duration(1)) / tick_);
+}
+
+uint64_t TimerWheel::TickOf(Clock::time_point t) const noexcept
+{
+    if (t <= origin_)
+        return 0;
+    return static_cast<uint64_t>((t - origin_) / tick_);
+}
+
+uint64_t TimerWheel::CatchUp() noexcept
+{
+    // The wheel only advances when the timerfd fires, so it may lag behind the clock by much more
+    // than a tick. Nothing is due before NextTick(): moving up to it needs no stepping.
+    const uint64_t now = TickOf(Clock::now());
+    if (now > currentTick_ + 1)
+        currentTick_ = std::max(currentTick_, std::min(now, NextTick() - 1));
+    return std::max(currentTick_, now);
+}
+
+TimerId TimerWheel::Add(Clock::duration delay, uint64_t period, TimerCallback &&cb)
+{
+    const uint64_t now = CatchUp();
+    const uint32_t index = Allocate();
+    Node &node = nodes_[index];
+    node.expires = now + std::max<uint64_t>(TicksOf(delay), 1);
+    node.period = period;
+    node.active = true;
+    node.cancelled = false;
+    node.cb = std::move(cb);
+    Insert(index);
+    ++active_;
+
+    if (node.expires < armedTick_)
+        Rearm();
+
+    return TimerId{.index = index, .generation = node.generation};
+}
+
+uint32_t TimerWheel::Allocate()
+{
+    if (freeList_ != kNil) {
+        const uint32_t index = freeList_;
+        freeList_ = nodes_[index].next;
+        nodes_[index].next = kNil;
+        return index;
+    }
+
+    if (nodes_.size() >= kNil)
+        throw TimerWheelError("timer slab exhausted", ENOMEM);
+
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::Release(uint32_t index) noexcept
+{
+    Node &node = nodes_[index];
+    --active_;
+    node.active = false;
+    ++node.generation;
+
+    if (index == running_) {
+        // The callback is executing right now; it is destroyed once it returned.
+        node.cancelled = true;
+        return;
+    }
+
+    node.cb = nullptr;
+    node.next = freeList_;
+    freeList_ = index;
+}
+
+TimerWheel::Node *TimerWheel::Lookup(TimerId id) noexcept
+{
+    if (id.index >= nodes_.size())
+        return nullptr;
+    Node &node = nodes_[id.index];
+    return (node.active && node.generation == id.generation) ? &node : nullptr;
+}
+
+const TimerWheel::Node *TimerWheel::Lookup(TimerId id) const noexcept
+{
+    if (id.index >= nodes_.size())
+        return nullptr;
+    const Node &node = nodes_[id.index];
+    return (node.active && node.generation == id.generation) ? &node : nullptr;
+}
+
+//*****************************************************************************
+// Wheel
+//*****************************************************************************
+
+void TimerWheel::Insert(uint32_t index) noexcept
+{
+    Node &node = nodes_[index];
+    const uint64_t delta = node.expires - currentTick_;
+
+    unsigned level = 0;
+    while (level < kLevels - 1 && delta >= (uint64_t{1} << (kSlotBits * (level + 1))))
+        ++level;
+
+    // Beyond the horizon: park in the farthest slot of the top level and re-cascade from there.
+    const uint64_t horizon = (uint64_t{1} << (kSlotBits * kLevels)) - 1;
+    const uint64_t placed = (delta > horizon) ? currentTick_ + horizon : node.expires;
+
+    const auto slot = static_cast<uint32_t>(placed >> (kSlotBits * level)) & kSlotMask;
+    Link(index, level * kSlots + slot);
+}
+
+void TimerWheel::Link(uint32_t index, uint32_t list) noexcept
+{
+    Node &node = nodes_[index];
+    node.list = list;
+    node.prev = kNil;
+    node.next = heads_[list];
+    if (node.next != kNil)
+        nodes_[node.next].prev = index;
+    heads_[list] = index;
+}
+
+void TimerWheel::Unlink(uint32_t index) noexcept
+{
+    Node &node = nodes_[index];
+    if (node.list == kNil)
+        return;
+
+    if (node.prev != kNil)
+        nodes_[node.prev].next = node.next;
+    else
+        heads_[node.list] = node.next;
+
+    if (node.next != kNil)
+        nodes_[node.next].prev = node.prev;
+
+    node.prev = kNil;
+    node.next = kNil;
+    node.list = kNil;
+}
+
+void TimerWheel::Cascade(unsigned level, uint32_t slot) noexcept
+{
+    uint32_t index = heads_[level * kSlots + slot];
+    heads_[level * kSlots + slot] = kNil;
+
+    while (index != kNil) {
+        const uint32_t next = nodes_[index].next;
+        nodes_[index].list = kNil;
+        Insert(index);
+        index = next;
+    }
+}
+
+uint64_t TimerWheel::NextTick() const noexcept
+{
+    // Level 0 holds expiries within the next 64 ticks, each slot a single tick. A slot of an upper
+    // level is due when the wheel reaches its first tick and cascades it down.
+    uint64_t next = kNever;
+    for (unsigned level = 0; level < kLevels; ++level) {
+        const unsigned shift = kSlotBits * level;
+        const uint64_t base = currentTick_ >> shift;
+        for (uint64_t i = 1; i <= kSlots; ++i) {
+            const uint64_t at = (base + i) << shift;
+            if (at >= next)
+                break;
+            if (heads_[level * kSlots + (static_cast<uint32_t>(base + i) & kSlotMask)] != kNil) {
+                next = at;
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+std::size_t TimerWheel::Step()
+{
+    ++currentTick_;
+
+    const auto slot = static_cast<uint32_t>(currentTick_) & kSlotMask;
+    if (slot == 0) {
+        for (unsigned level = 1; level < kLevels; ++level) {
+            const auto upper =
+                static_cast<uint32_t>(currentTick_ >> (kSlotBits * level)) & kSlotMask;
+            Cascade(level, upper);
+            if (upper != 0)
+                break;
+        }
+    }
+
+    // Move everything due to the expired list first: callbacks may schedule into this very slot.
+    uint32_t index = heads_[slot];
+    heads_[slot] = kNil;
+    while (index != kNil) {
+        const uint32_t next = nodes_[index].next;
+        nodes_[index].list = kNil;
+        if (nodes_[index].expires <= currentTick_)
+            Link(index, kExpiredList);
+        else
+            Insert(index);
+        index = next;
+    }
+
+    return RunExpired();
+}
+
+std::size_t TimerWheel::RunExpired()
+{
+    std::size_t fired = 0;
+
+    while (heads_[kExpiredList] != kNil) {
+        const uint32_t index = heads_[kExpiredList];
+        Unlink(index);
+        Node &node = nodes_[index];
+
+        if (node.period == 0) {
+            TimerCallback cb = std::move(node.cb);
+            Release(index);
+            if (cb)
+                cb();
+        } else {
+            node.expires = currentTick_ + node.period;
+            Insert(index);
+
+            // Node storage is a deque, references stay valid while the callback schedules more.
+            running_ = index;
+            if (node.cb)
+                node.cb();
+            running_ = kNil;
+
+            if (node.cancelled) {
+                node.cancelled = false;
+                node.cb = nullptr;
+                node.next = freeList_;
+                freeList_ = index;
+            }
+        }
+        ++fired;
+    }
+
+    return fired;
+}
+
+//*****************************************************************************
+// timerfd
+//*****************************************************************************
+
+void TimerWheel::Rearm() noexcept
+{
+    const uint64_t next = NextTick();
+    if (next == kNever) {
+        Disarm();
+        return;
+    }
+    if (next == armedTick_)
+        return;
+
+    // One-shot at an absolute deadline; steady_clock is CLOCK_MONOTONIC.
+    const auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              (origin_ + tick_ * static_cast<Clock::rep>(next)).time_since_epoch())
+                              .count();
+    itimerspec spec{};
+    spec.it_value.tv_sec = deadline / 1'000'000'000;
+    spec.it_value.tv_nsec = deadline % 1'000'000'000;
+
+    if (::timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr) == -1) {
+        spdlog::error("TimerWheel: failed to arm timerfd: {}", strerror(errno));
+        return;
+    }
+    armedTick_ = next;
+}
+
+void TimerWheel::Disarm() noexcept
+{
+    if (armedTick_ == kNever)
+        return;
+
+    itimerspec spec{};
+    if (::timerfd_settime(timerFd_, 0, &spec, nullptr) == -1) {
+        spdlog::error("TimerWheel: failed to disarm timerfd: {}", strerror(errno));
+        return;
+    }
+    armedTick_ = kNever;
+}
@@ -0,0 +1,235 @@
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chunk_stream.h>
+#include <filesystem>
+#include <format>
+#include <fs_utils.h>
+#include <gtest/gtest.h>
+#include <pubsub.h>
+#include <thread>
+#include <uds_client.h>
+#include <uds_server.h>
+
+namespace fs = std::filesystem;
+using namespace net;
+
+namespace {
+
+constexpr std::size_t kTestChunkSize = 4096;
+
+std::byte patternAt(uint64_t offset) { return static_cast<std::byte>(offset % 251); }
+
+//! "stream <credits> <bytes>" streams a byte pattern, written in odd-sized pieces; "stream
+//! <credits> fail" ends with an error. Anything else is echoed, "subscribe <topic>" after
+//! subscribing the session to broker_; events queued meanwhile go out ahead of every answer.
+class ChunkStreamTest : public ::testing::Test {
+  public:
+    ChunkStreamTest()
+     : server_(fs::temp_directory_path() /
+               ("sockact-stream-test-" + fs_utils::random_suffix() + ".sock"))
+    {
+    }
+
+    void SetUp() override
+    {
+        server_thread_ = std::thread([this]() {
+            while (running_.load()) {
+                auto session = server_.WaitForConnection();
+                if (!session.has_value())
+                    break;
+                Serve(*session);
+            }
+        });
+    }
+
+    void TearDown() override
+    {
+        running_.store(false);
+        server_.Unblock();
+        if (server_thread_.joinable())
+            server_thread_.join();
+    }
+
+  protected:
+    void Serve(const SocketSession &session)
+    {
+        std::array<std::byte, 1024> buffer{};
+        const auto subscriber = std::make_shared<Subscriber>(SubscriberOptions{}, [] {});
+        std::vector<SharedBuffer> events;
+        while (running_.load()) {
+            auto got = session.receive(std::span(buffer));
+            if (!got.has_value() || *got == 0)
+                return;
+            subscriber->Drain(events);
+            for (const auto &event : events) {
+                if (!session.send(std::span(*event)))
+                    return;
+            }
+            events.clear();
+
+            const std::string_view request(reinterpret_cast<const char *>(buffer.data()), *got);
+            if (request.starts_with("subscribe "))
+                broker_.Subscribe(subscriber, request.substr(10));
+            const auto stream = ParseStreamRequest(request);
+            if (!stream) {
+                if (!session.send(std::span(buffer.data(), *got)))
+                    return;
+                continue;
+            }
+
+            ChunkWriter out(session, stream->credits, running_, kTestChunkSize);
+            if (stream->request == "fail") {
+                out.Fail("no such thing");
+                continue;
+            }
+            uint64_t size = 0;
+            std::from_chars(stream->request.data(),
+                            stream->request.data() + stream->request.size(), size);
+            std::vector<std::byte> piece(1000);
+            for (uint64_t offset = 0; offset < size; offset += piece.size()) {
+                const auto length = std::min<uint64_t>(piece.size(), size - offset);
+                for (uint64_t i = 0; i < length; ++i)
+                    piece[i] = patternAt(offset + i);
+                if (!out.Write(std::span(piece).first(length)))
+                    break;
+                written_.store(offset + length);
+            }
+            if (!out.Finish())
+                return;
+        }
+    }
+
+    UdsServer server_;
+    std::thread server_thread_;
+    std::atomic<bool> running_{true};
+    std::atomic<uint64_t> written_{0};
+    Broker broker_;
+};
+
+} // namespace
+
+TEST(ChunkStreamRequest, ParsesCreditsAndRequest)
+{
+    const auto stream = ParseStreamRequest("stream 8 report all");
+    ASSERT_TRUE(stream.has_value());
+    EXPECT_EQ(stream->credits, 8u);
+    EXPECT_EQ(stream->request, "report all");
+
+    EXPECT_EQ(ParseStreamRequest("stream 3")->credits, 3u);
+    EXPECT_EQ(ParseStreamRequest("stream 3")->request, "");
+    EXPECT_EQ(ParseStreamRequest("stream x report")->credits, 0u);
+    EXPECT_FALSE(ParseStreamRequest("streaming 8 report").has_value());
+    EXPECT_FALSE(ParseStreamRequest("ping").has_value());
+}
+
+TEST_F(ChunkStreamTest, DeliversTheResponseInOrderInBoundedChunks)
+{
+    UdsClient client;
+    ASSERT_EQ(client.connect(server_.SocketPath()), std::errc{});
+
+    constexpr uint64_t kSize = 3 * 1024 * 1024 + 17;
+    uint64_t offset = 0;
+    bool inOrder = true;
+    std::size_t largest = 0;
+    const auto result = client.stream(
+        std::to_string(kSize),
+        [&](std::span<const std::byte> chunk) {
+            largest = std::max(largest, chunk.size());
+            for (const auto byte : chunk)
+                inOrder = inOrder && byte == patternAt(offset++);
+        },
+        2);
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->error.empty());
+    EXPECT_EQ(result->bytes, kSize);
+    EXPECT_EQ(offset, kSize);
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ(largest, kTestChunkSize);
+    EXPECT_EQ(result->chunks, (kSize + kTestChunkSize - 1) / kTestChunkSize);
+
+    // Every grant was consumed by the stream: the next request is answered as usual.
+    const std::string ping = "ping";
+    ASSERT_TRUE(client.send(std::span(ping)).has_value());
+    std::array<char, 16> reply{};
+    const auto got = client.receive(std::span(reply));
+    ASSERT_TRUE(got.has_value());
+    EXPECT_EQ(std::string_view(reply.data(), *got), ping);
+}
+
+TEST_F(ChunkStreamTest, ReportsTheServersError)
+{
+    UdsClient client;
+    ASSERT_EQ(client.connect(server_.SocketPath()), std::errc{});
+
+    int chunks = 0;
+    const auto result =
+        client.stream("fail", [&chunks](std::span<const std::byte>) { ++chunks; });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->error, "no such thing");
+    EXPECT_EQ(result->bytes, 0u);
+    EXPECT_EQ(chunks, 0);
+
+    const auto empty = client.stream("0", [&chunks](std::span<const std::byte>) { ++chunks; });
+    ASSERT_TRUE(empty.has_value());
+    EXPECT_TRUE(empty->error.empty());
+    EXPECT_EQ(empty->chunks, 1u);
+    EXPECT_EQ(empty->bytes, 0u);
+}
+
+TEST_F(ChunkStreamTest, TellsEventsAheadOfTheChunksApart)
+{
+    UdsClient client;
+    ASSERT_EQ(client.connect(server_.SocketPath()), std::errc{});
+
+    const std::string subscribe = "subscribe news";
+    ASSERT_TRUE(client.send(std::span(subscribe)).has_value());
+    std::array<char, 32> reply{};
+    const auto got = client.receive(std::span(reply));
+    ASSERT_TRUE(got.has_value());
+    ASSERT_EQ(std::string_view(reply.data(), *got), subscribe);
+
+    ASSERT_EQ(broker_.Publish("news", "first"), 1u);
+    ASSERT_EQ(broker_.Publish("news", "second"), 1u);
+    constexpr uint64_t kSize = 3 * kTestChunkSize + 5;
+    uint64_t offset = 0;
+    bool inOrder = true;
+    std::vector<std::string> events;
+    const auto result = client.stream(
+        std::to_string(kSize),
+        [&](std::span<const std::byte> chunk) {
+            for (const auto byte : chunk)
+                inOrder = inOrder && byte == patternAt(offset++);
+        },
+        2,
+        [&events](std::string_view topic, std::span<const std::byte> payload) {
+            events.push_back(std::format(
+                "{} {}", topic,
+                std::string_view(reinterpret_cast<const char *>(payload.data()), payload.size())));
+        });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->bytes, kSize);
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ(events, (std::vector<std::string>{"news first", "news second"}));
+
+    // Without an event callback the events are skipped.
+    ASSERT_EQ(broker_.Publish("news", "third"), 1u);
+    const auto skipped = client.stream("100", [](std::span<const std::byte>) {});
+    ASSERT_TRUE(skipped.has_value());
+    EXPECT_EQ(skipped->bytes, 100u);
+}
+
+TEST_F(ChunkStreamTest, SenderWaitsForCredits)
+{
+    UdsClient client;
+    ASSERT_EQ(client.connect(server_.SocketPath()), std::errc{});
+
+    // Two credits and no grants after them: the server gets two chunks out, then waits.
+    const std::string request = std::format("stream 2 {}", 10 * kTestChunkSize);
+    ASSERT_TRUE(client.send(std::span(request)).has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_GE(written_.load(), 2 * kTestChunkSize);
+    EXPECT_LT(written_.load(), 3 * kTestChunkSize);
+    client.disconnect();
+}
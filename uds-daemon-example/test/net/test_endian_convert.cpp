@@ -0,0 +1,102 @@
+#include <array>
+#include <endian_convert.h>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+// Bulk conversion is usable in constant expressions.
+constexpr std::array<uint32_t, 3> kConverted = [] {
+    std::array<uint32_t, 3> in{0x01020304, 0x0a0b0c0d, 0};
+    std::array<uint32_t, 3> out{};
+    host_to_network<uint32_t>(in, out);
+    return out;
+}();
+static_assert(kConverted[0] == host_to_network(uint32_t{0x01020304}));
+static_assert(kConverted[1] == host_to_network(uint32_t{0x0a0b0c0d}));
+
+template <typename T>
+std::vector<T> makeSamples(std::size_t count)
+{
+    std::vector<T> samples(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if constexpr (std::is_floating_point_v<T>)
+            samples[i] = static_cast<T>(i) * T(1.25) - T(3);
+        else
+            samples[i] = static_cast<T>(0x0102030405060708ULL * (i + 1));
+    }
+    return samples;
+}
+
+template <typename T>
+void expectMatchesScalar(detail::SwapIsa isa)
+{
+    // Lengths around every vector width, so each loop and the scalar tail are exercised.
+    for (std::size_t count = 0; count < 80; ++count) {
+        const auto in = makeSamples<T>(count);
+        std::vector<T> out(count);
+        detail::SwapBytes(isa, reinterpret_cast<const std::byte *>(in.data()),
+                          reinterpret_cast<std::byte *>(out.data()), count, sizeof(T));
+        for (std::size_t i = 0; i < count; ++i) {
+            const T expected = host_to_network(in[i]);
+            ASSERT_EQ(std::memcmp(&out[i], &expected, sizeof(T)), 0)
+                << detail::SwapIsaName(isa) << " count " << count << " index " << i;
+        }
+    }
+}
+
+} // namespace
+
+TEST(EndianConvertTest, EveryIsaMatchesScalar)
+{
+    for (auto isa : {detail::SwapIsa::Scalar, detail::SwapIsa::Ssse3, detail::SwapIsa::Avx2,
+                     detail::SwapIsa::Neon}) {
+        if (!detail::SwapIsaSupported(isa))
+            continue;
+        SCOPED_TRACE(detail::SwapIsaName(isa));
+        expectMatchesScalar<uint16_t>(isa);
+        expectMatchesScalar<int32_t>(isa);
+        expectMatchesScalar<uint64_t>(isa);
+        expectMatchesScalar<float>(isa);
+        expectMatchesScalar<double>(isa);
+    }
+    EXPECT_TRUE(detail::SwapIsaSupported(detail::ActiveSwapIsa()));
+}
+
+TEST(EndianConvertTest, InPlaceRoundTrip)
+{
+    const auto original = makeSamples<uint32_t>(1001);
+    auto data = original;
+
+    host_to_network(std::span(data));
+    EXPECT_EQ(data[5], host_to_network(original[5]));
+    EXPECT_EQ(data[1000], host_to_network(original[1000]));
+
+    network_to_host(std::span(data));
+    EXPECT_EQ(data, original);
+}
+
+TEST(EndianConvertTest, OutOfPlaceLeavesInputAndExtraOutput)
+{
+    const auto in = makeSamples<double>(37);
+    std::vector<double> out(40, 7.0);
+
+    host_to_network<double>(in, out);
+    std::vector<double> back(in.size());
+    network_to_host<double>(std::span(out).first(in.size()), back);
+
+    EXPECT_EQ(back, in);
+    EXPECT_EQ(out[37], 7.0);
+    EXPECT_EQ(in, makeSamples<double>(37));
+}
+
+TEST(EndianConvertTest, SingleBytesAreCopied)
+{
+    std::array<uint8_t, 4> in{1, 2, 3, 4};
+    std::array<uint8_t, 4> out{};
+    host_to_network<uint8_t>(in, out);
+    EXPECT_EQ(out, in);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <peer_rate_limiter.h>
+
+using namespace net;
+using namespace std::chrono_literals;
+
+namespace {
+
+const PeerRateLimiter::Clock::time_point kStart{1h};
+
+} // namespace
+
+TEST(PeerRateLimiterTest, SessionsOfOneUidShareItsRate)
+{
+    PeerRateLimiter limiter({.uidRate = 100, .uidBurst = 1});
+    auto account = limiter.AccountOf(1000);
+    utils::TokenBucket a;
+    utils::TokenBucket b;
+
+    EXPECT_EQ(limiter.Admit(*account, a, kStart), 0ms);
+    EXPECT_EQ(limiter.Admit(*account, b, kStart), 10ms);
+
+    // Another uid is not held up by the backlog of the first.
+    auto other = limiter.AccountOf(1001);
+    utils::TokenBucket c;
+    EXPECT_EQ(limiter.Admit(*other, c, kStart), 0ms);
+}
+
+TEST(PeerRateLimiterTest, LongerOfSessionAndUidWaitWins)
+{
+    PeerRateLimiter limiter({.uidRate = 1000, .uidBurst = 1});
+    auto account = limiter.AccountOf(1000);
+    utils::TokenBucket session(10, 1);
+
+    EXPECT_EQ(limiter.Admit(*account, session, kStart), 0ms);
+    EXPECT_EQ(limiter.Admit(*account, session, kStart), 100ms);
+}
+
+TEST(PeerRateLimiterTest, WeightScalesShare)
+{
+    PeerRateLimiter limiter({.uidRate = 100, .uidBurst = 1, .uidWeights = {{0, 4}}});
+    auto heavy = limiter.AccountOf(0);
+    auto light = limiter.AccountOf(1000);
+    utils::TokenBucket session;
+
+    // Weight 4 gets four times the burst and a quarter of the spacing.
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(limiter.Admit(*heavy, session, kStart), 0ms);
+    EXPECT_EQ(limiter.Admit(*heavy, session, kStart), 2500us);
+
+    EXPECT_EQ(limiter.Admit(*light, session, kStart), 0ms);
+    EXPECT_EQ(limiter.Admit(*light, session, kStart), 10ms);
+}
+
+TEST(PeerRateLimiterTest, CountsThrottledRequests)
+{
+    PeerRateLimiter limiter({.uidRate = 100, .uidBurst = 1});
+    auto account = limiter.AccountOf(1000);
+    EXPECT_EQ(limiter.AccountOf(1000), account);
+    utils::TokenBucket session;
+    for (int i = 0; i < 3; ++i)
+        limiter.Admit(*account, session, kStart);
+
+    const auto stats = limiter.Stats();
+    ASSERT_EQ(stats.size(), 1U);
+    EXPECT_EQ(stats[0].uid, 1000U);
+    EXPECT_EQ(stats[0].requests, 3U);
+    EXPECT_EQ(stats[0].throttled, 2U);
+    EXPECT_EQ(stats[0].delayed, 30ms);
+
+    limiter.Reconfigure({});
+    EXPECT_EQ(limiter.Admit(*account, session, kStart), 0ms);
+}
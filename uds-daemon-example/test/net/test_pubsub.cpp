@@ -0,0 +1,192 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include <pubsub.h>
+#include <socket_session.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace net;
+
+namespace {
+
+std::shared_ptr<Subscriber> makeSubscriber(SubscriberOptions options = {},
+                                           std::atomic<int> *notified = nullptr)
+{
+    return std::make_shared<Subscriber>(options, [notified]() {
+        if (notified)
+            ++*notified;
+    });
+}
+
+std::string payloadOf(const SharedBuffer &message)
+{
+    auto view = EventFrame::Parse(*message);
+    EXPECT_TRUE(view);
+    const auto payload = view->Get<event::Payload>();
+    return std::string(reinterpret_cast<const char *>(payload.data()), payload.size());
+}
+
+std::vector<SharedBuffer> drain(Subscriber &subscriber)
+{
+    std::vector<SharedBuffer> out;
+    subscriber.Drain(out);
+    return out;
+}
+
+} // namespace
+
+TEST(PubSubTest, FanOutSharesOneBuffer)
+{
+    Broker broker;
+    auto a = makeSubscriber();
+    auto b = makeSubscriber();
+    auto other = makeSubscriber();
+    broker.Subscribe(a, "state");
+    broker.Subscribe(b, "state");
+    broker.Subscribe(b, "state"); // no duplicate delivery
+    broker.Subscribe(other, "alarms");
+
+    EXPECT_EQ(broker.Publish("state", "ready"), 2U);
+    EXPECT_EQ(broker.Publish("nobody", "ignored"), 0U);
+
+    const auto fromA = drain(*a);
+    const auto fromB = drain(*b);
+    ASSERT_EQ(fromA.size(), 1U);
+    ASSERT_EQ(fromB.size(), 1U);
+    EXPECT_EQ(fromA[0].get(), fromB[0].get());
+    EXPECT_EQ(payloadOf(fromA[0]), "ready");
+    EXPECT_EQ(EventFrame::Parse(*fromA[0])->Get<event::Topic>(), "state");
+    EXPECT_EQ(other->Queued(), 0U);
+}
+
+TEST(PubSubTest, NotifiesOnlyWhenQueueTurnsNonEmpty)
+{
+    Broker broker;
+    std::atomic<int> notified{0};
+    auto subscriber = makeSubscriber({}, &notified);
+    broker.Subscribe(subscriber, "t");
+
+    broker.Publish("t", "1");
+    broker.Publish("t", "2");
+    EXPECT_EQ(notified, 1);
+
+    EXPECT_EQ(drain(*subscriber).size(), 2U);
+    broker.Publish("t", "3");
+    EXPECT_EQ(notified, 2);
+}
+
+TEST(PubSubTest, DropOldestKeepsNewest)
+{
+    Broker broker;
+    auto subscriber = makeSubscriber({.maxQueued = 2, .policy = SlowSubscriberPolicy::DropOldest});
+    broker.Subscribe(subscriber, "t");
+    for (const char *value : {"1", "2", "3"})
+        broker.Publish("t", value);
+
+    const auto events = drain(*subscriber);
+    ASSERT_EQ(events.size(), 2U);
+    EXPECT_EQ(payloadOf(events[0]), "2");
+    EXPECT_EQ(payloadOf(events[1]), "3");
+    EXPECT_EQ(subscriber->Stats().dropped, 1U);
+}
+
+TEST(PubSubTest, ConflateReplacesSameTopic)
+{
+    Broker broker;
+    auto subscriber = makeSubscriber({.maxQueued = 2, .policy = SlowSubscriberPolicy::Conflate});
+    broker.Subscribe(subscriber, "temperature");
+    broker.Subscribe(subscriber, "alarm");
+
+    broker.Publish("temperature", "20");
+    broker.Publish("alarm", "on");
+    broker.Publish("temperature", "21");
+    broker.Publish("temperature", "22");
+
+    const auto events = drain(*subscriber);
+    ASSERT_EQ(events.size(), 2U);
+    EXPECT_EQ(payloadOf(events[0]), "22");
+    EXPECT_EQ(payloadOf(events[1]), "on");
+    EXPECT_EQ(subscriber->Stats().conflated, 2U);
+}
+
+TEST(PubSubTest, DisconnectRemovesSlowSubscriber)
+{
+    Broker broker;
+    std::atomic<int> notified{0};
+    auto slow = makeSubscriber({.maxQueued = 1, .policy = SlowSubscriberPolicy::Disconnect},
+                               &notified);
+    auto fast = makeSubscriber();
+    broker.Subscribe(slow, "t");
+    broker.Subscribe(fast, "t");
+
+    EXPECT_EQ(broker.Publish("t", "1"), 2U);
+    EXPECT_EQ(broker.Publish("t", "2"), 1U);
+    EXPECT_TRUE(slow->Closed());
+    EXPECT_EQ(notified, 2); // first event and the close
+    EXPECT_EQ(slow->Queued(), 0U);
+    EXPECT_EQ(broker.Subscribers("t"), 1U);
+}
+
+TEST(PubSubTest, UnsubscribeAndRemove)
+{
+    Broker broker;
+    auto subscriber = makeSubscriber();
+    broker.Subscribe(subscriber, "a");
+    broker.Subscribe(subscriber, "b");
+
+    EXPECT_TRUE(broker.Unsubscribe(*subscriber, "a"));
+    EXPECT_FALSE(broker.Unsubscribe(*subscriber, "a"));
+    EXPECT_EQ(broker.Publish("a", "x"), 0U);
+    EXPECT_EQ(broker.Publish("b", "x"), 1U);
+
+    broker.Remove(*subscriber);
+    EXPECT_EQ(broker.Subscribers("b"), 0U);
+    EXPECT_EQ(subscriber.use_count(), 1);
+}
+
+TEST(PubSubTest, GatherSendDeliversFrames)
+{
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    SocketSession sender(fds[0]);
+    SocketSession receiver(fds[1]);
+
+    Broker broker;
+    auto subscriber = makeSubscriber();
+    broker.Subscribe(subscriber, "t");
+    broker.Publish("t", "first");
+    broker.Publish("t", std::string(100000, 'x')); // more than one send fits in the buffer
+
+    const auto events = drain(*subscriber);
+    std::vector<std::span<const std::byte>> pieces;
+    std::size_t total = 0;
+    for (const auto &event : events) {
+        pieces.emplace_back(*event);
+        total += event->size();
+    }
+
+    std::vector<std::byte> received(total);
+    std::size_t got = 0;
+    std::thread reader([&]() {
+        while (got < total) {
+            auto n = receiver.receive(std::span(received).subspan(got));
+            if (!n)
+                break;
+            got += *n;
+        }
+    });
+    EXPECT_EQ(sender.sendv(pieces), total);
+    reader.join();
+    ASSERT_EQ(got, total);
+
+    // Each event opens with the marker that sets it apart from a reply.
+    ASSERT_EQ(received[0], std::byte{kEventMarker});
+    auto first = EventFrame::Parse(received);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(received[first->Size()], std::byte{kEventMarker});
+    EXPECT_EQ(payloadOf(events[0]), "first");
+    auto second = EventFrame::Parse(std::span(received).subspan(first->Size()));
+    ASSERT_TRUE(second);
+    EXPECT_EQ(second->Get<event::Payload>().size(), 100000U);
+}
@@ -0,0 +1,204 @@
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <socket_session.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace net;
+
+namespace {
+
+std::pair<SocketSession, SocketSession> makeSessionPair()
+{
+    int fds[2];
+    EXPECT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    return {SocketSession(fds[0]), SocketSession(fds[1])};
+}
+
+std::string receiveAll(const SocketSession &session, std::size_t size)
+{
+    std::string out(size, '\0');
+    auto n = session.receive(std::span(out), [size](std::span<const std::byte> data) {
+        return data.size() >= size;
+    });
+    out.resize(n ? *n : 0);
+    return out;
+}
+
+// Waits until thread \p tid sleeps: a receive on it has stopped spinning and parked in poll().
+void waitUntilParked(pid_t tid)
+{
+    const auto path = std::format("/proc/self/task/{}/stat", tid);
+    for (;;) {
+        std::ifstream stat(path);
+        std::string line;
+        std::getline(stat, line);
+        // The state follows the thread name, which is in parentheses.
+        const auto name = line.rfind(')');
+        if (name != std::string::npos && name + 2 < line.size() && line[name + 2] == 'S')
+            return;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+//! Receives \p message on a thread of its own and sends it from this one \p delay after the
+//! receive parked, however long a loaded machine takes to get it there.
+std::string receiveAfterPark(const SocketSession &sender, const SocketSession &receiver,
+                             std::string_view message,
+                             std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+{
+    std::atomic<pid_t> tid{0};
+    std::string received;
+    std::thread reader([&]() {
+        tid.store(::gettid());
+        received = receiveAll(receiver, message.size());
+    });
+    while (tid.load() == 0)
+        std::this_thread::yield();
+    waitUntilParked(tid.load());
+    std::this_thread::sleep_for(delay);
+    sender.send(std::span(message));
+    reader.join();
+    return received;
+}
+
+} // namespace
+
+TEST(SocketSessionTest, SendFileSplicesRegion)
+{
+    const std::string content = "header|payload|trailer";
+    const int file = ::memfd_create("session-test", MFD_CLOEXEC);
+    ASSERT_EQ(::write(file, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+
+    auto [client, server] = makeSessionPair();
+    utils::Pipe pipe;
+    EXPECT_EQ(server.sendFile(file, 7, 7, pipe), 7U);
+    EXPECT_EQ(receiveAll(client, 7), "payload");
+
+    // Past the end of file the transfer stops short.
+    EXPECT_EQ(server.sendFile(file, 15, 100, pipe), 7U);
+    EXPECT_EQ(receiveAll(client, 7), "trailer");
+    ::close(file);
+}
+
+TEST(SocketSessionTest, ReceiveFileWritesAtOffset)
+{
+    const int file = ::memfd_create("session-test", MFD_CLOEXEC);
+    auto [client, server] = makeSessionPair();
+    utils::Pipe pipe;
+
+    ASSERT_TRUE(client.send(std::span(std::string_view("upload"))));
+    EXPECT_EQ(server.receiveFile(file, 4, 6, pipe), 6U);
+
+    std::string stored(10, '\0');
+    ASSERT_EQ(::pread(file, stored.data(), stored.size(), 0), 10);
+    EXPECT_EQ(stored.substr(4), "upload");
+    ::close(file);
+}
+
+TEST(SocketSessionTest, RelayForwardsBetweenSessions)
+{
+    auto [client, relayIn] = makeSessionPair();
+    auto [relayOut, backend] = makeSessionPair();
+    utils::Pipe pipe;
+
+    // Larger than a socket buffer: the writer needs the relay to make progress.
+    const std::string payload(512 * 1024, 'r');
+    std::thread writer([&client, &payload]() { client.send(std::span(payload)); });
+    std::thread reader([&backend, &payload]() {
+        EXPECT_EQ(receiveAll(backend, payload.size()), payload);
+    });
+
+    EXPECT_EQ(relayIn.relayTo(relayOut, payload.size(), pipe), payload.size());
+    writer.join();
+    reader.join();
+}
+
+TEST(SocketSessionTest, ReceiveIntoAndSendFromPipe)
+{
+    auto [a, b] = makeSessionPair();
+    auto [c, d] = makeSessionPair();
+    utils::Pipe pipe;
+
+    ASSERT_TRUE(a.send(std::span(std::string_view("spliced"))));
+    EXPECT_EQ(b.receiveInto(pipe, 64), 7U);
+    EXPECT_EQ(c.sendFrom(pipe, 7), 7U);
+    EXPECT_EQ(receiveAll(d, 7), "spliced");
+}
+
+TEST(SocketSessionTest, PeerCredentialsOfLocalPeer)
+{
+    auto [a, b] = makeSessionPair();
+    const auto &peer = a.peerCredentials();
+    ASSERT_TRUE(peer.has_value());
+    EXPECT_EQ(peer->pid, ::getpid());
+    EXPECT_EQ(peer->uid, ::getuid());
+    EXPECT_EQ(peer->gid, ::getgid());
+
+    SocketSession moved(std::move(a));
+    ASSERT_TRUE(moved.peerCredentials().has_value());
+    EXPECT_EQ(moved.peerCredentials()->pid, ::getpid());
+}
+
+TEST(SocketSessionTest, ShutdownWakesBlockedSend)
+{
+    auto [a, b] = makeSessionPair();
+    // Far more than both socket buffers hold; b never reads.
+    const std::string payload(8 * 1024 * 1024, 'x');
+    std::expected<std::size_t, std::errc> sent;
+    std::thread writer([&a, &sent, &payload]() { sent = a.send(std::span(payload)); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(a.shutdown());
+    writer.join();
+    EXPECT_FALSE(sent.has_value());
+}
+
+TEST(SocketSessionTest, SpinReceiveCountsHitsAndParks)
+{
+    auto [a, b] = makeSessionPair();
+    b.setSpinPolicy({.spin = std::chrono::seconds(1)});
+
+    // Already queued: found by the first probe.
+    ASSERT_TRUE(a.send(std::span(std::string_view("early"))));
+    EXPECT_EQ(receiveAll(b, 5), "early");
+    EXPECT_EQ(b.spinStats().spinHits, 1U);
+
+    // Arrives after a short spin budget ran out: parks and still gets it.
+    b.setSpinPolicy({.spin = std::chrono::microseconds(100)});
+    EXPECT_EQ(receiveAfterPark(a, b, "late"), "late");
+    EXPECT_EQ(b.spinStats().spinHits, 1U);
+    EXPECT_EQ(b.spinStats().parks, 1U);
+
+    // A stop request reaches a spinning receive once it parks.
+    std::expected<std::size_t, std::errc> received;
+    std::string buffer(16, '\0');
+    std::thread reader([&b, &received, &buffer]() { received = b.receive(std::span(buffer)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    b.unblockReceive();
+    reader.join();
+    ASSERT_FALSE(received.has_value());
+    EXPECT_EQ(received.error(), std::errc::operation_canceled);
+}
+
+TEST(SocketSessionTest, AdaptiveSpinSkipsSlowPeers)
+{
+    auto [a, b] = makeSessionPair();
+    b.setSpinPolicy({.spin = std::chrono::microseconds(200), .adaptive = true});
+
+    // Every message takes far longer than the spin limit; after the first misses the receive
+    // parks without spinning, which it shows by not catching data that is already there.
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(receiveAfterPark(a, b, "x", std::chrono::milliseconds(10)), "x");
+    EXPECT_EQ(b.spinStats().parks, 4U);
+
+    ASSERT_TRUE(a.send(std::span(std::string_view("y"))));
+    EXPECT_EQ(receiveAll(b, 1), "y");
+    EXPECT_EQ(b.spinStats().spinHits, 0U);
+    EXPECT_EQ(b.spinStats().parks, 5U);
+}
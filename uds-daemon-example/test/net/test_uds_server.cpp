@@ -1,3 +1,4 @@
+#include <atomic>
 #include <cstring>
 #include <final_action.h>
 #include <fs_utils.h>
@@ -92,6 +93,79 @@ TEST(UdsServerBasicTest, MoveAssign)
     EXPECT_EQ(serverMoved.ServerSocket().getFd(), serverCreationFd);
 }
 
+TEST(UdsServerBasicTest, KeepSocketPathHandsListenerOver)
+{
+    auto socketPath =
+        fs::temp_directory_path() / ("sockact-uds-test-" + fs_utils::random_suffix() + ".sock");
+    int handedOverFd = -1;
+    {
+        UdsServer server(socketPath);
+        // Stands in for the copy the systemd fd store keeps
+        handedOverFd = ::dup(server.ServerSocket().getFd());
+        ASSERT_GE(handedOverFd, 0);
+        server.KeepSocketPath();
+    }
+    ASSERT_TRUE(fs::exists(socketPath));
+
+    UdsServer successor(
+        systemd_socket::SocketInfo{.fd = handedOverFd, .path = socketPath, .name = "uds-listener"});
+
+    int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(client, 0);
+    auto closeClient = utils::Finally([client]() noexcept { ::close(client); });
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+
+    auto session = successor.WaitForConnection();
+    EXPECT_TRUE(session.has_value());
+
+    // Sockets passed in by systemd are not unlinked by us
+    fs::remove(socketPath);
+}
+
+TEST(UdsServerBasicTest, SharedNonBlockingListener)
+{
+    auto socketPath =
+        fs::temp_directory_path() / ("sockact-uds-test-" + fs_utils::random_suffix() + ".sock");
+    UdsServer first(socketPath);
+    ASSERT_TRUE(first.SetNonBlocking());
+    // Stands in for the copy a forked worker has
+    UdsServer second(systemd_socket::SocketInfo{
+        .fd = ::dup(first.ServerSocket().getFd()), .path = socketPath, .name = "shared"});
+
+    std::atomic<int> accepted{0};
+    std::atomic<int> canceled{0};
+    auto waitOn = [&](UdsServer &server) {
+        auto session = server.WaitForConnection();
+        if (session)
+            ++accepted;
+        else if (session.error() == std::errc::operation_canceled)
+            ++canceled;
+    };
+    std::thread a(waitOn, std::ref(first));
+    std::thread b(waitOn, std::ref(second));
+
+    int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(client, 0);
+    auto closeClient = utils::Finally([client]() noexcept { ::close(client); });
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(::connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+
+    while (accepted == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Whichever lost the race went back to select() and can still be unblocked.
+    first.Unblock();
+    second.Unblock();
+    a.join();
+    b.join();
+    EXPECT_EQ(accepted, 1);
+    EXPECT_EQ(canceled, 1);
+}
+
 TEST_F(UdsServerTest, WaitForConnection)
 {
     auto uds_path = server().SocketPath();
@@ -4,12 +4,12 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
-#include <endian_convert.h>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
+#include <wire_schema.h>
 #include <fmt/format.h>
 
 struct TestData {
@@ -32,53 +32,30 @@ struct TestData {
                (std::string_view(name.data()) == std::string_view(rhs.name.data()));
     }
 
+    struct Name;
+    struct Data0;
+    struct Data1;
+    struct Data2;
+    using Schema = net::wire::Schema<net::wire::FixedString<Name, 10>,
+                                     net::wire::Scalar<Data0, uint32_t>,
+                                     net::wire::Scalar<Data1, uint16_t>,
+                                     net::wire::Scalar<Data2, uint8_t>>;
+
     std::vector<std::byte> serialize() const
     {
-        std::vector<std::byte> buffer;
-        buffer.reserve(name.size() + sizeof(data0) + sizeof(data1) + sizeof(data2));
-
-        auto append_bytes = [&buffer]<typename T>(T data, std::size_t size) {
-            const auto *ptr = reinterpret_cast<const std::byte *>(data);
-            buffer.insert(buffer.end(), ptr, ptr + size);
-        };
-
-        auto push = [&buffer]<typename T>(T v) {
-            T net = net::host_to_network(v);
-            auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(net);
-            buffer.insert(buffer.end(), bytes.begin(), bytes.end());
-        };
-
-        append_bytes(name.data(), name.size());
-        push(data0);
-        push(data1);
-        push(data2);
-
+        std::vector<std::byte> buffer(Schema::kMinSize);
+        Schema::Encode(buffer, std::string_view(name.data()), data0, data1, data2);
         return buffer;
     }
 
     static TestData deserialize(std::span<const std::byte> buf)
     {
-        TestData result;
-        size_t offset = 0;
-
-        std::memcpy(result.name.data(), buf.data(), result.name.size());
-        offset += result.name.size();
-
-        auto pull = [&buf, &offset]<typename T>(T &field) {
-            if (offset + sizeof(T) > buf.size())
-                throw std::runtime_error("Buffer too small while reading field");
-
-            T net{};
-            std::memcpy(&net, buf.data() + offset, sizeof(T));
-            offset += sizeof(T);
-            field = net::network_to_host(net);
-        };
-
-        pull(result.data0);
-        pull(result.data1);
-        pull(result.data2);
+        auto view = Schema::Parse(buf);
+        if (!view)
+            throw std::runtime_error("Buffer too small while reading field");
 
-        return result;
+        return TestData(view->Get<Name>(), view->Get<Data0>(), view->Get<Data1>(),
+                        view->Get<Data2>());
     }
 
     std::array<char, 10> name{};
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <wire_schema.h>
+
+using namespace net::wire;
+
+namespace {
+
+struct Kind;
+struct Id;
+struct Ratio;
+struct Label;
+struct Payload;
+struct Trailer;
+
+using FixedMessage = Schema<Scalar<Kind, uint8_t>, Scalar<Id, uint64_t>, Scalar<Ratio, double>,
+                            FixedString<Label, 8>>;
+
+using VariableMessage = Schema<Scalar<Kind, uint8_t>, Text<Label>, Bytes<Payload, uint32_t>,
+                               Scalar<Trailer, int16_t>>;
+
+std::span<const std::byte> bytesOf(const std::string &s) { return std::as_bytes(std::span(s)); }
+
+} // namespace
+
+TEST(WireSchemaTest, FixedLayoutIsCompileTime)
+{
+    static_assert(FixedMessage::kFixedSize);
+    static_assert(FixedMessage::kMinSize == 1 + 8 + 8 + 8);
+    static_assert(FixedMessage::IndexOf<Ratio> == 2);
+    static_assert(!VariableMessage::kFixedSize);
+    static_assert(VariableMessage::kMinSize == 1 + 2 + 4 + 2);
+}
+
+TEST(WireSchemaTest, ScalarsAreBigEndian)
+{
+    std::array<std::byte, FixedMessage::kMinSize> buffer{};
+    ASSERT_EQ(FixedMessage::Encode(buffer, 7, 0x0102030405060708ULL, 1.5, "abc"),
+              FixedMessage::kMinSize);
+
+    EXPECT_EQ(buffer[0], std::byte{7});
+    EXPECT_EQ(buffer[1], std::byte{0x01});
+    EXPECT_EQ(buffer[8], std::byte{0x08});
+    // 1.5 is 0x3FF8000000000000.
+    EXPECT_EQ(buffer[9], std::byte{0x3f});
+    EXPECT_EQ(buffer[10], std::byte{0xf8});
+    EXPECT_EQ(buffer[17], std::byte{'a'});
+    EXPECT_EQ(buffer[20], std::byte{0});
+
+    auto view = FixedMessage::Parse(buffer);
+    ASSERT_TRUE(view);
+    EXPECT_EQ(view->Get<Kind>(), 7);
+    EXPECT_EQ(view->Get<Id>(), 0x0102030405060708ULL);
+    EXPECT_EQ(view->Get<Ratio>(), 1.5);
+    EXPECT_EQ(view->Get<Label>(), "abc");
+}
+
+TEST(WireSchemaTest, VariableFieldsRoundTrip)
+{
+    const std::string payload("binary\0payload", 14);
+    std::vector<std::byte> buffer;
+    ASSERT_EQ(VariableMessage::Append(buffer, 3, "hello", bytesOf(payload), -42),
+              1U + 2 + 5 + 4 + payload.size() + 2);
+
+    // Trailing bytes belong to the next message and are not part of the view.
+    buffer.push_back(std::byte{0xee});
+    auto view = VariableMessage::Parse(buffer);
+    ASSERT_TRUE(view);
+    EXPECT_EQ(view->Size(), buffer.size() - 1);
+    EXPECT_EQ(view->Get<Kind>(), 3);
+    EXPECT_EQ(view->Get<Label>(), "hello");
+    EXPECT_TRUE(std::ranges::equal(view->Get<Payload>(), bytesOf(payload)));
+    EXPECT_EQ(view->Get<Trailer>(), -42);
+
+    // The view points into the receive buffer, nothing was copied.
+    EXPECT_EQ(view->Get<Label>().data(), reinterpret_cast<const char *>(buffer.data() + 3));
+}
+
+TEST(WireSchemaTest, EncodeRejectsOversizeAndShortBuffers)
+{
+    std::array<std::byte, FixedMessage::kMinSize> buffer{};
+    EXPECT_EQ(FixedMessage::Encode(buffer, 1, 2, 3.0, "too long label").error(),
+              std::errc::value_too_large);
+    EXPECT_EQ(FixedMessage::Encode(std::span(buffer).first(10), 1, 2, 3.0, "ok").error(),
+              std::errc::no_buffer_space);
+
+    std::vector<std::byte> out;
+    const std::string label(70000, 'x');
+    EXPECT_EQ(VariableMessage::Append(out, 1, label, {}, 0).error(), std::errc::value_too_large);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(WireSchemaTest, ParseRejectsTruncatedMessages)
+{
+    std::vector<std::byte> buffer;
+    ASSERT_TRUE(VariableMessage::Append(buffer, 1, "label", bytesOf("data"), 5));
+
+    for (std::size_t size = 0; size < buffer.size(); ++size) {
+        EXPECT_EQ(VariableMessage::Parse(std::span(buffer).first(size)).error(),
+                  std::errc::bad_message)
+            << "size " << size;
+    }
+    EXPECT_TRUE(VariableMessage::Parse(buffer));
+}
+
+// Random input must either be rejected or yield a view whose fields all lie inside the input and
+// re-encode to exactly the bytes that were parsed.
+TEST(WireSchemaTest, FuzzParseRandomInput)
+{
+    std::mt19937 rng(0x5eed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<std::size_t> length(0, 64);
+
+    std::size_t accepted = 0;
+    for (int round = 0; round < 20000; ++round) {
+        std::vector<std::byte> input(length(rng));
+        for (auto &b : input)
+            b = static_cast<std::byte>(byte(rng));
+        // Keep length prefixes small now and then so some inputs are well-formed.
+        if (input.size() > 7 && round % 2 == 0) {
+            input[1] = input[3] = input[4] = input[5] = std::byte{0};
+            input[2] = static_cast<std::byte>(byte(rng) % 8);
+        }
+
+        auto view = VariableMessage::Parse(input);
+        if (!view)
+            continue;
+        ++accepted;
+
+        // Offsets, not pointers: gtest's pointer comparisons trip -Wstrict-overflow when optimized.
+        const auto *begin = input.data();
+        const auto size = static_cast<std::ptrdiff_t>(view->Size());
+        const auto label = view->Get<Label>();
+        const auto payload = view->Get<Payload>();
+        const std::ptrdiff_t labelAt = reinterpret_cast<const std::byte *>(label.data()) - begin;
+        const std::ptrdiff_t payloadAt = payload.data() - begin;
+        ASSERT_GE(labelAt, 0);
+        ASSERT_LE(labelAt + static_cast<std::ptrdiff_t>(label.size()), size);
+        ASSERT_GE(payloadAt, 0);
+        ASSERT_LE(payloadAt + static_cast<std::ptrdiff_t>(payload.size()), size);
+
+        std::vector<std::byte> reencoded;
+        ASSERT_TRUE(VariableMessage::Append(reencoded, view->Get<Kind>(), label, payload,
+                                            view->Get<Trailer>()));
+        ASSERT_TRUE(std::ranges::equal(reencoded, view->Raw()));
+    }
+    EXPECT_GT(accepted, 0U);
+}
+
+TEST(WireSchemaTest, FuzzRoundTripRandomValues)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::size_t> length(0, 300);
+
+    for (int round = 0; round < 5000; ++round) {
+        const auto kind = static_cast<uint8_t>(rng());
+        const auto trailer = static_cast<int16_t>(rng());
+        std::string label(length(rng), '\0');
+        for (auto &c : label)
+            c = static_cast<char>(rng());
+        std::vector<std::byte> payload(length(rng));
+        for (auto &b : payload)
+            b = static_cast<std::byte>(rng());
+
+        std::vector<std::byte> buffer;
+        ASSERT_TRUE(VariableMessage::Append(buffer, kind, label, payload, trailer));
+        auto view = VariableMessage::Parse(buffer);
+        ASSERT_TRUE(view);
+        EXPECT_EQ(view->Size(), buffer.size());
+        EXPECT_EQ(view->Get<Kind>(), kind);
+        EXPECT_EQ(view->Get<Label>(), label);
+        EXPECT_TRUE(std::ranges::equal(view->Get<Payload>(), payload));
+        EXPECT_EQ(view->Get<Trailer>(), trailer);
+    }
+}
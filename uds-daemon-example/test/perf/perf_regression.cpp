@@ -0,0 +1,430 @@
+//! Performance regression suite: starts the built uds-daemon, drives a fixed set of loopback
+//! scenarios against it with the udsctl load generator and compares throughput and latency with
+//! a checked-in baseline. Run by ctest (label perf_regression); --update rewrites the baseline
+//! from the current build.
+
+#include <load_generator.h>
+
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cxxopts.hpp>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <spawn.h>
+#include <spdlog/spdlog.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <uds_client.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// What ctest reports as skipped (SKIP_RETURN_CODE): numbers of an unoptimized build say nothing.
+constexpr int kSkipped = 77;
+constexpr auto kWarmup = std::chrono::seconds(1);
+constexpr auto kDuration = std::chrono::seconds(2);
+constexpr auto kStartTimeout = std::chrono::seconds(5);
+
+struct Scenario {
+    const char *name;
+    std::size_t connections;
+    //! Total requests per second; 0 for closed loop.
+    double rate;
+    std::size_t payloadSize;
+};
+
+// Fixed on purpose: a baseline is only comparable to the scenarios it was taken with.
+constexpr Scenario kScenarios[] = {
+    {.name = "closed_1conn", .connections = 1, .rate = 0, .payloadSize = 4},
+    {.name = "closed_8conn", .connections = 8, .rate = 0, .payloadSize = 4},
+    {.name = "closed_1conn_512b", .connections = 1, .rate = 0, .payloadSize = 512},
+    {.name = "open_4conn_4k", .connections = 4, .rate = 4000, .payloadSize = 64},
+};
+
+struct Metric {
+    const char *name;
+    bool higherIsBetter;
+};
+
+constexpr Metric kMetrics[] = {
+    {.name = "throughput_rps", .higherIsBetter = true},
+    {.name = "latency_p50_us", .higherIsBetter = false},
+    {.name = "latency_p99_us", .higherIsBetter = false},
+};
+
+struct Tolerance {
+    //! Throughput may drop by this fraction of the baseline.
+    double throughput{0.4};
+    //! Latency may grow by this fraction of the baseline plus latencySlackUs.
+    double latency{1.0};
+    double latencySlackUs{25};
+};
+
+using Results = std::map<std::string, std::map<std::string, double>>;
+
+//*****************************************************************************
+// Reads the baseline file: nested objects of numbers (and strings, which are
+// skipped), flattened to "scenarios.<name>.<metric>" keys. Not a general JSON
+// parser: no arrays, no escapes beyond \" and \\.
+class BaselineReader {
+  public:
+    explicit BaselineReader(std::string text)
+     : text_(std::move(text))
+    {
+    }
+
+    std::map<std::string, double> Read()
+    {
+        std::map<std::string, double> values;
+        Object("", values);
+        Space();
+        if (pos_ != text_.size())
+            Fail("trailing characters");
+        return values;
+    }
+
+  private:
+    void Object(const std::string &prefix, std::map<std::string, double> &values)
+    {
+        Expect('{');
+        Space();
+        if (Peek() == '}') {
+            ++pos_;
+            return;
+        }
+        for (;;) {
+            const std::string key = prefix + String();
+            Expect(':');
+            Space();
+            if (Peek() == '{')
+                Object(key + ".", values);
+            else if (Peek() == '"')
+                String();
+            else
+                values[key] = Number();
+            Space();
+            if (Peek() == '}') {
+                ++pos_;
+                return;
+            }
+            Expect(',');
+        }
+    }
+
+    std::string String()
+    {
+        Expect('"');
+        std::string out;
+        while (Peek() != '"') {
+            if (Peek() == '\\')
+                ++pos_;
+            out += Peek();
+            ++pos_;
+        }
+        ++pos_;
+        Space();
+        return out;
+    }
+
+    double Number()
+    {
+        double value = 0;
+        const auto [end, ec] = std::from_chars(text_.data() + pos_, text_.data() + text_.size(),
+                                               value);
+        if (ec != std::errc{})
+            Fail("number expected");
+        pos_ = static_cast<std::size_t>(end - text_.data());
+        return value;
+    }
+
+    void Expect(char c)
+    {
+        Space();
+        if (Peek() != c)
+            Fail(std::format("'{}' expected", c));
+        ++pos_;
+    }
+
+    char Peek()
+    {
+        if (pos_ >= text_.size())
+            Fail("unexpected end");
+        return text_[pos_];
+    }
+
+    void Space()
+    {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+            ++pos_;
+    }
+
+    [[noreturn]] void Fail(const std::string &what) const
+    {
+        throw std::runtime_error(std::format("baseline: {} at offset {}", what, pos_));
+    }
+
+    std::string text_;
+    std::size_t pos_{0};
+};
+
+//*****************************************************************************
+// uds-daemon in interactive mode on a socket of its own, stopped with SIGTERM.
+class Daemon {
+  public:
+    explicit Daemon(const fs::path &binary)
+    {
+        char dirTemplate[] = "/tmp/uds-perf-XXXXXX";
+        if (::mkdtemp(dirTemplate) == nullptr)
+            throw std::runtime_error(std::format("mkdtemp: {}", std::strerror(errno)));
+        dir_ = dirTemplate;
+        socket_ = dir_ / "perf.sock";
+        const auto config = dir_ / "uds-daemon.conf";
+        std::ofstream(config) << std::format("socket_path = {}\nlog_level = warn\n",
+                                             socket_.string());
+
+        std::vector<std::string> args{binary.string(), "-i", "-l", "warn", "-c", config.string()};
+        std::vector<char *> argv;
+        for (auto &arg : args)
+            argv.push_back(arg.data());
+        argv.push_back(nullptr);
+        // Clients hanging up at the end of a scenario are logged as warnings; keep them out of
+        // the report.
+        posix_spawn_file_actions_t actions;
+        ::posix_spawn_file_actions_init(&actions);
+        const auto log = (dir_ / "uds-daemon.log").string();
+        ::posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(),
+                                           O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ::posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+        const int err = ::posix_spawn(&pid_, argv[0], &actions, nullptr, argv.data(), environ);
+        ::posix_spawn_file_actions_destroy(&actions);
+        if (err != 0) {
+            Shutdown();
+            throw std::runtime_error(std::format("starting {}: {}", argv[0], std::strerror(err)));
+        }
+
+        try {
+            WaitUntilServing();
+        } catch (...) {
+            Shutdown();
+            throw;
+        }
+    }
+
+    ~Daemon() { Shutdown(); }
+
+    Daemon(const Daemon &) = delete;
+    Daemon &operator=(const Daemon &) = delete;
+
+    [[nodiscard]] const fs::path &Socket() const noexcept { return socket_; }
+
+  private:
+    void Shutdown() noexcept
+    {
+        if (pid_ > 0) {
+            ::kill(pid_, SIGTERM);
+            int status = 0;
+            ::waitpid(pid_, &status, 0);
+            pid_ = 0;
+        }
+        std::error_code ec;
+        fs::remove_all(dir_, ec);
+    }
+
+    void WaitUntilServing()
+    {
+        const auto deadline = std::chrono::steady_clock::now() + kStartTimeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            net::UdsClient probe;
+            if (fs::exists(socket_) && probe.connect(socket_) == std::errc{})
+                return;
+            int status = 0;
+            if (::waitpid(pid_, &status, WNOHANG) == pid_) {
+                pid_ = 0;
+                throw std::runtime_error("uds-daemon exited during startup:\n" + Log());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        throw std::runtime_error("uds-daemon did not start serving in time:\n" + Log());
+    }
+
+    std::string Log() const
+    {
+        std::ifstream in(dir_ / "uds-daemon.log");
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    fs::path dir_;
+    fs::path socket_;
+    pid_t pid_{0};
+};
+
+std::map<std::string, double> measure(const Daemon &daemon, const Scenario &scenario)
+{
+    udsctl::LoadOptions options;
+    options.socket_path = daemon.Socket();
+    options.connections = scenario.connections;
+    options.rate = scenario.rate;
+    options.warmup = kWarmup;
+    options.duration = kDuration;
+    options.payload = std::string(scenario.payloadSize, 'x');
+
+    const auto report = udsctl::RunLoad(options);
+    if (report.errors > 0 || report.requests == 0)
+        throw std::runtime_error(std::format("{}: {} requests, {} errors", scenario.name,
+                                             report.requests, report.errors));
+    const auto micros = [&report](double percentile) {
+        return static_cast<double>(report.latency.ValueAtPercentile(percentile)) / 1000.0;
+    };
+    return {{"throughput_rps", static_cast<double>(report.requests) / report.seconds},
+            {"latency_p50_us", micros(50)},
+            {"latency_p99_us", micros(99)}};
+}
+
+// Prints one line per metric; returns the number of regressions.
+int compare(const Results &measured, const std::map<std::string, double> &baseline,
+            const Tolerance &tolerance)
+{
+    int regressions = 0;
+    std::cout << std::format("{:<20} {:<16} {:>12} {:>12} {:>14}  {}\n", "scenario", "metric",
+                             "baseline", "measured", "limit", "result");
+    for (const auto &[scenario, metrics] : measured) {
+        for (const auto &metric : kMetrics) {
+            const double value = metrics.at(metric.name);
+            const auto it = baseline.find(std::format("scenarios.{}.{}", scenario, metric.name));
+            if (it == baseline.end()) {
+                std::cout << std::format("{:<20} {:<16} {:>12} {:>12.1f} {:>14}  NO BASELINE\n",
+                                         scenario, metric.name, "-", value, "-");
+                ++regressions;
+                continue;
+            }
+            const double base = it->second;
+            const double limit = metric.higherIsBetter
+                                     ? base * (1.0 - tolerance.throughput)
+                                     : base * (1.0 + tolerance.latency) + tolerance.latencySlackUs;
+            const bool ok = metric.higherIsBetter ? value >= limit : value <= limit;
+            regressions += ok ? 0 : 1;
+            std::cout << std::format("{:<20} {:<16} {:>12.1f} {:>12.1f} {:>2} {:>11.1f}  {} "
+                                     "({:+.0f}%)\n",
+                                     scenario, metric.name, base, value,
+                                     metric.higherIsBetter ? ">=" : "<=", limit,
+                                     ok ? "ok" : "REGRESSION", (value / base - 1.0) * 100.0);
+        }
+    }
+    return regressions;
+}
+
+void writeBaseline(const fs::path &path, const Results &measured, const Tolerance &tolerance)
+{
+    std::ofstream out(path);
+    out << "{\n";
+    out << "  \"comment\": \"Written by perf_regression --update from an optimized build; "
+           "limits are relative to these numbers\",\n";
+    out << "  \"tolerance\": {\n";
+    out << std::format("    \"throughput\": {},\n", tolerance.throughput);
+    out << std::format("    \"latency\": {},\n", tolerance.latency);
+    out << std::format("    \"latency_slack_us\": {}\n", tolerance.latencySlackUs);
+    out << "  },\n";
+    out << "  \"scenarios\": {\n";
+    std::size_t n = 0;
+    for (const auto &[scenario, metrics] : measured) {
+        out << std::format("    \"{}\": {{\n", scenario);
+        std::size_t m = 0;
+        for (const auto &metric : kMetrics)
+            out << std::format("      \"{}\": {:.1f}{}\n", metric.name, metrics.at(metric.name),
+                               ++m < std::size(kMetrics) ? "," : "");
+        out << std::format("    }}{}\n", ++n < measured.size() ? "," : "");
+    }
+    out << "  }\n";
+    out << "}\n";
+    if (!out)
+        throw std::runtime_error(std::format("writing {} failed", path.string()));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    cxxopts::Options options("perf_regression",
+                             "Loopback throughput and latency of uds-daemon against a baseline");
+    options.add_options()("daemon", "uds-daemon binary to test", cxxopts::value<std::string>())(
+        "baseline", "Baseline JSON file", cxxopts::value<std::string>())(
+        "build-type", "Build configuration; numbers of unoptimized builds are not compared",
+        cxxopts::value<std::string>()->default_value("Release"))(
+        "update", "Rewrite the baseline from this run instead of comparing")("h,help", "Help");
+
+    try {
+        const auto args = options.parse(argc, argv);
+        if (args.count("help") || !args.count("daemon") || !args.count("baseline")) {
+            std::cout << options.help() << std::endl;
+            return args.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        const auto buildType = args["build-type"].as<std::string>();
+        if (buildType != "Release" && buildType != "RelWithDebInfo" &&
+            buildType != "MinSizeRel") {
+            std::cout << std::format("Skipped: {} build, the baseline is for optimized builds\n",
+                                     buildType.empty() ? "unspecified" : buildType);
+            return kSkipped;
+        }
+
+        spdlog::set_level(spdlog::level::warn);
+        const fs::path baselinePath = args["baseline"].as<std::string>();
+        std::map<std::string, double> baseline;
+        if (fs::exists(baselinePath)) {
+            std::ifstream in(baselinePath);
+            std::stringstream text;
+            text << in.rdbuf();
+            baseline = BaselineReader(text.str()).Read();
+        }
+        Tolerance tolerance;
+        const auto setting = [&baseline](const char *key, double &value) {
+            if (const auto it = baseline.find(std::format("tolerance.{}", key));
+                it != baseline.end())
+                value = it->second;
+        };
+        setting("throughput", tolerance.throughput);
+        setting("latency", tolerance.latency);
+        setting("latency_slack_us", tolerance.latencySlackUs);
+
+        Daemon daemon(args["daemon"].as<std::string>());
+        Results measured;
+        for (const auto &scenario : kScenarios)
+            measured[scenario.name] = measure(daemon, scenario);
+
+        if (args.count("update")) {
+            writeBaseline(baselinePath, measured, tolerance);
+            std::cout << std::format("Baseline written to {}\n", baselinePath.string());
+            return EXIT_SUCCESS;
+        }
+
+        const int regressions = compare(measured, baseline, tolerance);
+        if (regressions > 0) {
+            std::cout << std::format("\n{} metric(s) outside the tolerance of {}. If the change "
+                                     "is intended, rerun with --update and commit the result.\n",
+                                     regressions, baselinePath.string());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception &e) {
+        std::cerr << "perf_regression: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
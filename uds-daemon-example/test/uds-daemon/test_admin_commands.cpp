@@ -0,0 +1,76 @@
+#include <admin_commands.h>
+#include <filesystem>
+#include <format>
+#include <fs_utils.h>
+#include <gtest/gtest.h>
+#include <request_trace.h>
+#include <string>
+
+namespace fs = std::filesystem;
+using namespace uds_daemon;
+
+TEST(AdminCommandsTest, TraceParsesItsArguments)
+{
+    EXPECT_EQ(TraceCommand("on"), "tracing 1 in 1 requests");
+    EXPECT_EQ(TraceCommand("on 100"), "tracing 1 in 100 requests");
+    EXPECT_EQ(TraceCommand(""), "tracing 1 in 100 requests");
+
+    EXPECT_EQ(TraceCommand("on 0"), "error: '0' is not a sample rate, expected N > 0");
+    EXPECT_EQ(TraceCommand("on -1"), "error: '-1' is not a sample rate, expected N > 0");
+    EXPECT_EQ(TraceCommand("on 10x"), "error: '10x' is not a sample rate, expected N > 0");
+    EXPECT_EQ(TraceCommand("dump"), "error: trace dump needs a file name");
+    EXPECT_EQ(TraceCommand("of"), "error: usage: trace [on [N] | off | clear | dump <file>]");
+    // A rejected command leaves tracing as it was.
+    EXPECT_EQ(utils::RequestTrace::SampleEvery(), 100u);
+
+    EXPECT_EQ(TraceCommand("clear"), "trace cleared");
+    EXPECT_EQ(TraceCommand("off"), "tracing off");
+    EXPECT_EQ(TraceCommand(""), "tracing off");
+}
+
+TEST(AdminCommandsTest, CaptureParsesItsArguments)
+{
+    const auto usage = std::string("error: usage: capture start <file> [N sessions] [max MiB]");
+    net::RequestCapture capture;
+    EXPECT_EQ(CaptureCommand(capture, "", nullptr), "capture off");
+    EXPECT_EQ(CaptureCommand(capture, "start", nullptr), usage);
+    EXPECT_EQ(CaptureCommand(capture, "start file 0", nullptr), usage);
+    EXPECT_EQ(CaptureCommand(capture, "start file x", nullptr), usage);
+    EXPECT_EQ(CaptureCommand(capture, "start file 2 0", nullptr), usage);
+    EXPECT_EQ(CaptureCommand(capture, "start file 2 1M", nullptr), usage);
+    EXPECT_EQ(CaptureCommand(capture, "begin file", nullptr),
+              "error: usage: capture [start <file> [N sessions] [max MiB] | stop]");
+    EXPECT_EQ(CaptureCommand(capture, "stop", nullptr), "capture off");
+    EXPECT_FALSE(capture.Status().has_value());
+
+    const auto path =
+        fs::temp_directory_path() / ("sockact-admin-capture-" + fs_utils::random_suffix());
+    EXPECT_EQ(CaptureCommand(capture, std::format("start {} 3 2", path.string()), nullptr),
+              std::format("capturing 1 in 3 sessions to {}", path.string()));
+    const auto status = capture.Status();
+    ASSERT_TRUE(status.has_value());
+    EXPECT_EQ(status->path, path);
+    EXPECT_EQ(status->sessionEvery, 3u);
+    // The file header counts as written.
+    const auto described = std::format("{}: 1 in 3 sessions, 0 requests, {} bytes, 0 dropped",
+                                       path.string(), status->stats.bytes);
+    EXPECT_EQ(CaptureCommand(capture, "", nullptr), "capturing " + described);
+    EXPECT_EQ(CaptureCommand(capture, "stop", nullptr), "capture stopped: " + described);
+    fs::remove(path);
+}
+
+TEST(AdminCommandsTest, StatsAndCacheReportTheWorker)
+{
+    net::UdsServerWorker worker(net::UdsServer(
+        fs::temp_directory_path() / ("sockact-admin-worker-" + fs_utils::random_suffix())));
+
+    EXPECT_EQ(StatsCommand(worker, ""), "0 sessions (0 active), 0 requests");
+    EXPECT_EQ(StatsCommand(worker, "all"), "error: usage: stats");
+
+    const std::string empty = "0 entries, 0 bytes, 0 hits, 0 misses, 0 insertions, "
+                              "0 evictions, 0 expired, 0 invalidated";
+    EXPECT_EQ(CacheCommand(worker, ""), empty);
+    EXPECT_EQ(CacheCommand(worker, "stats"), empty);
+    EXPECT_EQ(CacheCommand(worker, "invalidate"), "dropped 0 cached responses");
+    EXPECT_EQ(CacheCommand(worker, "flush"), "error: usage: cache [stats | invalidate]");
+}
@@ -0,0 +1,98 @@
+#include <admin_server.h>
+#include <array>
+#include <filesystem>
+#include <fs_utils.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <uds_client.h>
+
+namespace fs = std::filesystem;
+using uds_daemon::AdminServer;
+
+namespace {
+
+//! "echo <args>" replies with its arguments, "fail" throws.
+class AdminServerTest : public ::testing::Test {
+  public:
+    AdminServerTest()
+     : path_(fs::temp_directory_path() /
+             ("sockact-admin-test-" + fs_utils::random_suffix() + ".sock"))
+    {
+    }
+
+  protected:
+    AdminServer::Commands Commands()
+    {
+        return AdminServer::Commands{
+            {"echo", [](std::string_view args) { return std::string(args); }},
+            {"fail",
+             [](std::string_view) -> std::string { throw std::runtime_error("out of luck"); }}};
+    }
+
+    //! What the admin socket replies to \p line.
+    std::string Send(const std::string &line) const
+    {
+        net::UdsClient client;
+        if (client.connect(path_) != std::errc{})
+            return "connect failed";
+        if (!client.send(std::span(line)))
+            return "send failed";
+        std::array<char, 256> reply{};
+        const auto got = client.receive(std::span(reply));
+        return got ? std::string(reply.data(), *got) : "receive failed";
+    }
+
+    fs::path path_;
+};
+
+} // namespace
+
+TEST_F(AdminServerTest, DispatchesByName)
+{
+    const AdminServer admin(path_, Commands());
+    EXPECT_EQ(admin.Execute("echo hello admin"), "hello admin");
+    // Blanks around the name and the arguments do not count.
+    EXPECT_EQ(admin.Execute("  echo \t spaced out \r\n"), "spaced out");
+    EXPECT_EQ(admin.Execute("echo"), "");
+
+    EXPECT_EQ(Send("echo over the socket\n"), "over the socket");
+}
+
+TEST_F(AdminServerTest, RejectsUnknownCommands)
+{
+    const AdminServer admin(path_, Commands());
+    EXPECT_EQ(admin.Execute("reboot now"), "error: unknown command 'reboot', try help");
+    // Names are matched whole.
+    EXPECT_EQ(admin.Execute("ech hello"), "error: unknown command 'ech', try help");
+    EXPECT_EQ(Send("reboot"), "error: unknown command 'reboot', try help");
+}
+
+TEST_F(AdminServerTest, HelpListsTheCommands)
+{
+    const AdminServer admin(path_, Commands());
+    EXPECT_EQ(admin.Execute("help"), "commands: help echo fail");
+    EXPECT_EQ(admin.Execute(""), "commands: help echo fail");
+    EXPECT_EQ(Send("help"), "commands: help echo fail");
+}
+
+TEST_F(AdminServerTest, TurnsExceptionsIntoErrorReplies)
+{
+    const AdminServer admin(path_, Commands());
+    EXPECT_EQ(admin.Execute("fail"), "error: out of luck");
+    // The admin thread lives on.
+    EXPECT_EQ(Send("fail"), "error: out of luck");
+    EXPECT_EQ(Send("echo still here"), "still here");
+}
+
+TEST_F(AdminServerTest, SocketIsOwnerOnly)
+{
+    // Whatever the umask of the process.
+    const mode_t previous = ::umask(0);
+    const AdminServer admin(path_, Commands());
+    ::umask(previous);
+
+    const auto perms = fs::status(path_).permissions();
+    EXPECT_EQ(perms, fs::perms::owner_read | fs::perms::owner_write);
+}
@@ -0,0 +1,75 @@
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fs_utils.h>
+#include <gtest/gtest.h>
+#include <pubsub.h>
+#include <server_worker.h>
+#include <sys/socket.h>
+#include <uds_client.h>
+
+namespace fs = std::filesystem;
+using namespace net;
+
+TEST(SessionFdNameTest, RoundTrips)
+{
+    const SessionState state{.id = 42, .replies = 7};
+    EXPECT_EQ(SessionFdName(state), "session-42-7");
+
+    const auto parsed = ParseSessionFdName(SessionFdName(state));
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->id, 42u);
+    EXPECT_EQ(parsed->replies, 7u);
+
+    const auto largest = ParseSessionFdName("session-18446744073709551615-0");
+    ASSERT_TRUE(largest.has_value());
+    EXPECT_EQ(largest->id, UINT64_MAX);
+    EXPECT_EQ(largest->replies, 0u);
+}
+
+TEST(SessionFdNameTest, RejectsMalformedNames)
+{
+    for (const std::string_view name :
+         {"", "uds-listener", "session-", "session-42", "session-42-", "session--1-2",
+          "session-x-1", "session-1-2x", "session-1-2-3", "session-18446744073709551616-0",
+          "Session-1-2"}) {
+        EXPECT_FALSE(ParseSessionFdName(name).has_value()) << name;
+    }
+}
+
+TEST(ServerWorkerTest, NewSessionsContinueAfterAdoptedIds)
+{
+    UdsServer server(fs::temp_directory_path() /
+                     ("sockact-worker-test-" + fs_utils::random_suffix() + ".sock"));
+    const auto path = server.SocketPath();
+    UdsServerWorker worker(std::move(server));
+
+    std::array<int, 2> fds{};
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+    worker.Adopt(SocketSession(fds[0]), SessionState{.id = 41, .replies = 3});
+    const SocketSession adopted(fds[1]);
+
+    // The adopted session watches the lifecycle events, then the worker starts accepting.
+    const std::string subscribe = std::format("subscribe {}", kSessionsTopic);
+    ASSERT_TRUE(adopted.send(std::span(subscribe)).has_value());
+    std::array<char, 64> reply{};
+    const auto got = adopted.receive(std::span(reply));
+    ASSERT_TRUE(got.has_value());
+    ASSERT_EQ(std::string_view(reply.data(), *got), "subscribed sessions");
+
+    worker.Start();
+    UdsClient client;
+    ASSERT_EQ(client.connect(path), std::errc{});
+
+    std::array<std::byte, 64> event{};
+    const auto received = adopted.receive(std::span(event));
+    ASSERT_TRUE(received.has_value());
+    const auto view = EventFrame::Parse(std::span(event).first(*received));
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(view->Get<event::Topic>(), kSessionsTopic);
+    const auto payload = view->Get<event::Payload>();
+    EXPECT_EQ(std::string_view(reinterpret_cast<const char *>(payload.data()), payload.size()),
+              "opened 42");
+    EXPECT_EQ(worker.Stats().sessions, 2u);
+}
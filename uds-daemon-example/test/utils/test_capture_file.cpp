@@ -0,0 +1,120 @@
+#include <capture_file.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <string_view>
+#include <unistd.h>
+
+using namespace utils;
+
+namespace {
+
+using Clock = CaptureWriter::Clock;
+
+class CaptureFileTest : public ::testing::Test {
+  protected:
+    void TearDown() override { std::filesystem::remove(path_); }
+
+    static std::span<const std::byte> Bytes(std::string_view text)
+    {
+        return std::as_bytes(std::span(text.data(), text.size()));
+    }
+
+    static std::string_view Text(std::span<const std::byte> bytes)
+    {
+        return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+    }
+
+    const std::filesystem::path path_{std::filesystem::temp_directory_path() /
+                                      ("test_capture_" + std::to_string(::getpid()) + ".cap")};
+};
+
+} // namespace
+
+TEST_F(CaptureFileTest, RoundTripsRequestsWithSessionsAndOffsets)
+{
+    const auto start = Clock::now();
+    {
+        CaptureWriter writer(path_, 1 << 20);
+        EXPECT_TRUE(writer.Record(1, start + std::chrono::microseconds(10), Bytes("hello")));
+        EXPECT_TRUE(writer.Record(2, start + std::chrono::microseconds(20), Bytes("")));
+        EXPECT_TRUE(writer.Record(1, start + std::chrono::microseconds(30), Bytes("12345678")));
+        writer.Close();
+        EXPECT_FALSE(writer.Record(1, start, Bytes("late")));
+
+        const auto stats = writer.Stats();
+        EXPECT_EQ(stats.records, 3u);
+        EXPECT_EQ(stats.dropped, 0u);
+        EXPECT_EQ(stats.bytes, std::filesystem::file_size(path_));
+    }
+
+    CaptureReader reader(path_);
+    EXPECT_GT(reader.Header().startedAt, 0);
+    const auto records = reader.Records();
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].session, 1u);
+    EXPECT_EQ(Text(records[0].request), "hello");
+    EXPECT_EQ(records[1].session, 2u);
+    EXPECT_TRUE(records[1].request.empty());
+    EXPECT_EQ(Text(records[2].request), "12345678");
+    EXPECT_LT(records[0].offset, records[1].offset);
+    EXPECT_EQ(records[2].offset - records[0].offset, std::chrono::microseconds(20));
+}
+
+TEST_F(CaptureFileTest, RecordsRequestsReceivedBeforeTheStartAtOffsetZero)
+{
+    // A session takes the receive time, then a capture is started, then the request is recorded.
+    const auto receivedAt = Clock::now();
+    {
+        CaptureWriter writer(path_, 1 << 20);
+        EXPECT_TRUE(writer.Record(1, receivedAt - std::chrono::seconds(1), Bytes("early")));
+        EXPECT_TRUE(writer.Record(1, receivedAt, Bytes("racing")));
+    }
+
+    const CaptureReader reader(path_);
+    const auto records = reader.Records();
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].offset, std::chrono::nanoseconds(0));
+    EXPECT_EQ(records[1].offset, std::chrono::nanoseconds(0));
+}
+
+TEST_F(CaptureFileTest, DropsRequestsBeyondTheSizeLimit)
+{
+    const std::string request(100, 'x');
+    // The file header and two records of 24 + 104 bytes.
+    CaptureWriter writer(path_, sizeof(CaptureFileHeader) + 2 * 128);
+    int recorded = 0;
+    for (int i = 0; i < 5; ++i)
+        recorded += writer.Record(7, Clock::now(), Bytes(request)) ? 1 : 0;
+    writer.Close();
+
+    EXPECT_EQ(recorded, 2);
+    EXPECT_EQ(writer.Stats().dropped, 3u);
+    EXPECT_EQ(CaptureReader(path_).Records().size(), 2u);
+}
+
+TEST_F(CaptureFileTest, IgnoresATrailingPartialRecord)
+{
+    {
+        CaptureWriter writer(path_, 1 << 20);
+        writer.Record(1, Clock::now(), Bytes("complete"));
+        writer.Record(1, Clock::now(), Bytes("cut short by a crash"));
+    }
+    std::filesystem::resize_file(path_, std::filesystem::file_size(path_) - 10);
+
+    const CaptureReader reader(path_);
+    const auto records = reader.Records();
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(Text(records[0].request), "complete");
+}
+
+TEST_F(CaptureFileTest, RejectsFilesThatAreNotCaptures)
+{
+    const int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ASSERT_GE(fd, 0);
+    const std::string junk(64, 'j');
+    ASSERT_EQ(::write(fd, junk.data(), junk.size()), static_cast<ssize_t>(junk.size()));
+    ::close(fd);
+
+    EXPECT_THROW(CaptureReader{path_}, CaptureFileError);
+    EXPECT_THROW(CaptureReader{path_.string() + ".missing"}, CaptureFileError);
+}
@@ -0,0 +1,55 @@
+#include <config_file.h>
+#include <fs_utils.h>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace utils;
+namespace fs = std::filesystem;
+
+TEST(ConfigFileTest, ParsesKeyValuesCommentsAndBlanks)
+{
+    const auto config = ConfigFile::Parse("# comment\n"
+                                          "\n"
+                                          "log_level = debug\n"
+                                          "  backlog=64   # trailing comment\n"
+                                          "; other comment\n"
+                                          "io_cpus =\n");
+
+    EXPECT_EQ(config.Get("log_level"), "debug");
+    EXPECT_EQ(config.Get("backlog"), "64");
+    EXPECT_EQ(config.Get("io_cpus"), "");
+    EXPECT_FALSE(config.Get("missing").has_value());
+    EXPECT_EQ(config.Entries().size(), 3U);
+}
+
+TEST(ConfigFileTest, RejectsMalformedLines)
+{
+    EXPECT_THROW(ConfigFile::Parse("no equals sign"), ConfigFileError);
+    EXPECT_THROW(ConfigFile::Parse("= value"), ConfigFileError);
+    EXPECT_THROW(ConfigFile::Parse("a = 1\na = 2"), ConfigFileError);
+}
+
+TEST(ConfigFileTest, ErrorNamesSourceAndLine)
+{
+    try {
+        ConfigFile::Parse("a = 1\n\nbroken", "test.conf");
+        FAIL() << "expected ConfigFileError";
+    } catch (const ConfigFileError &e) {
+        EXPECT_NE(std::string(e.what()).find("test.conf:3"), std::string::npos) << e.what();
+    }
+}
+
+TEST(ConfigFileTest, LoadFromFile)
+{
+    const auto path =
+        fs::temp_directory_path() / ("uds-config-test-" + fs_utils::random_suffix() + ".conf");
+    {
+        std::ofstream out(path);
+        out << "idle_timeout = 30\n";
+    }
+    const auto config = ConfigFile::Load(path);
+    fs::remove(path);
+
+    EXPECT_EQ(config.Get("idle_timeout"), "30");
+    EXPECT_THROW(ConfigFile::Load(path), ConfigFileError);
+}
@@ -0,0 +1,61 @@
+#include <cpu_affinity.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace utils;
+
+TEST(CpuSetTest, ParseSinglesAndRanges)
+{
+    const auto set = CpuSet::Parse("0-2, 5,7-8");
+    EXPECT_EQ(set.Count(), 6U);
+    EXPECT_TRUE(set.Contains(0));
+    EXPECT_TRUE(set.Contains(2));
+    EXPECT_FALSE(set.Contains(3));
+    EXPECT_TRUE(set.Contains(5));
+    EXPECT_TRUE(set.Contains(8));
+    EXPECT_EQ(set.ToString(), "0-2,5,7-8");
+}
+
+TEST(CpuSetTest, EmptyListIsEmptySet)
+{
+    EXPECT_TRUE(CpuSet::Parse("").Empty());
+    EXPECT_TRUE(CpuSet::Parse("  ").Empty());
+    EXPECT_EQ(CpuSet().ToString(), "");
+}
+
+TEST(CpuSetTest, RejectsMalformedLists)
+{
+    EXPECT_THROW(CpuSet::Parse("a"), CpuAffinityError);
+    EXPECT_THROW(CpuSet::Parse("1,"), CpuAffinityError);
+    EXPECT_THROW(CpuSet::Parse("3-1"), CpuAffinityError);
+    EXPECT_THROW(CpuSet::Parse("1-"), CpuAffinityError);
+    EXPECT_THROW(CpuSet::Parse("100000"), CpuAffinityError);
+}
+
+TEST(CpuSetTest, FormatRoundTrip)
+{
+    const auto set = CpuSet::Parse("3,1,2,10");
+    EXPECT_EQ(set.ToString(), "1-3,10");
+    EXPECT_EQ(CpuSet::Parse(set.ToString()), set);
+}
+
+TEST(CpuSetTest, SubsetOf)
+{
+    const auto all = CpuSet::Parse("0-7");
+    EXPECT_TRUE(CpuSet::Parse("1,3").IsSubsetOf(all));
+    EXPECT_FALSE(CpuSet::Parse("7-8").IsSubsetOf(all));
+    EXPECT_TRUE(CpuSet().IsSubsetOf(all));
+}
+
+TEST(CpuAffinityTest, PinCurrentThreadToFirstAllowedCpu)
+{
+    const auto allowed = CpuSet::OfCurrentThread();
+    ASSERT_FALSE(allowed.Empty());
+
+    std::thread([&allowed]() {
+        CpuSet one;
+        one.Add(allowed.Cpus().front());
+        PinCurrentThread(one);
+        EXPECT_EQ(CpuSet::OfCurrentThread(), one);
+    }).join();
+}
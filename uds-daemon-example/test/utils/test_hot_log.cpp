@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <hot_log.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <sstream>
+#include <thread>
+
+using namespace utils;
+
+namespace {
+
+enum class Color { Red = 1, Green = 2 };
+
+class HotLogTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        previous_ = spdlog::default_logger();
+        auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(out_);
+        sink->set_pattern("%l %v");
+        auto logger = std::make_shared<spdlog::logger>("hot-log-test", sink);
+        logger->set_level(spdlog::level::trace);
+        spdlog::set_default_logger(logger);
+    }
+
+    void TearDown() override
+    {
+        HotLog::Stop();
+        spdlog::set_default_logger(previous_);
+    }
+
+    std::size_t Lines() const
+    {
+        const auto text = out_.str();
+        return static_cast<std::size_t>(std::ranges::count(text, '\n'));
+    }
+
+    std::ostringstream out_;
+    std::shared_ptr<spdlog::logger> previous_;
+};
+
+} // namespace
+
+TEST_F(HotLogTest, WritesDirectlyWithoutBackend)
+{
+    HOT_LOG(spdlog::level::info, "request {} from {} ({}) took {:.1f} ms", 42, "client",
+            Color::Green, 1.25);
+    EXPECT_EQ(out_.str(), "info request 42 from client (2) took 1.2 ms\n");
+}
+
+TEST_F(HotLogTest, BackendFormatsRecordsOfAllThreads)
+{
+    HotLog::Start();
+    ASSERT_TRUE(HotLog::Running());
+    const auto before = HotLog::Stats().written;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 10; ++i)
+                // Release builds compile out levels below info.
+                HOT_LOG(spdlog::level::warn, "thread {} message {}", t, i);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    HotLog::Stop();
+
+    EXPECT_EQ(Lines(), 40U);
+    EXPECT_NE(out_.str().find("warning thread 3 message 9"), std::string::npos);
+    EXPECT_EQ(HotLog::Stats().written - before, 40U);
+}
+
+TEST_F(HotLogTest, BelowLoggerLevelIsNotCaptured)
+{
+    spdlog::default_logger()->set_level(spdlog::level::warn);
+    HOT_LOG(spdlog::level::info, "hidden {}", 1);
+    HOT_LOG(spdlog::level::warn, "shown {}", 2);
+    EXPECT_EQ(out_.str(), "warning shown 2\n");
+}
+
+TEST_F(HotLogTest, RateLimitedReportsSuppressed)
+{
+    auto log = [](int i) {
+        HOT_LOG_RATE_LIMITED(spdlog::level::info, 20, 1, "message {}", i);
+    };
+    for (int i = 0; i < 5; ++i)
+        log(i);
+    EXPECT_EQ(Lines(), 1U);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    log(5);
+    EXPECT_EQ(Lines(), 2U);
+    EXPECT_NE(out_.str().find("message 5 (4 similar suppressed)"), std::string::npos);
+}
+
+TEST_F(HotLogTest, SampledWritesEveryNth)
+{
+    for (int i = 0; i < 10; ++i)
+        HOT_LOG_SAMPLED(spdlog::level::info, 3, "sample {}", i);
+    EXPECT_EQ(out_.str(), "info sample 0\ninfo sample 3\ninfo sample 6\ninfo sample 9\n");
+}
+
+TEST_F(HotLogTest, LongStringsAreCut)
+{
+    const std::string payload(1000, 'x');
+    HOT_LOG(spdlog::level::info, "{} {}", payload, 7);
+    const auto text = out_.str();
+    EXPECT_LT(text.size(), HotLogRecord::kSize);
+    EXPECT_TRUE(text.ends_with("x 7\n"));
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <intrusive_list.h>
+#include <intrusive_queue.h>
+#include <memory>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+struct LruTag;
+
+struct Item : IntrusiveListHook<>, IntrusiveListHook<LruTag> {
+    explicit Item(int v)
+     : value(v)
+    {
+    }
+    int value;
+};
+
+template <typename Container>
+std::vector<int> valuesOf(const Container &c)
+{
+    std::vector<int> out;
+    for (const auto &item : c)
+        out.push_back(item.value);
+    return out;
+}
+
+} // namespace
+
+TEST(IntrusiveListTest, PushEraseAndIterate)
+{
+    std::vector<Item> items{Item(1), Item(2), Item(3), Item(4)};
+    Item zero(0);
+    IntrusiveList<Item> list;
+    for (auto &item : items)
+        list.push_back(item);
+    list.push_front(zero);
+
+    EXPECT_EQ(valuesOf(list), (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(list.size(), 5U);
+    EXPECT_EQ(list.front().value, 0);
+    EXPECT_EQ(list.back().value, 4);
+
+    list.pop_front();
+    list.pop_back();
+    EXPECT_EQ(valuesOf(list), (std::vector<int>{1, 2, 3}));
+    EXPECT_FALSE(zero.IntrusiveListHook<>::IsLinked());
+    EXPECT_FALSE(items[3].IntrusiveListHook<>::IsLinked());
+    list.clear();
+}
+
+TEST(IntrusiveListTest, ElementToIteratorIsDirect)
+{
+    Item a(1), b(2), c(3);
+    IntrusiveList<Item> list;
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+
+    auto it = list.data_to_iterator(&b);
+    EXPECT_EQ(it->value, 2);
+    EXPECT_EQ((++it)->value, 3);
+    EXPECT_EQ(list.cdata_to_iterator(nullptr), list.cend());
+
+    list.remove(b);
+    EXPECT_FALSE(b.IntrusiveListHook<>::IsLinked());
+    EXPECT_EQ(valuesOf(list), (std::vector<int>{1, 3}));
+
+    // Erase returns the follower, insert links in front of a position.
+    auto next = list.erase(list.data_to_iterator(&a));
+    EXPECT_EQ(next->value, 3);
+    list.insert(next, b);
+    EXPECT_EQ(valuesOf(list), (std::vector<int>{2, 3}));
+    list.clear();
+}
+
+TEST(IntrusiveListTest, DisposeDeletesOwnedElements)
+{
+    auto tracked = std::make_shared<int>(0);
+    struct Owned : IntrusiveListHook<> {
+        std::shared_ptr<int> ref;
+    };
+
+    IntrusiveList<Owned> list;
+    for (int i = 0; i < 3; ++i) {
+        auto *owned = new Owned();
+        owned->ref = tracked;
+        list.push_back(*owned);
+    }
+    EXPECT_EQ(tracked.use_count(), 4);
+
+    list.erase_and_dispose(list.begin(), std::default_delete<Owned>());
+    EXPECT_EQ(tracked.use_count(), 3);
+    list.clear_and_dispose(std::default_delete<Owned>());
+    EXPECT_EQ(tracked.use_count(), 1);
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(IntrusiveListTest, SpliceAndMove)
+{
+    Item a(1), b(2), c(3);
+    IntrusiveList<Item> first;
+    IntrusiveList<Item> second;
+    first.push_back(a);
+    second.push_back(b);
+    second.push_back(c);
+
+    first.splice(first.end(), second);
+    EXPECT_TRUE(second.empty());
+    EXPECT_EQ(valuesOf(first), (std::vector<int>{1, 2, 3}));
+
+    IntrusiveList<Item> moved(std::move(first));
+    EXPECT_TRUE(first.empty());
+    EXPECT_EQ(valuesOf(moved), (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(&moved.back(), &c);
+    moved.clear();
+}
+
+TEST(IntrusiveListTest, ElementOnTwoListsViaTags)
+{
+    Item a(1), b(2);
+    IntrusiveList<Item> table;
+    IntrusiveQueue<Item, LruTag> lru;
+    table.push_back(a);
+    table.push_back(b);
+    lru.push_back(a);
+    lru.push_back(b);
+
+    lru.remove(a);
+    EXPECT_EQ(valuesOf(table), (std::vector<int>{1, 2}));
+    EXPECT_EQ(valuesOf(lru), (std::vector<int>{2}));
+    EXPECT_TRUE(a.IntrusiveListHook<>::IsLinked());
+    EXPECT_FALSE(a.IntrusiveListHook<LruTag>::IsLinked());
+    table.clear();
+    lru.clear();
+}
+
+TEST(IntrusiveQueueTest, FifoWithMoveToBack)
+{
+    Item a(1), b(2), c(3);
+    IntrusiveQueue<Item> queue;
+    queue.push_back(a);
+    queue.push_back(b);
+    queue.push_back(c);
+
+    queue.move_to_back(a);
+    EXPECT_EQ(valuesOf(queue), (std::vector<int>{2, 3, 1}));
+
+    EXPECT_EQ(queue.pop_front(), &b);
+    queue.remove(c);
+    EXPECT_EQ(queue.pop_front(), &a);
+    EXPECT_EQ(queue.pop_front(), nullptr);
+}
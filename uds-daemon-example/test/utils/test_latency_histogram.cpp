@@ -0,0 +1,70 @@
+#include <chrono>
+#include <gtest/gtest.h>
+#include <latency_histogram.h>
+
+using namespace utils;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogramTest, EmptyHistogram)
+{
+    LatencyHistogram h;
+    EXPECT_EQ(h.Count(), 0u);
+    EXPECT_EQ(h.Min(), 0u);
+    EXPECT_EQ(h.Max(), 0u);
+    EXPECT_EQ(h.ValueAtPercentile(99.0), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact)
+{
+    LatencyHistogram h;
+    for (int i = 1; i <= 100; ++i)
+        h.Record(std::chrono::nanoseconds(i));
+
+    EXPECT_EQ(h.Count(), 100u);
+    EXPECT_EQ(h.Min(), 1u);
+    EXPECT_EQ(h.Max(), 100u);
+    EXPECT_EQ(h.ValueAtPercentile(50.0), 50u);
+    EXPECT_EQ(h.ValueAtPercentile(99.0), 99u);
+    EXPECT_EQ(h.ValueAtPercentile(100.0), 100u);
+    EXPECT_DOUBLE_EQ(h.Mean(), 50.5);
+}
+
+TEST(LatencyHistogramTest, RelativeErrorIsBounded)
+{
+    for (uint64_t v : {1'000ULL, 12'345ULL, 987'654ULL, 1'000'000'007ULL, 3'600'000'000'000ULL}) {
+        LatencyHistogram h;
+        h.RecordValue(v, 1);
+        h.RecordValue(v * 2, 1); // keep max above the reported bucket bound
+        const auto reported = h.ValueAtPercentile(50.0);
+        EXPECT_GE(reported, v);
+        EXPECT_LE(static_cast<double>(reported - v), static_cast<double>(v) / 128.0) << v;
+    }
+}
+
+TEST(LatencyHistogramTest, TailPercentiles)
+{
+    LatencyHistogram h;
+    h.RecordValue(100'000, 999); // 100us
+    h.Record(50ms);
+
+    EXPECT_LE(h.ValueAtPercentile(99.0), 101'000u);
+    EXPECT_GE(h.ValueAtPercentile(99.95), 49'000'000u);
+    EXPECT_EQ(h.Max(), 50'000'000u);
+}
+
+TEST(LatencyHistogramTest, MergeCombinesCounts)
+{
+    LatencyHistogram a;
+    LatencyHistogram b;
+    a.Record(10us);
+    b.Record(20us);
+    b.Record(30us);
+
+    a.Merge(b);
+    EXPECT_EQ(a.Count(), 3u);
+    EXPECT_EQ(a.Min(), 10'000u);
+    EXPECT_EQ(a.Max(), 30'000u);
+
+    a.Reset();
+    EXPECT_EQ(a.Count(), 0u);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <mpsc_queue.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+
+TEST(MpscQueueTest, FifoUntilFullThenEmpty)
+{
+    MpscQueue<int> queue(4);
+    EXPECT_EQ(queue.Capacity(), 4U);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(queue.TryPush(i));
+    EXPECT_FALSE(queue.TryPush(99));
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(queue.TryPop(), i);
+    EXPECT_FALSE(queue.TryPop().has_value());
+
+    // Cells are reusable after a full lap.
+    EXPECT_TRUE(queue.TryPush(5));
+    EXPECT_EQ(queue.TryPop(), 5);
+}
+
+TEST(MpscQueueTest, NonTrivialElements)
+{
+    MpscQueue<std::string> queue(2);
+    const std::string copied(100, 'x');
+    EXPECT_TRUE(queue.TryPush(copied));
+    EXPECT_TRUE(queue.TryEmplace(std::size_t{3}, 'y'));
+
+    std::vector<std::string> out;
+    EXPECT_EQ(queue.PopBatch(std::back_inserter(out), 10), 2U);
+    EXPECT_EQ(out[0], copied);
+    EXPECT_EQ(out[1], "yyy");
+}
+
+TEST(MpscQueueTest, DestroysRemainingElements)
+{
+    auto tracked = std::make_shared<int>(0);
+    {
+        MpscQueue<std::shared_ptr<int>> queue(4);
+        queue.TryPush(tracked);
+        EXPECT_EQ(tracked.use_count(), 2);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
+
+// Producers tag values with their id; per producer the consumer must see a gap-free sequence.
+TEST(MpscQueueTest, StressManyProducers)
+{
+    constexpr unsigned kProducers = 4;
+    constexpr uint64_t kPerProducer = 200'000;
+    MpscQueue<uint64_t> queue(128);
+
+    std::vector<std::thread> producers;
+    for (uint64_t p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (uint64_t i = 0; i < kPerProducer;) {
+                if (queue.TryPush((p << 32) | i))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<uint64_t> next(kProducers, 0);
+    uint64_t received = 0;
+    std::vector<uint64_t> batch;
+    while (received < kProducers * kPerProducer) {
+        batch.clear();
+        if (queue.PopBatch(std::back_inserter(batch), 64) == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (uint64_t v : batch) {
+            const auto producer = v >> 32;
+            ASSERT_LT(producer, kProducers);
+            ASSERT_EQ(v & 0xffffffffU, next[producer]);
+            ++next[producer];
+        }
+        received += batch.size();
+    }
+
+    for (auto &t : producers)
+        t.join();
+    EXPECT_FALSE(queue.TryPop().has_value());
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <pipe.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+// Anonymous file with \p content, stands in for a regular file.
+int memFile(std::string_view content)
+{
+    const int fd = ::memfd_create("pipe-test", MFD_CLOEXEC);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(::write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+    return fd;
+}
+
+std::string fileContent(int fd)
+{
+    std::string out(4096, '\0');
+    const ssize_t n = ::pread(fd, out.data(), out.size(), 0);
+    out.resize(n > 0 ? static_cast<std::size_t>(n) : 0);
+    return out;
+}
+
+} // namespace
+
+TEST(PipeTest, ReadStringReusesBuffer)
+{
+    Pipe p;
+    std::string buffer;
+    buffer.reserve(4096);
+    const auto *storage = buffer.data();
+
+    p.writeString("hello");
+    ASSERT_EQ(p.readString(buffer), 5U);
+    EXPECT_EQ(buffer, "hello");
+    EXPECT_EQ(buffer.data(), storage);
+
+    // Empty pipe: non-blocking read end yields an empty string, not an error.
+    ASSERT_EQ(p.readString(buffer), 0U);
+}
+
+TEST(PipeTest, ReadStringReturnsEverythingQueued)
+{
+    Pipe p;
+    const std::string big(3000, 'x');
+    p.writeString(big);
+    EXPECT_EQ(p.readString(), big);
+}
+
+TEST(PipeTest, CapacityCanBeRaised)
+{
+    Pipe p;
+    EXPECT_GE(p.capacity(), 4096U);
+    ASSERT_TRUE(p.setCapacity(256 * 1024));
+    EXPECT_GE(p.capacity(), 256U * 1024);
+}
+
+TEST(PipeTest, SpliceFileThroughPipe)
+{
+    const int in = memFile("0123456789");
+    const int out = memFile("");
+    Pipe p;
+
+    loff_t offset = 2;
+    ASSERT_EQ(p.spliceFrom(in, 5, &offset), 5U);
+    EXPECT_EQ(offset, 7);
+    EXPECT_EQ(p.buffered(), 5U);
+
+    loff_t outOffset = 0;
+    ASSERT_EQ(p.spliceTo(out, 5, &outOffset), 5U);
+    EXPECT_EQ(fileContent(out), "23456");
+    EXPECT_EQ(p.buffered(), 0U);
+
+    ::close(in);
+    ::close(out);
+}
+
+TEST(PipeTest, TeeDuplicatesWithoutConsuming)
+{
+    Pipe source;
+    Pipe copy;
+    source.writeString("mirror");
+
+    ASSERT_EQ(source.teeTo(copy, 64), 6U);
+    EXPECT_EQ(copy.readString(), "mirror");
+    EXPECT_EQ(source.readString(), "mirror");
+}
+
+TEST(PipeTest, VmspliceMapsUserPages)
+{
+    Pipe p;
+    const std::string text = "gifted pages";
+    ASSERT_EQ(p.vmspliceFrom(std::as_bytes(std::span(text))), text.size());
+    EXPECT_EQ(p.readString(), text);
+}
+
+TEST(PipeTest, RelayMovesMoreThanOnePipeful)
+{
+    std::string content(200 * 1024, '\0');
+    for (std::size_t i = 0; i < content.size(); ++i)
+        content[i] = static_cast<char>('a' + i % 26);
+
+    const int in = memFile(content);
+    const int out = memFile("");
+    Pipe p;
+
+    loff_t inOffset = 0;
+    loff_t outOffset = 0;
+    ASSERT_EQ(p.relay(in, out, content.size() + 100, &inOffset, &outOffset), content.size());
+    EXPECT_EQ(outOffset, static_cast<loff_t>(content.size()));
+    EXPECT_EQ(p.buffered(), 0U);
+
+    std::string copied(content.size(), '\0');
+    ASSERT_EQ(::pread(out, copied.data(), copied.size(), 0), static_cast<ssize_t>(copied.size()));
+    EXPECT_EQ(copied, content);
+
+    ::close(in);
+    ::close(out);
+}
+
+TEST(PipeTest, RelayEmptiesThePipeWhenTheOutputFails)
+{
+    const std::string content(200 * 1024, 'x');
+    const int in = memFile(content);
+
+    // The output cannot grow beyond 100 KiB: the relay fails partway through a pipeful.
+    const int out = ::memfd_create("pipe-test-sealed", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ASSERT_GE(out, 0);
+    ASSERT_EQ(::ftruncate(out, 100 * 1024), 0);
+    ASSERT_EQ(::fcntl(out, F_ADD_SEALS, F_SEAL_GROW), 0);
+
+    Pipe p;
+    loff_t inOffset = 0;
+    loff_t outOffset = 0;
+    EXPECT_FALSE(p.relay(in, out, content.size(), &inOffset, &outOffset).has_value());
+    EXPECT_GT(outOffset, 0);
+    EXPECT_EQ(p.buffered(), 0U);
+
+    ::close(in);
+    ::close(out);
+}
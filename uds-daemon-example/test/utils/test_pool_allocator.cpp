@@ -0,0 +1,166 @@
+#include <array>
+#include <gtest/gtest.h>
+#include <list.h>
+#include <pool_allocator.h>
+#include <queue.h>
+#include <string>
+#include <thread>
+
+using namespace utils;
+
+namespace {
+
+const PoolStats *findPool(const ArenaStats &stats, std::size_t blockSize)
+{
+    for (const auto &pool : stats.pools) {
+        if (pool.blockSize == blockSize)
+            return &pool;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(PoolAllocatorTest, ReleasedBlockIsReused)
+{
+    PoolArena arena(PoolBacking::Heap);
+    void *a = arena.Allocate(40);
+    arena.Deallocate(a, 40);
+
+    // Same size class (33..48 bytes) hands out the block from the free list.
+    void *b = arena.Allocate(48);
+    EXPECT_EQ(a, b);
+    arena.Deallocate(b, 48);
+}
+
+TEST(PoolAllocatorTest, BlocksAreAlignedAndDistinct)
+{
+    PoolArena arena(PoolBacking::Heap);
+    std::array<void *, 100> blocks{};
+    for (auto &block : blocks) {
+        block = arena.Allocate(24);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % PoolArena::kGranularity, 0U);
+    }
+    for (std::size_t i = 1; i < blocks.size(); ++i) {
+        const auto distance =
+            static_cast<std::byte *>(blocks[i]) - static_cast<std::byte *>(blocks[i - 1]);
+        EXPECT_GE(distance, 32);
+    }
+
+    for (auto *block : blocks)
+        arena.Deallocate(block, 24);
+}
+
+TEST(PoolAllocatorTest, StatsTrackUsage)
+{
+    PoolArena arena(PoolBacking::Heap);
+    std::array<void *, 10> blocks{};
+    for (auto &block : blocks)
+        block = arena.Allocate(64);
+    for (std::size_t i = 0; i < 4; ++i)
+        arena.Deallocate(blocks[i], 64);
+
+    const ArenaStats stats = arena.Stats();
+    EXPECT_EQ(stats.regions, 1U);
+    EXPECT_EQ(stats.oversizeAllocations, 0U);
+    ASSERT_EQ(stats.pools.size(), 1U);
+
+    const PoolStats &pool = stats.pools.front();
+    EXPECT_EQ(pool.blockSize, 64U);
+    EXPECT_EQ(pool.allocations, 10U);
+    EXPECT_EQ(pool.deallocations, 4U);
+    EXPECT_EQ(pool.inUse, 6U);
+    EXPECT_EQ(pool.peakInUse, 10U);
+    EXPECT_EQ(pool.capacity, 10U);
+
+    for (std::size_t i = 4; i < blocks.size(); ++i)
+        arena.Deallocate(blocks[i], 64);
+}
+
+TEST(PoolAllocatorTest, SlabsAreRefilledAcrossRegions)
+{
+    PoolArena arena(PoolBacking::Heap);
+    const std::size_t count = 2 * 256 * 1024 / PoolArena::kMaxBlockSize;
+    std::vector<void *> blocks;
+    for (std::size_t i = 0; i < count; ++i)
+        blocks.push_back(arena.Allocate(PoolArena::kMaxBlockSize));
+
+    EXPECT_EQ(arena.Stats().regions, 2U);
+    for (auto *block : blocks)
+        arena.Deallocate(block, PoolArena::kMaxBlockSize);
+    EXPECT_EQ(arena.Stats().pools.front().inUse, 0U);
+}
+
+TEST(PoolAllocatorTest, OversizeRequestsBypassThePools)
+{
+    PoolArena arena(PoolBacking::Heap);
+    void *big = arena.Allocate(PoolArena::kMaxBlockSize + 1);
+    arena.Deallocate(big, PoolArena::kMaxBlockSize + 1);
+
+    const ArenaStats stats = arena.Stats();
+    EXPECT_EQ(stats.oversizeAllocations, 1U);
+    EXPECT_EQ(stats.regions, 0U);
+    EXPECT_TRUE(stats.pools.empty());
+}
+
+TEST(PoolAllocatorTest, HugePageBackingFallsBackGracefully)
+{
+    // Without reserved huge pages the region is a THP-advised mapping; either way it works.
+    PoolArena arena(PoolBacking::HugePages);
+    auto *p = static_cast<char *>(arena.Allocate(100));
+    std::fill_n(p, 100, 'x');
+    arena.Deallocate(p, 100);
+
+    const ArenaStats stats = arena.Stats();
+    EXPECT_EQ(stats.backing, PoolBacking::HugePages);
+    EXPECT_EQ(stats.regions, 1U);
+    EXPECT_EQ(stats.reservedBytes, 2U * 1024 * 1024);
+}
+
+TEST(PoolAllocatorTest, PoolListInsertAndErase)
+{
+    using Allocator = PoolAllocator<std::string>;
+    const auto before = Allocator::Stats();
+
+    {
+        CPoolList<std::string> list;
+        for (int i = 0; i < 100; ++i)
+            list.push_back(std::to_string(i));
+        list.remove_if([](const std::string &s) { return s.size() == 1; });
+        EXPECT_EQ(list.size(), 90U);
+        EXPECT_EQ(list.front(), "10");
+
+        auto it = list.data_to_iterator(&list.back());
+        EXPECT_EQ(*it, "99");
+    }
+
+    // All list nodes went through one size class and were returned.
+    const auto after = Allocator::Stats();
+    ASSERT_FALSE(after.pools.empty());
+    uint64_t allocations = 0;
+    for (const auto &pool : after.pools) {
+        EXPECT_EQ(pool.inUse, 0U);
+        const PoolStats *old = findPool(before, pool.blockSize);
+        allocations += pool.allocations - (old ? old->allocations : 0);
+    }
+    EXPECT_EQ(allocations, 100U);
+}
+
+TEST(PoolAllocatorTest, PoolQueuePushAndPop)
+{
+    CPoolQueue<int> queue;
+    for (int i = 0; i < 10000; ++i)
+        queue.push_back(i);
+    for (int i = 0; i < 5000; ++i)
+        queue.pop_front();
+    EXPECT_EQ(queue.front(), 5000);
+    EXPECT_EQ(queue.size(), 5000U);
+}
+
+TEST(PoolAllocatorTest, ArenasAreThreadLocal)
+{
+    const PoolArena *main = &PoolArena::ThisThread<PoolBacking::Heap>();
+    const PoolArena *other = nullptr;
+    std::thread([&other]() { other = &PoolArena::ThisThread<PoolBacking::Heap>(); }).join();
+    EXPECT_NE(main, other);
+}
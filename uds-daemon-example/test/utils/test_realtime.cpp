@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <realtime.h>
+#include <thread>
+
+using namespace utils;
+
+namespace {
+
+int schedPolicyOfCurrentThread()
+{
+    int policy = -1;
+    sched_param param{};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    return policy;
+}
+
+} // namespace
+
+TEST(RealtimeTest, RejectsPriorityOutOfRange)
+{
+    try {
+        SetCurrentThreadPriority(kMaxRealtimePriority + 1);
+        FAIL() << "priority above the maximum accepted";
+    } catch (const RealtimeError &e) {
+        EXPECT_EQ(e.code().value(), EINVAL);
+    }
+    EXPECT_THROW(SetCurrentThreadPriority(-1), RealtimeError);
+}
+
+TEST(RealtimeTest, FifoAndBackToNormal)
+{
+    // On a thread of its own, so a failure cannot leave the test runner under SCHED_FIFO.
+    int fifo = -1;
+    int normal = -1;
+    bool permitted = true;
+    std::thread([&]() {
+        try {
+            SetCurrentThreadPriority(1);
+        } catch (const RealtimeError &) {
+            permitted = false;
+            return;
+        }
+        fifo = schedPolicyOfCurrentThread();
+        SetCurrentThreadPriority(0);
+        normal = schedPolicyOfCurrentThread();
+    }).join();
+
+    if (!permitted)
+        GTEST_SKIP() << "SCHED_FIFO not permitted here";
+    EXPECT_EQ(fifo, SCHED_FIFO);
+    EXPECT_EQ(normal, SCHED_OTHER);
+}
+
+TEST(RealtimeTest, DefaultStackSizeAppliesToNewThreads)
+{
+    pthread_attr_t saved;
+    ASSERT_EQ(pthread_getattr_default_np(&saved), 0);
+    std::size_t savedSize = 0;
+    pthread_attr_getstacksize(&saved, &savedSize);
+    pthread_attr_destroy(&saved);
+
+    constexpr std::size_t kStack = 256 * 1024;
+    SetDefaultThreadStackSize(kStack);
+    std::size_t stackSize = 0;
+    std::thread([&stackSize]() {
+        pthread_attr_t attr;
+        pthread_getattr_np(pthread_self(), &attr);
+        pthread_attr_getstacksize(&attr, &stackSize);
+        pthread_attr_destroy(&attr);
+        PrefaultStack(); // fits well within it
+    }).join();
+    SetDefaultThreadStackSize(savedSize);
+
+    EXPECT_GE(stackSize, kStack);
+    EXPECT_LT(stackSize, 2 * kStack);
+}
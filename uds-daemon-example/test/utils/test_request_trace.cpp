@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <request_trace.h>
+#include <sstream>
+#include <thread>
+
+using namespace utils;
+
+namespace {
+
+using Clock = RequestTrace::Clock;
+
+class RequestTraceTest : public ::testing::Test {
+  protected:
+    void SetUp() override { RequestTrace::Clear(); }
+
+    void TearDown() override
+    {
+        RequestTrace::Disable();
+        RequestTrace::Clear();
+    }
+
+    static std::vector<TraceSpan> SpansOf(uint64_t track)
+    {
+        auto spans = RequestTrace::Collect();
+        std::erase_if(spans, [track](const TraceSpan &span) { return span.track != track; });
+        return spans;
+    }
+};
+
+} // namespace
+
+TEST_F(RequestTraceTest, SamplesEveryNthRequestWhileEnabled)
+{
+    EXPECT_FALSE(RequestTrace::Enabled());
+    EXPECT_FALSE(RequestTrace::Sample());
+
+    RequestTrace::Enable(4);
+    EXPECT_EQ(RequestTrace::SampleEvery(), 4u);
+    int sampled = 0;
+    for (int i = 0; i < 40; ++i)
+        sampled += RequestTrace::Sample() ? 1 : 0;
+    EXPECT_EQ(sampled, 10);
+
+    RequestTrace::Disable();
+    EXPECT_FALSE(RequestTrace::Sample());
+}
+
+TEST_F(RequestTraceTest, KeepsSpansOfThreadsThatExited)
+{
+    const auto start = Clock::now();
+    std::thread([start]() {
+        RequestTrace::Record("recv", 101, start, start + std::chrono::microseconds(3));
+        RequestTrace::Record("send", 101, start + std::chrono::microseconds(3),
+                             start + std::chrono::microseconds(5));
+    }).join();
+
+    auto spans = SpansOf(101);
+    ASSERT_EQ(spans.size(), 2u);
+    std::ranges::sort(spans, {}, &TraceSpan::start);
+    EXPECT_STREQ(spans[0].name, "recv");
+    EXPECT_EQ(spans[1].end - spans[1].start, std::chrono::microseconds(2));
+
+    RequestTrace::Clear();
+    EXPECT_TRUE(SpansOf(101).empty());
+}
+
+TEST_F(RequestTraceTest, FullRingKeepsTheNewestSpans)
+{
+    const auto start = Clock::now();
+    std::thread([start]() {
+        for (std::size_t i = 0; i < RequestTrace::kThreadSpans + 10; ++i) {
+            const auto at = start + std::chrono::microseconds(i);
+            RequestTrace::Record("handler", 102, at, at);
+        }
+    }).join();
+
+    const auto spans = SpansOf(102);
+    ASSERT_EQ(spans.size(), RequestTrace::kThreadSpans);
+    EXPECT_EQ(std::ranges::min(spans, {}, &TraceSpan::start).start,
+              start + std::chrono::microseconds(10));
+}
+
+TEST_F(RequestTraceTest, WritesChromeTraceEvents)
+{
+    const Clock::time_point start{std::chrono::nanoseconds(5'000'250)};
+    const std::vector<TraceSpan> spans{
+        {.name = "recv", .track = 7, .start = start, .end = start + std::chrono::nanoseconds(750)},
+        {.name = "request",
+         .track = 7,
+         .start = start,
+         .end = start + std::chrono::microseconds(2)},
+    };
+
+    std::ostringstream out;
+    EXPECT_EQ(RequestTrace::WriteChromeTrace(out, spans, 42, "session"), 2u);
+    const auto json = out.str();
+
+    EXPECT_TRUE(json.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    EXPECT_NE(json.find("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":42,\"tid\":7,"
+                        "\"args\":{\"name\":\"session 7\"}}"),
+              std::string::npos);
+    EXPECT_NE(json.find("{\"name\":\"recv\",\"cat\":\"request\",\"ph\":\"X\",\"pid\":42,"
+                        "\"tid\":7,\"ts\":5000.250,\"dur\":0.750}"),
+              std::string::npos);
+    // The enclosing span comes first, as the viewers expect for spans starting together.
+    EXPECT_LT(json.find("\"request\""), json.find("\"recv\""));
+    EXPECT_TRUE(json.ends_with("]}\n"));
+}
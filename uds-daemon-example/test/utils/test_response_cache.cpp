@@ -0,0 +1,185 @@
+#include <format>
+#include <gtest/gtest.h>
+#include <response_cache.h>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+using namespace std::chrono_literals;
+
+namespace {
+
+ResponseCacheOptions singleShard(std::size_t budget, std::chrono::milliseconds ttl = 0ms)
+{
+    return ResponseCacheOptions{.byteBudget = budget, .ttl = ttl, .shards = 1};
+}
+
+} // namespace
+
+TEST(ResponseCacheTest, HitAfterInsert)
+{
+    ResponseCache cache(singleShard(64 * 1024));
+    std::string response;
+
+    EXPECT_FALSE(cache.Lookup("get state", response));
+    EXPECT_TRUE(cache.Insert("get state", "state: ready"));
+    ASSERT_TRUE(cache.Lookup("get state", response));
+    EXPECT_EQ(response, "state: ready");
+
+    // Replacing keeps a single entry.
+    EXPECT_TRUE(cache.Insert("get state", "state: busy"));
+    ASSERT_TRUE(cache.Lookup("get state", response));
+    EXPECT_EQ(response, "state: busy");
+
+    const auto stats = cache.Stats();
+    EXPECT_EQ(stats.hits, 2U);
+    EXPECT_EQ(stats.misses, 1U);
+    EXPECT_EQ(stats.entries, 1U);
+}
+
+TEST(ResponseCacheTest, BinaryKeysAreComparedInFull)
+{
+    ResponseCache cache(singleShard(64 * 1024));
+    const std::string a("key\0a", 5);
+    const std::string b("key\0b", 5);
+    ASSERT_TRUE(cache.Insert(a, "A"));
+
+    std::string response;
+    EXPECT_FALSE(cache.Lookup(b, response));
+    EXPECT_FALSE(cache.Lookup("key", response));
+    EXPECT_TRUE(cache.Lookup(a, response));
+}
+
+TEST(ResponseCacheTest, StaysWithinBudget)
+{
+    constexpr std::size_t kBudget = 16 * 1024;
+    ResponseCache cache(singleShard(kBudget));
+
+    for (int i = 0; i < 2000; ++i) {
+        ASSERT_TRUE(cache.Insert(std::format("request {}", i), std::string(100, 'x')));
+        ASSERT_LE(cache.Stats().bytes, kBudget);
+    }
+    const auto stats = cache.Stats();
+    EXPECT_GT(stats.evictions, 0U);
+    EXPECT_EQ(stats.entries + stats.evictions, 2000U);
+
+    // An entry that can never fit is refused.
+    EXPECT_FALSE(cache.Insert("huge", std::string(kBudget, 'x')));
+}
+
+TEST(ResponseCacheTest, ClockKeepsReferencedEntries)
+{
+    ResponseCache cache(singleShard(8 * 1024));
+    std::string response;
+    ASSERT_TRUE(cache.Insert("hot", "value"));
+
+    // The hot entry is hit between inserts, so the hand always finds its bit set.
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(cache.Lookup("hot", response)) << "evicted after " << i << " inserts";
+        cache.Insert(std::format("cold {}", i), std::string(64, 'c'));
+    }
+    EXPECT_GT(cache.Stats().evictions, 0U);
+}
+
+TEST(ResponseCacheTest, EntriesExpireAfterTtl)
+{
+    ResponseCache cache(singleShard(64 * 1024, 100ms));
+    const auto start = ResponseCache::Clock::now();
+    std::string response;
+
+    ASSERT_TRUE(cache.Insert("state", "old", start));
+    EXPECT_TRUE(cache.Lookup("state", response, start + 99ms));
+    EXPECT_FALSE(cache.Lookup("state", response, start + 100ms));
+
+    const auto stats = cache.Stats();
+    EXPECT_EQ(stats.expirations, 1U);
+    EXPECT_EQ(stats.entries, 0U);
+}
+
+TEST(ResponseCacheTest, Invalidation)
+{
+    ResponseCache cache(ResponseCacheOptions{.byteBudget = 64 * 1024, .shards = 4});
+    std::string response;
+    for (int i = 0; i < 10; ++i)
+        cache.Insert(std::format("r{}", i), "v");
+
+    EXPECT_TRUE(cache.Invalidate("r3"));
+    EXPECT_FALSE(cache.Invalidate("r3"));
+    EXPECT_FALSE(cache.Lookup("r3", response));
+    EXPECT_TRUE(cache.Lookup("r4", response));
+
+    cache.InvalidateAll();
+    const auto stats = cache.Stats();
+    EXPECT_EQ(stats.entries, 0U);
+    EXPECT_EQ(stats.bytes, 0U);
+    EXPECT_EQ(stats.invalidations, 10U);
+    EXPECT_FALSE(cache.Lookup("r4", response));
+}
+
+TEST(ResponseCacheTest, ReconfigureShrinksAndDisables)
+{
+    ResponseCache cache(singleShard(64 * 1024));
+    for (int i = 0; i < 100; ++i)
+        cache.Insert(std::format("r{}", i), std::string(200, 'v'));
+
+    cache.Reconfigure(singleShard(8 * 1024));
+    EXPECT_LE(cache.Stats().bytes, 8U * 1024);
+
+    cache.Reconfigure(singleShard(0));
+    EXPECT_EQ(cache.Stats().entries, 0U);
+    EXPECT_FALSE(cache.Insert("r1", "v"));
+}
+
+TEST(ResponseCacheTest, RemovalKeepsProbeRunsReachable)
+{
+    // Many keys in a small table produce long probe runs; removing from their middle must not cut
+    // off the keys behind.
+    ResponseCache cache(singleShard(1 << 20));
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_TRUE(cache.Insert(std::format("k{}", i), std::format("v{}", i)));
+    for (int i = 0; i < 1000; i += 3)
+        ASSERT_TRUE(cache.Invalidate(std::format("k{}", i)));
+
+    std::string response;
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(cache.Lookup(std::format("k{}", i), response), i % 3 != 0) << i;
+        if (i % 3 != 0) {
+            EXPECT_EQ(response, std::format("v{}", i));
+        }
+    }
+}
+
+TEST(ResponseCacheTest, HashSpreadsShortKeys)
+{
+    std::set<uint64_t> hashes;
+    for (int i = 0; i < 10000; ++i)
+        hashes.insert(ResponseCache::Hash(std::format("{}", i)));
+    EXPECT_EQ(hashes.size(), 10000U);
+    EXPECT_NE(ResponseCache::Hash(""), ResponseCache::Hash(std::string(1, '\0')));
+}
+
+TEST(ResponseCacheTest, ConcurrentAccess)
+{
+    ResponseCache cache(ResponseCacheOptions{.byteBudget = 32 * 1024, .shards = 8});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            std::string response;
+            for (int i = 0; i < 5000; ++i) {
+                const auto key = std::format("r{}", (i * 7 + t) % 300);
+                if (cache.Lookup(key, response)) {
+                    EXPECT_EQ(response, "reply to " + key);
+                } else {
+                    cache.Insert(key, "reply to " + key);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    const auto stats = cache.Stats();
+    EXPECT_EQ(stats.hits + stats.misses, 20000U);
+    EXPECT_LE(stats.bytes, 32U * 1024);
+}
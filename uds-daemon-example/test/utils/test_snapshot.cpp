@@ -0,0 +1,68 @@
+#include <atomic>
+#include <gtest/gtest.h>
+#include <snapshot.h>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+struct Pair {
+    int a{0};
+    int b{0};
+};
+
+} // namespace
+
+TEST(SnapshotTest, ReaderSeesPublishedValue)
+{
+    Snapshot<Pair> snapshot(Pair{.a = 1, .b = 1});
+    Snapshot<Pair>::Reader reader(snapshot);
+    EXPECT_EQ(reader->a, 1);
+    EXPECT_FALSE(reader.Refresh());
+
+    snapshot.Publish(Pair{.a = 2, .b = 2});
+    EXPECT_EQ(snapshot.Generation(), 1U);
+    EXPECT_EQ(reader->a, 2);
+    EXPECT_FALSE(reader.Refresh());
+}
+
+TEST(SnapshotTest, OldValueLivesWhileReferenced)
+{
+    Snapshot<Pair> snapshot(Pair{.a = 1, .b = 1});
+    auto old = snapshot.Load();
+    snapshot.Publish(Pair{.a = 2, .b = 2});
+
+    EXPECT_EQ(old->a, 1);
+    EXPECT_EQ(snapshot.Load()->a, 2);
+}
+
+// Readers must never observe a torn value while a writer keeps publishing.
+TEST(SnapshotTest, ConcurrentReadersSeeConsistentValues)
+{
+    Snapshot<Pair> snapshot;
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            Snapshot<Pair>::Reader reader(snapshot);
+            while (!stop.load(std::memory_order_relaxed)) {
+                const Pair &p = *reader;
+                if (p.a != p.b)
+                    ++torn;
+            }
+        });
+    }
+
+    for (int i = 1; i <= 2000; ++i)
+        snapshot.Publish(Pair{.a = i, .b = i});
+    stop = true;
+    for (auto &t : readers)
+        t.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(snapshot.Load()->a, 2000);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <spsc_ring.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace utils;
+
+TEST(SpscRingTest, CapacityIsRoundedToPowerOfTwo)
+{
+    EXPECT_EQ(SpscRing<int>(5).Capacity(), 8U);
+    EXPECT_EQ(SpscRing<int>(8).Capacity(), 8U);
+    EXPECT_EQ(SpscRing<int>(0).Capacity(), 2U);
+}
+
+TEST(SpscRingTest, FifoUntilFullThenEmpty)
+{
+    SpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(ring.TryPush(i));
+    EXPECT_FALSE(ring.TryPush(99));
+    EXPECT_EQ(ring.SizeApprox(), 4U);
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(ring.TryPop(), i);
+    EXPECT_FALSE(ring.TryPop().has_value());
+}
+
+TEST(SpscRingTest, BatchPushAndPopWrapAround)
+{
+    SpscRing<int> ring(8);
+    std::vector<int> in{0, 1, 2, 3, 4, 5};
+    EXPECT_EQ(ring.PushBatch(std::span(in)), 6U);
+
+    std::vector<int> out;
+    EXPECT_EQ(ring.PopBatch(std::back_inserter(out), 4), 4U);
+
+    // Only 6 of these fit: 2 still queued, capacity 8.
+    std::vector<int> more{6, 7, 8, 9, 10, 11, 12};
+    EXPECT_EQ(ring.PushBatch(std::span(more)), 6U);
+
+    EXPECT_EQ(ring.PopBatch(std::back_inserter(out), 100), 8U);
+    EXPECT_EQ(out, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+}
+
+TEST(SpscRingTest, DestroysRemainingElements)
+{
+    auto tracked = std::make_shared<int>(0);
+    {
+        SpscRing<std::shared_ptr<int>> ring(4);
+        ring.TryPush(tracked);
+        ring.TryPush(tracked);
+        EXPECT_EQ(tracked.use_count(), 3);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
+
+// Every element arrives exactly once and in order while both sides run concurrently.
+TEST(SpscRingTest, StressProducerConsumer)
+{
+    static constexpr uint64_t kCount = 1'000'000;
+    SpscRing<uint64_t> ring(256);
+
+    std::thread producer([&ring]() {
+        std::vector<uint64_t> batch;
+        for (uint64_t next = 0; next < kCount;) {
+            if (next % 3 == 0) {
+                if (ring.TryPush(next))
+                    ++next;
+                else
+                    std::this_thread::yield();
+                continue;
+            }
+            batch.clear();
+            for (uint64_t i = next; i < std::min(next + 16, kCount); ++i)
+                batch.push_back(i);
+            const auto pushed = ring.PushBatch(std::span(batch));
+            next += pushed;
+            if (pushed == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    uint64_t expected = 0;
+    std::vector<uint64_t> out;
+    while (expected < kCount) {
+        out.clear();
+        if (ring.PopBatch(std::back_inserter(out), 32) == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (uint64_t v : out)
+            ASSERT_EQ(v, expected++);
+    }
+    producer.join();
+    EXPECT_FALSE(ring.TryPop().has_value());
+}
@@ -0,0 +1,174 @@
+#include <chrono>
+#include <fdset.h>
+#include <gtest/gtest.h>
+#include <sys/timerfd.h>
+#include <timer_wheel.h>
+#include <vector>
+
+using namespace utils;
+using namespace std::chrono_literals;
+
+//*****************************
+// One-shot timer fires once, not before its deadline
+TEST(TimerWheelTest, OneShotFiresAtDeadline)
+{
+    TimerWheel wheel(1ms);
+    int fired = 0;
+    auto id = wheel.Schedule(50ms, [&fired] { ++fired; });
+    const auto t0 = wheel.Now();
+
+    EXPECT_TRUE(wheel.IsActive(id));
+    EXPECT_EQ(wheel.AdvanceTo(t0 + 49ms), 0u);
+    EXPECT_EQ(fired, 0);
+
+    EXPECT_EQ(wheel.AdvanceTo(t0 + 50ms), 1u);
+    EXPECT_EQ(fired, 1);
+    EXPECT_FALSE(wheel.IsActive(id));
+    EXPECT_EQ(wheel.Size(), 0u);
+
+    wheel.AdvanceTo(t0 + 500ms);
+    EXPECT_EQ(fired, 1);
+}
+
+//*****************************
+// Cancel prevents the callback, stale ids are rejected
+TEST(TimerWheelTest, CancelAndStaleHandle)
+{
+    TimerWheel wheel(1ms);
+    bool fired = false;
+    auto id = wheel.Schedule(10ms, [&fired] { fired = true; });
+    const auto t0 = wheel.Now();
+
+    EXPECT_TRUE(wheel.Cancel(id));
+    EXPECT_FALSE(wheel.Cancel(id));
+
+    // The slot is recycled; the old handle must not touch the new timer.
+    auto other = wheel.Schedule(10ms, [] {});
+    EXPECT_EQ(other.index, id.index);
+    EXPECT_FALSE(wheel.Cancel(id));
+    EXPECT_TRUE(wheel.IsActive(other));
+
+    wheel.AdvanceTo(t0 + 20ms);
+    EXPECT_FALSE(fired);
+}
+
+//*****************************
+// Reset pushes the deadline out, e.g. an idle timeout on traffic
+TEST(TimerWheelTest, ResetPostponesDeadline)
+{
+    TimerWheel wheel(1ms);
+    int fired = 0;
+    auto id = wheel.Schedule(30ms, [&fired] { ++fired; });
+    const auto t0 = wheel.Now();
+
+    wheel.AdvanceTo(t0 + 20ms);
+    EXPECT_TRUE(wheel.Reset(id, 30ms));
+    wheel.AdvanceTo(t0 + 49ms);
+    EXPECT_EQ(fired, 0);
+    wheel.AdvanceTo(t0 + 50ms);
+    EXPECT_EQ(fired, 1);
+}
+
+//*****************************
+// Periodic timers re-arm until cancelled from their own callback
+TEST(TimerWheelTest, PeriodicUntilCancelled)
+{
+    TimerWheel wheel(1ms);
+    int fired = 0;
+    TimerId id;
+    id = wheel.SchedulePeriodic(10ms, [&] {
+        if (++fired == 3)
+            wheel.Cancel(id);
+    });
+    const auto t0 = wheel.Now();
+
+    wheel.AdvanceTo(t0 + 25ms);
+    EXPECT_EQ(fired, 2);
+    wheel.AdvanceTo(t0 + 100ms);
+    EXPECT_EQ(fired, 3);
+    EXPECT_EQ(wheel.Size(), 0u);
+}
+
+//*****************************
+// Timers on the upper levels cascade down and keep their order
+TEST(TimerWheelTest, CascadesAcrossLevels)
+{
+    TimerWheel wheel(1ms);
+    std::vector<int> order;
+    wheel.Schedule(70ms, [&order] { order.push_back(1); });
+    wheel.Schedule(5000ms, [&order] { order.push_back(2); });
+    wheel.Schedule(300'000ms, [&order] { order.push_back(3); });
+    const auto t0 = wheel.Now();
+
+    wheel.AdvanceTo(t0 + 69ms);
+    EXPECT_TRUE(order.empty());
+    wheel.AdvanceTo(t0 + 70ms);
+    EXPECT_EQ(order, std::vector<int>({1}));
+    wheel.AdvanceTo(t0 + 4999ms);
+    EXPECT_EQ(order.size(), 1u);
+    wheel.AdvanceTo(t0 + 5000ms);
+    EXPECT_EQ(order, std::vector<int>({1, 2}));
+    wheel.AdvanceTo(t0 + 299'999ms);
+    EXPECT_EQ(order.size(), 2u);
+    wheel.AdvanceTo(t0 + 300'000ms);
+    EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+}
+
+//*****************************
+// Callbacks may schedule new timers into the slot that is being processed
+TEST(TimerWheelTest, RescheduleFromCallback)
+{
+    TimerWheel wheel(1ms);
+    int fired = 0;
+    std::function<void()> again = [&] {
+        if (++fired < 4)
+            wheel.Schedule(64ms, again);
+    };
+    wheel.Schedule(64ms, again);
+    const auto t0 = wheel.Now();
+
+    wheel.AdvanceTo(t0 + 64ms);
+    EXPECT_EQ(fired, 1);
+    wheel.AdvanceTo(t0 + 256ms);
+    EXPECT_EQ(fired, 4);
+}
+
+//*****************************
+// The timerfd drives the wheel from an event loop
+TEST(TimerWheelTest, TimerFdWakesEventLoop)
+{
+    TimerWheel wheel(5ms);
+    FdSet set;
+    bool fired = false;
+    wheel.Schedule(20ms, [&fired] { fired = true; });
+    set.AddFd(wheel.Fd(), [&wheel](int) { wheel.OnReadable(); });
+
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (!fired && std::chrono::steady_clock::now() < deadline)
+        EXPECT_EQ(set.Select(500ms), FdSetRet::OK);
+
+    EXPECT_TRUE(fired);
+
+    // Disarmed without pending timers
+    EXPECT_EQ(set.Select(50ms), FdSetRet::TIMEOUT);
+}
+
+//*****************************
+// The timerfd is armed one-shot for the next expiry, not ticking in between
+TEST(TimerWheelTest, TimerFdArmedForNextExpiryOnly)
+{
+    TimerWheel wheel(10ms);
+    wheel.SchedulePeriodic(500ms, [] {});
+
+    itimerspec spec{};
+    ASSERT_EQ(::timerfd_gettime(wheel.Fd(), &spec), 0);
+    EXPECT_EQ(spec.it_interval.tv_sec, 0);
+    EXPECT_EQ(spec.it_interval.tv_nsec, 0);
+    EXPECT_GE(spec.it_value.tv_sec * 1000 + spec.it_value.tv_nsec / 1'000'000, 400);
+
+    // An earlier timer moves the deadline forward.
+    wheel.Schedule(100ms, [] {});
+    ASSERT_EQ(::timerfd_gettime(wheel.Fd(), &spec), 0);
+    EXPECT_EQ(spec.it_value.tv_sec, 0);
+    EXPECT_LE(spec.it_value.tv_nsec, 110'000'000);
+}
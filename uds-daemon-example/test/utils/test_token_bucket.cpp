@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <token_bucket.h>
+
+using namespace utils;
+using namespace std::chrono_literals;
+
+namespace {
+
+const TokenBucket::Clock::time_point kStart{1h};
+
+} // namespace
+
+TEST(TokenBucketTest, UnlimitedNeverWaits)
+{
+    TokenBucket bucket;
+    EXPECT_TRUE(bucket.Unlimited());
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(bucket.Reserve(kStart), 0ns);
+}
+
+TEST(TokenBucketTest, BurstThenRate)
+{
+    TokenBucket bucket(100, 3); // one token every 10 ms
+    EXPECT_TRUE(bucket.TryAcquire(kStart));
+    EXPECT_TRUE(bucket.TryAcquire(kStart));
+    EXPECT_TRUE(bucket.TryAcquire(kStart));
+    EXPECT_FALSE(bucket.TryAcquire(kStart));
+    EXPECT_FALSE(bucket.TryAcquire(kStart + 9ms));
+    EXPECT_TRUE(bucket.TryAcquire(kStart + 10ms));
+    EXPECT_FALSE(bucket.TryAcquire(kStart + 10ms));
+}
+
+TEST(TokenBucketTest, ReserveQueuesBehindBacklog)
+{
+    TokenBucket bucket(100, 1);
+    EXPECT_EQ(bucket.Reserve(kStart), 0ms);
+    EXPECT_EQ(bucket.Reserve(kStart), 10ms);
+    EXPECT_EQ(bucket.Reserve(kStart), 20ms);
+    // Reservations count even though they were waited for, so TryAcquire fails until they passed.
+    EXPECT_FALSE(bucket.TryAcquire(kStart + 25ms));
+    EXPECT_TRUE(bucket.TryAcquire(kStart + 30ms));
+}
+
+TEST(TokenBucketTest, IdleTimeRefillsOnlyUpToBurst)
+{
+    TokenBucket bucket(1000, 2);
+    EXPECT_EQ(bucket.Reserve(kStart), 0ms);
+    const auto later = kStart + 1s;
+    EXPECT_EQ(bucket.Reserve(later), 0ms);
+    EXPECT_EQ(bucket.Reserve(later), 0ms);
+    EXPECT_EQ(bucket.Reserve(later), 1ms);
+}
+
+TEST(TokenBucketTest, ReconfigureToUnlimited)
+{
+    TokenBucket bucket(1, 1);
+    EXPECT_TRUE(bucket.TryAcquire(kStart));
+    EXPECT_FALSE(bucket.TryAcquire(kStart));
+    bucket.Reconfigure(0, 1);
+    EXPECT_TRUE(bucket.Unlimited());
+    EXPECT_TRUE(bucket.TryAcquire(kStart));
+}
@@ -0,0 +1,151 @@
+#include "admin_commands.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <request_trace.h>
+#include <unistd.h>
+#include <utility>
+
+namespace uds_daemon {
+
+namespace {
+
+// Splits "<word> <rest>" at the first space.
+std::pair<std::string_view, std::string_view> splitWord(std::string_view text)
+{
+    const auto space = text.find(' ');
+    if (space == std::string_view::npos)
+        return {text, {}};
+    return {text.substr(0, space), text.substr(space + 1)};
+}
+
+bool parsePositive(std::string_view text, uint64_t &value)
+{
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc{} && end == text.data() + text.size() && value > 0;
+}
+
+} // namespace
+
+std::string TraceCommand(std::string_view args)
+{
+    const auto [verb, operand] = splitWord(args);
+
+    if (verb == "on") {
+        uint64_t every = 1;
+        if (!operand.empty() && !parsePositive(operand, every))
+            return std::format("error: '{}' is not a sample rate, expected N > 0", operand);
+        utils::RequestTrace::Enable(every);
+        return std::format("tracing 1 in {} requests", every);
+    }
+    if (verb == "off") {
+        utils::RequestTrace::Disable();
+        return "tracing off";
+    }
+    if (verb == "clear") {
+        utils::RequestTrace::Clear();
+        return "trace cleared";
+    }
+    if (verb == "dump") {
+        if (operand.empty())
+            return "error: trace dump needs a file name";
+        std::ofstream out{std::string(operand)};
+        if (!out)
+            return std::format("error: cannot write {}: {}", operand, strerror(errno));
+        const auto spans = utils::RequestTrace::WriteChromeTrace(
+            out, utils::RequestTrace::Collect(), ::getpid(), "session");
+        out.close();
+        if (!out)
+            return std::format("error: writing {} failed", operand);
+        return std::format("wrote {} spans to {}", spans, operand);
+    }
+    if (verb.empty()) {
+        const auto every = utils::RequestTrace::SampleEvery();
+        return every == 0 ? std::string("tracing off")
+                          : std::format("tracing 1 in {} requests", every);
+    }
+    return "error: usage: trace [on [N] | off | clear | dump <file>]";
+}
+
+std::string DescribeCapture(const net::RequestCaptureStatus &status)
+{
+    return std::format("{}: 1 in {} sessions, {} requests, {} bytes, {} dropped",
+                       status.path.string(), status.sessionEvery, status.stats.records,
+                       status.stats.bytes, status.stats.dropped);
+}
+
+std::string CaptureCommand(net::RequestCapture &capture, std::string_view args,
+                           const WorkerContext *worker)
+{
+    constexpr uint64_t kDefaultMaxMiB = 1024;
+
+    const auto [verb, rest] = splitWord(args);
+    if (verb == "start") {
+        const auto [file, limits] = splitWord(rest);
+        const auto [everyText, maxText] = splitWord(limits);
+        uint64_t every = 1;
+        uint64_t maxMiB = kDefaultMaxMiB;
+        if (file.empty() || (!everyText.empty() && !parsePositive(everyText, every)) ||
+            (!maxText.empty() && !parsePositive(maxText, maxMiB)))
+            return "error: usage: capture start <file> [N sessions] [max MiB]";
+        std::string path(file);
+        if (worker)
+            path += std::format(".{}", worker->Index());
+        try {
+            capture.Start(path, every, maxMiB * 1024 * 1024);
+        } catch (const utils::CaptureFileError &e) {
+            return std::format("error: {}", e.what());
+        }
+        return std::format("capturing 1 in {} sessions to {}", every, path);
+    }
+    if (verb == "stop") {
+        const auto status = capture.Stop();
+        if (!status)
+            return "capture off";
+        return std::format("capture stopped: {}", DescribeCapture(*status));
+    }
+    if (verb.empty()) {
+        const auto status = capture.Status();
+        return status ? std::format("capturing {}", DescribeCapture(*status))
+                      : std::string("capture off");
+    }
+    return "error: usage: capture [start <file> [N sessions] [max MiB] | stop]";
+}
+
+std::string StatsCommand(const net::UdsServerWorker &server, std::string_view args)
+{
+    if (!args.empty())
+        return "error: usage: stats";
+
+    const auto stats = server.Stats();
+    std::string reply = std::format("{} sessions ({} active), {} requests", stats.sessions,
+                                    stats.activeSessions, stats.requests);
+    for (const auto &peer : server.PeerThrottleStats()) {
+        reply += std::format(
+            "; uid {}: {} requests, {} throttled, {} ms delayed", peer.uid, peer.requests,
+            peer.throttled,
+            std::chrono::duration_cast<std::chrono::milliseconds>(peer.delayed).count());
+    }
+    return reply;
+}
+
+std::string CacheCommand(net::UdsServerWorker &server, std::string_view args)
+{
+    if (args == "invalidate") {
+        const auto entries = server.ResponseCacheStats().entries;
+        server.InvalidateResponses();
+        return std::format("dropped {} cached responses", entries);
+    }
+    if (args.empty() || args == "stats") {
+        const auto stats = server.ResponseCacheStats();
+        return std::format("{} entries, {} bytes, {} hits, {} misses, {} insertions, "
+                           "{} evictions, {} expired, {} invalidated",
+                           stats.entries, stats.bytes, stats.hits, stats.misses, stats.insertions,
+                           stats.evictions, stats.expirations, stats.invalidations);
+    }
+    return "error: usage: cache [stats | invalidate]";
+}
+
+} // namespace uds_daemon
@@ -0,0 +1,40 @@
+#ifndef ADMIN_COMMANDS_H_
+#define ADMIN_COMMANDS_H_
+
+#include <request_capture.h>
+#include <server_worker.h>
+#include <worker_supervisor.h>
+
+#include <string>
+#include <string_view>
+
+//*****************************************************************************
+// Commands of the admin socket (admin_server.h). Each takes the text after
+// its name and returns the reply line; a reply starting with "error: " is a
+// rejected command, e.g. a usage message.
+//*****************************************************************************
+
+namespace uds_daemon {
+
+//! "trace [on [N] | off | clear | dump <file>]": request tracing of this process, sampling
+//! every Nth request.
+std::string TraceCommand(std::string_view args);
+
+//! "capture [start <file> [N] [MiB] | stop]": records the requests of every Nth session to a
+//! capture file of at most MiB (default 1024) for `udsctl replay`. With \p worker set, the
+//! worker writes <file>.<index>.
+std::string CaptureCommand(net::RequestCapture &capture, std::string_view args,
+                           const WorkerContext *worker);
+std::string DescribeCapture(const net::RequestCaptureStatus &status);
+
+//! "stats": the sessions and requests of this process, then the requests of each client uid
+//! with how many of them the rate limits held back and for how long.
+std::string StatsCommand(const net::UdsServerWorker &server, std::string_view args);
+
+//! "cache [stats | invalidate]": the counters of the response cache, or dropping every cached
+//! response, e.g. after the state the handlers report on changed.
+std::string CacheCommand(net::UdsServerWorker &server, std::string_view args);
+
+} // namespace uds_daemon
+
+#endif // ADMIN_COMMANDS_H_
@@ -0,0 +1,120 @@
+#include "admin_server.h"
+#include <array>
+#include <byte_util.h>
+#include <format>
+#include <poll.h>
+#include <span>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+
+namespace uds_daemon {
+
+namespace {
+
+std::string_view trim(std::string_view text)
+{
+    constexpr std::string_view kSpace = " \t\r\n";
+    const auto first = text.find_first_not_of(kSpace);
+    if (first == std::string_view::npos)
+        return {};
+    return text.substr(first, text.find_last_not_of(kSpace) - first + 1);
+}
+
+// Restores the process umask when the socket has been bound.
+class ScopedUmask {
+  public:
+    explicit ScopedUmask(mode_t mask) : previous_(::umask(mask)) {}
+    ~ScopedUmask() { ::umask(previous_); }
+
+    ScopedUmask(const ScopedUmask &) = delete;
+    ScopedUmask &operator=(const ScopedUmask &) = delete;
+
+  private:
+    const mode_t previous_;
+};
+
+// Bound under umask 077: the socket never exists with more than owner permissions, not even
+// between bind() and a chmod.
+net::UdsServer bindOwnerOnly(const std::filesystem::path &socketPath)
+{
+    const ScopedUmask ownerOnly(077);
+    return net::UdsServer(socketPath);
+}
+
+} // namespace
+
+AdminServer::AdminServer(const std::filesystem::path &socketPath, Commands commands)
+ : server_(bindOwnerOnly(socketPath))
+ , commands_(std::move(commands))
+{
+    std::filesystem::permissions(socketPath, std::filesystem::perms::owner_read |
+                                                 std::filesystem::perms::owner_write);
+    thread_ = std::thread(&AdminServer::Run, this);
+    spdlog::info("Admin commands on {}", socketPath.string());
+}
+
+AdminServer::~AdminServer() { Stop(); }
+
+void AdminServer::Stop() noexcept
+{
+    if (!running_.exchange(false))
+        return;
+    server_.Unblock();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+std::string AdminServer::Execute(std::string_view line) const
+{
+    line = trim(line);
+    const auto space = line.find(' ');
+    const std::string_view name = line.substr(0, space);
+    const std::string_view args =
+        space == std::string_view::npos ? std::string_view{} : trim(line.substr(space + 1));
+
+    if (name == "help" || name.empty()) {
+        std::string reply = "commands: help";
+        for (const auto &[command, _] : commands_)
+            reply += " " + command;
+        return reply;
+    }
+
+    const auto it = commands_.find(name);
+    if (it == commands_.end())
+        return std::format("error: unknown command '{}', try help", name);
+    try {
+        return it->second(args);
+    } catch (const std::exception &e) {
+        return std::format("error: {}", e.what());
+    }
+}
+
+void AdminServer::Run()
+{
+    std::array<std::byte, 1024> buffer{};
+    while (running_) {
+        auto session = server_.WaitForConnection();
+        if (!session) {
+            if (session.error() == std::errc::operation_canceled)
+                break;
+            spdlog::warn("Admin socket: accept failed: {}",
+                         std::make_error_code(session.error()).message());
+            continue;
+        }
+
+        // A silent client must not hold up the next one (or a stop) for longer than this.
+        pollfd pfd{.fd = session->getFd(), .events = POLLIN, .revents = 0};
+        if (::poll(&pfd, 1, static_cast<int>(kCommandTimeout.count() * 1000)) <= 0)
+            continue;
+
+        auto received = session->receive(std::span(buffer));
+        if (!received)
+            continue;
+        const std::string_view line = utils::from_bytes(std::span(buffer.data(), *received));
+        const std::string reply = Execute(line);
+        spdlog::info("Admin command '{}': {}", trim(line), reply);
+        session->send(std::span(reply));
+    }
+}
+
+} // namespace uds_daemon
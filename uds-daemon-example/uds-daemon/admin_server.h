@@ -0,0 +1,59 @@
+#ifndef ADMIN_SERVER_H_
+#define ADMIN_SERVER_H_
+
+#include <uds_server.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace uds_daemon {
+
+//*****************************************************************************
+//! \brief AdminServer
+//! Operator commands on a unix socket of their own, next to the service
+//! socket. A connection carries one command line ("<name> <args>") and gets
+//! one reply line, so `udsctl send -s <admin socket> -m "trace on"` is a
+//! client. The socket is created with mode 0600: whoever can connect
+//! controls the daemon.
+//!
+//! Commands run one at a time on the admin thread and should return quickly;
+//! a client that connects but sends nothing is dropped after kCommandTimeout.
+class AdminServer {
+  public:
+    //! Produces the reply to the arguments of a command (the text after its name).
+    using Command = std::function<std::string(std::string_view args)>;
+    using Commands = std::map<std::string, Command, std::less<>>;
+
+    static constexpr auto kCommandTimeout = std::chrono::seconds(1);
+
+    //! Binds \p socketPath and starts serving; throws net::UdsServerError if it cannot bind.
+    //! "help" lists the commands.
+    AdminServer(const std::filesystem::path &socketPath, Commands commands);
+    ~AdminServer();
+
+    AdminServer(const AdminServer &) = delete;
+    AdminServer &operator=(const AdminServer &) = delete;
+
+    void Stop() noexcept;
+
+    //! Reply to one command line; what the admin thread sends back.
+    [[nodiscard]] std::string Execute(std::string_view line) const;
+
+  private:
+    void Run();
+
+    net::UdsServer server_;
+    Commands commands_;
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+};
+
+} // namespace uds_daemon
+
+#endif // ADMIN_SERVER_H_
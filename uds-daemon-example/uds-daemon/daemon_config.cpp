@@ -0,0 +1,341 @@
+#include "daemon_config.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <functional>
+#include <map>
+#include <ranges>
+#include <spdlog/spdlog.h>
+
+namespace uds_daemon {
+
+namespace {
+
+constexpr std::size_t kMinBufferSize = 64;
+constexpr std::size_t kMaxBufferSize = 1024 * 1024;
+constexpr int kMaxBacklog = 65535;
+constexpr std::size_t kMaxSubscriberQueue = 65536;
+// A spin longer than this costs more CPU than a wakeup from poll() costs latency.
+constexpr std::chrono::microseconds kMaxReceiveSpin{10000};
+
+template <typename T>
+T parseNumber(std::string_view key, std::string_view value)
+{
+    T result{};
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (value.empty() || ec != std::errc{} || end != value.data() + value.size())
+        throw DaemonConfigError(std::format("{}: '{}' is not a valid number", key, value));
+    return result;
+}
+
+bool parseBool(std::string_view key, std::string_view value)
+{
+    if (value == "yes" || value == "true" || value == "1")
+        return true;
+    if (value == "no" || value == "false" || value == "0")
+        return false;
+    throw DaemonConfigError(std::format("{}: '{}' is not yes or no", key, value));
+}
+
+utils::CpuSet parseCpus(std::string_view key, std::string_view value)
+{
+    try {
+        return utils::CpuSet::Parse(value);
+    } catch (const utils::CpuAffinityError &e) {
+        throw DaemonConfigError(std::format("{}: {}", key, e.what()));
+    }
+}
+
+spdlog::level::level_enum parseLevel(std::string_view key, std::string_view value)
+{
+    // from_str() maps unknown names to "off"; only accept the real spelling.
+    const auto level = spdlog::level::from_str(std::string(value));
+    if (level == spdlog::level::off && value != "off")
+        throw DaemonConfigError(std::format("{}: unknown log level '{}'", key, value));
+    return level;
+}
+
+constexpr std::array<std::pair<std::string_view, net::SlowSubscriberPolicy>, 3> kPolicies{{
+    {"disconnect", net::SlowSubscriberPolicy::Disconnect},
+    {"drop-oldest", net::SlowSubscriberPolicy::DropOldest},
+    {"conflate", net::SlowSubscriberPolicy::Conflate},
+}};
+
+net::SlowSubscriberPolicy parsePolicy(std::string_view key, std::string_view value)
+{
+    for (const auto &[name, policy] : kPolicies) {
+        if (name == value)
+            return policy;
+    }
+    throw DaemonConfigError(std::format("{}: unknown policy '{}'", key, value));
+}
+
+std::string_view policyName(net::SlowSubscriberPolicy policy)
+{
+    for (const auto &[name, p] : kPolicies) {
+        if (p == policy)
+            return name;
+    }
+    return "unknown";
+}
+
+// "uid:weight,uid:weight"
+std::map<uid_t, double> parseWeights(std::string_view key, std::string_view value)
+{
+    std::map<uid_t, double> weights;
+    for (const auto part : value | std::views::split(',')) {
+        const std::string_view entry(part.begin(), part.end());
+        const auto colon = entry.find(':');
+        if (colon == std::string_view::npos)
+            throw DaemonConfigError(std::format("{}: '{}' is not uid:weight", key, entry));
+        weights[parseNumber<uid_t>(key, entry.substr(0, colon))] =
+            parseNumber<double>(key, entry.substr(colon + 1));
+    }
+    return weights;
+}
+
+std::string formatWeights(const std::map<uid_t, double> &weights)
+{
+    std::string out;
+    for (const auto &[uid, weight] : weights)
+        out += std::format("{}{}:{}", out.empty() ? "" : ",", uid, weight);
+    return out.empty() ? std::string("none") : out;
+}
+
+using Setter = std::function<void(DaemonConfig &, std::string_view key, std::string_view value)>;
+
+const std::vector<std::pair<std::string_view, Setter>> &setters()
+{
+    static const std::vector<std::pair<std::string_view, Setter>> table = {
+        {"log_level",
+         [](DaemonConfig &c, auto key, auto value) { c.logLevel = parseLevel(key, value); }},
+        {"socket_path", [](DaemonConfig &c, auto, auto value) { c.socketPath = value; }},
+        {"admin_socket", [](DaemonConfig &c, auto, auto value) { c.adminSocket = value; }},
+        {"idle_timeout",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.idleTimeout = std::chrono::seconds(parseNumber<unsigned>(key, value));
+         }},
+        {"reap_interval_ms",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.reapInterval = std::chrono::milliseconds(parseNumber<unsigned>(key, value));
+         }},
+        {"max_sessions",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.maxSessions = parseNumber<std::size_t>(key, value);
+         }},
+        {"backlog",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.backlog = parseNumber<int>(key, value);
+         }},
+        {"buffer_size",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.bufferSize = parseNumber<std::size_t>(key, value);
+         }},
+        {"accept_cpus",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.acceptCpus = parseCpus(key, value);
+         }},
+        {"io_cpus",
+         [](DaemonConfig &c, auto key, auto value) { c.server.ioCpus = parseCpus(key, value); }},
+        {"worker_cpus",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.workerCpus = parseCpus(key, value);
+         }},
+        {"response_cache_bytes",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.responseCache.byteBudget = parseNumber<std::size_t>(key, value);
+         }},
+        {"subscriber_queue",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.subscriber.maxQueued = parseNumber<std::size_t>(key, value);
+         }},
+        {"slow_subscriber_policy",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.subscriber.policy = parsePolicy(key, value);
+         }},
+        {"drain_timeout_ms",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.drainTimeout = std::chrono::milliseconds(parseNumber<unsigned>(key, value));
+         }},
+        {"session_rate",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.peerLimits.sessionRate = parseNumber<double>(key, value);
+         }},
+        {"session_burst",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.peerLimits.sessionBurst = parseNumber<double>(key, value);
+         }},
+        {"uid_rate",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.peerLimits.uidRate = parseNumber<double>(key, value);
+         }},
+        {"uid_burst",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.peerLimits.uidBurst = parseNumber<double>(key, value);
+         }},
+        {"uid_weights",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.peerLimits.uidWeights = parseWeights(key, value);
+         }},
+        {"receive_spin_us",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.receiveSpin.spin =
+                 std::chrono::microseconds(parseNumber<unsigned>(key, value));
+         }},
+        {"receive_spin_adaptive",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.receiveSpin.adaptive = parseBool(key, value);
+         }},
+        {"realtime_accept_priority",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.realtime.acceptPriority = parseNumber<int>(key, value);
+         }},
+        {"realtime_io_priority",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.realtime.ioPriority = parseNumber<int>(key, value);
+         }},
+        {"realtime_timer_priority",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.realtime.timerPriority = parseNumber<int>(key, value);
+         }},
+        {"response_cache_ttl_ms",
+         [](DaemonConfig &c, auto key, auto value) {
+             c.server.responseCache.ttl =
+                 std::chrono::milliseconds(parseNumber<unsigned>(key, value));
+         }},
+    };
+    return table;
+}
+
+void checkCpus(std::string_view key, const utils::CpuSet &cpus, const utils::CpuSet &allowed)
+{
+    if (!cpus.IsSubsetOf(allowed))
+        throw DaemonConfigError(std::format("{}: cpus {} not within the allowed cpus {}", key,
+                                            cpus.ToString(), allowed.ToString()));
+}
+
+} // namespace
+
+DaemonConfig ApplyConfigFile(const utils::ConfigFile &file, DaemonConfig base)
+{
+    for (const auto &[key, value] : file.Entries()) {
+        const auto &table = setters();
+        const auto it = std::ranges::find(table, std::string_view(key),
+                                          &std::pair<std::string_view, Setter>::first);
+        if (it == table.end())
+            throw DaemonConfigError(std::format("unknown key '{}'", key));
+        it->second(base, key, value);
+    }
+    return base;
+}
+
+void ValidateConfig(const DaemonConfig &config, const utils::CpuSet &allowedCpus)
+{
+    const auto &server = config.server;
+
+    if (config.socketPath.empty())
+        throw DaemonConfigError("socket_path must not be empty");
+    if (config.adminSocket == config.socketPath)
+        throw DaemonConfigError("admin_socket must differ from socket_path");
+    if (server.reapInterval < std::chrono::milliseconds(10))
+        throw DaemonConfigError("reap_interval_ms must be at least 10");
+    if (server.backlog < 1 || server.backlog > kMaxBacklog)
+        throw DaemonConfigError(std::format("backlog must be within 1..{}", kMaxBacklog));
+    if (server.bufferSize < kMinBufferSize || server.bufferSize > kMaxBufferSize)
+        throw DaemonConfigError(
+            std::format("buffer_size must be within {}..{}", kMinBufferSize, kMaxBufferSize));
+
+    if (server.subscriber.maxQueued < 1 || server.subscriber.maxQueued > kMaxSubscriberQueue)
+        throw DaemonConfigError(
+            std::format("subscriber_queue must be within 1..{}", kMaxSubscriberQueue));
+
+    const auto &limits = server.peerLimits;
+    if (!(limits.sessionRate >= 0) || !(limits.uidRate >= 0))
+        throw DaemonConfigError("session_rate and uid_rate must not be negative");
+    if (!(limits.sessionBurst >= 1) || !(limits.uidBurst >= 1))
+        throw DaemonConfigError("session_burst and uid_burst must be at least 1");
+    for (const auto &[uid, weight] : limits.uidWeights) {
+        if (!(weight > 0))
+            throw DaemonConfigError(std::format("uid_weights: weight of uid {} must be positive",
+                                                uid));
+    }
+
+    if (server.receiveSpin.spin > kMaxReceiveSpin)
+        throw DaemonConfigError(
+            std::format("receive_spin_us must be at most {}", kMaxReceiveSpin.count()));
+
+    const auto &rt = server.realtime;
+    for (const auto &[key, priority] :
+         {std::pair{"realtime_accept_priority", rt.acceptPriority},
+          std::pair{"realtime_io_priority", rt.ioPriority},
+          std::pair{"realtime_timer_priority", rt.timerPriority}}) {
+        if (priority < 1 || priority > utils::kMaxRealtimePriority)
+            throw DaemonConfigError(
+                std::format("{} must be within 1..{}", key, utils::kMaxRealtimePriority));
+    }
+
+    checkCpus("accept_cpus", server.acceptCpus, allowedCpus);
+    checkCpus("io_cpus", server.ioCpus, allowedCpus);
+    checkCpus("worker_cpus", server.workerCpus, allowedCpus);
+}
+
+std::vector<std::string> DescribeChanges(const DaemonConfig &from, const DaemonConfig &to)
+{
+    std::vector<std::string> changes;
+    auto note = [&changes](std::string_view key, const auto &before, const auto &after) {
+        if (before != after)
+            changes.push_back(std::format("{}: {} -> {}", key, before, after));
+    };
+    auto cpus = [](const utils::CpuSet &set) {
+        return set.Empty() ? std::string("all") : set.ToString();
+    };
+    auto level = [](spdlog::level::level_enum l) {
+        const auto name = spdlog::level::to_string_view(l);
+        return std::string(name.data(), name.size());
+    };
+    // Compared as text, which is also how they are written in the file.
+    auto number = [](double v) { return std::format("{}", v); };
+    auto seconds = [](std::chrono::milliseconds d) {
+        return std::chrono::duration_cast<std::chrono::seconds>(d).count();
+    };
+
+    note("log_level", level(from.logLevel), level(to.logLevel));
+    note("socket_path", from.socketPath.string(), to.socketPath.string());
+    note("admin_socket", from.adminSocket.string(), to.adminSocket.string());
+    note("idle_timeout", seconds(from.server.idleTimeout), seconds(to.server.idleTimeout));
+    note("reap_interval_ms", from.server.reapInterval.count(), to.server.reapInterval.count());
+    note("max_sessions", from.server.maxSessions, to.server.maxSessions);
+    note("backlog", from.server.backlog, to.server.backlog);
+    note("buffer_size", from.server.bufferSize, to.server.bufferSize);
+    note("accept_cpus", cpus(from.server.acceptCpus), cpus(to.server.acceptCpus));
+    note("io_cpus", cpus(from.server.ioCpus), cpus(to.server.ioCpus));
+    note("worker_cpus", cpus(from.server.workerCpus), cpus(to.server.workerCpus));
+    note("response_cache_bytes", from.server.responseCache.byteBudget,
+         to.server.responseCache.byteBudget);
+    note("subscriber_queue", from.server.subscriber.maxQueued, to.server.subscriber.maxQueued);
+    note("slow_subscriber_policy", policyName(from.server.subscriber.policy),
+         policyName(to.server.subscriber.policy));
+    note("drain_timeout_ms", from.server.drainTimeout.count(), to.server.drainTimeout.count());
+    const auto &before = from.server.peerLimits;
+    const auto &after = to.server.peerLimits;
+    note("session_rate", number(before.sessionRate), number(after.sessionRate));
+    note("session_burst", number(before.sessionBurst), number(after.sessionBurst));
+    note("uid_rate", number(before.uidRate), number(after.uidRate));
+    note("uid_burst", number(before.uidBurst), number(after.uidBurst));
+    note("uid_weights", formatWeights(before.uidWeights), formatWeights(after.uidWeights));
+    note("receive_spin_us", from.server.receiveSpin.spin.count(),
+         to.server.receiveSpin.spin.count());
+    note("receive_spin_adaptive", from.server.receiveSpin.adaptive,
+         to.server.receiveSpin.adaptive);
+    note("realtime_accept_priority", from.server.realtime.acceptPriority,
+         to.server.realtime.acceptPriority);
+    note("realtime_io_priority", from.server.realtime.ioPriority, to.server.realtime.ioPriority);
+    note("realtime_timer_priority", from.server.realtime.timerPriority,
+         to.server.realtime.timerPriority);
+    note("response_cache_ttl_ms", from.server.responseCache.ttl.count(),
+         to.server.responseCache.ttl.count());
+    return changes;
+}
+
+} // namespace uds_daemon
@@ -0,0 +1,53 @@
+#ifndef DAEMON_CONFIG_H_
+#define DAEMON_CONFIG_H_
+
+#include <config_file.h>
+#include <cpu_affinity.h>
+#include <server_worker.h>
+#include <spdlog/common.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace uds_daemon {
+
+inline constexpr std::string_view kDefaultConfigPath = "/etc/uds-daemon/uds-daemon.conf";
+
+class DaemonConfigError : public std::system_error {
+  public:
+    explicit DaemonConfigError(const std::string &what, int errnum = EINVAL)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//*****************************************************************************
+//! \brief DaemonConfig
+//! Settings of uds-daemon. Everything except the socket paths is re-read on
+//! SIGHUP and applied to the running server.
+struct DaemonConfig {
+    spdlog::level::level_enum logLevel{spdlog::level::info};
+    fs::path socketPath{"/run/sockact-local-a.sock"};
+    //! Operator commands (AdminServer); empty for none.
+    fs::path adminSocket{};
+    net::ServerWorkerOptions server{};
+};
+
+//! Overlays the keys of \p file onto \p base; throws DaemonConfigError on unknown keys and
+//! malformed values.
+DaemonConfig ApplyConfigFile(const utils::ConfigFile &file, DaemonConfig base);
+
+//! Range checks; cpu sets have to lie within \p allowedCpus. Throws DaemonConfigError.
+void ValidateConfig(const DaemonConfig &config, const utils::CpuSet &allowedCpus);
+
+//! "key: old -> new" for every setting that differs.
+std::vector<std::string> DescribeChanges(const DaemonConfig &from, const DaemonConfig &to);
+
+} // namespace uds_daemon
+
+#endif // DAEMON_CONFIG_H_
@@ -0,0 +1,57 @@
+#include "request_capture.h"
+#include <algorithm>
+#include <utility>
+
+namespace net {
+
+void RequestCapture::Start(const std::filesystem::path& path, uint64_t sessionEvery,
+                           uint64_t maxBytes)
+{
+    auto writer = std::make_shared<utils::CaptureWriter>(path, maxBytes);
+    std::shared_ptr<utils::CaptureWriter> previous;
+    {
+        std::lock_guard lock(mutex_);
+        previous = std::exchange(writer_, std::move(writer));
+        sessionEvery_ = std::max<uint64_t>(sessionEvery, 1);
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    // Sessions still holding the previous writer find it closed and drop their requests.
+    if (previous)
+        previous->Close();
+}
+
+std::optional<RequestCaptureStatus> RequestCapture::Stop()
+{
+    std::shared_ptr<utils::CaptureWriter> writer;
+    uint64_t sessionEvery = 1;
+    {
+        std::lock_guard lock(mutex_);
+        writer = std::exchange(writer_, nullptr);
+        sessionEvery = sessionEvery_;
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    if (!writer)
+        return std::nullopt;
+    writer->Close();
+    return RequestCaptureStatus{
+        .path = writer->Path(), .sessionEvery = sessionEvery, .stats = writer->Stats()};
+}
+
+std::optional<RequestCaptureStatus> RequestCapture::Status() const
+{
+    std::lock_guard lock(mutex_);
+    if (!writer_)
+        return std::nullopt;
+    return RequestCaptureStatus{
+        .path = writer_->Path(), .sessionEvery = sessionEvery_, .stats = writer_->Stats()};
+}
+
+std::shared_ptr<utils::CaptureWriter> RequestCapture::ForSession(uint64_t id) const
+{
+    std::lock_guard lock(mutex_);
+    if (!writer_ || id % sessionEvery_ != 0)
+        return nullptr;
+    return writer_;
+}
+
+} // namespace net
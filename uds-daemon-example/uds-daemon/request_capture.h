@@ -0,0 +1,56 @@
+#ifndef NET_REQUEST_CAPTURE_H_
+#define NET_REQUEST_CAPTURE_H_
+
+#include <capture_file.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace net {
+
+struct RequestCaptureStatus {
+    std::filesystem::path path;
+    //! Every how many sessions one is recorded.
+    uint64_t sessionEvery{1};
+    utils::CaptureStats stats{};
+};
+
+//*****************************************************************************
+//! \brief RequestCapture
+//! Switches request capture of a server on and off at runtime. Sessions are
+//! sampled as a whole (by id), so a replay sees complete conversations; a
+//! session notices a start or stop with one atomic load per request.
+class RequestCapture {
+  public:
+    //! Records every \p sessionEvery-th session to \p path, at most \p maxBytes; replaces a
+    //! capture already running. Throws utils::CaptureFileError.
+    void Start(const std::filesystem::path& path, uint64_t sessionEvery, uint64_t maxBytes);
+
+    //! Flushes and closes the capture file; nullopt if no capture was running.
+    std::optional<RequestCaptureStatus> Stop();
+
+    [[nodiscard]] std::optional<RequestCaptureStatus> Status() const;
+
+    //! Changes whenever a capture starts or stops.
+    [[nodiscard]] uint64_t Generation() const noexcept
+    {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    //! Where session \p id records its requests; nullptr if it is not sampled or no capture runs.
+    [[nodiscard]] std::shared_ptr<utils::CaptureWriter> ForSession(uint64_t id) const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<utils::CaptureWriter> writer_;
+    uint64_t sessionEvery_{1};
+    std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace net
+
+#endif // NET_REQUEST_CAPTURE_H_
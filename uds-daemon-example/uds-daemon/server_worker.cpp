@@ -1,13 +1,102 @@
 #include "server_worker.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <request_trace.h>
+#include <sd_notify.h>
 #include <spdlog/spdlog.h>
+#include <string.h>
+#include <usdt.h>
 
 namespace net {
 
-UdsServerWorker::UdsServerWorker(UdsServer&& server)
- : udsServer_(std::move(server)), running_(true)
+namespace {
+
+void pinThread(std::string_view role, const utils::CpuSet& cpus)
+{
+    try {
+        utils::PinCurrentThread(cpus);
+        spdlog::info("{} thread running on {}", role,
+                     utils::DescribeAffinity(utils::CpuSet::OfCurrentThread()));
+    } catch (const utils::CpuAffinityError& e) {
+        spdlog::warn("{} thread: {}", role, e.what());
+    }
+}
+
+// Applied alongside the cpu placement, so a reload of the priorities takes effect the same way.
+void raisePriority(std::string_view role, const RealtimeOptions& realtime, int priority)
+{
+    if (!realtime.enabled)
+        return;
+    try {
+        utils::SetCurrentThreadPriority(priority);
+        spdlog::info("{} thread running at SCHED_FIFO priority {}", role, priority);
+    } catch (const utils::RealtimeError& e) {
+        spdlog::warn("{} thread: {}", role, e.what());
+    }
+    utils::PrefaultStack();
+}
+
+bool rateLimited(const PeerLimits& limits) noexcept
 {
+    return limits.sessionRate > 0 || limits.uidRate > 0;
+}
+
+// How often a drain checks whether the sessions finished.
+constexpr auto kDrainPoll = std::chrono::milliseconds(5);
+
+} // namespace
+
+std::string SessionFdName(const SessionState& state)
+{
+    return std::format("{}{}-{}", kSessionFdPrefix, state.id, state.replies);
+}
+
+std::optional<SessionState> ParseSessionFdName(std::string_view name) noexcept
+{
+    if (!name.starts_with(kSessionFdPrefix))
+        return std::nullopt;
+    name.remove_prefix(kSessionFdPrefix.size());
+
+    SessionState state;
+    const char* end = name.data() + name.size();
+    auto [sep, ec] = std::from_chars(name.data(), end, state.id);
+    if (ec != std::errc{} || sep == end || *sep != '-')
+        return std::nullopt;
+
+    auto [last, ec2] = std::from_chars(sep + 1, end, state.replies);
+    if (ec2 != std::errc{} || last != end)
+        return std::nullopt;
+    return state;
+}
+
+UdsServerWorker::UdsServerWorker(UdsServer&& server, const ServerWorkerOptions& options)
+ : udsServer_(std::move(server))
+ , allowedCpus_(utils::CpuSet::OfCurrentThread())
+ , responseCache_(std::make_unique<utils::ResponseCache>(options.responseCache))
+ , broker_(std::make_unique<Broker>())
+ , limiter_(std::make_unique<PeerRateLimiter>(options.peerLimits))
+ , capture_(std::make_unique<RequestCapture>())
+ , options_(options)
+ , sessionOptions_(SessionOptionsOf(options))
+ , running_(true)
+ , applied_(options)
+{
+    timerFdSet_.AddFd(timers_.Fd());
+    reapTimer_ =
+        timers_.SchedulePeriodic(applied_.reapInterval, [this]() { ReapFinishedSessions(); });
+}
+
+void UdsServerWorker::Start()
+{
+    if (!running_ || acceptThread_.joinable())
+        return;
+
+    timerThread_ = std::thread(&UdsServerWorker::TimerLoop, this);
     acceptThread_ = std::thread(&UdsServerWorker::AcceptLoop, this);
-    spdlog::info("UdsServerWorker started (socket: {})", udsServer_.SocketPath().string());
+    spdlog::info("UdsServerWorker started (socket: {}, idle timeout: {} ms)",
+                 udsServer_.SocketPath().string(), applied_.idleTimeout.count());
 }
 
 UdsServerWorker::~UdsServerWorker()
@@ -17,24 +106,112 @@ UdsServerWorker::~UdsServerWorker()
 
 void UdsServerWorker::Stop() noexcept
 {
-    if (!running_.exchange(false))
+    if (!StopThreads())
         return; // already stopped
 
+    DrainSessions(applied_.drainTimeout);
+    DeleteSessions();
+
+    if (applied_.responseCache.byteBudget > 0) {
+        const auto stats = responseCache_->Stats();
+        spdlog::info("Response cache: {} hits, {} misses, {} evictions, {} expired", stats.hits,
+                     stats.misses, stats.evictions, stats.expirations);
+    }
+
+    for (const auto& peer : limiter_->Stats()) {
+        if (peer.throttled == 0)
+            continue;
+        spdlog::info("uid {}: {} of {} requests throttled, {} ms delay in total", peer.uid,
+                     peer.throttled, peer.requests,
+                     std::chrono::duration_cast<std::chrono::milliseconds>(peer.delayed).count());
+    }
+}
+
+bool UdsServerWorker::StopThreads() noexcept
+{
+    if (!running_.exchange(false))
+        return false;
+
     spdlog::info("Stopping UdsServerWorker...");
     udsServer_.Unblock();
 
     if (acceptThread_.joinable())
         acceptThread_.join();
 
-    spdlog::debug("Cleaning up session workers...");
-    workers_.clear();
+    timerFdSet_.UnBlock();
+    if (timerThread_.joinable())
+        timerThread_.join();
+    return true;
+}
+
+void UdsServerWorker::Adopt(SocketSession&& session, const SessionState& state)
+{
+    // Ids of new sessions continue after the ones handed over.
+    uint64_t next = nextSessionId_.load();
+    while (next <= state.id && !nextSessionId_.compare_exchange_weak(next, state.id + 1)) {
+    }
+
+    spdlog::info("Resumed session {} (fd={}, {} replies sent)", state.id, session.getFd(),
+                 state.replies);
+    AddSession(std::move(session), state);
+}
+
+std::size_t UdsServerWorker::HandOff(bool includeListener) noexcept
+{
+    if (!StopThreads())
+        return 0;
+
+    // Each session answers the request it is processing before its thread leaves.
+    DrainSessions(applied_.drainTimeout);
+
+    std::size_t budget = systemd_notify::fdStoreLimit();
+    if (includeListener && budget > 0) {
+        const std::array fds{udsServer_.ServerSocket().getFd()};
+        if (systemd_notify::storeFds(kListenerFdName, fds)) {
+            udsServer_.KeepSocketPath();
+            --budget;
+        }
+    }
+
+    std::size_t handedOff = 0;
+    for (auto& s : sessions_) {
+        auto& worker = *s.worker;
+        worker.Stop(); // drained, the join is immediate
+        if (worker.Disconnected() || s.expired || s.forced)
+            continue;
+
+        if (handedOff == budget) {
+            spdlog::warn("fd store full, closing session {}", worker.State().id);
+            continue;
+        }
+
+        const std::array fds{worker.Fd()};
+        if (systemd_notify::storeFds(SessionFdName(worker.State()), fds))
+            ++handedOff;
+    }
+
+    // Our copies are closed here; the fd store keeps the connections alive.
+    DeleteSessions();
+    spdlog::info("Handed over {} session(s)", handedOff);
+    return handedOff;
 }
 
 void UdsServerWorker::AcceptLoop()
 {
+    utils::Snapshot<ServerWorkerOptions>::Reader options(options_);
+    pinThread("Accept", Placement(options->acceptCpus));
+    raisePriority("Accept", options->realtime, options->realtime.acceptPriority);
     spdlog::info("Accept thread started — waiting for clients...");
     while (running_) {
         auto sessionResult = udsServer_.WaitForConnection();
+        // Every connection is traced while tracing is on; sampling applies to requests.
+        const bool traced = utils::RequestTrace::Enabled();
+        const auto accepted = traced ? std::chrono::steady_clock::now()
+                                     : std::chrono::steady_clock::time_point{};
+        if (options.Refresh()) {
+            pinThread("Accept", Placement(options->acceptCpus));
+            raisePriority("Accept", options->realtime, options->realtime.acceptPriority);
+        }
 
         if (!sessionResult) {
             if (sessionResult.error() == std::errc::operation_canceled) {
@@ -46,11 +223,263 @@ void UdsServerWorker::AcceptLoop()
             continue;
         }
 
-        spdlog::info("New client connected (fd={})", sessionResult->getFd());
-        workers_.push_back(std::make_unique<SocketSessionWorker>(std::move(*sessionResult)));
+        if (!AdmitSession(options->maxSessions)) {
+            spdlog::warn("Session limit of {} reached, closing new connection (fd={})",
+                         options->maxSessions, sessionResult->getFd());
+            continue;
+        }
+
+        if (const auto& peer = sessionResult->peerCredentials())
+            spdlog::info("New client connected (fd={}, pid={}, uid={}, gid={})",
+                         sessionResult->getFd(), peer->pid, peer->uid, peer->gid);
+        else
+            spdlog::info("New client connected (fd={})", sessionResult->getFd());
+        const uint64_t id = nextSessionId_++;
+        UDS_PROBE(session_accept, id, sessionResult->getFd());
+        AddSession(std::move(*sessionResult), SessionState{.id = id, .replies = 0});
+        if (traced)
+            utils::RequestTrace::Record("accept", id, accepted, std::chrono::steady_clock::now());
     }
 
     spdlog::info("Accept thread exiting...");
 }
 
+void UdsServerWorker::TimerLoop()
+{
+    utils::Snapshot<ServerWorkerOptions>::Reader options(options_);
+    pinThread("Timer", Placement(options->workerCpus));
+    raisePriority("Timer", options->realtime, options->realtime.timerPriority);
+    spdlog::debug("Timer thread started");
+    while (running_) {
+        if (timerFdSet_.Select() == utils::FdSetRet::UNBLOCK)
+            break;
+
+        if (options.Refresh()) {
+            pinThread("Timer", Placement(options->workerCpus));
+            raisePriority("Timer", options->realtime, options->realtime.timerPriority);
+        }
+
+        std::lock_guard lock(mutex_);
+        timers_.OnReadable();
+    }
+    spdlog::debug("Timer thread exiting...");
+}
+
+void UdsServerWorker::AddSession(SocketSession&& session, const SessionState& state)
+{
+    auto entry = std::make_unique<Session>(
+        std::make_unique<SocketSessionWorker>(std::move(session), sessionOptions_, state));
+    entry->repliesBefore = state.replies;
+    sessionsAdded_.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard lock(mutex_);
+        sessions_.push_back(*entry);
+        auto& linked = *entry.release(); // owned by sessions_ from here on
+
+        if (applied_.idleTimeout > std::chrono::milliseconds::zero())
+            ArmIdleTimer(linked, applied_.idleTimeout);
+    }
+    broker_->Publish(kSessionsTopic, std::format("opened {}", state.id));
+}
+
+bool UdsServerWorker::AdmitSession(std::size_t maxSessions)
+{
+    if (maxSessions == 0)
+        return true;
+
+    std::lock_guard lock(mutex_);
+    if (sessions_.size() >= maxSessions)
+        ReapFinishedSessions(); // do not count sessions that already ended
+    return sessions_.size() < maxSessions;
+}
+
+void UdsServerWorker::Reconfigure(const ServerWorkerOptions& options)
+{
+    {
+        std::lock_guard lock(mutex_);
+
+        if (options.backlog != applied_.backlog && !udsServer_.SetBacklog(options.backlog))
+            spdlog::error("Failed to set backlog {}: {}", options.backlog, strerror(errno));
+
+        if (options.reapInterval != applied_.reapInterval) {
+            timers_.Cancel(reapTimer_);
+            reapTimer_ = timers_.SchedulePeriodic(options.reapInterval,
+                                                  [this]() { ReapFinishedSessions(); });
+        }
+
+        if (options.idleTimeout != applied_.idleTimeout) {
+            // Re-time every session against the new limit, keeping the idle time it has so far.
+            for (auto& s : sessions_) {
+                timers_.Cancel(s.idleTimer);
+                s.idleTimer = {};
+                if (options.idleTimeout > std::chrono::milliseconds::zero() &&
+                    !s.worker->IsFinished()) {
+                    const auto remaining = options.idleTimeout - s.worker->IdleFor();
+                    ArmIdleTimer(s, std::max(remaining, std::chrono::steady_clock::duration{}));
+                }
+            }
+        }
+        applied_ = options;
+    }
+
+    // Cached answers may predate the new settings.
+    responseCache_->Reconfigure(options.responseCache);
+    responseCache_->InvalidateAll();
+    limiter_->Reconfigure(options.peerLimits);
+
+    // Threads pick these up on their next connection, message or tick.
+    options_.Publish(options);
+    sessionOptions_.Publish(SessionOptionsOf(options));
+}
+
+std::size_t UdsServerWorker::Publish(std::string_view topic, std::string_view payload)
+{
+    return broker_->Publish(topic, payload);
+}
+
+void UdsServerWorker::InvalidateResponses()
+{
+    responseCache_->InvalidateAll();
+}
+
+utils::ResponseCacheStats UdsServerWorker::ResponseCacheStats() const
+{
+    return responseCache_->Stats();
+}
+
+ServerWorkerStats UdsServerWorker::Stats() const
+{
+    std::lock_guard lock(mutex_);
+    ServerWorkerStats stats{.sessions = sessionsAdded_.load(std::memory_order_relaxed),
+                            .activeSessions = 0,
+                            .requests = repliesOfClosed_};
+    for (const auto& s : sessions_) {
+        stats.requests += s.worker->State().replies - s.repliesBefore;
+        if (!s.worker->IsFinished())
+            ++stats.activeSessions;
+    }
+    return stats;
+}
+
+std::vector<ThrottleStats> UdsServerWorker::PeerThrottleStats() const
+{
+    return limiter_->Stats();
+}
+
+const utils::CpuSet& UdsServerWorker::Placement(const utils::CpuSet& cpus) const noexcept
+{
+    return cpus.Empty() ? allowedCpus_ : cpus;
+}
+
+SessionOptions UdsServerWorker::SessionOptionsOf(const ServerWorkerOptions& options) const
+{
+    const bool caching = options.responseCache.byteBudget > 0 && options.handler.cacheable;
+    return SessionOptions{.bufferSize = options.bufferSize,
+                          .cpus = Placement(options.ioCpus),
+                          .cpusConfigured = !options.ioCpus.Empty(),
+                          .handler = options.handler,
+                          .cache = caching ? responseCache_.get() : nullptr,
+                          .broker = broker_.get(),
+                          .subscriber = options.subscriber,
+                          .limiter = rateLimited(options.peerLimits) ? limiter_.get() : nullptr,
+                          .sessionRate = options.peerLimits.sessionRate,
+                          .sessionBurst = options.peerLimits.sessionBurst,
+                          .spin = options.receiveSpin,
+                          .priority = options.realtime.enabled ? options.realtime.ioPriority : 0,
+                          .capture = capture_.get()};
+}
+
+void UdsServerWorker::ArmIdleTimer(Session& session, std::chrono::steady_clock::duration delay)
+{
+    // Traffic only stamps the worker's last activity; the timer compares against it when it fires
+    // and re-arms itself for the remainder, so no wheel operation is needed per message. The
+    // session outlives the timer: reaping cancels it under mutex_ before the session is freed.
+    session.idleTimer = timers_.Schedule(delay, [this, &session]() {
+        const auto& worker = *session.worker;
+        if (worker.IsFinished())
+            return;
+
+        const auto timeout = applied_.idleTimeout;
+        if (timeout <= std::chrono::milliseconds::zero())
+            return; // disabled by a reload
+
+        const auto idle = worker.IdleFor();
+        if (idle >= timeout) {
+            spdlog::info("Closing idle session (fd={}, idle {} ms)", worker.Fd(),
+                         std::chrono::duration_cast<std::chrono::milliseconds>(idle).count());
+            session.expired = true;
+            session.worker->RequestStop();
+            return;
+        }
+        ArmIdleTimer(session, timeout - idle);
+    });
+}
+
+void UdsServerWorker::ReapFinishedSessions()
+{
+    std::size_t reaped = 0;
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (!it->worker->IsFinished()) {
+            ++it;
+            continue;
+        }
+        timers_.Cancel(it->idleTimer);
+        it->worker->Stop(); // thread already left Run(), join is immediate
+        repliesOfClosed_ += it->worker->State().replies - it->repliesBefore;
+        broker_->Publish(kSessionsTopic, std::format("closed {}", it->worker->State().id));
+        it = sessions_.erase_and_dispose(it, std::default_delete<Session>());
+        ++reaped;
+    }
+
+    if (reaped > 0)
+        spdlog::debug("Reaped {} finished session(s), {} active", reaped, sessions_.size());
+}
+
+std::size_t UdsServerWorker::DrainSessions(std::chrono::milliseconds timeout) noexcept
+{
+    // Runs after StopThreads(), nothing else touches sessions_ any more.
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto deadline = start + timeout;
+
+    // All at once: the sessions wind down in parallel, so the drain takes as long as the slowest
+    // request, not the sum of them.
+    for (auto& s : sessions_)
+        s.worker->RequestStop();
+
+    // Finishing is final, so each session is checked until it is done and never again.
+    auto pending = sessions_.begin();
+    for (;;) {
+        while (pending != sessions_.end() && pending->worker->IsFinished())
+            ++pending;
+        const auto now = Clock::now();
+        if (pending == sessions_.end() || now >= deadline)
+            break;
+        std::this_thread::sleep_for(std::min<Clock::duration>(kDrainPoll, deadline - now));
+    }
+
+    std::size_t forced = 0;
+    for (auto it = pending; it != sessions_.end(); ++it) {
+        if (it->worker->IsFinished())
+            continue;
+        it->worker->ForceClose();
+        it->forced = true;
+        ++forced;
+    }
+
+    const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+    if (forced > 0)
+        spdlog::warn("Drained {} session(s) in {} ms, {} still busy after {} ms were closed",
+                     sessions_.size(), took.count(), forced, timeout.count());
+    else
+        spdlog::info("Drained {} session(s) in {} ms", sessions_.size(), took.count());
+    return forced;
+}
+
+void UdsServerWorker::DeleteSessions() noexcept
+{
+    sessions_.clear_and_dispose(std::default_delete<Session>());
+}
+
 } // namespace net
@@ -1,19 +1,96 @@
 #ifndef NET_UDS_SERVER_WORKER_H_
 #define NET_UDS_SERVER_WORKER_H_
 
+#include <cpu_affinity.h>
+#include <intrusive_list.h>
+#include <request_capture.h>
+#include <snapshot.h>
 #include <uds_server.h>
 #include <socket_session_worker.h>
+#include <timer_wheel.h>
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 namespace net {
 
+//! fd store name of a listening socket bound by the daemon itself.
+inline constexpr std::string_view kListenerFdName = "uds-listener";
+//! fd store names of handed over sessions: "session-<id>-<replies>".
+inline constexpr std::string_view kSessionFdPrefix = "session-";
+
+std::string SessionFdName(const SessionState& state);
+std::optional<SessionState> ParseSessionFdName(std::string_view name) noexcept;
+
+//! SCHED_FIFO priorities (1..99) of the worker's threads; the session I/O threads are the ones
+//! on the request path.
+struct RealtimeOptions {
+    //! Set by --realtime; without it every thread runs under the normal scheduler.
+    bool enabled{false};
+    int acceptPriority{30};
+    int ioPriority{40};
+    int timerPriority{20};
+};
+
+struct ServerWorkerOptions {
+    //! Sessions without traffic for this long are closed; zero disables the idle timeout.
+    std::chrono::milliseconds idleTimeout{std::chrono::minutes(5)};
+    //! How often finished sessions are reaped.
+    std::chrono::milliseconds reapInterval{std::chrono::seconds(1)};
+    //! Connections beyond this many sessions are closed right away; zero means unlimited.
+    std::size_t maxSessions{0};
+    //! Accept queue length, applied to the listening socket on Reconfigure().
+    int backlog{UdsServer::defaultBacklog};
+    //! Receive buffer size of each session.
+    std::size_t bufferSize{1024};
+    //! CPUs of the accept thread, the per-session I/O threads and the timer (worker) thread;
+    //! an empty set allows every CPU the daemon was started with.
+    utils::CpuSet acceptCpus{};
+    utils::CpuSet ioCpus{};
+    utils::CpuSet workerCpus{};
+    //! Answers every session with this handler.
+    RequestHandler handler{EchoHandler()};
+    //! Budget and TTL of the cache shared by cacheable handlers; a zero budget turns it off.
+    utils::ResponseCacheOptions responseCache{};
+    //! Event queue of each subscribed session.
+    SubscriberOptions subscriber{};
+    //! How long Stop() and HandOff() let sessions finish the request in hand before their
+    //! connections are cut; keep it well below the unit's TimeoutStopSec.
+    std::chrono::milliseconds drainTimeout{std::chrono::seconds(5)};
+    //! Request rate limits per session and per client uid (SO_PEERCRED).
+    PeerLimits peerLimits{};
+    //! Busy polling of each session's receive before it parks; zero spin turns it off.
+    SpinPolicy receiveSpin{};
+    RealtimeOptions realtime{};
+};
+
+struct ServerWorkerStats {
+    //! Sessions accepted or adopted since the worker started.
+    uint64_t sessions{0};
+    uint64_t activeSessions{0};
+    //! Replies sent by this worker.
+    uint64_t requests{0};
+};
+
+//! Topic of the session lifecycle events ("opened <id>", "closed <id>").
+inline constexpr std::string_view kSessionsTopic = "sessions";
+
+//*****************************************************************************
+//! \brief UdsServerWorker
+//! Serves the connections of a listening socket, one I/O thread per session.
+//! Nothing is accepted before Start(), so that the sessions a previous process
+//! handed over can be Adopt()ed first and new session ids continue after theirs.
 class UdsServerWorker {
   public:
-    explicit UdsServerWorker(UdsServer&& server);
+    explicit UdsServerWorker(UdsServer&& server, const ServerWorkerOptions& options = {});
     ~UdsServerWorker();
 
     UdsServerWorker(const UdsServerWorker&) = delete;
@@ -22,15 +99,96 @@ class UdsServerWorker {
     UdsServerWorker(UdsServerWorker&&) noexcept = default;
     UdsServerWorker& operator=(UdsServerWorker&&) noexcept = default;
 
+    //! Starts the timer and accept threads; has no effect once started or stopped.
+    void Start();
+
+    //! Stops accepting, then drains: every session is asked to stop at once and may finish the
+    //! request it is processing until the drain timeout; the ones still busy after that are
+    //! closed forcibly.
     void Stop() noexcept;
 
+    //! Continues a session handed over by a previous daemon process; call it before Start().
+    void Adopt(SocketSession&& session, const SessionState& state);
+
+    //! Stops like Stop() but keeps the client connections open: every live session is parked in
+    //! the systemd fd store together with its state, optionally along with the listening socket,
+    //! so the next process can resume them. Returns the number of sessions handed over.
+    std::size_t HandOff(bool includeListener) noexcept;
+
+    //! Applies new options to the running server without touching established sessions:
+    //! limits and placement take effect on the next connection, message or timer tick.
+    void Reconfigure(const ServerWorkerOptions& options);
+
+    //! Queues \p payload to every session subscribed to \p topic; returns how many there were.
+    std::size_t Publish(std::string_view topic, std::string_view payload);
+
+    //! Drops every cached response, e.g. after the state the handlers report on changed.
+    void InvalidateResponses();
+    [[nodiscard]] utils::ResponseCacheStats ResponseCacheStats() const;
+
+    //! Records incoming requests of sampled sessions to a capture file for `udsctl replay`.
+    [[nodiscard]] RequestCapture& Capture() noexcept { return *capture_; }
+
+    [[nodiscard]] ServerWorkerStats Stats() const;
+
+    //! Requests and throttle counters per client uid.
+    [[nodiscard]] std::vector<ThrottleStats> PeerThrottleStats() const;
+
   private:
+    // Heap allocated and linked into sessions_, so the address stays stable for the idle timer
+    // and a session is dropped from the table in O(1).
+    struct Session : utils::IntrusiveListHook<> {
+        explicit Session(std::unique_ptr<SocketSessionWorker> w) noexcept
+         : worker(std::move(w))
+        {
+        }
+
+        std::unique_ptr<SocketSessionWorker> worker;
+        //! Replies already sent when the session came to this process.
+        uint64_t repliesBefore{0};
+        utils::TimerId idleTimer;
+        bool expired{false};
+        //! Cut by a drain that ran out of time; not handed over.
+        bool forced{false};
+    };
+
     void AcceptLoop();
+    void TimerLoop();
+    bool StopThreads() noexcept;
+
+    const utils::CpuSet& Placement(const utils::CpuSet& cpus) const noexcept;
+    SessionOptions SessionOptionsOf(const ServerWorkerOptions& options) const;
+    bool AdmitSession(std::size_t maxSessions);
+
+    void AddSession(SocketSession&& session, const SessionState& state);
+    void ArmIdleTimer(Session& session, std::chrono::steady_clock::duration delay);
+    void ReapFinishedSessions();
+    std::size_t DrainSessions(std::chrono::milliseconds timeout) noexcept;
+    void DeleteSessions() noexcept;
 
     UdsServer udsServer_;
+    utils::CpuSet allowedCpus_;
+    std::unique_ptr<utils::ResponseCache> responseCache_;
+    std::unique_ptr<Broker> broker_;
+    std::unique_ptr<PeerRateLimiter> limiter_;
+    std::unique_ptr<RequestCapture> capture_;
+    utils::Snapshot<ServerWorkerOptions> options_;
+    SessionOptionsSnapshot sessionOptions_;
     std::atomic<bool> running_{false};
+    std::atomic<uint64_t> nextSessionId_{1};
+    std::atomic<uint64_t> sessionsAdded_{0};
     std::thread acceptThread_;
-    std::vector<std::unique_ptr<SocketSessionWorker>> workers_;
+
+    // Guards sessions_, timers_, applied_ and repliesOfClosed_; the timer thread runs wheel
+    // callbacks with it held.
+    mutable std::mutex mutex_;
+    utils::IntrusiveList<Session> sessions_;
+    uint64_t repliesOfClosed_{0};
+    ServerWorkerOptions applied_;
+    utils::TimerWheel timers_;
+    utils::TimerId reapTimer_;
+    utils::FdSet timerFdSet_;
+    std::thread timerThread_;
 };
 
 } // namespace net
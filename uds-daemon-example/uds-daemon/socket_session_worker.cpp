@@ -1,53 +1,385 @@
 #include "socket_session_worker.h"
-#include <array>
+#include <algorithm>
+#include <charconv>
 #include <span>
 #include <spdlog/spdlog.h>
 #include <format>
 #include <byte_util.h>
+#include <hot_log.h>
+#include <request_trace.h>
+#include <usdt.h>
 
 namespace net {
 
-SocketSessionWorker::SocketSessionWorker(SocketSession &&session)
+namespace {
+
+// Longest uninterrupted throttle sleep; bounds how long a stop request waits for a session.
+constexpr auto kThrottleSlice = std::chrono::milliseconds(20);
+// "Message Received" lines per second over all sessions; the rest are counted, not written.
+constexpr double kMessageLogRate = 100;
+
+using Clock = SocketSessionWorker::Clock;
+
+// Span boundaries of one traced request, in order.
+struct RequestMarks {
+    Clock::time_point waiting;
+    Clock::time_point ready;
+    Clock::time_point received;
+    Clock::time_point handling;
+    Clock::time_point sending;
+};
+
+void traceRequest(uint64_t session, const RequestMarks &marks)
+{
+    using utils::RequestTrace;
+    const auto sent = Clock::now();
+    // Not stamped if the data was there before the receive looked.
+    const auto ready = std::clamp(marks.ready, marks.waiting, marks.received);
+    RequestTrace::Record("wait", session, marks.waiting, ready);
+    RequestTrace::Record("request", session, ready, sent);
+    RequestTrace::Record("recv", session, ready, marks.received);
+    RequestTrace::Record("dispatch", session, marks.received, marks.handling);
+    RequestTrace::Record("handler", session, marks.handling, marks.sending);
+    RequestTrace::Record("send", session, marks.sending, sent);
+}
+
+// "<count> <text>": text repeated count times, written a block of whole repetitions at a time.
+void repeatText(std::string_view request, ChunkWriter &out)
+{
+    const auto space = request.find(' ');
+    const std::string_view number = request.substr(0, space);
+    const std::string_view text =
+        space == std::string_view::npos ? std::string_view{} : request.substr(space + 1);
+    uint64_t count = 0;
+    const auto [end, ec] = std::from_chars(number.data(), number.data() + number.size(), count);
+    if (ec != std::errc{} || end != number.data() + number.size() || text.empty()) {
+        out.Fail("error: usage: stream <credits> <count> <text>");
+        return;
+    }
+
+    const uint64_t perBlock = std::max<uint64_t>(kMaxChunkSize / text.size(), 1);
+    std::string block;
+    for (uint64_t i = 0; i < std::min(perBlock, count); ++i)
+        block += text;
+    for (; count >= perBlock; count -= perBlock) {
+        if (!out.Write(block))
+            return;
+    }
+    out.Write(std::string_view(block).substr(0, count * text.size()));
+}
+
+} // namespace
+
+RequestHandler EchoHandler()
+{
+    return RequestHandler{
+        .handle =
+            [](std::string_view request, const SessionState &state, std::string &reply) {
+                reply = std::format("{}-replay {}", state.replies, request);
+            },
+        .cacheable = false,
+        .stream = [](std::string_view request, const SessionState &,
+                     ChunkWriter &out) { repeatText(request, out); }};
+}
+
+SocketSessionWorker::SocketSessionWorker(SocketSession &&session,
+                                         const SessionOptionsSnapshot &options, SessionState state)
  : session_(std::move(session))
+ , id_(state.id)
+ , replies_(state.replies)
  , running_(true)
+ , lastActivity_(Clock::now().time_since_epoch().count())
+ , options_(options)
  , thread_(&SocketSessionWorker::Run, this)
 {
-    spdlog::debug("SessionWorker started (fd={})", session_.getFd());
+    spdlog::debug("SessionWorker started (fd={}, session={})", session_.getFd(), id_);
 }
 
 SocketSessionWorker::~SocketSessionWorker() { Stop(); }
 
+void SocketSessionWorker::RequestStop() noexcept
+{
+    if (running_.exchange(false))
+        session_.unblockReceive();
+}
+
+void SocketSessionWorker::ForceClose() noexcept
+{
+    RequestStop();
+    session_.shutdown();
+}
+
 void SocketSessionWorker::Stop() noexcept
 {
-    if (!running_.exchange(false))
+    RequestStop();
+
+    if (!thread_.joinable())
         return;
 
-    session_.unblockReceive();
+    thread_.join();
+    spdlog::debug("SessionWorker stopped");
+}
 
-    if (thread_.joinable())
-        thread_.join();
+bool SocketSessionWorker::IsFinished() const noexcept
+{
+    return finished_.load(std::memory_order_acquire);
+}
 
-    spdlog::debug("SessionWorker stopped");
+SocketSessionWorker::Clock::duration SocketSessionWorker::IdleFor() const noexcept
+{
+    const Clock::time_point last{
+        Clock::duration(lastActivity_.load(std::memory_order_relaxed))};
+    return Clock::now() - last;
+}
+
+bool SocketSessionWorker::Disconnected() const noexcept
+{
+    return disconnected_.load(std::memory_order_acquire);
 }
 
-void SocketSessionWorker::Run() const
+SessionState SocketSessionWorker::State() const noexcept
 {
-    std::array<std::byte, 1024> buffer{};
-    int rcvCount = 0;
+    return SessionState{.id = id_, .replies = replies_.load(std::memory_order_relaxed)};
+}
+
+int SocketSessionWorker::Fd() const noexcept { return session_.getFd(); }
+
+void SocketSessionWorker::ApplyOptions(const SessionOptions &options,
+                                       std::vector<std::byte> &buffer, std::string &reply)
+{
+    // Session threads start out on the cpus of the thread that created them. Without io_cpus
+    // that is usually where they belong already; otherwise they move quietly, and only a
+    // configured placement is worth a line.
+    try {
+        if (options.cpusConfigured) {
+            utils::PinCurrentThread(options.cpus);
+            spdlog::info("Session {}: I/O thread running on {}", id_,
+                         utils::DescribeAffinity(utils::CpuSet::OfCurrentThread()));
+        } else if (!(utils::CpuSet::OfCurrentThread() == options.cpus)) {
+            utils::PinCurrentThread(options.cpus);
+        }
+    } catch (const utils::CpuAffinityError &e) {
+        spdlog::warn("Session {}: {}", id_, e.what());
+    }
+
+    if (buffer.size() != options.bufferSize)
+        buffer = std::vector<std::byte>(options.bufferSize);
+
+    if (options.priority > 0) {
+        // The daemon reported missing privileges at startup already; once per session is noise.
+        try {
+            utils::SetCurrentThreadPriority(options.priority);
+        } catch (const utils::RealtimeError &e) {
+            spdlog::debug("Session {}: {}", id_, e.what());
+        }
+        utils::PrefaultStack();
+        // Room for an echo of a full buffer, written once so its pages are in place; clear()
+        // keeps the capacity. The receive buffer was zero filled when it was allocated.
+        reply.resize(options.bufferSize + 64);
+        reply.clear();
+    }
+
+    session_.setSpinPolicy(options.spin);
+    sessionBucket_.Reconfigure(options.sessionRate, options.sessionBurst);
+    if (options.limiter != nullptr && !account_) {
+        const auto &peer = session_.peerCredentials();
+        account_ = options.limiter->AccountOf(peer ? peer->uid : kUnknownUid);
+    }
+}
+
+void SocketSessionWorker::Throttle(const SessionOptions &options)
+{
+    if (options.limiter == nullptr)
+        return;
+
+    // The request is held back, not rejected: a client over its share gets slower replies and
+    // its unread requests queue up in its own socket buffer. A stop request cuts the wait short,
+    // so a shutdown or handover still answers the request in hand.
+    const auto until = Clock::now() + options.limiter->Admit(*account_, sessionBucket_);
+    for (auto left = until - Clock::now(); left > Clock::duration::zero() && running_;
+         left = until - Clock::now())
+        std::this_thread::sleep_for(std::min<Clock::duration>(left, kThrottleSlice));
+}
+
+void SocketSessionWorker::Capture(const SessionOptions &options, Clock::time_point receivedAt,
+                                  std::span<const std::byte> request)
+{
+    if (options.capture == nullptr)
+        return;
+    if (const auto generation = options.capture->Generation(); generation != captureGeneration_) {
+        captureGeneration_ = generation;
+        capture_ = options.capture->ForSession(id_);
+    }
+    if (capture_)
+        capture_->Record(id_, receivedAt, request);
+}
+
+void SocketSessionWorker::Respond(const SessionOptions &options, std::string_view request,
+                                  std::string &reply)
+{
+    const bool cached = options.handler.cacheable && options.cache != nullptr;
+    if (cached && options.cache->Lookup(request, reply))
+        return;
+
+    options.handler.handle(request, State(), reply);
+    if (cached)
+        options.cache->Insert(request, reply);
+}
+
+bool SocketSessionWorker::HandleSubscription(const SessionOptions &options,
+                                             std::string_view request, std::string &reply)
+{
+    constexpr std::string_view kSubscribe = "subscribe ";
+    constexpr std::string_view kUnsubscribe = "unsubscribe ";
+
+    const bool subscribe = request.starts_with(kSubscribe);
+    if (options.broker == nullptr || (!subscribe && !request.starts_with(kUnsubscribe)))
+        return false;
+
+    const std::string_view topic = request.substr(subscribe ? kSubscribe.size()
+                                                            : kUnsubscribe.size());
+    if (subscribe) {
+        if (!subscriber_) {
+            broker_ = options.broker;
+            subscriber_ = std::make_shared<Subscriber>(options.subscriber,
+                                                       [this]() { session_.unblockReceive(); });
+        }
+        broker_->Subscribe(subscriber_, topic);
+        reply = std::format("subscribed {}", topic);
+    } else {
+        const bool removed = subscriber_ && broker_->Unsubscribe(*subscriber_, topic);
+        reply = std::format("{} {}", removed ? "unsubscribed" : "not subscribed", topic);
+    }
+    return true;
+}
+
+bool SocketSessionWorker::SendEvents()
+{
+    if (!subscriber_)
+        return true;
+    if (subscriber_->Closed()) {
+        spdlog::warn("Session {} does not keep up with its events, closing it", id_);
+        return false;
+    }
+
+    // Every queued event goes out with one gather send; the buffers are shared, not copied.
+    while (subscriber_->Drain(events_, 64) > 0) {
+        eventPieces_.clear();
+        for (const auto &event : events_)
+            eventPieces_.emplace_back(*event);
+        auto sent = session_.sendv(eventPieces_);
+        events_.clear();
+        if (!sent)
+            return false;
+    }
+    return true;
+}
+
+bool SocketSessionWorker::Stream(const SessionOptions &options, const StreamRequest &request)
+{
+    ChunkWriter out(session_, request.credits, running_);
+    if (request.credits == 0)
+        out.Fail("error: usage: stream <credits> <request>, with credits > 0");
+    else if (!options.handler.stream)
+        out.Fail("error: this server does not stream");
+    else
+        options.handler.stream(request.request, State(), out);
+    if (!out.Ended())
+        out.Finish();
+    HOT_LOG(spdlog::level::debug, "Session {}: streamed {} bytes in {} chunks", id_, out.Bytes(),
+            out.Chunks());
+
+    if (out.Broken()) {
+        // A chunk may have been cut short; nothing sensible can follow on this connection.
+        session_.shutdown();
+        return false;
+    }
+    // Events published meanwhile woke the grant receive, not the session loop.
+    return SendEvents();
+}
+
+void SocketSessionWorker::Run()
+{
+    SessionOptionsSnapshot::Reader options(options_);
+    std::vector<std::byte> buffer;
+    std::string response;
+    ApplyOptions(*options, buffer, response);
 
     while (running_) {
+        // Sampled per request: a traced request records all of its spans.
+        const bool traced = utils::RequestTrace::Sample();
+        session_.setReadyTimestamps(traced);
+        RequestMarks marks{};
+        if (traced)
+            marks.waiting = Clock::now();
+
         auto msg = session_.receive(std::span(buffer));
         if (!msg.has_value()) {
-            spdlog::debug("Session disconnected (fd={})", session_.getFd());
+            // Publishers wake the receive the same way a stop request does.
+            if (msg.error() == std::errc::operation_canceled && running_) {
+                if (SendEvents())
+                    continue;
+                disconnected_.store(true, std::memory_order_release);
+                break;
+            }
+            if (msg.error() != std::errc::operation_canceled) {
+                spdlog::debug("Session disconnected (fd={})", session_.getFd());
+                disconnected_.store(true, std::memory_order_release);
+            }
             break;
         }
+        // A relaxed store is all an idle timeout reset costs; the timer re-checks lazily.
+        marks.received = Clock::now();
+        lastActivity_.store(marks.received.time_since_epoch().count(), std::memory_order_relaxed);
+
         std::string_view str = utils::from_bytes(std::span(buffer.data(), msg.value()));
-        spdlog::info("Message Received {}", str);
+        HOT_LOG_RATE_LIMITED(spdlog::level::info, kMessageLogRate, kMessageLogRate,
+                             "Message Received {}", str);
+
+        Capture(*options, marks.received, std::span(buffer.data(), msg.value()));
+        Throttle(*options);
+        if (traced)
+            marks.handling = Clock::now();
+        UDS_PROBE(handler_start, id_, str.size());
+        // A streamed response goes out from within the handler.
+        const auto stream = ParseStreamRequest(str);
+        if (stream) {
+            if (!Stream(*options, *stream)) {
+                // Also when a stop cut the stream short: the socket is shut down by now and must
+                // not be handed over.
+                disconnected_.store(true, std::memory_order_release);
+                break;
+            }
+        } else if (!HandleSubscription(*options, str, response)) {
+            Respond(*options, str, response);
+        }
+        UDS_PROBE(handler_end, id_, stream ? std::size_t{0} : response.size());
+        // Only this thread writes the counter; no read-modify-write needed.
+        replies_.store(replies_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (traced)
+            marks.sending = Clock::now();
+        if (!stream)
+            session_.send(std::span(response));
+        if (traced) {
+            marks.ready = session_.readyTime();
+            traceRequest(id_, marks);
+        }
+
+        // A reload is noticed with one atomic load per message.
+        if (options.Refresh())
+            ApplyOptions(*options, buffer, response);
+    }
 
-        std::string response = std::format("{}-replay {}",rcvCount,str);
-        rcvCount++;
-        session_.send(std::span(response));
+    if (options->spin.spin > std::chrono::microseconds::zero()) {
+        const auto spin = session_.spinStats();
+        spdlog::debug("Session {}: {} receive(s) served while spinning, {} parked", id_,
+                      spin.spinHits, spin.parks);
     }
+    if (subscriber_)
+        broker_->Remove(*subscriber_);
+    UDS_PROBE(session_close, id_, replies_.load(std::memory_order_relaxed),
+              disconnected_.load(std::memory_order_relaxed));
+    finished_.store(true, std::memory_order_release);
 }
 
 } // namespace net
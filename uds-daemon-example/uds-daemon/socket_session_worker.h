@@ -1,15 +1,88 @@
 #ifndef SOCKET_SESSION_WORKER_H_
 #define SOCKET_SESSION_WORKER_H_
 
+#include <chunk_stream.h>
+#include <cpu_affinity.h>
+#include <peer_rate_limiter.h>
+#include <pubsub.h>
+#include <realtime.h>
+#include <request_capture.h>
+#include <response_cache.h>
+#include <snapshot.h>
 #include <socket_session.h>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 namespace net {
 
+//! Per-session state that survives a handover to a new daemon process.
+struct SessionState {
+    uint64_t id{0};
+    //! Replies sent so far; numbers the next "<n>-replay" answer.
+    uint64_t replies{0};
+};
+
+//! Produces the reply to one request. A handler whose reply depends on nothing but the request
+//! bytes sets cacheable, so repeated requests are answered from the response cache.
+struct RequestHandler {
+    std::function<void(std::string_view request, const SessionState& state, std::string& reply)>
+        handle;
+    bool cacheable{false};
+    //! Answers "stream <credits> <request>" chunk by chunk, for responses of any size; it
+    //! returns early once a write fails. Unset, such requests get an error.
+    std::function<void(std::string_view request, const SessionState& state, ChunkWriter& out)>
+        stream;
+};
+
+//! "<n>-replay <request>": numbered per session, hence not cacheable. Streams answer
+//! "<count> <text>" with text repeated count times.
+RequestHandler EchoHandler();
+
+//! Session settings that can change while the session runs.
+struct SessionOptions {
+    //! Receive buffer size; longer messages are read in several parts.
+    std::size_t bufferSize{1024};
+    //! CPUs the session thread runs on.
+    utils::CpuSet cpus{};
+    //! False when \p cpus only stands for every cpu the daemon may use (no io_cpus).
+    bool cpusConfigured{false};
+    RequestHandler handler{EchoHandler()};
+    //! Shared by all sessions of a server; nullptr when caching is off.
+    utils::ResponseCache* cache{nullptr};
+    //! Topics the session can subscribe to with "subscribe <topic>"; nullptr disables it. Events
+    //! go out between the replies as EventFrames, told apart by their kEventMarker.
+    Broker* broker{nullptr};
+    //! Queue limit and slow consumer policy of the session's event queue.
+    SubscriberOptions subscriber{};
+    //! Shared per-uid admission control; nullptr when no rate is configured.
+    PeerRateLimiter* limiter{nullptr};
+    //! Requests per second and burst of this session alone; a rate of zero is unlimited.
+    double sessionRate{0};
+    double sessionBurst{16};
+    //! Busy polling before a receive parks; trades CPU for latency.
+    SpinPolicy spin{};
+    //! SCHED_FIFO priority of the session thread, 0 for the normal scheduler. A real-time
+    //! session also prefaults its stack and reply buffer before the first request.
+    int priority{0};
+    //! Request capture of the server; records only while a capture runs and samples the session.
+    RequestCapture* capture{nullptr};
+};
+
+using SessionOptionsSnapshot = utils::Snapshot<SessionOptions>;
+
 class SocketSessionWorker {
   public:
-    explicit SocketSessionWorker(SocketSession&& session);
+    using Clock = std::chrono::steady_clock;
+
+    //! \p options is read once per message and has to outlive the worker.
+    SocketSessionWorker(SocketSession&& session, const SessionOptionsSnapshot& options,
+                        SessionState state = {});
     ~SocketSessionWorker();
 
     // Non-copyable
@@ -20,13 +93,60 @@ class SocketSessionWorker {
     SocketSessionWorker(SocketSessionWorker&&) noexcept = default;
     SocketSessionWorker& operator=(SocketSessionWorker&&) noexcept = default;
 
+    //! Asks the session thread to finish without waiting for it; a request already received is
+    //! still answered.
+    void RequestStop() noexcept;
+    //! Cuts the connection of a session that did not finish after RequestStop(), e.g. one
+    //! blocked sending to a client that stopped reading.
+    void ForceClose() noexcept;
     void Stop() noexcept;
 
+    //! True once the session thread left its receive loop (peer gone, error or stop).
+    bool IsFinished() const noexcept;
+
+    //! Time since the last message was received.
+    Clock::duration IdleFor() const noexcept;
+
+    //! True if the session ended because the peer closed or failed, not on request, or if its
+    //! connection was left unusable (a stream cut short); such a session is not handed over.
+    bool Disconnected() const noexcept;
+
+    SessionState State() const noexcept;
+
+    int Fd() const noexcept;
+
   private:
-    void Run() const;
+    void Run();
+    void ApplyOptions(const SessionOptions& options, std::vector<std::byte>& buffer,
+                      std::string& reply);
+    void Respond(const SessionOptions& options, std::string_view request, std::string& reply);
+    bool HandleSubscription(const SessionOptions& options, std::string_view request,
+                            std::string& reply);
+    bool SendEvents();
+    bool Stream(const SessionOptions& options, const StreamRequest& request);
+    void Throttle(const SessionOptions& options);
+    void Capture(const SessionOptions& options, Clock::time_point receivedAt,
+                 std::span<const std::byte> request);
 
     SocketSession session_;
+    uint64_t id_;
+    std::atomic<uint64_t> replies_;
     std::atomic<bool> running_{false};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> disconnected_{false};
+    std::atomic<Clock::rep> lastActivity_{0};
+    const SessionOptionsSnapshot& options_;
+    // Set up on the first "subscribe"; only the session thread touches these.
+    Broker* broker_{nullptr};
+    std::shared_ptr<Subscriber> subscriber_;
+    std::vector<SharedBuffer> events_;
+    std::vector<std::span<const std::byte>> eventPieces_;
+    // Rate limit state; the uid account is looked up once, on the first limited message.
+    utils::TokenBucket sessionBucket_;
+    std::shared_ptr<PeerRateLimiter::Account> account_;
+    // Writer of the capture this session is sampled into, refreshed when the generation changes.
+    uint64_t captureGeneration_{0};
+    std::shared_ptr<utils::CaptureWriter> capture_;
     std::thread thread_;
 };
 
@@ -1,8 +1,21 @@
+#include <admin_commands.h>
+#include <admin_server.h>
+#include <algorithm>
+#include <chrono>
+#include <cpu_affinity.h>
 #include <csignal>
 #include <cstdlib>
+#include <cstring>
 #include <cxxopts.hpp>
+#include <daemon_config.h>
+#include <final_action.h>
+#include <filesystem>
+#include <format>
 #include <iostream>
 #include <memory>
+#include <hot_log.h>
+#include <optional>
+#include <realtime.h>
 #include <sd_notify.h>
 #include <sd_socket.h>
 #include <server_worker.h>
@@ -13,10 +26,31 @@
 #include <string_view>
 #include <systemd/sd-daemon.h> // for sd_booted()
 #include <uds_server.h>
+#include <unistd.h>
+#include <vector>
+#include <worker_supervisor.h>
+
+static constexpr std::size_t kMaxWorkers = 1024;
+// How often a worker publishes its counters to the supervisor.
+static constexpr auto kStatsInterval = std::chrono::seconds(1);
+// Shutdown time allowed on top of the drain timeout, for joining threads and the fd handover.
+static constexpr auto kStopMargin = std::chrono::seconds(2);
+// Thread stacks in real-time mode: locked and resident in full, so far below the 8 MiB default.
+static constexpr std::size_t kRealtimeThreadStack = 512 * 1024;
 
 struct CliArgs {
-    spdlog::level::level_enum log_level;
     bool interactive;
+    std::optional<fs::path> config_path;
+    // Settings given on the command line win over the config file, also across reloads.
+    std::optional<spdlog::level::level_enum> log_level;
+    std::optional<std::chrono::seconds> idle_timeout;
+    std::optional<utils::CpuSet> accept_cpus;
+    std::optional<utils::CpuSet> io_cpus;
+    std::optional<utils::CpuSet> worker_cpus;
+    //! Worker processes under a supervisor; 0 serves from the daemon process itself.
+    std::size_t workers;
+    //! SCHED_FIFO threads and locked memory.
+    bool realtime;
 };
 
 static CliArgs parse_arguments(int argc, const char *argv[])
@@ -27,6 +61,24 @@ static CliArgs parse_arguments(int argc, const char *argv[])
          cxxopts::value<std::string>()->default_value("info"));
 
     opts("i,interactive", "Force interactive mode (disable systemd/daemon mode)");
+    opts("c,config", "Configuration file (default " + std::string(uds_daemon::kDefaultConfigPath) +
+                         " if present), re-read on SIGHUP",
+         cxxopts::value<std::string>());
+    opts("idle-timeout", "Close client sessions idle for this many seconds (0 = never)",
+         cxxopts::value<int>()->default_value("300"));
+    opts("accept-cpus", "Pin the accept thread to these CPUs (cpu list, e.g. 0-1)",
+         cxxopts::value<std::string>()->default_value(""));
+    opts("io-cpus", "Pin the session I/O threads to these CPUs",
+         cxxopts::value<std::string>()->default_value(""));
+    opts("worker-cpus", "Pin the timer/housekeeping thread to these CPUs",
+         cxxopts::value<std::string>()->default_value(""));
+    opts("w,workers",
+         "Serve from N worker processes sharing the listening socket, each pinned to one CPU "
+         "and restarted when it fails (0 = serve from this process)",
+         cxxopts::value<std::size_t>()->default_value("0"));
+    opts("realtime",
+         "Run the I/O threads under SCHED_FIFO (priorities from the config file), lock all memory "
+         "and prefault thread stacks; needs CAP_SYS_NICE and CAP_IPC_LOCK or matching rlimits");
     opts("h,help", "Show help message");
 
     cxxopts::ParseResult result;
@@ -44,30 +96,362 @@ static CliArgs parse_arguments(int argc, const char *argv[])
         std::exit(EXIT_FAILURE);
     }
 
-    const bool interactive = result.count("interactive") > 0;
-    const std::string level_str = result["log-level"].as<std::string>();
-    spdlog::level::level_enum log_level;
+    CliArgs args{};
+    args.interactive = result.count("interactive") > 0;
 
-    try {
-        log_level = spdlog::level::from_str(level_str);
-    } catch (const spdlog::spdlog_ex &ex) {
-        std::cerr << "Warning: Invalid log level '" << level_str << "' (" << ex.what()
-                  << "), falling back to 'info'\n";
-        log_level = spdlog::level::info;
+    if (result.count("config"))
+        args.config_path = result["config"].as<std::string>();
+
+    if (result.count("log-level")) {
+        const std::string level_str = result["log-level"].as<std::string>();
+        try {
+            args.log_level = spdlog::level::from_str(level_str);
+        } catch (const spdlog::spdlog_ex &ex) {
+            std::cerr << "Warning: Invalid log level '" << level_str << "' (" << ex.what()
+                      << "), falling back to 'info'\n";
+            args.log_level = spdlog::level::info;
+        }
     }
 
-    CliArgs args{
-        .log_level = log_level,
-        .interactive = interactive,
+    if (result.count("idle-timeout"))
+        args.idle_timeout = std::chrono::seconds(std::max(result["idle-timeout"].as<int>(), 0));
+
+    auto parse_cpus = [&result](const char *name) -> std::optional<utils::CpuSet> {
+        if (!result.count(name))
+            return std::nullopt;
+        try {
+            return utils::CpuSet::Parse(result[name].as<std::string>());
+        } catch (const utils::CpuAffinityError &ex) {
+            std::cerr << "Error parsing --" << name << ": " << ex.what() << "\n";
+            std::exit(EXIT_FAILURE);
+        }
     };
+    args.accept_cpus = parse_cpus("accept-cpus");
+    args.io_cpus = parse_cpus("io-cpus");
+    args.worker_cpus = parse_cpus("worker-cpus");
+
+    args.realtime = result.count("realtime") > 0;
+    args.workers = result["workers"].as<std::size_t>();
+    if (args.workers > kMaxWorkers) {
+        std::cerr << "Error: --workers must be at most " << kMaxWorkers << "\n";
+        std::exit(EXIT_FAILURE);
+    }
     return args;
 }
 
+//! Config file (if any) overlaid with the command line, validated. Throws on any error.
+static uds_daemon::DaemonConfig load_config(const CliArgs &args, const utils::CpuSet &allowedCpus)
+{
+    uds_daemon::DaemonConfig config;
+
+    const fs::path path = args.config_path.value_or(fs::path(uds_daemon::kDefaultConfigPath));
+    if (args.config_path || fs::exists(path))
+        config = uds_daemon::ApplyConfigFile(utils::ConfigFile::Load(path), config);
+
+    if (args.log_level)
+        config.logLevel = *args.log_level;
+    if (args.idle_timeout)
+        config.server.idleTimeout = *args.idle_timeout;
+    if (args.accept_cpus)
+        config.server.acceptCpus = *args.accept_cpus;
+    if (args.io_cpus)
+        config.server.ioCpus = *args.io_cpus;
+    if (args.worker_cpus)
+        config.server.workerCpus = *args.worker_cpus;
+    config.server.realtime.enabled = args.realtime;
+
+    uds_daemon::ValidateConfig(config, allowedCpus);
+    return config;
+}
+
+//! Re-reads the configuration for SIGHUP; std::nullopt (logged) if it is invalid. With
+//! \p describe the changes are logged and reported to systemd.
+static std::optional<uds_daemon::DaemonConfig>
+reload_config(const CliArgs &args, const utils::CpuSet &allowedCpus,
+              const uds_daemon::DaemonConfig &config, bool describe)
+{
+    try {
+        auto next = load_config(args, allowedCpus);
+        if (next.socketPath != config.socketPath) {
+            if (describe)
+                spdlog::warn("socket_path changes need a restart, keeping {}",
+                             config.socketPath.string());
+            next.socketPath = config.socketPath;
+        }
+        if (next.adminSocket != config.adminSocket) {
+            if (describe)
+                spdlog::warn("admin_socket changes need a restart, keeping '{}'",
+                             config.adminSocket.string());
+            next.adminSocket = config.adminSocket;
+        }
+        if (describe) {
+            const auto changes = uds_daemon::DescribeChanges(config, next);
+            for (const auto &change : changes)
+                spdlog::info("Config {}", change);
+            systemd_notify::status(changes.empty() ? "Configuration unchanged"
+                                                   : "Configuration reloaded");
+        }
+        spdlog::set_level(next.logLevel);
+        return next;
+    } catch (const std::exception &e) {
+        spdlog::error("Reload failed, keeping current configuration: {}", e.what());
+        if (describe)
+            systemd_notify::status("Reload failed, running with previous configuration");
+        return std::nullopt;
+    }
+}
+
+//! Serves \p udsserver until SIGTERM (or SIGINT when interactive). Runs in the daemon process
+//! itself or, with \p worker set, in a worker process of the supervisor.
+static int serve(const CliArgs &args, uds_daemon::DaemonConfig config,
+                 const utils::CpuSet &allowedCpus, net::UdsServer &&udsserver,
+                 bool handOffListener, const utils::SignalHandler &signalHandler,
+                 uds_daemon::WorkerContext *worker)
+{
+    const bool standalone = worker == nullptr;
+    if (!standalone)
+        udsserver.KeepSocketPath(); // the supervisor owns it
+
+    if (args.realtime) {
+        // Per process: memory locks do not survive fork(), so every worker takes its own.
+        try {
+            utils::LockProcessMemory();
+        } catch (const utils::RealtimeError &e) {
+            spdlog::warn("Running without locked memory: {}", e.what());
+        }
+        utils::PrefaultStack();
+    }
+
+    // Per process as well: the formatting thread does not survive fork().
+    utils::HotLog::Start();
+    const auto stopHotLog = utils::Finally([]() { utils::HotLog::Stop(); });
+
+    bool theEnd = false;
+    try {
+        spdlog::info("Service started — listening on {}", udsserver.SocketPath().string());
+        net::UdsServerWorker udsServerWorker(std::move(udsserver), config.server);
+
+        // Traces and captures live in the process that serves, so every worker has an admin
+        // socket of its own. Declared after the server worker, so it stops first.
+        std::optional<uds_daemon::AdminServer> admin;
+        if (!config.adminSocket.empty()) {
+            auto path = config.adminSocket;
+            if (worker)
+                path += std::format(".{}", worker->Index());
+            admin.emplace(path,
+                          uds_daemon::AdminServer::Commands{
+                              {"trace", uds_daemon::TraceCommand},
+                              {"capture", [&udsServerWorker, worker](std::string_view operands) {
+                                   return uds_daemon::CaptureCommand(udsServerWorker.Capture(),
+                                                                    operands, worker);
+                               }},
+                              {"stats", [&udsServerWorker](std::string_view operands) {
+                                   return uds_daemon::StatsCommand(udsServerWorker, operands);
+                               }},
+                              {"cache", [&udsServerWorker](std::string_view operands) {
+                                   return uds_daemon::CacheCommand(udsServerWorker, operands);
+                               }}});
+        }
+
+        if (standalone && (sd_booted() > 0) && (!args.interactive)) {
+            const auto stored = systemd_socket::getSystemdStoredFds(net::kSessionFdPrefix);
+            for (const auto &[fd, name] : stored) {
+                systemd_notify::removeStoredFds(name);
+                if (auto state = net::ParseSessionFdName(name)) {
+                    udsServerWorker.Adopt(net::SocketSession(fd), *state);
+                } else {
+                    spdlog::warn("Dropping stored fd {} with malformed name '{}'", fd, name);
+                    ::close(fd);
+                }
+            }
+        }
+        // Only now: ids of new sessions have to continue after the adopted ones.
+        udsServerWorker.Start();
+        if (standalone)
+            systemd_notify::ready();
+        else
+            worker->Ready();
+
+        while (!theEnd) {
+            const auto receivedSignal = signalHandler.waitFor(kStatsInterval);
+            if (!receivedSignal) {
+                if (worker)
+                    worker->Publish(udsServerWorker.Stats());
+                continue;
+            }
+
+            switch (*receivedSignal) {
+            case SIGTERM:
+            case SIGINT:
+                spdlog::info("Termination requested {}", *receivedSignal);
+                if (standalone) {
+                    systemd_notify::stopping();
+                    systemd_notify::extendTimeout(config.server.drainTimeout + kStopMargin);
+                }
+                theEnd = true;
+                break;
+
+            case SIGHUP:
+                spdlog::info("Reload configuration requested");
+                if (standalone)
+                    systemd_notify::reloading();
+                if (auto next = reload_config(args, allowedCpus, config, standalone)) {
+                    udsServerWorker.Reconfigure(next->server);
+                    config = std::move(*next);
+                }
+                if (standalone)
+                    systemd_notify::ready();
+                break;
+
+            default:
+                spdlog::warn("Unhandled signal received: {}", *receivedSignal);
+                break;
+            }
+        }
+
+        spdlog::info("Shutting down...");
+        if (standalone && (!args.interactive) && (systemd_notify::fdStoreLimit() > 0)) {
+            // With FileDescriptorStorePreserve=restart the successor resumes every session;
+            // on a plain stop systemd closes the stored fds once the unit is inactive.
+            udsServerWorker.HandOff(handOffListener);
+        } else {
+            udsServerWorker.Stop();
+        }
+        if (const auto capture = udsServerWorker.Capture().Stop())
+            spdlog::info("Capture stopped: {}", uds_daemon::DescribeCapture(*capture));
+        if (worker)
+            worker->Publish(udsServerWorker.Stats());
+
+    } catch (const std::exception &e) {
+        spdlog::critical("Unhandled exception in main loop: {}", e.what());
+        return EXIT_FAILURE;
+    } catch (...) {
+        spdlog::critical("Unknown exception occurred in main()");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+//! Pre-fork mode: the daemon process only supervises args.workers worker processes, which all
+//! accept on \p udsserver. Readiness is reported to systemd once every worker is up.
+static int supervise(const CliArgs &args, uds_daemon::DaemonConfig config,
+                     const utils::CpuSet &allowedCpus, net::UdsServer &udsserver,
+                     const utils::SignalHandler &signalHandler)
+{
+    if (!udsserver.SetNonBlocking()) {
+        spdlog::critical("Failed to share the listening socket: {}", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // Sessions parked by a single process run cannot be split between workers.
+    if ((sd_booted() > 0) && (!args.interactive)) {
+        for (const auto &[fd, name] : systemd_socket::getSystemdStoredFds(net::kSessionFdPrefix)) {
+            spdlog::warn("Closing stored session '{}': not resumed in worker mode", name);
+            systemd_notify::removeStoredFds(name);
+            ::close(fd);
+        }
+    }
+
+    try {
+        uds_daemon::WorkerSupervisor supervisor(
+            args.workers, allowedCpus, [&](uds_daemon::WorkerContext &worker) {
+                spdlog::set_default_logger(spdlog::default_logger()->clone(
+                    std::format("uds-daemon/{}", worker.Index())));
+                return serve(args, config, allowedCpus, std::move(udsserver), false, signalHandler,
+                             &worker);
+            });
+
+        spdlog::info("Starting {} worker processes on {}", args.workers,
+                     udsserver.SocketPath().string());
+        supervisor.Start();
+
+        bool ready = false;
+        std::string status;
+        for (bool theEnd = false; !theEnd;) {
+            const auto restart = supervisor.Supervise();
+            if (!ready && supervisor.AllReady()) {
+                systemd_notify::ready();
+                ready = true;
+            }
+
+            const auto totals = supervisor.Totals();
+            auto current = std::format("{} workers, {} active sessions, {} requests, {} restarts",
+                                       args.workers, totals.activeSessions, totals.requests,
+                                       totals.restarts);
+            if (ready && current != status) {
+                status = std::move(current);
+                systemd_notify::status(status);
+            }
+
+            const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::min<std::chrono::steady_clock::duration>(restart.value_or(kStatsInterval),
+                                                              kStatsInterval));
+            const auto receivedSignal = signalHandler.waitFor(timeout);
+            if (!receivedSignal)
+                continue;
+
+            switch (*receivedSignal) {
+            case SIGTERM:
+            case SIGINT:
+                spdlog::info("Termination requested {}", *receivedSignal);
+                systemd_notify::stopping();
+                systemd_notify::extendTimeout(config.server.drainTimeout + kStopMargin);
+                theEnd = true;
+                break;
+
+            case SIGHUP:
+                spdlog::info("Reload configuration requested");
+                systemd_notify::reloading();
+                // Checked here once; restarted workers start with the new settings.
+                if (auto next = reload_config(args, allowedCpus, config, true)) {
+                    config = std::move(*next);
+                    supervisor.Broadcast(SIGHUP);
+                }
+                systemd_notify::ready();
+                break;
+
+            case SIGCHLD: // reaped on the next round
+            case SIGUSR1: // a worker became ready
+                break;
+
+            default:
+                spdlog::warn("Unhandled signal received: {}", *receivedSignal);
+                break;
+            }
+        }
+
+        spdlog::info("Stopping workers...");
+        // The workers drain in parallel, each within the drain timeout.
+        supervisor.Stop(config.server.drainTimeout + kStopMargin);
+        const auto totals = supervisor.Totals();
+        spdlog::info("Workers served {} sessions and {} requests, {} restarts", totals.sessions,
+                     totals.requests, totals.restarts);
+
+    } catch (const std::exception &e) {
+        spdlog::critical("Worker supervisor failed: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, const char *argv[])
 {
     auto args = parse_arguments(argc, argv);
 
-    bool theEnd = false;
+    //--------------------------------------------------------------------------
+    // Configuration
+    //--------------------------------------------------------------------------
+    utils::CpuSet allowedCpus;
+    uds_daemon::DaemonConfig config;
+    try {
+        allowedCpus = utils::CpuSet::OfCurrentThread();
+        config = load_config(args, allowedCpus);
+    } catch (const std::exception &e) {
+        std::cerr << "Invalid configuration: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
 
     //--------------------------------------------------------------------------
     // Logger setup
@@ -84,18 +468,48 @@ int main(int argc, const char *argv[])
         }
 
         spdlog::set_default_logger(logger);
-        spdlog::set_level(args.log_level);
+        spdlog::set_level(config.logLevel);
     } catch (const std::exception &e) {
         std::fprintf(stderr, "Failed to initialize logger: %s\n", e.what());
         return EXIT_FAILURE;
     }
 
+    spdlog::info("CPU affinity: accept {}, io {}, worker {} (allowed {})",
+                 utils::DescribeAffinity(config.server.acceptCpus),
+                 utils::DescribeAffinity(config.server.ioCpus),
+                 utils::DescribeAffinity(config.server.workerCpus), allowedCpus.ToString());
+
+    if (args.realtime) {
+        const auto &rt = config.server.realtime;
+        const int highest = std::max({rt.acceptPriority, rt.ioPriority, rt.timerPriority});
+        for (const auto &problem : utils::RealtimePrivilegeProblems(highest))
+            spdlog::warn("Real-time mode: {}", problem);
+        try {
+            // Has to happen before the first thread is started.
+            utils::SetDefaultThreadStackSize(kRealtimeThreadStack);
+        } catch (const utils::RealtimeError &e) {
+            spdlog::warn("Real-time mode: {}", e.what());
+        }
+        spdlog::info("Real-time mode: SCHED_FIFO priorities accept {}, io {}, timer {}",
+                     rt.acceptPriority, rt.ioPriority, rt.timerPriority);
+    }
+
     //--------------------------------------------------------------------------
     // Signal handler setup
     //--------------------------------------------------------------------------
-    utils::SignalHandler signalHandler(args.interactive
-                                           ? std::initializer_list<int>{SIGTERM, SIGINT, SIGHUP}
-                                           : std::initializer_list<int>{SIGTERM, SIGHUP});
+    std::vector<int> signals{SIGTERM, SIGHUP};
+    if (args.interactive)
+        signals.push_back(SIGINT);
+    if (args.workers > 0) {
+        // Worker exits and readiness; blocked before the first fork.
+        signals.push_back(SIGCHLD);
+        signals.push_back(SIGUSR1);
+    }
+    utils::SignalHandler signalHandler(signals);
+
+    // Writes to a client that went away fail with EPIPE instead of killing the daemon; send()
+    // passes MSG_NOSIGNAL, but splice() has no such flag.
+    std::signal(SIGPIPE, SIG_IGN);
 
     try {
         signalHandler.enableSegfaultHandler();
@@ -108,20 +522,30 @@ int main(int argc, const char *argv[])
     // Create and initialize the UDS server
     //--------------------------------------------------------------------------
     net::UdsServer udsserver;
+    // A listener bound by ourselves has no socket unit keeping it; it travels through the fd store.
+    bool handOffListener = true;
     try {
         if ((sd_booted() > 0) && (!args.interactive)) {
             auto sockets = systemd_socket::getSystemdUnixSockets();
             if (sockets.empty()) {
                 spdlog::warn("No systemd UNIX sockets found, falling back to manual bind()");
-                udsserver = net::UdsServer("/run/sockact-local-a.sock");
+                udsserver = net::UdsServer(config.socketPath, config.server.backlog);
             } else {
-                for (const auto &[fd, path] : sockets) {
-                    spdlog::info("Systemd provided socket: fd={} path={}", fd, path.string());
+                for (const auto &[fd, path, name] : sockets) {
+                    spdlog::info("Systemd provided socket: fd={} path={} name={}", fd,
+                                 path.string(), name);
+                }
+                const auto &socket = sockets.front();
+                if (socket.name == net::kListenerFdName) {
+                    // Owned by us again; it is stored anew on the next handover.
+                    systemd_notify::removeStoredFds(socket.name);
+                } else {
+                    handOffListener = false;
                 }
-                udsserver = net::UdsServer(*sockets.begin());
+                udsserver = net::UdsServer(socket);
             }
         } else {
-            udsserver = net::UdsServer("/run/sockact-local-a.sock");
+            udsserver = net::UdsServer(config.socketPath, config.server.backlog);
         }
     } catch (const std::exception &e) {
         spdlog::critical("Failed to initialize UdsServer: {}", e.what());
@@ -131,44 +555,8 @@ int main(int argc, const char *argv[])
     //--------------------------------------------------------------------------
     // Main loop
     //--------------------------------------------------------------------------
-    try {
-        spdlog::info("Service started — listening on {}", udsserver.SocketPath().string());
-        net::UdsServerWorker udsServerWorker(std::move(udsserver));
-        systemd_notify::ready();
-
-        while (!theEnd) {
-            const int receivedSignal = signalHandler.wait();
-            switch (receivedSignal) {
-            case SIGTERM:
-            case SIGINT:
-                spdlog::info("Termination requested {}", receivedSignal);
-                systemd_notify::stopping();
-                theEnd = true;
-                break;
-
-            case SIGHUP:
-                spdlog::info("Reload configuration requested");
-                systemd_notify::reloading();
-                // Config could be reloaded
-                systemd_notify::ready();
-                break;
-
-            default:
-                spdlog::warn("Unhandled signal received: {}", receivedSignal);
-                break;
-            }
-        }
-
-        spdlog::info("Shutting down...");
-        udsServerWorker.Stop();
-
-    } catch (const std::exception &e) {
-        spdlog::critical("Unhandled exception in main loop: {}", e.what());
-        return EXIT_FAILURE;
-    } catch (...) {
-        spdlog::critical("Unknown exception occurred in main()");
-        return EXIT_FAILURE;
-    }
-
-    return EXIT_SUCCESS;
+    if (args.workers > 0)
+        return supervise(args, config, allowedCpus, udsserver, signalHandler);
+    return serve(args, config, allowedCpus, std::move(udsserver), handOffListener, signalHandler,
+                 nullptr);
 }
@@ -0,0 +1,265 @@
+#include "worker_supervisor.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <format>
+#include <new>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace uds_daemon {
+
+namespace {
+
+// A worker that exits sooner than this after its start counts as crash looping.
+constexpr auto kStableUptime = std::chrono::seconds(1);
+constexpr auto kMinBackoff = std::chrono::milliseconds(100);
+constexpr auto kMaxBackoff = std::chrono::seconds(10);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<bool>::is_always_lock_free,
+              "slots are shared between processes and must not need a lock");
+
+std::string describeExit(int status)
+{
+    if (WIFSIGNALED(status))
+        return std::format("killed by signal {}", WTERMSIG(status));
+    return std::format("exited with status {}", WEXITSTATUS(status));
+}
+
+int64_t millis(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+} // namespace
+
+void WorkerContext::Ready() noexcept
+{
+    slot_.ready.store(true, std::memory_order_release);
+    ::kill(supervisor_, SIGUSR1);
+}
+
+void WorkerContext::Publish(const net::ServerWorkerStats &stats) noexcept
+{
+    slot_.sessions.store(stats.sessions, std::memory_order_relaxed);
+    slot_.activeSessions.store(stats.activeSessions, std::memory_order_relaxed);
+    slot_.requests.store(stats.requests, std::memory_order_relaxed);
+}
+
+WorkerSupervisor::WorkerSupervisor(std::size_t workers, const utils::CpuSet &cpus,
+                                   WorkerMain main)
+ : main_(std::move(main))
+ , workers_(workers)
+{
+    const auto cpuList = cpus.Cpus();
+    for (std::size_t i = 0; i < workers_.size() && !cpuList.empty(); ++i)
+        workers_[i].cpu = cpuList[i % cpuList.size()];
+
+    void *mem = ::mmap(nullptr, sizeof(WorkerContext::Slot) * workers, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        throw WorkerSupervisorError("mmap of the worker slots failed");
+    slots_ = new (mem) WorkerContext::Slot[workers];
+}
+
+WorkerSupervisor::~WorkerSupervisor()
+{
+    Stop(std::chrono::seconds(5));
+    ::munmap(slots_, sizeof(WorkerContext::Slot) * workers_.size());
+}
+
+void WorkerSupervisor::Start()
+{
+    for (std::size_t i = 0; i < workers_.size(); ++i)
+        Spawn(i);
+}
+
+bool WorkerSupervisor::AllReady() const noexcept
+{
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        if (workers_[i].pid == 0 || !slots_[i].ready.load(std::memory_order_acquire))
+            return false;
+    }
+    return true;
+}
+
+std::optional<WorkerSupervisor::Clock::duration> WorkerSupervisor::Supervise()
+{
+    int status = 0;
+    pid_t pid;
+    while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+        const auto it = std::ranges::find(workers_, pid, &Worker::pid);
+        if (it != workers_.end())
+            Exited(static_cast<std::size_t>(it - workers_.begin()), status);
+    }
+
+    std::optional<Clock::duration> next;
+    const auto now = Clock::now();
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        auto &worker = workers_[i];
+        if (stopping_ || !worker.restartAt)
+            continue;
+        if (*worker.restartAt <= now) {
+            Spawn(i);
+        } else {
+            const auto left = *worker.restartAt - now;
+            next = next ? std::min(*next, left) : left;
+        }
+    }
+    return next;
+}
+
+void WorkerSupervisor::Broadcast(int signal) const noexcept
+{
+    for (const auto &worker : workers_) {
+        if (worker.pid > 0)
+            ::kill(worker.pid, signal);
+    }
+}
+
+void WorkerSupervisor::Stop(std::chrono::milliseconds timeout) noexcept
+{
+    stopping_ = true;
+    Broadcast(SIGTERM);
+
+    const auto deadline = Clock::now() + timeout;
+    bool killed = false;
+    while (Running() > 0) {
+        int status = 0;
+        const pid_t pid = ::waitpid(-1, &status, WNOHANG);
+        if (pid > 0) {
+            const auto it = std::ranges::find(workers_, pid, &Worker::pid);
+            if (it != workers_.end())
+                Exited(static_cast<std::size_t>(it - workers_.begin()), status);
+            continue;
+        }
+        if (pid < 0 && errno == ECHILD)
+            break;
+
+        if (!killed && Clock::now() >= deadline) {
+            spdlog::warn("{} worker(s) did not stop within {} ms, killing them", Running(),
+                         timeout.count());
+            Broadcast(SIGKILL);
+            killed = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+std::vector<WorkerStats> WorkerSupervisor::Stats() const
+{
+    std::vector<WorkerStats> stats;
+    stats.reserve(workers_.size());
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        const auto &worker = workers_[i];
+        const auto &slot = slots_[i];
+        const bool running = worker.pid > 0;
+        stats.push_back(WorkerStats{
+            .pid = worker.pid,
+            .ready = running && slot.ready.load(std::memory_order_acquire),
+            .restarts = worker.restarts,
+            .sessions = worker.pastSessions +
+                        (running ? slot.sessions.load(std::memory_order_relaxed) : 0),
+            .activeSessions = running ? slot.activeSessions.load(std::memory_order_relaxed) : 0,
+            .requests = worker.pastRequests +
+                        (running ? slot.requests.load(std::memory_order_relaxed) : 0)});
+    }
+    return stats;
+}
+
+WorkerStats WorkerSupervisor::Totals() const
+{
+    WorkerStats total;
+    for (const auto &s : Stats()) {
+        total.restarts += s.restarts;
+        total.sessions += s.sessions;
+        total.activeSessions += s.activeSessions;
+        total.requests += s.requests;
+    }
+    return total;
+}
+
+void WorkerSupervisor::Spawn(std::size_t index)
+{
+    auto &worker = workers_[index];
+    auto &slot = slots_[index];
+    slot.ready.store(false, std::memory_order_relaxed);
+    slot.sessions.store(0, std::memory_order_relaxed);
+    slot.activeSessions.store(0, std::memory_order_relaxed);
+    slot.requests.store(0, std::memory_order_relaxed);
+
+    const pid_t supervisor = ::getpid();
+    const pid_t pid = ::fork();
+    if (pid < 0)
+        throw WorkerSupervisorError(std::format("fork of worker {} failed", index));
+
+    if (pid == 0) {
+        // Workers go down with the supervisor, even if it is killed outright.
+        ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (::getppid() != supervisor)
+            ::_exit(EXIT_FAILURE);
+
+        ::unsetenv("NOTIFY_SOCKET");
+        ::unsetenv("FDSTORE");
+
+        int status = EXIT_FAILURE;
+        try {
+            // Still single threaded: every thread the worker starts inherits the cpu.
+            utils::CpuSet cpu;
+            cpu.Add(worker.cpu);
+            utils::PinCurrentThread(cpu);
+
+            WorkerContext context(index, slot, supervisor);
+            status = main_(context);
+        } catch (const std::exception &e) {
+            spdlog::critical("Worker {}: {}", index, e.what());
+        }
+        spdlog::shutdown();
+        // No destructors of objects inherited from the supervisor: they own the listener path.
+        ::_exit(status);
+    }
+
+    worker.pid = pid;
+    worker.started = Clock::now();
+    worker.restartAt.reset();
+    spdlog::info("Started worker {} (pid {}) on cpu {}", index, pid, worker.cpu);
+}
+
+void WorkerSupervisor::Exited(std::size_t index, int status)
+{
+    auto &worker = workers_[index];
+    auto &slot = slots_[index];
+    worker.pastSessions += slot.sessions.load(std::memory_order_relaxed);
+    worker.pastRequests += slot.requests.load(std::memory_order_relaxed);
+    slot.sessions.store(0, std::memory_order_relaxed);
+    slot.requests.store(0, std::memory_order_relaxed);
+    slot.activeSessions.store(0, std::memory_order_relaxed);
+    slot.ready.store(false, std::memory_order_relaxed);
+    worker.pid = 0;
+
+    if (stopping_) {
+        spdlog::debug("Worker {} {}", index, describeExit(status));
+        return;
+    }
+
+    const auto uptime = Clock::now() - worker.started;
+    worker.backoff = uptime < kStableUptime
+                         ? std::clamp<Clock::duration>(worker.backoff * 2, kMinBackoff, kMaxBackoff)
+                         : Clock::duration::zero();
+    worker.restartAt = Clock::now() + worker.backoff;
+    ++worker.restarts;
+    spdlog::error("Worker {} {} after {} ms, restarting in {} ms", index, describeExit(status),
+                  millis(uptime), millis(worker.backoff));
+}
+
+std::size_t WorkerSupervisor::Running() const noexcept
+{
+    return static_cast<std::size_t>(
+        std::ranges::count_if(workers_, [](const Worker &w) { return w.pid > 0; }));
+}
+
+} // namespace uds_daemon
@@ -0,0 +1,143 @@
+#ifndef WORKER_SUPERVISOR_H_
+#define WORKER_SUPERVISOR_H_
+
+#include <cpu_affinity.h>
+#include <server_worker.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <system_error>
+#include <vector>
+
+namespace uds_daemon {
+
+class WorkerSupervisorError : public std::system_error {
+  public:
+    explicit WorkerSupervisorError(const std::string &what, int errnum = errno)
+     : std::system_error(errnum, std::generic_category(), what)
+    {
+    }
+};
+
+//! Counters of one worker slot, summed over every process that ran in it.
+struct WorkerStats {
+    pid_t pid{0};
+    bool ready{false};
+    uint64_t restarts{0};
+    uint64_t sessions{0};
+    uint64_t activeSessions{0};
+    uint64_t requests{0};
+};
+
+//! Worker side of a slot: lives in memory shared with the supervisor.
+class WorkerContext {
+  public:
+    [[nodiscard]] std::size_t Index() const noexcept { return index_; }
+
+    //! Tells the supervisor the worker accepts connections.
+    void Ready() noexcept;
+    //! Makes the counters of this process visible to the supervisor.
+    void Publish(const net::ServerWorkerStats &stats) noexcept;
+
+  private:
+    friend class WorkerSupervisor;
+
+    struct Slot {
+        std::atomic<bool> ready{false};
+        std::atomic<uint64_t> sessions{0};
+        std::atomic<uint64_t> activeSessions{0};
+        std::atomic<uint64_t> requests{0};
+    };
+
+    WorkerContext(std::size_t index, Slot &slot, pid_t supervisor) noexcept
+     : index_(index)
+     , slot_(slot)
+     , supervisor_(supervisor)
+    {
+    }
+
+    std::size_t index_;
+    Slot &slot_;
+    pid_t supervisor_;
+};
+
+//*****************************************************************************
+//! \brief WorkerSupervisor
+//! Pre-forks worker processes that all serve the same listening socket, so a
+//! crash in one of them takes down only its own sessions. Each worker is
+//! pinned to one cpu of the given set (round robin) and restarted when it
+//! exits; a worker that dies right after starting is restarted with growing
+//! backoff instead of in a tight loop.
+//!
+//! Workers report readiness and publish their counters through a shared
+//! memory slot and wake the supervisor with SIGUSR1; exits arrive as SIGCHLD.
+//! Both have to be blocked (utils::SignalHandler) before Start(). Workers do
+//! not talk to systemd themselves: NOTIFY_SOCKET and FDSTORE are removed from
+//! their environment.
+//!
+//! Not thread-safe; driven from the supervisor's signal loop.
+class WorkerSupervisor {
+  public:
+    using Clock = std::chrono::steady_clock;
+    //! Body of a worker process; the return value becomes its exit status.
+    using WorkerMain = std::function<int(WorkerContext &)>;
+
+    WorkerSupervisor(std::size_t workers, const utils::CpuSet &cpus, WorkerMain main);
+    ~WorkerSupervisor();
+
+    WorkerSupervisor(const WorkerSupervisor &) = delete;
+    WorkerSupervisor &operator=(const WorkerSupervisor &) = delete;
+
+    //! Forks every worker; throws WorkerSupervisorError if fork() fails.
+    void Start();
+
+    //! True once every worker reported ready since it was (re)started.
+    [[nodiscard]] bool AllReady() const noexcept;
+
+    //! Reaps exited workers and starts the ones whose backoff elapsed. Returns how long until
+    //! the next pending restart, if any.
+    std::optional<Clock::duration> Supervise();
+
+    //! Sends \p signal to every running worker.
+    void Broadcast(int signal) const noexcept;
+
+    //! SIGTERM to every worker, SIGKILL to those still running after \p timeout.
+    void Stop(std::chrono::milliseconds timeout) noexcept;
+
+    [[nodiscard]] std::vector<WorkerStats> Stats() const;
+    [[nodiscard]] WorkerStats Totals() const;
+
+  private:
+    // Supervisor-only bookkeeping of a slot.
+    struct Worker {
+        unsigned cpu{0};
+        pid_t pid{0};
+        Clock::time_point started{};
+        Clock::duration backoff{};
+        std::optional<Clock::time_point> restartAt{};
+        uint64_t restarts{0};
+        // Counters of the processes that ran in this slot before.
+        uint64_t pastSessions{0};
+        uint64_t pastRequests{0};
+    };
+
+    void Spawn(std::size_t index);
+    void Exited(std::size_t index, int status);
+    std::size_t Running() const noexcept;
+
+    WorkerMain main_;
+    std::vector<Worker> workers_;
+    WorkerContext::Slot *slots_{nullptr};
+    bool stopping_{false};
+};
+
+} // namespace uds_daemon
+
+#endif // WORKER_SUPERVISOR_H_
@@ -0,0 +1,198 @@
+#include "load_generator.h"
+
+#include <byte_util.h>
+#include <format>
+#include <thread>
+#include <uds_client.h>
+#include <vector>
+
+namespace udsctl {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// uds-daemon answers every message with "<per-session counter>-replay <message>".
+std::size_t expectedReplySize(uint64_t seq, const std::string &payload)
+{
+    return std::formatted_size("{}-replay {}", seq, payload);
+}
+
+struct ConnectionResult {
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t reconnects{0};
+    utils::LatencyHistogram latency;
+};
+
+bool connectClient(net::UdsClient &client, const LoadOptions &options)
+{
+    if (client.connect(options.socket_path) != std::errc{})
+        return false;
+    client.setSpinPolicy(options.spin);
+    return true;
+}
+
+void runConnection(const LoadOptions &options, std::size_t index, Clock::time_point start,
+                   ConnectionResult &result)
+{
+    const auto measureFrom = start + options.warmup;
+    const auto end = measureFrom + options.duration;
+    const bool openLoop = options.rate > 0.0;
+
+    // Each connection gets an equal share of the total rate, offset so the connections do not
+    // fire in lockstep.
+    const std::chrono::duration<double> interval(
+        openLoop ? static_cast<double>(options.connections) / options.rate : 0.0);
+    const auto offset = std::chrono::duration_cast<Clock::duration>(
+        interval * static_cast<double>(index) / static_cast<double>(options.connections));
+
+    const auto request = utils::to_bytes(options.payload);
+    std::vector<std::byte> rxBuffer(options.payload.size() + 32);
+
+    auto client = std::make_unique<net::UdsClient>();
+    if (!connectClient(*client, options)) {
+        ++result.errors;
+        return;
+    }
+
+    uint64_t seq = 0;
+    for (uint64_t i = 0;; ++i) {
+        Clock::time_point intended;
+        if (openLoop) {
+            intended =
+                start + offset +
+                std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(i));
+            if (intended >= end)
+                break;
+            std::this_thread::sleep_until(intended);
+        } else {
+            intended = Clock::now();
+            if (intended >= end)
+                break;
+        }
+
+        const auto replySize = expectedReplySize(seq, options.payload);
+        if (rxBuffer.size() < replySize)
+            rxBuffer.resize(replySize);
+
+        std::expected<std::size_t, std::errc> received = std::unexpected(std::errc::io_error);
+        if (client->send(std::span(request))) {
+            received = client->receive(
+                std::span(rxBuffer.data(), replySize),
+                [replySize](std::span<const std::byte> data) { return data.size() >= replySize; });
+        }
+        const auto done = Clock::now();
+
+        if (!received || *received != replySize) {
+            ++result.errors;
+            // The session counter restarts with a new connection.
+            client = std::make_unique<net::UdsClient>();
+            seq = 0;
+            if (connectClient(*client, options))
+                ++result.reconnects;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        ++seq;
+        if (intended >= measureFrom) {
+            ++result.requests;
+            result.latency.Record(done - intended);
+        }
+    }
+
+    client->disconnect();
+}
+
+} // namespace
+
+LoadReport RunLoad(const LoadOptions &options)
+{
+    std::vector<ConnectionResult> results(options.connections);
+    std::vector<std::thread> threads;
+    threads.reserve(options.connections);
+
+    // Give all threads a common start slightly in the future so connecting does not skew the
+    // first requests of the schedule.
+    const auto start = Clock::now() + std::chrono::milliseconds(100);
+
+    for (std::size_t i = 0; i < options.connections; ++i) {
+        threads.emplace_back(runConnection, std::cref(options), i, start, std::ref(results[i]));
+    }
+    for (auto &t : threads)
+        t.join();
+
+    LoadReport report;
+    report.connections = options.connections;
+    report.rate = options.rate;
+    report.seconds = std::chrono::duration<double>(options.duration).count();
+    for (const auto &r : results) {
+        report.requests += r.requests;
+        report.errors += r.errors;
+        report.reconnects += r.reconnects;
+        report.latency.Merge(r.latency);
+    }
+    return report;
+}
+
+namespace {
+
+double toMicros(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+double throughput(const LoadReport &report)
+{
+    return report.seconds > 0.0 ? static_cast<double>(report.requests) / report.seconds : 0.0;
+}
+
+constexpr std::pair<const char *, double> kPercentiles[] = {
+    {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99_9", 99.9}};
+
+} // namespace
+
+void PrintReport(const LoadReport &report, std::ostream &out)
+{
+    const auto &h = report.latency;
+    if (report.rate > 0.0)
+        out << std::format("mode:        open-loop, target {:.0f} req/s\n", report.rate);
+    else
+        out << "mode:        closed-loop\n";
+    out << std::format("connections: {}\n", report.connections);
+    out << std::format("duration:    {:.1f} s\n", report.seconds);
+    out << std::format("requests:    {} ({} errors, {} reconnects)\n", report.requests,
+                       report.errors, report.reconnects);
+    out << std::format("throughput:  {:.1f} req/s\n", throughput(report));
+    out << "latency (us):\n";
+    out << std::format("  min    {:>12.1f}\n", toMicros(h.Min()));
+    out << std::format("  mean   {:>12.1f}\n", h.Mean() / 1000.0);
+    out << std::format("  p50    {:>12.1f}\n", toMicros(h.ValueAtPercentile(50.0)));
+    out << std::format("  p90    {:>12.1f}\n", toMicros(h.ValueAtPercentile(90.0)));
+    out << std::format("  p99    {:>12.1f}\n", toMicros(h.ValueAtPercentile(99.0)));
+    out << std::format("  p99.9  {:>12.1f}\n", toMicros(h.ValueAtPercentile(99.9)));
+    out << std::format("  max    {:>12.1f}\n", toMicros(h.Max()));
+}
+
+void WriteJsonReport(const LoadReport &report, std::ostream &out)
+{
+    const auto &h = report.latency;
+    out << "{\n";
+    out << std::format("  \"mode\": \"{}\",\n", report.rate > 0.0 ? "open" : "closed");
+    out << std::format("  \"rate\": {:.1f},\n", report.rate);
+    out << std::format("  \"connections\": {},\n", report.connections);
+    out << std::format("  \"duration_s\": {:.3f},\n", report.seconds);
+    out << std::format("  \"requests\": {},\n", report.requests);
+    out << std::format("  \"errors\": {},\n", report.errors);
+    out << std::format("  \"reconnects\": {},\n", report.reconnects);
+    out << std::format("  \"throughput_rps\": {:.1f},\n", throughput(report));
+    out << "  \"latency_us\": {\n";
+    out << std::format("    \"min\": {:.1f},\n", toMicros(h.Min()));
+    out << std::format("    \"mean\": {:.1f},\n", h.Mean() / 1000.0);
+    for (const auto &[name, p] : kPercentiles)
+        out << std::format("    \"{}\": {:.1f},\n", name, toMicros(h.ValueAtPercentile(p)));
+    out << std::format("    \"max\": {:.1f}\n", toMicros(h.Max()));
+    out << "  }\n";
+    out << "}\n";
+}
+
+} // namespace udsctl
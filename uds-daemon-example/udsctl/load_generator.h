@@ -0,0 +1,59 @@
+#ifndef UDSCTL_LOAD_GENERATOR_H
+#define UDSCTL_LOAD_GENERATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <latency_histogram.h>
+#include <optional>
+#include <ostream>
+#include <socket_session.h>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace udsctl {
+
+struct LoadOptions {
+    fs::path socket_path;
+    std::size_t connections{1};
+    //! Total request rate over all connections; 0 selects closed-loop mode.
+    double rate{0.0};
+    std::chrono::seconds duration{10};
+    std::chrono::seconds warmup{1};
+    std::string payload{"ping"};
+    //! Busy polling while waiting for a reply, to compare against the daemon's receive_spin_us.
+    net::SpinPolicy spin{};
+};
+
+struct LoadReport {
+    std::size_t connections{0};
+    double rate{0.0};
+    double seconds{0.0};
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t reconnects{0};
+    utils::LatencyHistogram latency;
+};
+
+//*****************************************************************************
+//! \brief RunLoad
+//! Opens options.connections sessions and drives request/response traffic
+//! against the daemon for warmup + duration.
+//!
+//! Open-loop (rate > 0): every connection follows a fixed schedule and the
+//! latency of a request is taken from its *intended* send time, so queueing
+//! behind a slow response is counted instead of hidden (no coordinated
+//! omission). Closed-loop (rate == 0): each connection sends the next request
+//! as soon as the previous response arrived; latency is pure service time.
+//!
+//! The daemon protocol has no message framing, so each connection keeps one
+//! request in flight; concurrency is scaled with the number of connections.
+LoadReport RunLoad(const LoadOptions &options);
+
+void PrintReport(const LoadReport &report, std::ostream &out);
+void WriteJsonReport(const LoadReport &report, std::ostream &out);
+
+} // namespace udsctl
+
+#endif // UDSCTL_LOAD_GENERATOR_H
@@ -0,0 +1,300 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <capture_file.h>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <system_error>
+#include <thread>
+#include <uds_client.h>
+#include <unordered_map>
+#include <vector>
+
+namespace udsctl {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Record = utils::CaptureReader::Record;
+
+// Replies longer than this are read in part; the rest is taken for the next reply.
+constexpr std::size_t kReplyBufferSize = 64 * 1024;
+// A session goes to its thread this much ahead of its first request, so the hand-over does not
+// delay the request.
+constexpr auto kSubmitLead = std::chrono::milliseconds(10);
+
+// Shared by the session threads and the progress reporter.
+struct Progress {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t running{0};
+    uint64_t requests{0};
+    uint64_t errors{0};
+    //! Latency since the last progress line.
+    utils::LatencyHistogram interval;
+};
+
+struct SessionResult {
+    uint64_t requests{0};
+    uint64_t errors{0};
+    utils::LatencyHistogram latency;
+};
+
+struct Schedule {
+    Clock::time_point start;
+    std::chrono::nanoseconds first;
+    double speed;
+
+    // Zero speed: as soon as the previous reply arrived.
+    Clock::time_point IntendedFor(const Record &record) const
+    {
+        if (speed <= 0.0)
+            return Clock::now();
+        return start + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double, std::nano>(
+                               static_cast<double>((record.offset - first).count()) / speed));
+    }
+};
+
+void replaySession(const ReplayOptions &options, const Schedule &schedule,
+                   const std::vector<const Record *> &requests, Progress &progress,
+                   SessionResult &result)
+{
+    std::vector<std::byte> reply(kReplyBufferSize);
+    net::UdsClient client;
+    bool connected = false;
+    std::this_thread::sleep_until(schedule.start);
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        const auto intended = schedule.IntendedFor(*requests[i]);
+        std::this_thread::sleep_until(intended);
+
+        // Connecting is part of the first request, as it was for the captured client.
+        if (!connected)
+            connected = client.connect(options.socket_path) == std::errc{};
+        std::expected<std::size_t, std::errc> received = std::unexpected(std::errc::io_error);
+        if (connected && client.send(requests[i]->request))
+            received = client.receive(std::span(reply));
+        const auto done = Clock::now();
+
+        std::lock_guard lock(progress.mutex);
+        if (!received || *received == 0) {
+            const auto lost = requests.size() - i;
+            result.errors += lost;
+            progress.errors += lost;
+            break;
+        }
+        ++result.requests;
+        result.latency.Record(done - intended);
+        ++progress.requests;
+        progress.interval.Record(done - intended);
+    }
+
+    client.disconnect();
+    std::lock_guard lock(progress.mutex);
+    --progress.running;
+    progress.done.notify_all();
+}
+
+//*****************************************************************************
+//! \brief SessionPool
+//! Threads that replay sessions, at most \p maxThreads of them. A thread is
+//! started only when a session is submitted and none is free; a thread whose
+//! session ended takes the next one queued.
+class SessionPool {
+  public:
+    SessionPool(std::size_t maxThreads, std::function<void(std::size_t session)> run)
+     : maxThreads_(std::max<std::size_t>(maxThreads, 1))
+     , run_(std::move(run))
+    {
+    }
+
+    SessionPool(const SessionPool &) = delete;
+    SessionPool &operator=(const SessionPool &) = delete;
+
+    //! Sessions still queued are dropped.
+    ~SessionPool()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            queue_.clear();
+            closing_ = true;
+        }
+        wake_.notify_all();
+        for (auto &t : threads_)
+            t.join();
+    }
+
+    //! Throws std::system_error if not even one thread could be started.
+    void Submit(std::size_t session)
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(session);
+        if (threads_.size() - busy_ < queue_.size() && threads_.size() < maxThreads_) {
+            try {
+                threads_.emplace_back(&SessionPool::Work, this);
+            } catch (const std::system_error &e) {
+                if (threads_.empty())
+                    throw;
+                // The system's limit: later sessions wait for one of the threads there are.
+                spdlog::warn("No thread for another session ({}); replaying at most {} at once",
+                             e.what(), threads_.size());
+                maxThreads_ = threads_.size();
+            }
+        }
+        wake_.notify_one();
+    }
+
+  private:
+    void Work()
+    {
+        std::unique_lock lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [this]() { return closing_ || !queue_.empty(); });
+            if (queue_.empty())
+                return;
+            const auto session = queue_.front();
+            queue_.pop_front();
+            ++busy_;
+            lock.unlock();
+            run_(session);
+            lock.lock();
+            --busy_;
+        }
+    }
+
+    std::size_t maxThreads_;
+    const std::function<void(std::size_t)> run_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::size_t> queue_;
+    std::size_t busy_{0};
+    bool closing_{false};
+    std::vector<std::thread> threads_;
+};
+
+double toMicros(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+void writeProgress(Clock::time_point start, Progress &progress, uint64_t &reported,
+                   std::ostream &out)
+{
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+    out << std::format("[{:7.1f} s] {} requests (+{}), {} errors, {} sessions running, "
+                       "p50 {:.1f} us, p99 {:.1f} us\n",
+                       elapsed.count(), progress.requests, progress.requests - reported,
+                       progress.errors, progress.running,
+                       toMicros(progress.interval.ValueAtPercentile(50.0)),
+                       toMicros(progress.interval.ValueAtPercentile(99.0)));
+    out.flush();
+    reported = progress.requests;
+    progress.interval.Reset();
+}
+
+// Hands each session to the pool as it comes due, \p order being the order they do, and writes
+// the progress lines meanwhile; returns once every session ended.
+void runSessions(const ReplayOptions &options, const Schedule &schedule,
+                 const std::vector<std::vector<const Record *>> &sessions,
+                 const std::vector<std::size_t> &order, SessionPool &pool, Progress &progress,
+                 std::ostream &out)
+{
+    const bool reporting = options.progress > std::chrono::milliseconds::zero();
+    auto nextReport = schedule.start + options.progress;
+    uint64_t reported = 0;
+    std::size_t next = 0;
+
+    std::unique_lock lock(progress.mutex);
+    while (progress.running > 0) {
+        const auto now = Clock::now();
+        std::optional<Clock::time_point> wake;
+        if (next < order.size()) {
+            const auto due = schedule.IntendedFor(*sessions[order[next]].front()) - kSubmitLead;
+            if (due <= now) {
+                lock.unlock();
+                pool.Submit(order[next++]);
+                lock.lock();
+                continue;
+            }
+            wake = due;
+        }
+        if (reporting) {
+            if (nextReport <= now) {
+                writeProgress(schedule.start, progress, reported, out);
+                nextReport += options.progress;
+                continue;
+            }
+            wake = std::min(wake.value_or(nextReport), nextReport);
+        }
+
+        if (wake)
+            progress.done.wait_until(lock, *wake);
+        else
+            progress.done.wait(lock);
+    }
+}
+
+} // namespace
+
+LoadReport RunReplay(const ReplayOptions &options, std::ostream &progress)
+{
+    const utils::CaptureReader capture(options.capture);
+    const auto records = capture.Records();
+    LoadReport report;
+    if (records.empty())
+        return report;
+
+    // Sessions in the order they first sent, each with its requests in capture order.
+    std::vector<std::vector<const Record *>> sessions;
+    std::unordered_map<uint64_t, std::size_t> indexOf;
+    auto first = records.front().offset;
+    auto last = first;
+    for (const auto &record : records) {
+        const auto [it, added] = indexOf.try_emplace(record.session, sessions.size());
+        if (added)
+            sessions.emplace_back();
+        sessions[it->second].push_back(&record);
+        first = std::min(first, record.offset);
+        last = std::max(last, record.offset);
+    }
+
+    std::vector<std::size_t> order(sessions.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::ranges::stable_sort(order, {}, [&sessions](std::size_t i) {
+        return sessions[i].front()->offset;
+    });
+
+    Progress shared;
+    shared.running = sessions.size();
+    std::vector<SessionResult> results(sessions.size());
+
+    // A common start slightly in the future, so starting the first threads does not delay the
+    // first requests of the schedule.
+    const Schedule schedule{.start = Clock::now() + std::chrono::milliseconds(100),
+                            .first = first,
+                            .speed = options.speed};
+    {
+        SessionPool pool(options.max_sessions, [&](std::size_t i) {
+            replaySession(options, schedule, sessions[i], shared, results[i]);
+        });
+        runSessions(options, schedule, sessions, order, pool, shared, progress);
+    }
+
+    const std::chrono::duration<double> captured = last - first;
+    report.connections = sessions.size();
+    report.seconds = std::chrono::duration<double>(Clock::now() - schedule.start).count();
+    if (options.speed > 0.0 && captured.count() > 0.0)
+        report.rate = static_cast<double>(records.size()) / captured.count() * options.speed;
+    for (const auto &r : results) {
+        report.requests += r.requests;
+        report.errors += r.errors;
+        report.latency.Merge(r.latency);
+    }
+    return report;
+}
+
+} // namespace udsctl
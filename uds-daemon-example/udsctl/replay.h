@@ -0,0 +1,47 @@
+#ifndef UDSCTL_REPLAY_H
+#define UDSCTL_REPLAY_H
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <load_generator.h>
+#include <ostream>
+
+namespace udsctl {
+
+struct ReplayOptions {
+    fs::path socket_path;
+    //! Written by the daemon's "capture start" admin command.
+    fs::path capture;
+    //! 1 replays at the captured pace, 2 twice as fast; 0 sends every session's requests back
+    //! to back.
+    double speed{1.0};
+    //! How often a progress line is written; zero turns progress off.
+    std::chrono::milliseconds progress{std::chrono::seconds(1)};
+    //! Sessions replayed at once, one thread each; a session due beyond it waits for a thread.
+    std::size_t max_sessions{1024};
+};
+
+//*****************************************************************************
+//! \brief RunReplay
+//! Replays a request capture against the daemon: every captured session gets
+//! a connection of its own, opened when its first request is due, so the
+//! original concurrency is kept up to options.max_sessions. Sessions run on
+//! threads that are started as sessions come due and reused once theirs ended;
+//! should the system refuse a thread, the ones running take the remaining
+//! sessions in turn. Requests are sent at their captured time
+//! scaled by options.speed and latency is taken from that intended time, as
+//! in open-loop RunLoad(). A session that fails is abandoned; its remaining
+//! requests count as errors.
+//!
+//! Each reply is taken to be what one read returns, since the protocol has no
+//! framing; that holds for replies of up to a socket buffer.
+//!
+//! Writes a progress line (requests, errors, latency of the interval) to
+//! \p progress every options.progress. Throws utils::CaptureFileError if the
+//! capture cannot be read.
+LoadReport RunReplay(const ReplayOptions &options, std::ostream &progress);
+
+} // namespace udsctl
+
+#endif // UDSCTL_REPLAY_H
@@ -1,7 +1,12 @@
 #include <byte_util.h>
+#include <chrono>
 #include <cxxopts.hpp>
 #include <filesystem>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <load_generator.h>
+#include <replay.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 #include <uds_client.h>
@@ -9,10 +14,18 @@
 
 namespace fs = std::filesystem;
 
+enum class ECommand { SEND, BENCH, REPLAY, STREAM };
+
 struct CliArgs {
+    ECommand command;
     fs::path socket_path;
     spdlog::level::level_enum log_level;
     std::string message;
+    udsctl::LoadOptions load;
+    udsctl::ReplayOptions replay;
+    uint32_t window{net::UdsClient::kDefaultStreamWindow};
+    std::optional<fs::path> output;
+    std::optional<fs::path> json_report;
 };
 
 static CliArgs parse_arguments(int argc, char *argv[])
@@ -26,7 +39,42 @@ static CliArgs parse_arguments(int argc, char *argv[])
         "l,log-level", "Log level (trace, debug, info, warn, error, critical, off)",
         cxxopts::value<std::string>()->default_value("info"))(
         "m,message", "Message to send to the server",
-        cxxopts::value<std::string>()->default_value("ping"))("h,help", "Print usage");
+        cxxopts::value<std::string>()->default_value("ping"))("h,help", "Print usage")(
+        "command", "send (default) | bench | replay | stream",
+        cxxopts::value<std::string>()->default_value("send"));
+
+    options.add_options("bench")(
+        "c,connections", "Number of concurrent connections",
+        cxxopts::value<std::size_t>()->default_value("1"))(
+        "r,rate", "Total requests per second (open loop); 0 = closed loop",
+        cxxopts::value<double>()->default_value("0"))(
+        "d,duration", "Measured duration in seconds", cxxopts::value<int>()->default_value("10"))(
+        "w,warmup", "Warmup in seconds, excluded from the report",
+        cxxopts::value<int>()->default_value("1"))(
+        "size", "Payload size in bytes (overrides --message)",
+        cxxopts::value<std::size_t>()->default_value("0"))(
+        "spin-us", "Busy poll this many microseconds for each reply before sleeping",
+        cxxopts::value<unsigned>()->default_value("0"))(
+        "spin-adaptive", "Spin only about as long as recent replies took")(
+        "json", "Also write the report as JSON to this file", cxxopts::value<std::string>());
+
+    options.add_options("replay")(
+        "capture", "Capture file written by the daemon's 'capture start' admin command",
+        cxxopts::value<std::string>())(
+        "speed", "Replay speed: 1 = as captured, 2 = twice as fast, 0 = no pauses",
+        cxxopts::value<double>()->default_value("1"))(
+        "max-sessions", "Captured sessions replayed at once; later ones wait for a thread",
+        cxxopts::value<std::size_t>()->default_value("1024"));
+
+    options.add_options("stream")(
+        "window", "Chunks in flight: the credits granted to the server",
+        cxxopts::value<uint32_t>()->default_value(
+            std::to_string(net::UdsClient::kDefaultStreamWindow)))(
+        "o,output", "Write the streamed response to this file instead of discarding it",
+        cxxopts::value<std::string>());
+
+    options.parse_positional({"command"});
+    options.positional_help("[send|bench|replay|stream]");
 
     cxxopts::ParseResult result;
     try {
@@ -43,7 +91,24 @@ static CliArgs parse_arguments(int argc, char *argv[])
         std::exit(EXIT_FAILURE);
     }
 
-    const std::string level_str = result["log-level"].as<std::string>();
+    const std::string command = result["command"].as<std::string>();
+    if (command != "send" && command != "bench" && command != "replay" && command != "stream") {
+        std::cerr << "Unknown command '" << command << "'\n\n" << options.help() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (command == "replay" && result.count("capture") == 0) {
+        std::cerr << "replay needs --capture\n\n" << options.help() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    // The net layer logs every message at info; keep bench output readable unless asked for.
+    const bool bench = command == "bench";
+    const bool replay = command == "replay";
+    const bool stream = command == "stream";
+    const std::string level_str = ((bench || replay || stream) && result.count("log-level") == 0)
+                                      ? std::string("warn")
+                                      : result["log-level"].as<std::string>();
     spdlog::level::level_enum log_level;
 
     try {
@@ -55,12 +120,124 @@ static CliArgs parse_arguments(int argc, char *argv[])
     }
 
     CliArgs args;
+    args.command = bench ? ECommand::BENCH : replay ? ECommand::REPLAY
+                                   : stream ? ECommand::STREAM
+                                            : ECommand::SEND;
     args.socket_path = result["socket"].as<std::string>();
     args.log_level = log_level;
     args.message = result["message"].as<std::string>();
+
+    args.load.socket_path = args.socket_path;
+    args.load.connections = std::max<std::size_t>(result["connections"].as<std::size_t>(), 1);
+    args.load.rate = std::max(result["rate"].as<double>(), 0.0);
+    args.load.duration = std::chrono::seconds(std::max(result["duration"].as<int>(), 1));
+    args.load.warmup = std::chrono::seconds(std::max(result["warmup"].as<int>(), 0));
+    if (auto size = result["size"].as<std::size_t>(); size > 0)
+        args.load.payload = std::string(size, 'x');
+    else
+        args.load.payload = args.message;
+    args.load.spin = net::SpinPolicy{
+        .spin = std::chrono::microseconds(result["spin-us"].as<unsigned>()),
+        .adaptive = result.count("spin-adaptive") > 0};
+    if (result.count("json"))
+        args.json_report = result["json"].as<std::string>();
+
+    args.replay.socket_path = args.socket_path;
+    if (replay)
+        args.replay.capture = result["capture"].as<std::string>();
+    args.replay.speed = std::max(result["speed"].as<double>(), 0.0);
+    args.replay.max_sessions = std::max<std::size_t>(result["max-sessions"].as<std::size_t>(), 1);
+
+    args.window = std::max<uint32_t>(result["window"].as<uint32_t>(), 1);
+    if (result.count("output"))
+        args.output = result["output"].as<std::string>();
     return args;
 }
 
+static int write_report(const CliArgs &args, const udsctl::LoadReport &report)
+{
+    udsctl::PrintReport(report, std::cout);
+
+    if (args.json_report) {
+        std::ofstream out(*args.json_report);
+        if (!out) {
+            spdlog::error("Failed to open {} for writing", args.json_report->string());
+            return EXIT_FAILURE;
+        }
+        udsctl::WriteJsonReport(report, out);
+    }
+
+    return report.requests > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int run_bench(const CliArgs &args)
+{
+    spdlog::info("Benchmarking {} with {} connection(s) for {} s", args.socket_path.string(),
+                 args.load.connections, args.load.duration.count());
+
+    return write_report(args, udsctl::RunLoad(args.load));
+}
+
+static int run_replay(const CliArgs &args)
+{
+    spdlog::info("Replaying {} against {} at speed {}", args.replay.capture.string(),
+                 args.socket_path.string(), args.replay.speed);
+
+    return write_report(args, udsctl::RunReplay(args.replay, std::cout));
+}
+
+//! Streams the response to args.message in chunks, written to args.output as they arrive; memory
+//! use does not depend on the response size.
+static int run_stream(const CliArgs &args)
+{
+    std::ofstream out;
+    if (args.output) {
+        out.open(*args.output, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            spdlog::error("Failed to open {} for writing", args.output->string());
+            return EXIT_FAILURE;
+        }
+    }
+
+    net::UdsClient client;
+    if (auto connect_result = client.connect(args.socket_path); connect_result != std::errc{}) {
+        spdlog::error("Failed to connect to {}: {}", args.socket_path.string(),
+                      std::make_error_code(connect_result).message());
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = client.stream(
+        args.message,
+        [&out](std::span<const std::byte> chunk) {
+            if (out.is_open())
+                out.write(reinterpret_cast<const char *>(chunk.data()),
+                          static_cast<std::streamsize>(chunk.size()));
+        },
+        args.window);
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    client.disconnect();
+
+    if (!result) {
+        spdlog::error("Stream failed: {}", std::make_error_code(result.error()).message());
+        return EXIT_FAILURE;
+    }
+    if (!result->error.empty()) {
+        spdlog::error("Server ended the stream: {}", result->error);
+        return EXIT_FAILURE;
+    }
+    out.close();
+    if (args.output && !out) {
+        spdlog::error("Writing {} failed", args.output->string());
+        return EXIT_FAILURE;
+    }
+    std::cout << std::format("{} bytes in {} chunks, {:.3f} s, {:.1f} MiB/s\n", result->bytes,
+                             result->chunks, seconds.count(),
+                             static_cast<double>(result->bytes) / (1024.0 * 1024.0) /
+                                 std::max(seconds.count(), 1e-9));
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char *argv[])
 {
     auto args = parse_arguments(argc, argv);
@@ -75,6 +252,13 @@ int main(int argc, char *argv[])
         spdlog::info("Starting client with log level '{}'",
                      spdlog::level::to_string_view(spdlog::get_level()));
 
+        if (args.command == ECommand::BENCH)
+            return run_bench(args);
+        if (args.command == ECommand::REPLAY)
+            return run_replay(args);
+        if (args.command == ECommand::STREAM)
+            return run_stream(args);
+
         // ---------------------------------------------------------------------
         // Connect to UDS server
         // ---------------------------------------------------------------------